@@ -0,0 +1,144 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Text;
+using System.Threading;
+
+/*
+ * Measures the startup time of short lived processes which run a workload
+ * touching a large part of corlib.  The benchmark starts itself repeatedly,
+ * first with JIT compilation only, then with an AOT cache shared through
+ * MONO_AOT_CACHE_DIR.  The first run with the cache generates the AOT modules
+ * in the background, the following runs wait until they are published and
+ * load them.
+ *
+ * The children are started with the runtime running the benchmark, or with
+ * RUNTIME if it is given.
+ *
+ * Usage: mono aot-cache-startup.exe [runs [runtime]]
+ */
+class T {
+	/* How long to wait for the background compiler before giving up */
+	const int timeout_ms = 300000;
+
+	static int workload () {
+		var sb = new StringBuilder ();
+		var dict = new Dictionary<string, int> ();
+		var list = new List<double> ();
+
+		for (int i = 0; i < 100; i++) {
+			string s = String.Format ("{0} {1:x} {2:F2}", i, i * 31, i / 7.0);
+			dict [s] = s.GetHashCode ();
+			list.Add (Double.Parse (i.ToString () + ".5"));
+			sb.Append (s.ToUpper ()).Append (Path.Combine ("a", s));
+		}
+		list.Sort ();
+		return sb.ToString ().Length + dict.Count + list.Count + DateTime.Now.Second;
+	}
+
+	static int run (string runtime, string exe, string cache_dir, int n) {
+		int total = 0;
+
+		for (int i = 0; i < n; i++) {
+			var info = new ProcessStartInfo (runtime, "\"" + exe + "\" --child");
+			info.UseShellExecute = false;
+			if (cache_dir != null)
+				info.EnvironmentVariables ["MONO_AOT_CACHE_DIR"] = cache_dir;
+
+			int start = Environment.TickCount;
+			using (Process p = Process.Start (info)) {
+				p.WaitForExit ();
+				if (p.ExitCode != 0)
+					throw new Exception (String.Format ("child exited with code {0}", p.ExitCode));
+			}
+			int ms = Environment.TickCount - start;
+
+			/* The first run with an empty cache triggers the compilation */
+			if (i > 0 || cache_dir == null)
+				total += ms;
+		}
+		return Math.Max (total, 1);
+	}
+
+	/* Published entries are named <assembly>-<guid>-<version hash><ext> */
+	static bool has_entry (string cache_dir, string assembly) {
+		foreach (string f in Directory.GetFiles (cache_dir, assembly + "-*")) {
+			if (!f.EndsWith (".tmp") && !f.EndsWith (".lock"))
+				return true;
+		}
+		return false;
+	}
+
+	/* Wait until the background compiler published the modules of ASSEMBLIES */
+	static bool wait_for_entries (string cache_dir, string [] assemblies) {
+		int start = Environment.TickCount;
+
+		while (true) {
+			bool done = true;
+			foreach (string a in assemblies) {
+				if (!has_entry (cache_dir, a))
+					done = false;
+			}
+			if (done)
+				return true;
+			if (Environment.TickCount - start > timeout_ms)
+				return false;
+			Thread.Sleep (100);
+		}
+	}
+
+	/*
+	 * Compilers started for other assemblies might still be writing into the
+	 * cache, so wait until their temporary files are gone, and retry if one
+	 * shows up while the directory is being deleted.
+	 */
+	static void delete_cache (string cache_dir) {
+		int start = Environment.TickCount;
+
+		while (true) {
+			try {
+				if (Directory.GetFiles (cache_dir, "*.tmp").Length == 0) {
+					Directory.Delete (cache_dir, true);
+					return;
+				}
+			} catch (IOException) {
+			} catch (UnauthorizedAccessException) {
+			}
+			if (Environment.TickCount - start > timeout_ms) {
+				Console.Error.WriteLine ("warning: could not delete {0}", cache_dir);
+				return;
+			}
+			Thread.Sleep (100);
+		}
+	}
+
+	static int Main (string [] args) {
+		if (args.Length > 0 && args [0] == "--child")
+			return workload () > 0 ? 0 : 1;
+
+		int n = args.Length > 0 ? Int32.Parse (args [0]) : 20;
+		string runtime = args.Length > 1 ? args [1] : Process.GetCurrentProcess ().MainModule.FileName;
+		string exe = typeof (T).Assembly.Location;
+		/* The assemblies loaded by the children */
+		string [] assemblies = { typeof (T).Assembly.GetName ().Name, typeof (object).Assembly.GetName ().Name };
+		string cache_dir = Path.Combine (Path.GetTempPath (), "aot-cache-startup-" + Process.GetCurrentProcess ().Id);
+
+		Directory.CreateDirectory (cache_dir);
+		try {
+			int jit = run (runtime, exe, null, n);
+			run (runtime, exe, cache_dir, 1);
+			if (!wait_for_entries (cache_dir, assemblies)) {
+				Console.Error.WriteLine ("error: the AOT cache in {0} wasn't generated after {1} s", cache_dir, timeout_ms / 1000);
+				return 1;
+			}
+			int aot = run (runtime, exe, cache_dir, n + 1);
+
+			Console.WriteLine ("jit: {0} ms/run", jit / n);
+			Console.WriteLine ("aot cache: {0} ms/run", aot / n);
+		} finally {
+			delete_cache (cache_dir);
+		}
+		return 0;
+	}
+}
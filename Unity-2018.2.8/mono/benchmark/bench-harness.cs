@@ -0,0 +1,36 @@
+using System;
+
+/*
+ * Driver shared by the benchmarks which time several kernels in one run.
+ * It is compiled into each of them, see HARNESS_TESTS in Makefile.am.
+ *
+ * A kernel runs N iterations of its loop and returns a value computed from
+ * the work done, which is printed so the loop can't be optimized away.
+ */
+static class Harness {
+	public delegate int Kernel (int n);
+
+	/* Whether Run calls the kernel once before timing it, so JIT time isn't counted */
+	public static bool WarmUp = true;
+
+	public static int Iterations (string [] args, int n) {
+		return args.Length > 0 ? Int32.Parse (args [0]) : n;
+	}
+
+	public static void Run (string name, Kernel f, int n) {
+		Run (name, f, n, n);
+	}
+
+	/* OPS is the amount of work done by N iterations, for the throughput column */
+	public static void Run (string name, Kernel f, int n, long ops) {
+		if (WarmUp)
+			f (1);
+		int gcs = GC.CollectionCount (0);
+		int start = Environment.TickCount;
+		int res = f (n);
+		int ms = Math.Max (Environment.TickCount - start, 1);
+
+		Console.WriteLine ("{0,-24} {1,6} ms, {2,10:F2} Mops/s, {3} gen0 collections ({4})",
+			name, ms, ops / (ms * 1000.0), GC.CollectionCount (0) - gcs, res);
+	}
+}
@@ -0,0 +1,77 @@
+using System;
+
+/*
+ * Array loops with bounds checks, over local arrays and arrays stored in
+ * fields.  Compare a normal run with one under -O=-loop, which turns off the
+ * removal of bounds checks from counted loops.  mono --stats reports the
+ * number of removed checks and versioned loops.
+ *
+ * Usage: bounds-check.exe [iterations]
+ */
+class T {
+	const int size = 4096;
+
+	int [] data = new int [size];
+	long [] longs = new long [size];
+
+	static int [] shared = new int [size];
+
+	static long local_sum (long [] a) {
+		long res = 0;
+
+		for (int i = 0; i < a.Length; i++)
+			res += a [i] ^ i;
+		return res;
+	}
+
+	long field_sum () {
+		long res = 0;
+
+		for (int i = 0; i < data.Length; i++)
+			res += data [i] * 3 + longs [i];
+		return res;
+	}
+
+	void field_update () {
+		for (int i = 0; i < data.Length; i++)
+			data [i] = data [i] * 7 + shared [i];
+	}
+
+	static T t = new T ();
+
+	static int run_local (int n) {
+		long res = 0;
+
+		for (int i = 0; i < n; i++)
+			res += local_sum (t.longs);
+		return (int)res;
+	}
+
+	static int run_field (int n) {
+		long res = 0;
+
+		for (int i = 0; i < n; i++)
+			res += t.field_sum ();
+		return (int)res;
+	}
+
+	static int run_update (int n) {
+		for (int i = 0; i < n; i++)
+			t.field_update ();
+		return t.data [size - 1];
+	}
+
+	static int Main (string [] args) {
+		int n = Harness.Iterations (args, 100000);
+
+		for (int i = 0; i < size; i++) {
+			t.longs [i] = i * 31;
+			shared [i] = i & 7;
+		}
+
+		Harness.Run ("local array", run_local, n, (long) n * size);
+		Harness.Run ("field arrays", run_field, n, (long) n * size);
+		Harness.Run ("field update", run_update, n, (long) n * size);
+		return 0;
+	}
+}
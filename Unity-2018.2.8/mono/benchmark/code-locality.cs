@@ -0,0 +1,88 @@
+using System;
+using System.Reflection;
+using System.Reflection.Emit;
+
+/*
+ * Calls a large number of generated methods round robin, so the hot code
+ * is bigger than the i-cache and the reach of the iTLB.  Each method has a
+ * throw path and a catch handler which never run.  The throw path is outside
+ * of the try block, since out of line bblocks inside one are not moved.  Run it as
+ *
+ *   perf stat -e iTLB-load-misses,L1-icache-load-misses mono code-locality.exe
+ *
+ * and compare with MONO_HUGE_CODE_PAGES=1, which backs the hot code pool
+ * with 2MB pages, and with -O=-branch, which keeps the handlers in line.
+ * mono --stats reports the number of cold bblocks moved.
+ *
+ * Usage: code-locality.exe [iterations] [methods]
+ */
+class T {
+	delegate int Work (int x);
+
+	static Work [] create (int count) {
+		AssemblyBuilder ab = AppDomain.CurrentDomain.DefineDynamicAssembly (new AssemblyName ("code-locality"), AssemblyBuilderAccess.Run);
+		ModuleBuilder mb = ab.DefineDynamicModule ("code-locality");
+		TypeBuilder tb = mb.DefineType ("Methods", TypeAttributes.Public);
+		ConstructorInfo exc_ctor = typeof (ArgumentException).GetConstructor (Type.EmptyTypes);
+
+		for (int i = 0; i < count; i++) {
+			MethodBuilder m = tb.DefineMethod ("M" + i, MethodAttributes.Public | MethodAttributes.Static, typeof (int), new Type [] { typeof (int) });
+			ILGenerator il = m.GetILGenerator ();
+			LocalBuilder res = il.DeclareLocal (typeof (int));
+			Label ok = il.DefineLabel ();
+
+			il.Emit (OpCodes.Ldarg_0);
+			il.Emit (OpCodes.Ldc_I4_0);
+			il.Emit (OpCodes.Bge, ok);
+			il.Emit (OpCodes.Newobj, exc_ctor);
+			il.Emit (OpCodes.Throw);
+			il.MarkLabel (ok);
+			il.BeginExceptionBlock ();
+			il.Emit (OpCodes.Ldarg_0);
+			for (int j = 0; j < 8; j++) {
+				il.Emit (OpCodes.Ldc_I4, i * 8 + j + 1);
+				il.Emit (OpCodes.Mul);
+				il.Emit (OpCodes.Ldc_I4, j + 3);
+				il.Emit (OpCodes.Xor);
+			}
+			il.Emit (OpCodes.Stloc, res);
+			il.BeginCatchBlock (typeof (ArgumentException));
+			il.Emit (OpCodes.Pop);
+			il.Emit (OpCodes.Ldc_I4_M1);
+			il.Emit (OpCodes.Stloc, res);
+			il.EndExceptionBlock ();
+			il.Emit (OpCodes.Ldloc, res);
+			il.Emit (OpCodes.Ret);
+		}
+
+		Type t = tb.CreateType ();
+		Work [] res_works = new Work [count];
+		for (int i = 0; i < count; i++)
+			res_works [i] = (Work) Delegate.CreateDelegate (typeof (Work), t.GetMethod ("M" + i));
+		return res_works;
+	}
+
+	static int run (Work [] works, int n) {
+		int res = 0;
+
+		for (int i = 0; i < n; i++)
+			for (int j = 0; j < works.Length; j++)
+				res += works [j] (i);
+		return res;
+	}
+
+	static int Main (string [] args) {
+		int n = args.Length > 0 ? Int32.Parse (args [0]) : 2000;
+		int count = args.Length > 1 ? Int32.Parse (args [1]) : 20000;
+
+		Work [] works = create (count);
+		/* JIT everything before measuring */
+		run (works, 1);
+
+		int start = Environment.TickCount;
+		int res = run (works, n);
+		int ms = Math.Max (Environment.TickCount - start, 1);
+		Console.WriteLine ("{0} methods: {1} ms, {2} Mcalls/s ({3})", count, ms, ((long)n * count) / (ms * 1000L), res);
+		return 0;
+	}
+}
@@ -0,0 +1,63 @@
+using System;
+
+/*
+ * Creates a new delegate and invokes it once, like an event system which
+ * creates many short lived delegates to the same methods.  Every new delegate
+ * used to go through the delegate trampoline on its first invocation.
+ * mono --stats reports the number of delegate invoke caches filled.
+ *
+ * Usage: delegate-create.exe [iterations]
+ */
+class T {
+	delegate int Handler (int x);
+
+	int state = 1;
+
+	int instance_handler (int x) {
+		return x + state;
+	}
+
+	static int static_handler (int x) {
+		return x ^ 7;
+	}
+
+	static T t = new T ();
+
+	static int instance (int n) {
+		int res = 0;
+
+		for (int i = 0; i < n; i++) {
+			Handler h = new Handler (t.instance_handler);
+			res += h (i);
+		}
+		return res;
+	}
+
+	static int static_method (int n) {
+		int res = 0;
+
+		for (int i = 0; i < n; i++) {
+			Handler h = new Handler (static_handler);
+			res += h (i);
+		}
+		return res;
+	}
+
+	static int reused (int n) {
+		int res = 0;
+		Handler h = new Handler (t.instance_handler);
+
+		for (int i = 0; i < n; i++)
+			res += h (i);
+		return res;
+	}
+
+	static int Main (string [] args) {
+		int n = Harness.Iterations (args, 10000000);
+
+		Harness.Run ("create+invoke instance", instance, n);
+		Harness.Run ("create+invoke static", static_method, n);
+		Harness.Run ("invoke only", reused, n);
+		return 0;
+	}
+}
@@ -0,0 +1,97 @@
+using System;
+
+/*
+ * Small temporary objects which never leave the method creating them.
+ * Compare a normal run with one under -O=-escape, which turns off their
+ * stack allocation.  Each test prints the number of gen0 collections it
+ * caused, mono --stats reports the number of stack allocated and scalar
+ * replaced objects.
+ *
+ * Usage: escape.exe [iterations]
+ */
+class Point {
+	public int x, y;
+
+	public Point (int x, int y) {
+		this.x = x;
+		this.y = y;
+	}
+
+	public int Dot (Point p) {
+		return x * p.x + y * p.y;
+	}
+}
+
+class Range {
+	public int start, end;
+
+	public Range (int start, int end) {
+		this.start = start;
+		this.end = end;
+	}
+
+	public bool Contains (int i) {
+		return i >= start && i < end;
+	}
+}
+
+class Acc {
+	public double sum;
+	public int count;
+
+	public void Add (double d) {
+		sum += d;
+		count ++;
+	}
+}
+
+class T {
+	/* Both objects are scalar replaced */
+	static int points (int n) {
+		int res = 0;
+
+		for (int i = 0; i < n; i++) {
+			Point a = new Point (i, i + 1);
+			Point b = new Point (2, 3);
+			res += a.Dot (b);
+		}
+		return res;
+	}
+
+	static int ranges (int n) {
+		int res = 0;
+
+		for (int i = 0; i < n; i++) {
+			Range r = new Range (i & 15, 12);
+			if (r.Contains (i & 7))
+				res++;
+		}
+		return res;
+	}
+
+	/* The accumulator lives across the loop, so it gets a stack slot */
+	static int average (int k) {
+		Acc acc = new Acc ();
+
+		for (int i = 0; i < 8; i++)
+			acc.Add (k + i * 0.5);
+		return (int)(acc.sum / acc.count);
+	}
+
+	static int accumulate (int n) {
+		int res = 0;
+
+		for (int i = 0; i < n; i++)
+			res += average (i);
+		return res;
+	}
+
+	static int Main (string [] args) {
+		int n = Harness.Iterations (args, 100000000);
+
+		Harness.Run ("points", points, n);
+		Harness.Run ("ranges", ranges, n);
+		Harness.Run ("accumulate", accumulate, n / 8);
+		return 0;
+	}
+}
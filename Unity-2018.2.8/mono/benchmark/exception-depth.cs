@@ -0,0 +1,69 @@
+using System;
+
+/*
+ * Throws an exception from a given stack depth and catches it at the top,
+ * without and with reading its StackTrace.  The throw path only records the
+ * raw ips of the frames, methods and line numbers are looked up when the
+ * trace is read, so the difference between the two columns is the cost of
+ * materializing the trace.  The last column has a finally clause in every
+ * frame, which makes the second pass of exception handling do some work.
+ *
+ * Usage: exception-depth.exe [iterations]
+ */
+class T {
+	static int recurse (int depth) {
+		if (depth == 0)
+			throw new FormatException ();
+		return recurse (depth - 1) + 1;
+	}
+
+	static int counter;
+
+	static int recurse_finally (int depth) {
+		if (depth == 0)
+			throw new FormatException ();
+		try {
+			return recurse_finally (depth - 1) + 1;
+		} finally {
+			counter++;
+		}
+	}
+
+	static int throw_catch (int n, int depth, bool read_trace, bool with_finally) {
+		int res = 0;
+
+		for (int i = 0; i < n; i++) {
+			try {
+				res += with_finally ? recurse_finally (depth) : recurse (depth);
+			} catch (FormatException e) {
+				if (read_trace)
+					res += e.StackTrace.Length;
+				else
+					res++;
+			}
+		}
+		return res;
+	}
+
+	static int run (int n, int depth, bool read_trace, bool with_finally) {
+		throw_catch (1, depth, read_trace, with_finally);
+		int start = Environment.TickCount;
+		throw_catch (n, depth, read_trace, with_finally);
+		return Math.Max (Environment.TickCount - start, 1);
+	}
+
+	static int Main (string [] args) {
+		int n = args.Length > 0 ? Int32.Parse (args [0]) : 20000;
+
+		foreach (int depth in new int [] { 1, 4, 16, 64, 256 }) {
+			int count = depth > 16 ? n * 16 / depth : n;
+			int plain = run (count, depth, false, false);
+			int trace = run (count, depth, true, false);
+			int fin = run (count, depth, false, true);
+
+			Console.WriteLine ("depth {0,3}: {1} throws/ms, {2} throws/ms reading StackTrace, {3} throws/ms with finally",
+				depth, count / plain, count / trace, count / fin);
+		}
+		return 0;
+	}
+}
@@ -0,0 +1,118 @@
+using System;
+using System.Collections.Generic;
+
+/*
+ * Exercises generic collections through code which is compiled once and
+ * shared between reference type instantiations, next to the same code
+ * instantiated with value types, which is compiled for every instantiation.
+ * The shared versions depend on small methods of their own class being
+ * inlined and on the rgctx slots they look up being loaded inline.  Run with
+ * --stats to see the "RGCTX fetches inlined" and "Methods inlined into shared
+ * code" counters.
+ *
+ * Usage: generic-collections.exe [iterations]
+ */
+class Bag<T> {
+	T [] items = new T [16];
+	int count;
+
+	public int Count {
+		get { return count; }
+	}
+
+	public T this [int index] {
+		get { return items [index]; }
+	}
+
+	void grow () {
+		T [] n = new T [items.Length * 2];
+		Array.Copy (items, n, count);
+		items = n;
+	}
+
+	public void Add (T item) {
+		if (count == items.Length)
+			grow ();
+		items [count++] = item;
+	}
+
+	public void Clear () {
+		count = 0;
+	}
+
+	public int IndexOf (T item) {
+		EqualityComparer<T> comparer = EqualityComparer<T>.Default;
+
+		for (int i = 0; i < count; i++)
+			if (comparer.Equals (items [i], item))
+				return i;
+		return -1;
+	}
+}
+
+class T {
+	static int bag<K> (K [] keys, int n) {
+		var b = new Bag<K> ();
+		int res = 0;
+
+		for (int i = 0; i < n; i++) {
+			b.Clear ();
+			foreach (K k in keys)
+				b.Add (k);
+			for (int j = 0; j < b.Count; j += 7)
+				res += b.IndexOf (b [j]);
+		}
+		return res;
+	}
+
+	static int list<K> (K [] keys, int n) {
+		var l = new List<K> ();
+		int res = 0;
+
+		for (int i = 0; i < n; i++) {
+			l.Clear ();
+			foreach (K k in keys)
+				l.Add (k);
+			for (int j = 0; j < l.Count; j++)
+				if (l [j] != null)
+					res++;
+		}
+		return res;
+	}
+
+	static int dictionary<K, V> (K [] keys, V value, int n) {
+		var d = new Dictionary<K, V> ();
+		int res = 0;
+
+		for (int i = 0; i < n; i++) {
+			d.Clear ();
+			foreach (K k in keys)
+				d [k] = value;
+			foreach (K k in keys) {
+				V v;
+				if (d.TryGetValue (k, out v))
+					res++;
+			}
+		}
+		return res;
+	}
+
+	static void Main (string [] args) {
+		int n = Harness.Iterations (args, 2000);
+		int [] ints = new int [1000];
+		string [] strings = new string [1000];
+		object value = new object ();
+
+		for (int i = 0; i < ints.Length; i++) {
+			ints [i] = i * 7919;
+			strings [i] = ints [i].ToString ();
+		}
+
+		Harness.Run ("Bag<string> (shared)", i => bag (strings, i), n / 10);
+		Harness.Run ("Bag<int>", i => bag (ints, i), n / 10);
+		Harness.Run ("List<string> (shared)", i => list (strings, i), n);
+		Harness.Run ("List<int>", i => list (ints, i), n);
+		Harness.Run ("Dictionary<string,object> (shared)", i => dictionary (strings, value, i), n / 4);
+		Harness.Run ("Dictionary<int,int>", i => dictionary (ints, 1, i), n / 4);
+	}
+}
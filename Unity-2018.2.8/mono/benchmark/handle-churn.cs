@@ -0,0 +1,53 @@
+using System;
+using System.Net.Sockets;
+using System.Threading;
+
+/*
+ * Creates and closes io-layer handles (events and sockets) from several
+ * threads at once, to measure contention in the handle table.
+ *
+ * Usage: handle-churn.exe [threads] [iterations per thread]
+ */
+class T {
+	static int iterations;
+
+	static void events () {
+		for (int i = 0; i < iterations; i++) {
+			ManualResetEvent ev = new ManualResetEvent (false);
+			ev.Set ();
+			ev.Close ();
+		}
+	}
+
+	static void sockets () {
+		for (int i = 0; i < iterations; i++) {
+			Socket s = new Socket (AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp);
+			s.Close ();
+		}
+	}
+
+	static void run (string name, int nthreads, ThreadStart start) {
+		Thread [] threads = new Thread [nthreads];
+		for (int i = 0; i < nthreads; i++)
+			threads [i] = new Thread (start);
+
+		int t = Environment.TickCount;
+		foreach (Thread th in threads)
+			th.Start ();
+		foreach (Thread th in threads)
+			th.Join ();
+		int ms = Math.Max (Environment.TickCount - t, 1);
+
+		long ops = (long) nthreads * iterations;
+		Console.WriteLine ("{0}: {1} threads, {2} ops in {3} ms ({4} ops/s)", name, nthreads, ops, ms, (ops * 1000) / ms);
+	}
+
+	static int Main (string [] args) {
+		int nthreads = args.Length > 0 ? Int32.Parse (args [0]) : 8;
+		iterations = args.Length > 1 ? Int32.Parse (args [1]) : 100000;
+
+		run ("event create/set/close", nthreads, events);
+		run ("socket open/close", nthreads, sockets);
+		return 0;
+	}
+}
@@ -0,0 +1,83 @@
+using System;
+
+/*
+ * Interface and virtual calls from a loop, on a receiver which is almost
+ * always of the same type.  Compare a normal run with one under
+ * MONO_PRECOMP=tiered, where the tier-1 code calls (or inlines) the common
+ * implementation behind a type check.  mono --stats reports the guarded
+ * call sites and how often their guards hit.
+ *
+ * Usage: inline-cache.exe [iterations]
+ */
+interface IShape {
+	int Area ();
+}
+
+class Square : IShape {
+	public int side = 3;
+
+	public int Area () {
+		return side * side;
+	}
+}
+
+class Rect : IShape {
+	public int w = 2, h = 5;
+
+	public int Area () {
+		return w * h;
+	}
+}
+
+abstract class Op {
+	public abstract int Apply (int a);
+}
+
+class Inc : Op {
+	public override int Apply (int a) {
+		return a + 1;
+	}
+}
+
+class T {
+	static IShape [] shapes;
+
+	static int interfaces (int n) {
+		int res = 0;
+
+		for (int i = 0; i < n; i++)
+			res += shapes [i & 1023].Area ();
+		return res;
+	}
+
+	static int virtuals (int n) {
+		Op op = new Inc ();
+		int res = 0;
+
+		for (int i = 0; i < n; i++)
+			res = op.Apply (res);
+		return res;
+	}
+
+	static int Main (string [] args) {
+		int n = Harness.Iterations (args, 100000000);
+
+		/* The loops are warmed up below, to get them to tier-1 code */
+		Harness.WarmUp = false;
+
+		/* One receiver in 100 is of the uncommon type */
+		shapes = new IShape [1024];
+		for (int i = 0; i < shapes.Length; i++)
+			shapes [i] = (i % 100) == 0 ? (IShape) new Rect () : new Square ();
+
+		/* Warm up, so the loops run in tier-1 code */
+		for (int i = 0; i < 100; i++) {
+			interfaces (1000);
+			virtuals (1000);
+		}
+
+		Harness.Run ("interface calls", interfaces, n);
+		Harness.Run ("virtual calls", virtuals, n);
+		return 0;
+	}
+}
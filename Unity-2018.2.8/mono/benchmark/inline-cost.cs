@@ -0,0 +1,79 @@
+using System;
+
+/*
+ * Small struct math helpers, 25-60 bytes of IL each, called from loops.
+ * These are over the classic 20 byte inline limit.  Compare a normal run
+ * with one under MONO_INLINELIMIT=20, which turns the inlining cost model
+ * off.  mono --stats reports how many methods the cost model inlined.
+ *
+ * Usage: inline-cost.exe [iterations]
+ */
+struct Vec3 {
+	public float x, y, z;
+
+	public Vec3 (float x, float y, float z) {
+		this.x = x;
+		this.y = y;
+		this.z = z;
+	}
+
+	public static Vec3 Add (Vec3 a, Vec3 b) {
+		return new Vec3 (a.x + b.x, a.y + b.y, a.z + b.z);
+	}
+
+	public static Vec3 Scale (Vec3 a, float s) {
+		return new Vec3 (a.x * s, a.y * s, a.z * s);
+	}
+
+	public static float Dot (Vec3 a, Vec3 b) {
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	public float SqrLength {
+		get { return x * x + y * y + z * z; }
+	}
+}
+
+class T {
+	static int Clamp (int v, int min, int max) {
+		if (v < min)
+			return min;
+		if (v > max)
+			return max;
+		return v;
+	}
+
+	static int Lerp (int a, int b, int t, int shift) {
+		if (shift == 0)
+			return a + (b - a) * t;
+		return a + (((b - a) * t) >> shift);
+	}
+
+	static float vectors (int n) {
+		Vec3 pos = new Vec3 (0, 0, 0);
+		Vec3 vel = new Vec3 (1, 2, 3);
+		float acc = 0;
+
+		for (int i = 0; i < n; i++) {
+			pos = Vec3.Add (pos, Vec3.Scale (vel, 0.001f));
+			acc += Vec3.Dot (pos, vel) + pos.SqrLength;
+		}
+		return acc;
+	}
+
+	static int ints (int n) {
+		int acc = 0;
+
+		for (int i = 0; i < n; i++)
+			acc += Clamp (Lerp (i & 0xff, 1000, i & 0xf, 4), 16, 512);
+		return acc;
+	}
+
+	static int Main (string [] args) {
+		int n = Harness.Iterations (args, 50000000);
+
+		Harness.Run ("struct math", delegate (int i) { return (int) vectors (i); }, n);
+		Harness.Run ("int helpers", ints, n);
+		return 0;
+	}
+}
@@ -0,0 +1,71 @@
+using System;
+using System.Collections;
+using System.Reflection;
+using System.Threading;
+
+/*
+ * JIT compiles every non-generic method of an assembly, splitting the
+ * methods between several threads.  Compare the time for 1 thread with
+ * the time for N threads (each run has to be a separate process, since
+ * compiled code is cached).
+ *
+ * Usage: jit-parallel.exe [threads] [assembly name]
+ */
+class T {
+	static ArrayList methods = new ArrayList ();
+	static int next;
+
+	static void compile () {
+		int i;
+
+		while ((i = Interlocked.Increment (ref next) - 1) < methods.Count) {
+			try {
+				((MethodBase) methods [i]).MethodHandle.GetFunctionPointer ();
+			} catch {
+			}
+		}
+	}
+
+	static void collect (Assembly a) {
+		BindingFlags flags = BindingFlags.Public | BindingFlags.NonPublic | BindingFlags.Instance |
+			BindingFlags.Static | BindingFlags.DeclaredOnly;
+
+		foreach (Type t in a.GetTypes ()) {
+			if (t.IsGenericTypeDefinition)
+				continue;
+			foreach (MethodInfo m in t.GetMethods (flags)) {
+				if (m.IsAbstract || m.IsGenericMethodDefinition)
+					continue;
+				if ((m.GetMethodImplementationFlags () & (MethodImplAttributes.InternalCall | MethodImplAttributes.Runtime)) != 0)
+					continue;
+				methods.Add (m);
+			}
+			foreach (ConstructorInfo c in t.GetConstructors (flags)) {
+				if (!c.IsStatic)
+					methods.Add (c);
+			}
+		}
+	}
+
+	static int Main (string [] args) {
+		int nthreads = args.Length > 0 ? Int32.Parse (args [0]) : Environment.ProcessorCount;
+		Assembly a = args.Length > 1 ? Assembly.Load (args [1]) : typeof (Uri).Assembly;
+
+		collect (a);
+
+		Thread [] threads = new Thread [nthreads];
+		for (int i = 0; i < nthreads; i++)
+			threads [i] = new Thread (compile);
+
+		int t = Environment.TickCount;
+		foreach (Thread th in threads)
+			th.Start ();
+		foreach (Thread th in threads)
+			th.Join ();
+		int ms = Math.Max (Environment.TickCount - t, 1);
+
+		Console.WriteLine ("{0}: {1} methods, {2} threads, {3} ms ({4} methods/s)",
+			a.GetName ().Name, methods.Count, nthreads, ms, (methods.Count * 1000L) / ms);
+		return 0;
+	}
+}
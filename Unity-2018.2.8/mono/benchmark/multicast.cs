@@ -0,0 +1,52 @@
+using System;
+
+/*
+ * Invokes an event with a growing number of subscribers and prints the cost
+ * per subscriber.  The delegate invoke wrapper calls the subscribers in a loop
+ * instead of recursing through the Invoke method of every delegate in the
+ * chain.
+ *
+ * Usage: multicast.exe [invocations]
+ */
+class T {
+	delegate void Handler (int x);
+
+	int sum;
+
+	void on_event (int x) {
+		sum += x;
+	}
+
+	static int count;
+
+	static void on_event_static (int x) {
+		count += x;
+	}
+
+	static void Main (string [] args) {
+		int n = args.Length > 0 ? Int32.Parse (args [0]) : 100000000;
+
+		foreach (int subscribers in new int [] { 1, 2, 5, 10, 20, 50, 100 }) {
+			Handler h = null;
+			T [] listeners = new T [subscribers];
+
+			for (int i = 0; i < subscribers; i++) {
+				listeners [i] = new T ();
+				if ((i & 1) == 0)
+					h += listeners [i].on_event;
+				else
+					h += on_event_static;
+			}
+
+			int iterations = n / subscribers;
+			h (1);
+			int start = Environment.TickCount;
+			for (int i = 0; i < iterations; i++)
+				h (i);
+			int ms = Math.Max (Environment.TickCount - start, 1);
+
+			Console.WriteLine ("{0,3} subscribers: {1} ms, {2} ns/invoke, {3} ns/subscriber",
+				subscribers, ms, (ms * 1000000L) / iterations, (ms * 1000000L) / ((long)iterations * subscribers));
+		}
+	}
+}
@@ -0,0 +1,120 @@
+using System;
+
+/*
+ * Runs some of the kernels from mini/bench.cs whose speed depends on how
+ * well the locals are allocated to registers across basic blocks.  Compare
+ * the results of -O=-linears and -O=linears, mono --stats reports the
+ * number of spill loads and stores emitted by the register allocators.
+ * regalloc.exe covers variables with short, disjoint live ranges.
+ *
+ * Usage: regalloc-kernels.exe [iterations]
+ */
+class T {
+	delegate int Kernel ();
+
+	static int nested_loops () {
+		int n = 16;
+		int x = 0;
+		int a = n;
+		while (a-- != 0) {
+			int b = n;
+			while (b-- != 0) {
+				int c = n;
+				while (c-- != 0) {
+					int d = n;
+					while (d-- != 0) {
+						int e = n;
+						while (e-- != 0) {
+							int f = n;
+							while (f-- != 0)
+								x++;
+						}
+					}
+				}
+			}
+		}
+		return x;
+	}
+
+	static int fib (int n) {
+		if (n < 2)
+			return 1;
+		return fib (n - 2) + fib (n - 1);
+	}
+
+	static int fib_kernel () {
+		return fib (30);
+	}
+
+	static int float_loop () {
+		double a = 0.0, b = 0.0001, c = 2300.5, d = 1000.0;
+		int loops = 0;
+
+		while (a < c) {
+			if (a == d)
+				b *= 2;
+			a += b;
+			if (b >= c)
+				break;
+			loops++;
+		}
+		return loops;
+	}
+
+	static byte [,] arr1 = new byte [256, 256];
+	static byte [,] arr2 = new byte [256, 256];
+
+	static int blur () {
+		int size = 256;
+
+		for (int i = 0; i < size; i++)
+			for (int j = 0; j < size; j++)
+				arr1 [i, j] = (byte) (i % 255);
+
+		for (int i = 3; i < size - 3; i++)
+			for (int j = 0; j < size; j++)
+				arr2 [i, j] = (byte) ((arr1 [i - 3, j] + arr1 [i + 3, j]
+						       + 6 * (arr1 [i - 2, j] + arr1 [i + 2, j])
+						       + 15 * (arr1 [i - 1, j] + arr1 [i + 1, j])
+						       + 20 * arr1 [i, j] + 32) >> 6);
+		return arr2 [128, 128];
+	}
+
+	static int register_pressure () {
+		int a = 1, b = 2, c = 3, d = 4, e = 5, f = 6, g = 7, h = 8;
+		int sum = 0;
+
+		for (int i = 0; i < 1000000; i++) {
+			a += b ^ i;
+			b += c;
+			c ^= d + i;
+			d += e;
+			e -= f;
+			f += g ^ h;
+			g += a;
+			h ^= b;
+			sum += a ^ h;
+		}
+		return sum;
+	}
+
+	static Harness.Kernel repeat (Kernel k) {
+		return delegate (int n) {
+			int res = 0;
+			for (int i = 0; i < n; i++)
+				res += k ();
+			return res;
+		};
+	}
+
+	static int Main (string [] args) {
+		int n = Harness.Iterations (args, 10);
+
+		Harness.Run ("nested loops", repeat (nested_loops), n);
+		Harness.Run ("fib", repeat (fib_kernel), n);
+		Harness.Run ("float", repeat (float_loop), n);
+		Harness.Run ("blur", repeat (blur), n * 10);
+		Harness.Run ("register pressure", repeat (register_pressure), n * 10);
+		return 0;
+	}
+}
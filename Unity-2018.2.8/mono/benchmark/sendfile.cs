@@ -0,0 +1,94 @@
+using System;
+using System.IO;
+using System.Net;
+using System.Net.Sockets;
+using System.Threading;
+
+/*
+ * Streams a file over a loopback connection, once with Socket.SendFile
+ * and once with a FileStream.Read/Socket.Send loop, and reports the
+ * throughput of each.
+ *
+ * Usage: sendfile.exe [file size in MB] [rounds]
+ */
+class T {
+	const int buf_size = 65536;
+
+	static long drain (Socket s) {
+		byte [] buf = new byte [buf_size];
+		long total = 0;
+		int n;
+
+		while ((n = s.Receive (buf)) > 0)
+			total += n;
+		s.Close ();
+		return total;
+	}
+
+	static void copy (Socket s, string path) {
+		byte [] buf = new byte [buf_size];
+		int n;
+
+		using (FileStream fs = new FileStream (path, FileMode.Open, FileAccess.Read, FileShare.Read, buf_size)) {
+			while ((n = fs.Read (buf, 0, buf.Length)) > 0) {
+				int sent = 0;
+				while (sent < n)
+					sent += s.Send (buf, sent, n - sent, SocketFlags.None);
+			}
+		}
+	}
+
+	static void run (string name, string path, long size, int rounds, bool use_sendfile) {
+		Socket listener = new Socket (AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp);
+		listener.Bind (new IPEndPoint (IPAddress.Loopback, 0));
+		listener.Listen (1);
+
+		int t = Environment.TickCount;
+		for (int i = 0; i < rounds; i++) {
+			Socket client = new Socket (AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp);
+			client.Connect (listener.LocalEndPoint);
+			Socket server = listener.Accept ();
+			long received = 0;
+			Thread reader = new Thread (delegate () { received = drain (server); });
+			reader.Start ();
+
+			if (use_sendfile)
+				client.SendFile (path);
+			else
+				copy (client, path);
+			client.Shutdown (SocketShutdown.Send);
+			reader.Join ();
+			client.Close ();
+
+			if (received != size)
+				throw new Exception (String.Format ("{0}: got {1} bytes, expected {2}", name, received, size));
+		}
+		int ms = Math.Max (Environment.TickCount - t, 1);
+		listener.Close ();
+
+		long mb = (size * rounds) >> 20;
+		Console.WriteLine ("{0}: {1} MB in {2} ms ({3} MB/s)", name, mb, ms, (mb * 1000) / ms);
+	}
+
+	static int Main (string [] args) {
+		int size_mb = args.Length > 0 ? Int32.Parse (args [0]) : 256;
+		int rounds = args.Length > 1 ? Int32.Parse (args [1]) : 4;
+		string path = Path.GetTempFileName ();
+		long size = (long) size_mb << 20;
+
+		try {
+			byte [] buf = new byte [1 << 20];
+			new Random (0).NextBytes (buf);
+			using (FileStream fs = new FileStream (path, FileMode.Create)) {
+				for (int i = 0; i < size_mb; i++)
+					fs.Write (buf, 0, buf.Length);
+			}
+
+			run ("read/send", path, size, rounds, false);
+			run ("sendfile", path, size, rounds, true);
+		} finally {
+			File.Delete (path);
+		}
+		return 0;
+	}
+}
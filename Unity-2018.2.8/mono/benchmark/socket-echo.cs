@@ -0,0 +1,117 @@
+using System;
+using System.Net;
+using System.Net.Sockets;
+using System.Threading;
+
+/*
+ * Loopback echo benchmark for the async socket path (BeginReceive/BeginSend
+ * dispatched by the threadpool's poll/epoll thread).
+ *
+ * Usage: socket-echo.exe [connections] [messages per connection]
+ */
+class T {
+	const int msg_size = 64;
+
+	static int pending;
+	static long messages;
+	static ManualResetEvent done = new ManualResetEvent (false);
+
+	class Echo {
+		public Socket sock;
+		public byte [] buf = new byte [msg_size];
+
+		public Echo (Socket sock) {
+			this.sock = sock;
+			sock.BeginReceive (buf, 0, buf.Length, SocketFlags.None, OnReceive, null);
+		}
+
+		void OnReceive (IAsyncResult ar) {
+			int n;
+			try {
+				n = sock.EndReceive (ar);
+			} catch (SocketException) {
+				n = 0;
+			}
+			if (n == 0) {
+				sock.Close ();
+				return;
+			}
+			sock.BeginSend (buf, 0, n, SocketFlags.None, OnSend, null);
+		}
+
+		void OnSend (IAsyncResult ar) {
+			sock.EndSend (ar);
+			sock.BeginReceive (buf, 0, buf.Length, SocketFlags.None, OnReceive, null);
+		}
+	}
+
+	class Client {
+		public Socket sock;
+		public byte [] buf = new byte [msg_size];
+		public int left;
+
+		public Client (EndPoint ep, int count) {
+			left = count;
+			sock = new Socket (AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp);
+			sock.NoDelay = true;
+			sock.Connect (ep);
+		}
+
+		public void Start () {
+			sock.BeginSend (buf, 0, buf.Length, SocketFlags.None, OnSend, null);
+		}
+
+		void OnSend (IAsyncResult ar) {
+			sock.EndSend (ar);
+			sock.BeginReceive (buf, 0, buf.Length, SocketFlags.None, OnReceive, null);
+		}
+
+		void OnReceive (IAsyncResult ar) {
+			sock.EndReceive (ar);
+			Interlocked.Increment (ref messages);
+			if (--left > 0) {
+				Start ();
+				return;
+			}
+			sock.Close ();
+			if (Interlocked.Decrement (ref pending) == 0)
+				done.Set ();
+		}
+	}
+
+	static int Main (string [] args) {
+		int nconn = args.Length > 0 ? Int32.Parse (args [0]) : 1000;
+		int nmsg = args.Length > 1 ? Int32.Parse (args [1]) : 100;
+		Client [] clients = new Client [nconn];
+
+		Socket listener = new Socket (AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp);
+		listener.Bind (new IPEndPoint (IPAddress.Loopback, 0));
+		listener.Listen (1024);
+		EndPoint ep = listener.LocalEndPoint;
+
+		Thread acceptor = new Thread (delegate () {
+			for (int i = 0; i < nconn; i++)
+				new Echo (listener.Accept ());
+		});
+		acceptor.Start ();
+
+		int start = Environment.TickCount;
+		for (int i = 0; i < nconn; i++)
+			clients [i] = new Client (ep, nmsg);
+		acceptor.Join ();
+		int connect_ms = Math.Max (Environment.TickCount - start, 1);
+
+		pending = nconn;
+		start = Environment.TickCount;
+		foreach (Client c in clients)
+			c.Start ();
+		done.WaitOne ();
+		int echo_ms = Math.Max (Environment.TickCount - start, 1);
+
+		listener.Close ();
+		Console.WriteLine ("{0} connections in {1} ms ({2} conn/s)", nconn, connect_ms, (nconn * 1000L) / connect_ms);
+		Console.WriteLine ("{0} messages in {1} ms ({2} msg/s)", messages, echo_ms, (messages * 1000L) / echo_ms);
+
+		return messages == (long) nconn * nmsg ? 0 : 1;
+	}
+}
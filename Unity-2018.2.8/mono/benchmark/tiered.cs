@@ -0,0 +1,73 @@
+using System;
+using System.Reflection;
+
+/*
+ * Measures the time to the first call of many cold methods, then the
+ * steady state speed of a hot one.  Compare a normal run with one under
+ * MONO_PRECOMP=tiered: the cold part should be faster, and the hot part
+ * the same once the tier-1 code is published.  mono --stats reports the
+ * number of tier-1 recompiles.
+ *
+ * Usage: tiered.exe [iterations]
+ */
+class T {
+	static int checksum (int [] a) {
+		int sum = 0;
+
+		for (int i = 0; i < a.Length; i++)
+			sum = (sum * 31) ^ a [i];
+		return sum;
+	}
+
+	static int hot (int n) {
+		int [] a = new int [1024];
+		int res = 0;
+
+		for (int i = 0; i < a.Length; i++)
+			a [i] = i * 7;
+		for (int i = 0; i < n; i++)
+			res += checksum (a);
+		return res;
+	}
+
+	static int cold (int n) {
+		BindingFlags flags = BindingFlags.Public | BindingFlags.Instance | BindingFlags.DeclaredOnly;
+		int count = 0;
+
+		/* Touch the property getters of the corlib types, most of them are only called once */
+		foreach (Type t in typeof (object).Assembly.GetTypes ()) {
+			if (!t.IsPublic || t.IsAbstract || t.IsGenericTypeDefinition || t.GetConstructor (Type.EmptyTypes) == null)
+				continue;
+			object o;
+			try {
+				o = Activator.CreateInstance (t);
+			} catch {
+				continue;
+			}
+			foreach (PropertyInfo p in t.GetProperties (flags)) {
+				if (!p.CanRead || p.GetIndexParameters ().Length != 0)
+					continue;
+				try {
+					p.GetValue (o, null);
+					count++;
+				} catch {
+				}
+			}
+			if (count >= n)
+				break;
+		}
+		return count;
+	}
+
+	static int Main (string [] args) {
+		int n = Harness.Iterations (args, 100000);
+
+		/* The first calls are what is being measured */
+		Harness.WarmUp = false;
+
+		Harness.Run ("cold methods", cold, 2000);
+		Harness.Run ("hot loop", hot, n);
+		Harness.Run ("hot loop again", hot, n);
+		return 0;
+	}
+}
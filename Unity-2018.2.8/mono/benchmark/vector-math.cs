@@ -0,0 +1,68 @@
+using System;
+
+/*
+ * Vector math throughput on a 4 float struct.  Compare a normal run with
+ * one under MONO_SIMD_TYPES=Bench.float4, which makes the JIT keep float4
+ * values in SSE registers and turn its operators into packed instructions.
+ *
+ * Usage: vector-math.exe [iterations]
+ */
+namespace Bench {
+
+struct float4 {
+	public float x, y, z, w;
+
+	public float4 (float x, float y, float z, float w) {
+		this.x = x;
+		this.y = y;
+		this.z = z;
+		this.w = w;
+	}
+
+	public static float4 operator + (float4 a, float4 b) {
+		return new float4 (a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+	}
+
+	public static float4 operator - (float4 a, float4 b) {
+		return new float4 (a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w);
+	}
+
+	public static float4 operator * (float4 a, float4 b) {
+		return new float4 (a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w);
+	}
+}
+
+class T {
+	delegate float4 Run (int n);
+
+	static float4 integrate (int n) {
+		float4 pos = new float4 (0, 0, 0, 0);
+		float4 vel = new float4 (1, 2, 3, 4);
+		float4 dt = new float4 (0.001f, 0.001f, 0.001f, 0.001f);
+		float4 damp = new float4 (0.9999f, 0.9999f, 0.9999f, 1);
+
+		for (int i = 0; i < n; i++) {
+			vel = vel * damp;
+			pos = pos + vel * dt;
+		}
+		return pos - vel;
+	}
+
+	static void run (string name, Run f, int n) {
+		f (1);
+		int t = Environment.TickCount;
+		float4 res = f (n);
+		int ms = Math.Max (Environment.TickCount - t, 1);
+		Console.WriteLine ("{0}: {1} ms, {2} Mops/s ({3} {4} {5} {6})", name, ms, (n * 3L) / (ms * 1000L),
+			res.x, res.y, res.z, res.w);
+	}
+
+	static int Main (string [] args) {
+		int n = args.Length > 0 ? Int32.Parse (args [0]) : 100000000;
+
+		run ("float4 integrate", integrate, n);
+		return 0;
+	}
+}
+
+}
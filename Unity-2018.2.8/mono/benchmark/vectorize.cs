@@ -0,0 +1,94 @@
+using System;
+
+/*
+ * Simple loops over int and float arrays.  Compare a normal run with one
+ * under -O=-simd, which turns the loop vectorizer off.  mono --stats
+ * reports the number of vectorized loops.
+ *
+ * Usage: vectorize.exe [iterations]
+ */
+class T {
+	const int size = 4096;
+
+	static float [] x = new float [size];
+	static float [] y = new float [size];
+	static int [] a = new int [size];
+	static int [] b = new int [size];
+
+	static void saxpy (float [] x, float [] y, float alpha) {
+		for (int i = 0; i < y.Length; i++)
+			y [i] = alpha * x [i] + y [i];
+	}
+
+	static int sum (int [] a) {
+		int res = 0;
+
+		for (int i = 0; i < a.Length; i++)
+			res += a [i];
+		return res;
+	}
+
+	static int min (int [] a) {
+		int res = Int32.MaxValue;
+
+		for (int i = 0; i < a.Length; i++)
+			res = Math.Min (res, a [i]);
+		return res;
+	}
+
+	static int max (int [] a) {
+		int res = Int32.MinValue;
+
+		for (int i = 0; i < a.Length; i++)
+			res = Math.Max (res, a [i]);
+		return res;
+	}
+
+	static void copy (int [] src, int [] dst, int n) {
+		for (int i = 0; i < n; i++)
+			dst [i] = src [i];
+	}
+
+	static int run_saxpy (int n) {
+		for (int i = 0; i < n; i++)
+			saxpy (x, y, 0.5f);
+		return (int)y [size - 1];
+	}
+
+	static int run_sum (int n) {
+		int res = 0;
+
+		for (int i = 0; i < n; i++)
+			res += sum (a);
+		return res;
+	}
+
+	static int run_minmax (int n) {
+		int res = 0;
+
+		for (int i = 0; i < n; i++)
+			res += max (a) - min (a);
+		return res;
+	}
+
+	static int run_copy (int n) {
+		for (int i = 0; i < n; i++)
+			copy (a, b, size);
+		return b [size - 1];
+	}
+
+	static int Main (string [] args) {
+		int n = Harness.Iterations (args, 100000);
+
+		for (int i = 0; i < size; i++) {
+			x [i] = i;
+			a [i] = (i * 7919) % 1000 - 500;
+		}
+
+		Harness.Run ("saxpy", run_saxpy, n, (long) n * size);
+		Harness.Run ("int sum", run_sum, n, (long) n * size);
+		Harness.Run ("int min/max", run_minmax, n, (long) n * size);
+		Harness.Run ("int copy", run_copy, n, (long) n * size);
+		return 0;
+	}
+}
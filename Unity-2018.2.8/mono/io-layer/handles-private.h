@@ -21,6 +21,7 @@
 #include <mono/io-layer/misc-private.h>
 #include <mono/io-layer/collection.h>
 #include <mono/io-layer/shared.h>
+#include <mono/utils/mono-membar.h>
 
 #define _WAPI_PRIVATE_MAX_SLOTS		(1024 * 16)
 #define _WAPI_PRIVATE_HANDLES(x) (_wapi_private_handles [x / _WAPI_HANDLE_INITIAL_COUNT][x % _WAPI_HANDLE_INITIAL_COUNT])
@@ -103,15 +104,30 @@ extern void _wapi_handle_foreach (WapiHandleType type,
 
 #define WAPI_SHARED_HANDLE_TYPED_DATA(handle, type) _wapi_shared_layout->handles[_WAPI_PRIVATE_HANDLES(GPOINTER_TO_UINT((handle))).u.shared.offset].u.type
 
+/*
+ * A private handle slot is claimed by atomically switching its type
+ * from WAPI_HANDLE_UNUSED to this value, and gets its real type once it
+ * is fully initialised.  Nothing looks up or searches for this type, and
+ * it must never be used to index the per-type tables.
+ */
+#define WAPI_HANDLE_CLAIMED WAPI_HANDLE_COUNT
+
 static inline WapiHandleType _wapi_handle_type (gpointer handle)
 {
 	guint32 idx = GPOINTER_TO_UINT(handle);
+	WapiHandleType type;
 	
 	if (!_WAPI_PRIVATE_VALID_SLOT (idx)) {
 		return(WAPI_HANDLE_COUNT);	/* An impossible type */
 	}
 	
-	return(_WAPI_PRIVATE_HANDLES(idx).type);
+	type = _WAPI_PRIVATE_HANDLES(idx).type;
+	if (type == WAPI_HANDLE_CLAIMED) {
+		/* Not published yet, so it isn't a valid handle */
+		return(WAPI_HANDLE_UNUSED);
+	}
+	
+	return(type);
 }
 
 static inline void _wapi_handle_set_signal_state (gpointer handle,
@@ -138,15 +154,6 @@ static inline void _wapi_handle_set_signal_state (gpointer handle,
 	if (state == TRUE) {
 		/* Tell everyone blocking on a single handle */
 
-		/* The condition the global signal cond is waiting on is the signalling of
-		 * _any_ handle. So lock it before setting the signalled state.
-		 */
-		pthread_cleanup_push ((void(*)(void *))mono_mutex_unlock_in_cleanup, (void *)_wapi_global_signal_mutex);
-		thr_ret = mono_mutex_lock (_wapi_global_signal_mutex);
-		if (thr_ret != 0)
-			g_warning ("Bad call to mono_mutex_lock result %d for global signal mutex", thr_ret);
-		g_assert (thr_ret == 0);
-
 		/* This function _must_ be called with
 		 * handle->signal_mutex locked
 		 */
@@ -164,6 +171,27 @@ static inline void _wapi_handle_set_signal_state (gpointer handle,
 			g_assert (thr_ret == 0);
 		}
 
+		/* Only wake the threads blocking on multiple handles
+		 * if one of them is waiting for this handle. Waiters
+		 * register in multi_waiters before checking the
+		 * signalled state, and we check multi_waiters after
+		 * setting it, so either they see the new state or we
+		 * see them.
+		 */
+		mono_memory_barrier ();
+		if (handle_data->multi_waiters == 0)
+			return;
+
+		/* The condition the global signal cond is waiting on is the signalling of
+		 * _any_ handle. Lock it so the broadcast can't slip in between a waiter
+		 * checking the handles and starting to wait.
+		 */
+		pthread_cleanup_push ((void(*)(void *))mono_mutex_unlock_in_cleanup, (void *)_wapi_global_signal_mutex);
+		thr_ret = mono_mutex_lock (_wapi_global_signal_mutex);
+		if (thr_ret != 0)
+			g_warning ("Bad call to mono_mutex_lock result %d for global signal mutex", thr_ret);
+		g_assert (thr_ret == 0);
+
 		/* Tell everyone blocking on multiple handles that something
 		 * was signalled
 		 */			
@@ -183,6 +211,28 @@ static inline void _wapi_handle_set_signal_state (gpointer handle,
 	}
 }
 
+static inline void _wapi_handle_add_multi_waiter (gpointer handle)
+{
+	guint32 idx = GPOINTER_TO_UINT(handle);
+
+	if (!_WAPI_PRIVATE_VALID_SLOT (idx)) {
+		return;
+	}
+
+	InterlockedIncrement (&_WAPI_PRIVATE_HANDLES(idx).multi_waiters);
+}
+
+static inline void _wapi_handle_remove_multi_waiter (gpointer handle)
+{
+	guint32 idx = GPOINTER_TO_UINT(handle);
+
+	if (!_WAPI_PRIVATE_VALID_SLOT (idx)) {
+		return;
+	}
+
+	InterlockedDecrement (&_WAPI_PRIVATE_HANDLES(idx).multi_waiters);
+}
+
 static inline void _wapi_shared_handle_set_signal_state (gpointer handle,
 							 gboolean state)
 {
@@ -156,6 +156,44 @@ pid_t _wapi_getpid (void)
 
 static mono_mutex_t scan_mutex = MONO_MUTEX_INITIALIZER;
 
+/*
+ * Handle types that _wapi_search_handle () or _wapi_handle_foreach ()
+ * look at while holding scan_mutex.  Destroying one of these must take
+ * scan_mutex too, so the check functions never see a half-cleared
+ * handle.  Everything else is created and destroyed without it.
+ */
+#define _WAPI_SEARCHED_HANDLE(type) (_WAPI_SHARED_HANDLE(type) || \
+				     type == WAPI_HANDLE_THREAD || \
+				     type == WAPI_HANDLE_FILE || \
+				     type == WAPI_HANDLE_SOCKET)
+
+/*
+ * Cleanup handler for paths which only hold scan_mutex for some
+ * handle types: MUTEX is NULL when it wasn't taken.
+ */
+static void scan_mutex_unlock_in_cleanup (void *mutex)
+{
+	if (mutex != NULL) {
+		mono_mutex_unlock_in_cleanup ((mono_mutex_t *)mutex);
+	}
+}
+
+/*
+ * Per-thread list of recently freed non-fd slots.  These are only
+ * hints: a slot is still claimed with a CAS, so it doesn't matter if
+ * another thread (or the scan in _wapi_handle_new_internal) got to it
+ * first.  This lets threads that create and close handles all the time
+ * do so without touching scan_mutex.
+ */
+#define HANDLE_CACHE_SIZE 64
+
+typedef struct {
+	guint32 count;
+	guint32 idx [HANDLE_CACHE_SIZE];
+} WapiHandleCache;
+
+static pthread_key_t handle_cache_key;
+
 static void handle_cleanup (void)
 {
 	int i, j, k;
@@ -224,9 +262,14 @@ void _wapi_cleanup ()
 static mono_once_t shared_init_once = MONO_ONCE_INIT;
 static void shared_init (void)
 {
+	int thr_ret;
+
 	g_assert ((sizeof (handle_ops) / sizeof (handle_ops[0]))
 		  == WAPI_HANDLE_COUNT);
 	
+	thr_ret = pthread_key_create (&handle_cache_key, g_free);
+	g_assert (thr_ret == 0);
+
 	_wapi_fd_reserve = getdtablesize();
 
 	/* This is needed by the code in _wapi_handle_new_internal */
@@ -298,8 +341,8 @@ static void _wapi_handle_init (struct _WapiHandleUnshared *handle,
 	
 	g_assert (_wapi_has_shut_down == FALSE);
 	
-	handle->type = type;
 	handle->signalled = FALSE;
+	handle->multi_waiters = 0;
 	handle->ref = 1;
 	
 	if (!_WAPI_SHARED_HANDLE(type)) {
@@ -314,6 +357,65 @@ static void _wapi_handle_init (struct _WapiHandleUnshared *handle,
 				sizeof (handle->u));
 		}
 	}
+
+	/* Searches don't take the handle lock, so only publish the
+	 * type once everything else is set up
+	 */
+	mono_memory_write_barrier ();
+	handle->type = type;
+}
+
+static gboolean _wapi_handle_try_claim (struct _WapiHandleUnshared *handle)
+{
+	return(InterlockedCompareExchange ((gint32 *)&handle->type,
+					   WAPI_HANDLE_CLAIMED,
+					   WAPI_HANDLE_UNUSED) == WAPI_HANDLE_UNUSED);
+}
+
+static WapiHandleCache *handle_cache_get (void)
+{
+	WapiHandleCache *cache = pthread_getspecific (handle_cache_key);
+
+	if (cache == NULL) {
+		cache = g_new0 (WapiHandleCache, 1);
+		pthread_setspecific (handle_cache_key, cache);
+	}
+
+	return(cache);
+}
+
+static void handle_cache_push (guint32 idx)
+{
+	WapiHandleCache *cache = handle_cache_get ();
+
+	if (cache->count < HANDLE_CACHE_SIZE) {
+		cache->idx [cache->count++] = idx;
+	}
+}
+
+/*
+ * _wapi_handle_new_cached:
+ *
+ * Lock-free version of _wapi_handle_new_internal () that only looks at
+ * the slots the calling thread freed recently.  Returns 0 if none of
+ * them could be claimed.
+ */
+static guint32 _wapi_handle_new_cached (WapiHandleType type,
+					gpointer handle_specific)
+{
+	WapiHandleCache *cache = handle_cache_get ();
+
+	while (cache->count > 0) {
+		guint32 idx = cache->idx [--cache->count];
+		struct _WapiHandleUnshared *handle = &_WAPI_PRIVATE_HANDLES(idx);
+
+		if (_wapi_handle_try_claim (handle)) {
+			_wapi_handle_init (handle, type, handle_specific);
+			return(idx);
+		}
+	}
+
+	return(0);
 }
 
 static guint32 _wapi_handle_new_shared (WapiHandleType type,
@@ -401,7 +503,12 @@ again:
 			for (k = SLOT_OFFSET (count); k < _WAPI_HANDLE_INITIAL_COUNT; k++) {
 				struct _WapiHandleUnshared *handle = &_wapi_private_handles [i][k];
 
-				if(handle->type == WAPI_HANDLE_UNUSED) {
+				/* Threads allocating from their
+				 * cache don't hold scan_mutex, so
+				 * claiming the slot must be atomic
+				 */
+				if(handle->type == WAPI_HANDLE_UNUSED &&
+				   _wapi_handle_try_claim (handle)) {
 					last = count + 1;
 			
 					_wapi_handle_init (handle, type, handle_specific);
@@ -436,6 +543,11 @@ static gpointer _wapi_handle_real_new (WapiHandleType type, gpointer handle_spec
 
 	g_assert(!_WAPI_FD_HANDLE(type));
 	
+	handle_idx = _wapi_handle_new_cached (type, handle_specific);
+	if (handle_idx != 0) {
+		goto got_slot;
+	}
+
 	pthread_cleanup_push ((void(*)(void *))mono_mutex_unlock_in_cleanup,
 			      (void *)&scan_mutex);
 	thr_ret = mono_mutex_lock (&scan_mutex);
@@ -464,7 +576,8 @@ static gpointer _wapi_handle_real_new (WapiHandleType type, gpointer handle_spec
 		handle = _WAPI_HANDLE_INVALID;
 		goto done;
 	}
-		
+
+got_slot:
 	/* Make sure we left the space for fd mappings */
 	g_assert (handle_idx >= _wapi_fd_reserve);
 	
@@ -697,6 +810,15 @@ gpointer _wapi_handle_new_fd (WapiHandleType type, int fd,
 	g_message ("%s: Assigning new fd handle %d", __func__, fd);
 #endif
 
+	if (type != WAPI_HANDLE_FILE) {
+		/* Only file handles are looked at by the file share
+		 * code, so sockets and pipes don't need the
+		 * (process-shared) lock below
+		 */
+		_wapi_handle_init (handle, type, handle_specific);
+		return(GUINT_TO_POINTER(fd));
+	}
+
 	/* Prevent file share entries racing with us, when the file
 	 * handle is only half initialised
 	 */
@@ -1086,6 +1208,7 @@ void _wapi_handle_unref (gpointer handle)
 		WapiHandleType type = _WAPI_PRIVATE_HANDLES(idx).type;
 		void (*close_func)(gpointer, gpointer) = _wapi_handle_ops_get_close_func (type);
 		gboolean is_shared = _WAPI_SHARED_HANDLE(type);
+		gboolean is_searched = _WAPI_SEARCHED_HANDLE(type);
 
 		if (is_shared) {
 			/* If this is a shared handle we need to take
@@ -1096,8 +1219,11 @@ void _wapi_handle_unref (gpointer handle)
 			g_assert (thr_ret == 0);
 		}
 		
-		pthread_cleanup_push ((void(*)(void *))mono_mutex_unlock_in_cleanup, (void *)&scan_mutex);
-		thr_ret = mono_mutex_lock (&scan_mutex);
+		if (is_searched) {
+			thr_ret = mono_mutex_lock (&scan_mutex);
+			g_assert (thr_ret == 0);
+		}
+		pthread_cleanup_push (scan_mutex_unlock_in_cleanup, is_searched ? (void *)&scan_mutex : NULL);
 
 #ifdef DEBUG
 		g_message ("%s: Destroying handle %p", __func__, handle);
@@ -1109,8 +1235,6 @@ void _wapi_handle_unref (gpointer handle)
 		memset (&_WAPI_PRIVATE_HANDLES(idx).u, '\0',
 			sizeof(_WAPI_PRIVATE_HANDLES(idx).u));
 
-		_WAPI_PRIVATE_HANDLES(idx).type = WAPI_HANDLE_UNUSED;
-		
 		if (!is_shared) {
 			/* Destroy the mutex and cond var.  We hope nobody
 			 * tried to grab them between the handle unlock and
@@ -1143,9 +1267,21 @@ void _wapi_handle_unref (gpointer handle)
 			}
 		}
 
-		thr_ret = mono_mutex_unlock (&scan_mutex);
-		g_assert (thr_ret == 0);
+		/* The slot can be claimed again as soon as the type
+		 * is reset, so this has to come last
+		 */
+		mono_memory_write_barrier ();
+		_WAPI_PRIVATE_HANDLES(idx).type = WAPI_HANDLE_UNUSED;
+
 		pthread_cleanup_pop (0);
+		if (is_searched) {
+			thr_ret = mono_mutex_unlock (&scan_mutex);
+			g_assert (thr_ret == 0);
+		}
+
+		if (!_WAPI_FD_HANDLE (type)) {
+			handle_cache_push (idx);
+		}
 
 		if (is_shared) {
 			_wapi_handle_unlock_shared_handles ();
@@ -1178,6 +1314,10 @@ gboolean _wapi_handle_test_capabilities (gpointer handle,
 	}
 	
 	type = _WAPI_PRIVATE_HANDLES(idx).type;
+	if (type >= WAPI_HANDLE_COUNT) {
+		/* Still being initialised */
+		return(FALSE);
+	}
 
 #ifdef DEBUG
 	g_message ("%s: testing 0x%x against 0x%x (%d)", __func__,
@@ -1189,6 +1329,10 @@ gboolean _wapi_handle_test_capabilities (gpointer handle,
 
 static void (*_wapi_handle_ops_get_close_func (WapiHandleType type))(gpointer, gpointer)
 {
+	if (type == WAPI_HANDLE_CLAIMED) {
+		return (NULL);
+	}
+
 	if (handle_ops[type] != NULL &&
 	    handle_ops[type]->close != NULL) {
 		return (handle_ops[type]->close);
@@ -1207,6 +1351,10 @@ void _wapi_handle_ops_close (gpointer handle, gpointer data)
 	}
 	
 	type = _WAPI_PRIVATE_HANDLES(idx).type;
+	if (type == WAPI_HANDLE_CLAIMED) {
+		/* Still being initialised */
+		return;
+	}
 
 	if (handle_ops[type] != NULL &&
 	    handle_ops[type]->close != NULL) {
@@ -1224,6 +1372,10 @@ void _wapi_handle_ops_signal (gpointer handle)
 	}
 	
 	type = _WAPI_PRIVATE_HANDLES(idx).type;
+	if (type == WAPI_HANDLE_CLAIMED) {
+		/* Still being initialised */
+		return;
+	}
 
 	if (handle_ops[type] != NULL && handle_ops[type]->signal != NULL) {
 		handle_ops[type]->signal (handle);
@@ -1240,6 +1392,10 @@ gboolean _wapi_handle_ops_own (gpointer handle)
 	}
 	
 	type = _WAPI_PRIVATE_HANDLES(idx).type;
+	if (type == WAPI_HANDLE_CLAIMED) {
+		/* Still being initialised */
+		return(FALSE);
+	}
 
 	if (handle_ops[type] != NULL && handle_ops[type]->own_handle != NULL) {
 		return(handle_ops[type]->own_handle (handle));
@@ -1258,6 +1414,10 @@ gboolean _wapi_handle_ops_isowned (gpointer handle)
 	}
 	
 	type = _WAPI_PRIVATE_HANDLES(idx).type;
+	if (type == WAPI_HANDLE_CLAIMED) {
+		/* Still being initialised */
+		return(FALSE);
+	}
 
 	if (handle_ops[type] != NULL && handle_ops[type]->is_owned != NULL) {
 		return(handle_ops[type]->is_owned (handle));
@@ -1276,6 +1436,10 @@ guint32 _wapi_handle_ops_special_wait (gpointer handle, guint32 timeout)
 	}
 	
 	type = _WAPI_PRIVATE_HANDLES(idx).type;
+	if (type == WAPI_HANDLE_CLAIMED) {
+		/* Still being initialised */
+		return(WAIT_FAILED);
+	}
 	
 	if (handle_ops[type] != NULL &&
 	    handle_ops[type]->special_wait != NULL) {
@@ -1295,6 +1459,10 @@ void _wapi_handle_ops_prewait (gpointer handle)
 	}
 	
 	type = _WAPI_PRIVATE_HANDLES (idx).type;
+	if (type == WAPI_HANDLE_CLAIMED) {
+		/* Still being initialised */
+		return;
+	}
 	
 	if (handle_ops[type] != NULL &&
 	    handle_ops[type]->prewait != NULL) {
@@ -1906,7 +2074,8 @@ void _wapi_handle_dump (void)
 			for (k = SLOT_OFFSET (0); k < _WAPI_HANDLE_INITIAL_COUNT; k++) {
 				handle_data = &_wapi_private_handles [i][k];
 
-				if (handle_data->type == WAPI_HANDLE_UNUSED) {
+				if (handle_data->type == WAPI_HANDLE_UNUSED ||
+				    handle_data->type == WAPI_HANDLE_CLAIMED) {
 					continue;
 				}
 		
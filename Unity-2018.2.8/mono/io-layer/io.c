@@ -379,10 +379,23 @@ static gboolean file_read(gpointer handle, gpointer buffer,
 		return(FALSE);
 	}
 
-	do {
-		ret = read (fd, buffer, numbytes);
-	} while (ret == -1 && errno == EINTR &&
-		 !_wapi_thread_cur_apc_pending());
+	if (overlapped != NULL) {
+		/* Positional read, which leaves the file pointer
+		 * alone so several threads can read the same handle
+		 */
+		off_t offset = (off_t)(((guint64)overlapped->OffsetHigh << 32) |
+				       overlapped->Offset);
+
+		do {
+			ret = pread (fd, buffer, numbytes, offset);
+		} while (ret == -1 && errno == EINTR &&
+			 !_wapi_thread_cur_apc_pending());
+	} else {
+		do {
+			ret = read (fd, buffer, numbytes);
+		} while (ret == -1 && errno == EINTR &&
+			 !_wapi_thread_cur_apc_pending());
+	}
 			
 	if(ret==-1) {
 		gint err = errno;
@@ -407,7 +420,7 @@ static gboolean file_read(gpointer handle, gpointer buffer,
 
 static gboolean file_write(gpointer handle, gconstpointer buffer,
 			   guint32 numbytes, guint32 *byteswritten,
-			   WapiOverlapped *overlapped G_GNUC_UNUSED)
+			   WapiOverlapped *overlapped)
 {
 	struct _WapiHandle_file *file_handle;
 	gboolean ok;
@@ -438,12 +451,19 @@ static gboolean file_write(gpointer handle, gconstpointer buffer,
 		return(FALSE);
 	}
 	
+	if (overlapped != NULL) {
+		current_pos = (off_t)(((guint64)overlapped->OffsetHigh << 32) |
+				      overlapped->Offset);
+	}
+	
 	if (lock_while_writing) {
 		/* Need to lock the region we're about to write to,
 		 * because we only do advisory locking on POSIX
 		 * systems
 		 */
-		current_pos = lseek (fd, (off_t)0, SEEK_CUR);
+		if (overlapped == NULL) {
+			current_pos = lseek (fd, (off_t)0, SEEK_CUR);
+		}
 		if (current_pos == -1) {
 #ifdef DEBUG
 			g_message ("%s: handle %p lseek failed: %s", __func__,
@@ -461,7 +481,12 @@ static gboolean file_write(gpointer handle, gconstpointer buffer,
 	}
 		
 	do {
-		ret = write (fd, buffer, numbytes);
+		if (overlapped != NULL) {
+			/* Positional write, see file_read () */
+			ret = pwrite (fd, buffer, numbytes, current_pos);
+		} else {
+			ret = write (fd, buffer, numbytes);
+		}
 	} while (ret == -1 && errno == EINTR &&
 		 !_wapi_thread_cur_apc_pending());
 	
@@ -2245,9 +2270,8 @@ gpointer GetStdHandle(WapiStdHandle stdhandle)
  * @bytesread: The actual number of bytes read is stored here.  This
  * value can be zero if the handle is positioned at the end of the
  * file.
- * @overlapped: points to a required %WapiOverlapped structure if
- * @handle has the %FILE_FLAG_OVERLAPPED option set, should be NULL
- * otherwise.
+ * @overlapped: points to a %WapiOverlapped structure holding the file
+ * position to use, or %NULL to use the current file position.
  *
  * If @handle does not have the %FILE_FLAG_OVERLAPPED option set, this
  * function reads up to @numbytes bytes from the file from the current
@@ -2255,9 +2279,10 @@ gpointer GetStdHandle(WapiStdHandle stdhandle)
  * bytes left in the file, just the amount available will be read.
  * The actual number of bytes read is stored in @bytesread.
 
- * If @handle has the %FILE_FLAG_OVERLAPPED option set, the current
- * file position is ignored and the read position is taken from data
- * in the @overlapped structure.
+ * If @overlapped is not %NULL, the current file position is ignored
+ * (and left unchanged) and the read position is taken from the Offset
+ * and OffsetHigh fields of the @overlapped structure.  This is only
+ * implemented for regular files.
  *
  * Return value: %TRUE if the read succeeds (even if no bytes were
  * read due to an attempt to read past the end of the file), %FALSE on
@@ -2291,9 +2316,8 @@ gboolean ReadFile(gpointer handle, gpointer buffer, guint32 numbytes,
  * @byteswritten: The actual number of bytes written is stored here.
  * If the handle is positioned at the file end, the length of the file
  * is extended.  This parameter may be %NULL.
- * @overlapped: points to a required %WapiOverlapped structure if
- * @handle has the %FILE_FLAG_OVERLAPPED option set, should be NULL
- * otherwise.
+ * @overlapped: points to a %WapiOverlapped structure holding the file
+ * position to use, or %NULL to use the current file position.
  *
  * If @handle does not have the %FILE_FLAG_OVERLAPPED option set, this
  * function writes up to @numbytes bytes from @buffer to the file at
@@ -2301,9 +2325,10 @@ gboolean ReadFile(gpointer handle, gpointer buffer, guint32 numbytes,
  * the file, the file is extended.  The actual number of bytes written
  * is stored in @byteswritten.
  *
- * If @handle has the %FILE_FLAG_OVERLAPPED option set, the current
- * file position is ignored and the write position is taken from data
- * in the @overlapped structure.
+ * If @overlapped is not %NULL, the current file position is ignored
+ * (and left unchanged) and the write position is taken from the
+ * Offset and OffsetHigh fields of the @overlapped structure.  This is
+ * only implemented for regular files.
  *
  * Return value: %TRUE if the write succeeds, %FALSE on error.
  */
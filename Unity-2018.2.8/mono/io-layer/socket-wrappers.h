@@ -71,6 +71,10 @@ extern int _wapi_send(guint32 handle, const void *msg, size_t len,
 extern int _wapi_sendto(guint32 handle, const void *msg, size_t len,
 			int send_flags, const struct sockaddr *to,
 			socklen_t tolen);
+extern int _wapi_recvmsgs(guint32 handle, struct msghdr *msgs,
+			  guint32 *lengths, int count, int recv_flags);
+extern int _wapi_sendmsgs(guint32 handle, const struct msghdr *msgs,
+			  guint32 *lengths, int count, int send_flags);
 extern int _wapi_setsockopt(guint32 handle, int level, int optname,
 			    const void *optval, socklen_t optlen);
 extern int _wapi_shutdown(guint32 handle, int how);
@@ -792,6 +792,232 @@ _wapi_sendmsg(guint32 fd,  const struct msghdr *msg, int send_flags)
 	return(ret);
 }
 
+#ifdef HAVE_RECVMMSG
+static gboolean recvmmsg_broken = FALSE;
+
+static int
+recvmsgs_mmsg (guint32 fd, struct msghdr *msgs, guint32 *lengths,
+	       int count, int recv_flags)
+{
+	struct mmsghdr *mmsgs = g_newa (struct mmsghdr, count);
+	int ret, i;
+
+	for (i = 0; i < count; i++) {
+		mmsgs [i].msg_hdr = msgs [i];
+		mmsgs [i].msg_len = 0;
+	}
+
+	/* MSG_WAITFORONE: only block until the first datagram
+	 * arrives, then take whatever else is already queued
+	 */
+	do {
+		ret = recvmmsg (fd, mmsgs, count, recv_flags | MSG_WAITFORONE,
+				NULL);
+	} while (ret == -1 && errno == EINTR &&
+		 !_wapi_thread_cur_apc_pending ());
+
+	for (i = 0; i < ret; i++) {
+		msgs [i] = mmsgs [i].msg_hdr;
+		lengths [i] = mmsgs [i].msg_len;
+	}
+
+	return(ret);
+}
+#endif
+
+#ifdef HAVE_SENDMMSG
+static gboolean sendmmsg_broken = FALSE;
+
+static int
+sendmsgs_mmsg (guint32 fd, const struct msghdr *msgs, guint32 *lengths,
+	       int count, int send_flags)
+{
+	struct mmsghdr *mmsgs = g_newa (struct mmsghdr, count);
+	int ret, i;
+
+	for (i = 0; i < count; i++) {
+		mmsgs [i].msg_hdr = msgs [i];
+		mmsgs [i].msg_len = 0;
+	}
+
+	do {
+		ret = sendmmsg (fd, mmsgs, count, send_flags);
+	} while (ret == -1 && errno == EINTR &&
+		 !_wapi_thread_cur_apc_pending ());
+
+	for (i = 0; i < ret; i++) {
+		lengths [i] = mmsgs [i].msg_len;
+	}
+
+	return(ret);
+}
+#endif
+
+/*
+ * _wapi_recvmsgs:
+ *
+ * Receive up to @count messages with as few system calls as possible
+ * (one, if recvmmsg () is available).  Only the first message is
+ * waited for; after that, whatever is already queued is returned.
+ * The size of each message is stored in @lengths.
+ *
+ * Returns the number of messages received, or SOCKET_ERROR if none
+ * could be.
+ */
+int _wapi_recvmsgs (guint32 fd, struct msghdr *msgs, guint32 *lengths,
+		    int count, int recv_flags)
+{
+	gpointer handle = GUINT_TO_POINTER (fd);
+	struct _WapiHandle_socket *socket_handle;
+	gboolean ok;
+	int ret = -1;
+	int i;
+	
+	if (startup_count == 0) {
+		WSASetLastError (WSANOTINITIALISED);
+		return(SOCKET_ERROR);
+	}
+	
+	if (_wapi_handle_type (handle) != WAPI_HANDLE_SOCKET) {
+		WSASetLastError (WSAENOTSOCK);
+		return(SOCKET_ERROR);
+	}
+
+	if (count <= 0) {
+		return(0);
+	}
+
+#ifdef HAVE_RECVMMSG
+	if (!recvmmsg_broken) {
+		ret = recvmsgs_mmsg (fd, msgs, lengths, count, recv_flags);
+		if (ret == -1 && errno == ENOSYS) {
+			/* Built against a newer libc than the kernel
+			 * supports
+			 */
+			recvmmsg_broken = TRUE;
+		} else {
+			goto done;
+		}
+	}
+#endif
+
+	for (i = 0; i < count; i++) {
+		int flags = i == 0 ? recv_flags : recv_flags | MSG_DONTWAIT;
+		int len;
+
+		do {
+			len = recvmsg (fd, &msgs [i], flags);
+		} while (len == -1 && errno == EINTR &&
+			 !_wapi_thread_cur_apc_pending ());
+
+		if (len == -1) {
+			break;
+		}
+		lengths [i] = len;
+	}
+	ret = i > 0 ? i : -1;
+
+#ifdef HAVE_RECVMMSG
+done:
+#endif
+	if (ret > 0 && lengths [0] == 0) {
+		/* see _wapi_recvfrom */
+		ok = _wapi_lookup_handle (handle, WAPI_HANDLE_SOCKET,
+					  (gpointer *)&socket_handle);
+		if (ok == FALSE || socket_handle->still_readable != 1) {
+			ret = -1;
+			errno = EINTR;
+		}
+	}
+	
+	if (ret == -1) {
+		gint errnum = errno;
+#ifdef DEBUG
+		g_message ("%s: recvmsgs error: %s", __func__, strerror(errno));
+#endif
+
+		errnum = errno_to_WSA (errnum, __func__);
+		WSASetLastError (errnum);
+		
+		return(SOCKET_ERROR);
+	}
+	return(ret);
+}
+
+/*
+ * _wapi_sendmsgs:
+ *
+ * Send up to @count messages with as few system calls as possible
+ * (one, if sendmmsg () is available).  The number of bytes sent from
+ * each message is stored in @lengths.
+ *
+ * Returns the number of messages sent, or SOCKET_ERROR if none could
+ * be.
+ */
+int _wapi_sendmsgs (guint32 fd, const struct msghdr *msgs, guint32 *lengths,
+		    int count, int send_flags)
+{
+	gpointer handle = GUINT_TO_POINTER (fd);
+	int ret = -1;
+	int i;
+	
+	if (startup_count == 0) {
+		WSASetLastError (WSANOTINITIALISED);
+		return(SOCKET_ERROR);
+	}
+	
+	if (_wapi_handle_type (handle) != WAPI_HANDLE_SOCKET) {
+		WSASetLastError (WSAENOTSOCK);
+		return(SOCKET_ERROR);
+	}
+
+	if (count <= 0) {
+		return(0);
+	}
+
+#ifdef HAVE_SENDMMSG
+	if (!sendmmsg_broken) {
+		ret = sendmsgs_mmsg (fd, msgs, lengths, count, send_flags);
+		if (ret == -1 && errno == ENOSYS) {
+			sendmmsg_broken = TRUE;
+		} else {
+			goto done;
+		}
+	}
+#endif
+
+	for (i = 0; i < count; i++) {
+		int len;
+
+		do {
+			len = sendmsg (fd, &msgs [i], send_flags);
+		} while (len == -1 && errno == EINTR &&
+			 !_wapi_thread_cur_apc_pending ());
+
+		if (len == -1) {
+			break;
+		}
+		lengths [i] = len;
+	}
+	ret = i > 0 ? i : -1;
+
+#ifdef HAVE_SENDMMSG
+done:
+#endif
+	if (ret == -1) {
+		gint errnum = errno;
+#ifdef DEBUG
+		g_message ("%s: sendmsgs error: %s", __func__, strerror (errno));
+#endif
+
+		errnum = errno_to_WSA (errnum, __func__);
+		WSASetLastError (errnum);
+		
+		return(SOCKET_ERROR);
+	}
+	return(ret);
+}
+
 int _wapi_setsockopt(guint32 fd, int level, int optname,
 		     const void *optval, socklen_t optlen)
 {
@@ -1128,7 +1354,34 @@ static gboolean wapi_disconnectex (guint32 fd, WapiOverlapped *overlapped,
 	return(socket_disconnect (fd));
 }
 
-#define SF_BUFFER_SIZE	16384
+#define SF_BUFFER_SIZE	65536
+
+/* Linux transfers at most this much per sendfile () call */
+#define SF_MAX_CHUNK	0x7ffff000
+
+#if defined(HAVE_SENDFILE) && (defined(__linux__) || defined(DARWIN))
+/*
+ * Wait for a non-blocking socket to drain, so sendfile () can carry
+ * on with the rest of the file.
+ */
+static gboolean
+sendfile_wait_writable (guint32 socket)
+{
+	struct pollfd pfd;
+	int ret;
+
+	pfd.fd = socket;
+	pfd.events = POLLOUT;
+	pfd.revents = 0;
+
+	do {
+		ret = poll (&pfd, 1, -1);
+	} while (ret == -1 && errno == EINTR && !_wapi_thread_cur_apc_pending ());
+
+	return(ret != -1);
+}
+#endif
+
 static gint
 wapi_sendfile (guint32 socket, gpointer fd, guint32 bytes_to_write, guint32 bytes_per_send, guint32 flags)
 {
@@ -1136,8 +1389,8 @@ wapi_sendfile (guint32 socket, gpointer fd, guint32 bytes_to_write, guint32 byte
 	gint file = GPOINTER_TO_INT (fd);
 	gint n;
 	gint errnum;
-	gssize res;
 	struct stat statbuf;
+	off_t offset, remaining;
 
 	n = fstat (file, &statbuf);
 	if (n == -1) {
@@ -1146,21 +1399,55 @@ wapi_sendfile (guint32 socket, gpointer fd, guint32 bytes_to_write, guint32 byte
 		WSASetLastError (errnum);
 		return SOCKET_ERROR;
 	}
-	do {
+
+	/* Send from the current file position to the end, like
+	 * TransmitFile does.  A single call is not enough: sendfile ()
+	 * can stop short (at 2GB on Linux, or whenever a non-blocking
+	 * socket fills up), so keep going until everything is out.
+	 */
+	offset = lseek (file, 0, SEEK_CUR);
+	if (offset == -1) {
+		offset = 0;
+	}
+	remaining = statbuf.st_size - offset;
+
+	while (remaining > 0) {
+		off_t sent;
+		gssize res;
+
 #ifdef __linux__
-		res = sendfile (socket, file, NULL, statbuf.st_size);
+		res = sendfile (socket, file, &offset, MIN (remaining, SF_MAX_CHUNK));
+		sent = res == -1 ? 0 : res;
 #elif defined(DARWIN)
 		/* TODO: header/tail could be sent in the 5th argument */
-		/* TODO: Might not send the entire file for non-blocking sockets */
-		res = sendfile (file, socket, 0, &statbuf.st_size, NULL, 0);
+		sent = remaining;
+		res = sendfile (file, socket, offset, &sent, NULL, 0);
+		offset += sent;
 #endif
-	} while (res != -1 && (errno == EINTR || errno == EAGAIN) && !_wapi_thread_cur_apc_pending ());
-	if (res == -1) {
-		errnum = errno;
-		errnum = errno_to_WSA (errnum, __func__);
-		WSASetLastError (errnum);
-		return SOCKET_ERROR;
+		remaining -= sent;
+
+		if (res == -1) {
+			if (errno == EINTR && !_wapi_thread_cur_apc_pending ()) {
+				continue;
+			}
+			if (errno == EAGAIN && sendfile_wait_writable (socket)) {
+				continue;
+			}
+
+			errnum = errno;
+			errnum = errno_to_WSA (errnum, __func__);
+			WSASetLastError (errnum);
+			return SOCKET_ERROR;
+		}
+
+		if (sent == 0) {
+			/* The file got shorter */
+			break;
+		}
 	}
+
+	/* The explicit offset doesn't move the file position */
+	lseek (file, offset, SEEK_SET);
 #else
 	/* Default implementation */
 	gint file = GPOINTER_TO_INT (fd);
@@ -1169,6 +1456,8 @@ wapi_sendfile (guint32 socket, gpointer fd, guint32 bytes_to_write, guint32 byte
 
 	buffer = g_malloc (SF_BUFFER_SIZE);
 	do {
+		gint written = 0;
+
 		do {
 			n = read (file, buffer, SF_BUFFER_SIZE);
 		} while (n == -1 && errno == EINTR && !_wapi_thread_cur_apc_pending ());
@@ -1178,9 +1467,22 @@ wapi_sendfile (guint32 socket, gpointer fd, guint32 bytes_to_write, guint32 byte
 			g_free (buffer);
 			return 0; /* We're done reading */
 		}
-		do {
-			n = send (socket, buffer, n, 0); /* short sends? enclose this in a loop? */
-		} while (n == -1 && errno == EINTR && !_wapi_thread_cur_apc_pending ());
+
+		/* send () can be short, so loop until the whole
+		 * chunk is out
+		 */
+		while (written < n) {
+			gint sent;
+
+			do {
+				sent = send (socket, buffer + written, n - written, 0);
+			} while (sent == -1 && errno == EINTR && !_wapi_thread_cur_apc_pending ());
+			if (sent == -1) {
+				n = -1;
+				break;
+			}
+			written += sent;
+		}
 	} while (n != -1);
 
 	if (n == -1) {
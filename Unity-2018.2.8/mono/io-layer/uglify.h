@@ -48,6 +48,7 @@ typedef gpointer HKEY;
 
 typedef WapiSecurityAttributes SECURITY_ATTRIBUTES;
 typedef WapiSecurityAttributes *LPSECURITY_ATTRIBUTES;
+typedef WapiOverlapped OVERLAPPED;
 typedef WapiOverlapped *LPOVERLAPPED;
 typedef WapiOverlappedCB LPOVERLAPPED_COMPLETION_ROUTINE;
 typedef WapiThreadStart LPTHREAD_START_ROUTINE;
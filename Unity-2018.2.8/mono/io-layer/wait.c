@@ -683,7 +683,12 @@ guint32 WaitForMultipleObjectsEx(guint32 numobjects, gpointer *handles,
 		 * (not lock, as we don't want exclusive access here)
 		 */
 		_wapi_handle_ref (handles[i]);
+
+		/* Ask signallers of this handle to wake us up */
+		_wapi_handle_add_multi_waiter (handles[i]);
 	}
+	/* Pairs with the barrier in _wapi_handle_set_signal_state () */
+	mono_memory_barrier ();
 
 	while(1) {
 		/* Prod all handles with prewait methods and
@@ -772,6 +777,8 @@ guint32 WaitForMultipleObjectsEx(guint32 numobjects, gpointer *handles,
 	}
 
 	for (i = 0; i < numobjects; i++) {
+		_wapi_handle_remove_multi_waiter (handles[i]);
+
 		/* Unref everything we reffed above */
 		_wapi_handle_unref (handles[i]);
 	}
@@ -126,6 +126,10 @@ struct _WapiHandleUnshared
 	gboolean signalled;
 	mono_mutex_t signal_mutex;
 	pthread_cond_t signal_cond;
+	/* Number of threads in WaitForMultipleObjects () waiting on this
+	 * handle, see _wapi_handle_set_signal_state ()
+	 */
+	volatile gint32 multi_waiters;
 	
 	union 
 	{
@@ -829,6 +829,12 @@ mono_classes_cleanup (void) MONO_INTERNAL;
 void
 mono_class_layout_fields   (MonoClass *klass) MONO_INTERNAL;
 
+void
+mono_class_register_simd_type (const char *name_space, const char *name) MONO_INTERNAL;
+
+gboolean
+mono_class_is_registered_simd_type (const char *name_space, const char *name) MONO_INTERNAL;
+
 void
 mono_class_setup_interface_offsets (MonoClass *klass) MONO_INTERNAL;
 
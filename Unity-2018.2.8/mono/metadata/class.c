@@ -60,6 +60,14 @@ guint32 classes_size, class_ext_size;
 /* Function supplied by the runtime to find classes by name using information from the AOT file */
 static MonoGetClassFromName get_class_from_name = NULL;
 
+/* Value types registered by the JIT as simd types, in addition to the Mono.Simd ones */
+typedef struct {
+	const char *name_space;
+	const char *name;
+} SimdTypeName;
+
+static GSList *simd_type_names;
+
 static MonoClass * mono_class_create_from_typedef (MonoImage *image, guint32 type_token);
 static gboolean mono_class_get_cached_class_info (MonoClass *klass, MonoCachedClassInfo *res);
 static gboolean can_access_type (MonoClass *access_klass, MonoClass *member_klass);
@@ -1559,6 +1567,66 @@ mono_type_get_basic_type_from_generic (MonoType *type)
 	return type;
 }
 
+/*
+ * mono_class_register_simd_type:
+ *
+ *   Register the value type NAME_SPACE.NAME as a simd type, whose values the JIT
+ * keeps in SIMD registers.  The type needs to have the layout of a Mono.Simd.Vector4f,
+ * types which don't are treated as normal value types.  Types loaded before the
+ * registration are not affected.  This needs to be called at startup, the list is
+ * read without locking.
+ */
+void
+mono_class_register_simd_type (const char *name_space, const char *name)
+{
+	SimdTypeName *entry = g_new0 (SimdTypeName, 1);
+
+	entry->name_space = g_strdup (name_space);
+	entry->name = g_strdup (name);
+	simd_type_names = g_slist_prepend (simd_type_names, entry);
+}
+
+gboolean
+mono_class_is_registered_simd_type (const char *name_space, const char *name)
+{
+	GSList *l;
+
+	for (l = simd_type_names; l; l = l->next) {
+		SimdTypeName *entry = l->data;
+
+		if (!strcmp (entry->name, name) && !strcmp (entry->name_space, name_space))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * simd_type_layout_is_valid:
+ *
+ *   Check that the registered simd type CLASS is laid out like a Vector4f:
+ * 4 float instance fields, filling 16 bytes.
+ */
+static gboolean
+simd_type_layout_is_valid (MonoClass *class)
+{
+	MonoClassField *field;
+	int i, count = 0;
+
+	if (class->image->assembly_name && !strcmp (class->image->assembly_name, "Mono.Simd"))
+		return TRUE;
+	if (class->instance_size - sizeof (MonoObject) != 16)
+		return FALSE;
+	for (i = 0; i < class->field.count; ++i) {
+		field = &class->fields [i];
+		if (field->type->attrs & FIELD_ATTRIBUTE_STATIC)
+			continue;
+		if (field->type->byref || field->type->type != MONO_TYPE_R4 || field->offset != sizeof (MonoObject) + count * 4)
+			return FALSE;
+		count ++;
+	}
+	return count == 4;
+}
+
 /*
  * mono_class_layout_fields:
  * @class: a class
@@ -1798,6 +1866,14 @@ mono_class_layout_fields (MonoClass *class)
 
 	class->size_inited = 1;
 
+	if (class->simd_type && !simd_type_layout_is_valid (class)) {
+		char *class_name = mono_type_get_full_name (class);
+
+		g_warning ("Type %s is registered as a simd type, but it isn't a struct of 4 float fields", class_name);
+		g_free (class_name);
+		class->simd_type = 0;
+	}
+
 	/*
 	 * Compute static field layout and size
 	 */
@@ -5074,6 +5150,9 @@ mono_class_create_from_typedef (MonoImage *image, guint32 type_token)
 	if (class->image->assembly_name && !strcmp (class->image->assembly_name, "Mono.Simd") && !strcmp (nspace, "Mono.Simd")) {
 		if (!strncmp (name, "Vector", 6))
 			class->simd_type = !strcmp (name + 6, "2d") || !strcmp (name + 6, "2ul") || !strcmp (name + 6, "2l") || !strcmp (name + 6, "4f") || !strcmp (name + 6, "4ui") || !strcmp (name + 6, "4i") || !strcmp (name + 6, "8s") || !strcmp (name + 6, "8us") || !strcmp (name + 6, "16b") || !strcmp (name + 6, "16sb");
+	} else if (simd_type_names && class->valuetype && !class->generic_container) {
+		/* The layout is checked by mono_class_layout_fields () */
+		class->simd_type = mono_class_is_registered_simd_type (nspace, name);
 	}
 
 	mono_loader_unlock ();
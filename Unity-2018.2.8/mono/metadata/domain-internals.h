@@ -126,6 +126,8 @@ struct _MonoJitInfo {
 	gboolean    has_generic_jit_info:1;
 	gboolean    from_aot:1;
 	gboolean    from_llvm:1;
+	/* Quick first-tier code, replaced by optimized code once the method is hot */
+	gboolean    tier0:1;
 #ifdef HAVE_SGEN_GC
 	/* FIXME: Embed this after the structure later */
 	gpointer    gc_info;
@@ -344,6 +346,9 @@ mono_jit_info_get_generic_sharing_context (MonoJitInfo *ji) MONO_INTERNAL;
 void
 mono_jit_info_set_generic_sharing_context (MonoJitInfo *ji, MonoGenericSharingContext *gsctx) MONO_INTERNAL;
 
+void
+mono_domain_shared_generic_init (void) MONO_INTERNAL;
+
 MonoJitInfo*
 mono_domain_lookup_shared_generic (MonoDomain *domain, MonoMethod *method) MONO_INTERNAL;
 
@@ -365,6 +370,12 @@ mono_domain_code_reserve (MonoDomain *domain, int size) MONO_INTERNAL;
 void*
 mono_domain_code_reserve_align (MonoDomain *domain, int size, int alignment) MONO_INTERNAL;
 
+void*
+mono_domain_code_reserve_pool (MonoDomain *domain, MonoCodePool pool, int size) MONO_INTERNAL;
+
+void*
+mono_domain_code_reserve_pool_align (MonoDomain *domain, MonoCodePool pool, int size, int alignment) MONO_INTERNAL;
+
 void
 mono_domain_code_commit (MonoDomain *domain, void *data, int size, int newsize) MONO_INTERNAL;
 
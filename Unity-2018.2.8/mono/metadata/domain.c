@@ -2122,6 +2122,41 @@ mono_domain_code_reserve_align (MonoDomain *domain, int size, int alignment)
 	return res;
 }
 
+/*
+ * mono_domain_code_reserve_pool:
+ *
+ *   Same as mono_domain_code_reserve (), but allocate from the placement pool POOL.
+ * LOCKING: Acquires the domain lock.
+ */
+void*
+mono_domain_code_reserve_pool (MonoDomain *domain, MonoCodePool pool, int size)
+{
+	gpointer res;
+
+	mono_domain_lock (domain);
+	res = mono_code_manager_reserve_pool (domain->code_mp, pool, size);
+	mono_domain_unlock (domain);
+
+	return res;
+}
+
+/*
+ * mono_domain_code_reserve_pool_align:
+ *
+ * LOCKING: Acquires the domain lock.
+ */
+void*
+mono_domain_code_reserve_pool_align (MonoDomain *domain, MonoCodePool pool, int size, int alignment)
+{
+	gpointer res;
+
+	mono_domain_lock (domain);
+	res = mono_code_manager_reserve_pool_align (domain->code_mp, pool, size, alignment);
+	mono_domain_unlock (domain);
+
+	return res;
+}
+
 /*
  * mono_domain_code_commit:
  *
@@ -773,6 +773,81 @@ ves_icall_System_IO_MonoIO_Write (HANDLE handle, MonoArray *src,
 	return (gint32)n;
 }
 
+gint32 
+ves_icall_System_IO_MonoIO_ReadAt (HANDLE handle, MonoArray *dest,
+				   gint32 dest_offset, gint32 count,
+				   gint64 position, gint32 *error)
+{
+	guchar *buffer;
+	gboolean result;
+	guint32 n;
+	OVERLAPPED ov;
+
+	MONO_ARCH_SAVE_REGS;
+
+	*error=ERROR_SUCCESS;
+	
+	if (dest_offset + count > mono_array_length (dest))
+		return 0;
+
+	/* The file position is passed in, so concurrent readers don't
+	 * need a Seek each (and a lock around the Seek/Read pair)
+	 */
+	memset (&ov, 0, sizeof (ov));
+	ov.Offset = position & 0xFFFFFFFF;
+	ov.OffsetHigh = position >> 32;
+
+	buffer = mono_array_addr (dest, guchar, dest_offset);
+	result = ReadFile (handle, buffer, count, &n, &ov);
+#ifdef PLATFORM_WIN32
+	if (!result && GetLastError () == ERROR_IO_PENDING)
+		result = GetOverlappedResult (handle, &ov, &n, TRUE);
+#endif
+
+	if (!result) {
+		*error=GetLastError ();
+		return -1;
+	}
+
+	return (gint32)n;
+}
+
+gint32 
+ves_icall_System_IO_MonoIO_WriteAt (HANDLE handle, MonoArray *src,
+				    gint32 src_offset, gint32 count,
+				    gint64 position, gint32 *error)
+{
+	guchar *buffer;
+	gboolean result;
+	guint32 n;
+	OVERLAPPED ov;
+
+	MONO_ARCH_SAVE_REGS;
+
+	*error=ERROR_SUCCESS;
+	
+	if (src_offset + count > mono_array_length (src))
+		return 0;
+
+	memset (&ov, 0, sizeof (ov));
+	ov.Offset = position & 0xFFFFFFFF;
+	ov.OffsetHigh = position >> 32;
+	
+	buffer = mono_array_addr (src, guchar, src_offset);
+	result = WriteFile (handle, buffer, count, &n, &ov);
+#ifdef PLATFORM_WIN32
+	if (!result && GetLastError () == ERROR_IO_PENDING)
+		result = GetOverlappedResult (handle, &ov, &n, TRUE);
+#endif
+
+	if (!result) {
+		*error=GetLastError ();
+		return -1;
+	}
+
+	return (gint32)n;
+}
+
 gint64 
 ves_icall_System_IO_MonoIO_Seek (HANDLE handle, gint64 offset, gint32 origin,
 				 gint32 *error)
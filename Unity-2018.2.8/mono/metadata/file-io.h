@@ -175,6 +175,16 @@ ves_icall_System_IO_MonoIO_Write (HANDLE handle, MonoArray *src,
 				  gint32 src_offset, gint32 count,
 				  gint32 *error) MONO_INTERNAL;
 
+extern gint32 
+ves_icall_System_IO_MonoIO_ReadAt (HANDLE handle, MonoArray *dest,
+				   gint32 dest_offset, gint32 count,
+				   gint64 position, gint32 *error) MONO_INTERNAL;
+
+extern gint32 
+ves_icall_System_IO_MonoIO_WriteAt (HANDLE handle, MonoArray *src,
+				    gint32 src_offset, gint32 count,
+				    gint64 position, gint32 *error) MONO_INTERNAL;
+
 extern gint64 
 ves_icall_System_IO_MonoIO_Seek (HANDLE handle, gint64 offset, gint32 origin,
 				 gint32 *error) MONO_INTERNAL;
@@ -1490,6 +1490,22 @@ mono_method_construct_object_context (MonoMethod *method)
 	return object_context;
 }
 
+static gint32 shared_generic_lookups;
+static gint32 failed_shared_generic_lookups;
+
+/*
+ * mono_domain_shared_generic_init:
+ *
+ *   Register the counters of mono_domain_lookup_shared_generic ().  This is
+ * done once at startup since the lookups run without the loader lock.
+ */
+void
+mono_domain_shared_generic_init (void)
+{
+	mono_counters_register ("Shared generic lookups", MONO_COUNTER_INT|MONO_COUNTER_GENERICS, &shared_generic_lookups);
+	mono_counters_register ("Failed shared generic lookups", MONO_COUNTER_INT|MONO_COUNTER_GENERICS, &failed_shared_generic_lookups);
+}
+
 /*
  * mono_domain_lookup_shared_generic:
  * @domain: a domain
@@ -1500,10 +1516,6 @@ mono_method_construct_object_context (MonoMethod *method)
 MonoJitInfo*
 mono_domain_lookup_shared_generic (MonoDomain *domain, MonoMethod *open_method)
 {
-	static gboolean inited = FALSE;
-	static int lookups = 0;
-	static int failed_lookups = 0;
-
 	MonoGenericContext object_context;
 	MonoMethod *object_method;
 	MonoJitInfo *ji;
@@ -1517,15 +1529,9 @@ mono_domain_lookup_shared_generic (MonoDomain *domain, MonoMethod *open_method)
 		ji = NULL;
 	mono_domain_jit_code_hash_unlock (domain);
 
-	if (!inited) {
-		mono_counters_register ("Shared generic lookups", MONO_COUNTER_INT|MONO_COUNTER_GENERICS, &lookups);
-		mono_counters_register ("Failed shared generic lookups", MONO_COUNTER_INT|MONO_COUNTER_GENERICS, &failed_lookups);
-		inited = TRUE;
-	}
-
-	++lookups;
+	InterlockedIncrement (&shared_generic_lookups);
 	if (!ji)
-		++failed_lookups;
+		InterlockedIncrement (&failed_shared_generic_lookups);
 
 	return ji;
 }
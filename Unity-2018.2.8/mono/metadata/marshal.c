@@ -119,6 +119,9 @@ mono_delegate_begin_invoke (MonoDelegate *delegate, gpointer *params);
 static MonoObject *
 mono_delegate_end_invoke (MonoDelegate *delegate, gpointer *params);
 
+static gboolean
+mono_delegate_get_invocation_list (MonoMulticastDelegate *del, MonoDelegate **list, gint32 len, gint32 param_count);
+
 static MonoObject *
 mono_marshal_xdomain_copy_value (MonoObject *val);
 
@@ -240,6 +243,7 @@ mono_marshal_init (void)
 		register_icall (mono_remoting_wrapper, "mono_remoting_wrapper", "object ptr ptr", FALSE);
 		register_icall (mono_delegate_begin_invoke, "mono_delegate_begin_invoke", "object object ptr", FALSE);
 		register_icall (mono_delegate_end_invoke, "mono_delegate_end_invoke", "object object ptr", FALSE);
+		register_icall (mono_delegate_get_invocation_list, "mono_delegate_get_invocation_list", "int32 object ptr int32 int32", FALSE);
 		register_icall (mono_marshal_xdomain_copy_value, "mono_marshal_xdomain_copy_value", "object object", FALSE);
 		register_icall (mono_marshal_xdomain_copy_out_value, "mono_marshal_xdomain_copy_out_value", "void object object", FALSE);
 		register_icall (mono_marshal_set_domain_by_id, "mono_marshal_set_domain_by_id", "int32 int32 int32", FALSE);
@@ -3725,6 +3729,48 @@ free_signature_method_pair (SignatureMethodPair *pair)
 	g_free (pair);
 }
 
+/*
+ * mono_delegate_get_invocation_list:
+ *
+ *   Store the LEN delegates in the chain of prev links of DEL into LIST, in
+ * invocation order. PARAM_COUNT is the number of parameters of the Invoke
+ * method of the delegate type. Return FALSE if one of them can't be called
+ * directly through its method_ptr by the delegate invoke wrapper, so it has to
+ * go through its Invoke method. Computes the method_ptr of the delegates which
+ * weren't invoked yet.
+ */
+static gboolean
+mono_delegate_get_invocation_list (MonoMulticastDelegate *del, MonoDelegate **list, gint32 len, gint32 param_count)
+{
+	/* The prev links point to the delegates which are invoked earlier */
+	for (; del && len > 0; del = del->prev) {
+		MonoDelegate *d = &del->delegate;
+		MonoMethod *method = d->method;
+		MonoMethodSignature *sig;
+
+		if (!method)
+			return FALSE;
+		sig = mono_method_signature (method);
+
+		/* Delegates which need a virtual call or a wrapper added by the delegate trampoline */
+		if (!d->target && (sig->hasthis || sig->param_count != param_count))
+			return FALSE;
+		if (d->target && mono_object_class (d->target) == mono_defaults.transparent_proxy_class)
+			return FALSE;
+		if ((method->iflags & METHOD_IMPL_ATTRIBUTE_SYNCHRONIZED) || mono_method_needs_static_rgctx_invoke (method, FALSE))
+			return FALSE;
+
+		if (!d->method_ptr) {
+			if (sig->hasthis && method->klass->valuetype)
+				method = mono_marshal_get_unbox_wrapper (method);
+			d->method_ptr = mono_compile_method (method);
+		}
+		list [--len] = d;
+	}
+
+	return TRUE;
+}
+
 /*
  * the returned method invokes all methods in a multicast delegate.
  */
@@ -3738,8 +3784,8 @@ mono_marshal_get_delegate_invoke (MonoMethod *method, MonoDelegate *del)
 	GHashTable *cache;
 	SignatureMethodPair key;
 	SignatureMethodPair *new_key;
-	int local_prev, local_target;
-	int pos0;
+	int local_prev, local_target, local_len, local_list, local_i, local_delegate;
+	int pos0, pos_recurse, pos_done, pos_static, pos_next, loop_start;
 	char *name;
 	MonoMethod *target_method = NULL;
 	MonoClass *target_class = NULL;
@@ -3800,14 +3846,30 @@ mono_marshal_get_delegate_invoke (MonoMethod *method, MonoDelegate *del)
 	/* allocate local 0 (object) */
 	local_target = mono_mb_add_local (mb, &mono_defaults.object_class->byval_arg);
 	local_prev = mono_mb_add_local (mb, &mono_defaults.object_class->byval_arg);
+	local_len = mono_mb_add_local (mb, &mono_defaults.int32_class->byval_arg);
+	local_list = mono_mb_add_local (mb, &mono_defaults.int_class->byval_arg);
+	local_i = mono_mb_add_local (mb, &mono_defaults.int32_class->byval_arg);
+	local_delegate = mono_mb_add_local (mb, &mono_defaults.object_class->byval_arg);
 
 	g_assert (sig->hasthis);
 	
 	/*
-	 * if (prev != null)
-         *	prev.Invoke( args .. );
+	 * if (prev != null) {
+	 *	for (len = 0, d = this; d != null; d = d.prev)
+	 *		len ++;
+	 *	list = localloc (len * sizeof (gpointer));
+	 *	if (mono_delegate_get_invocation_list (this, list, len, <param count>)) {
+	 *		for (i = 0; i < len - 1; ++i)
+	 *			list [i].<target>( args .. );
+	 *	} else {
+	 *		prev.Invoke( args .. );
+	 *	}
+	 * }
 	 * return this.<target>( args .. );
-         */
+	 *
+	 * The loop avoids recursing through the Invoke method of every delegate in
+	 * the chain of prev links.
+	 */
 	
 	/* this wrapper can be used in unmanaged-managed transitions */
 	emit_thread_interrupt_checkpoint (mb);
@@ -3822,11 +3884,100 @@ mono_marshal_get_delegate_invoke (MonoMethod *method, MonoDelegate *del)
 	/* if prev != null */
 	pos0 = mono_mb_emit_branch (mb, CEE_BRFALSE);
 
-	/* then recurse */
-
 	mono_mb_emit_byte (mb, MONO_CUSTOM_PREFIX);
 	mono_mb_emit_byte (mb, CEE_MONO_NOT_TAKEN);
 
+	/* for (len = 0, d = this; d != null; d = d.prev) len ++ */
+	mono_mb_emit_icon (mb, 0);
+	mono_mb_emit_stloc (mb, local_len);
+	mono_mb_emit_ldarg (mb, 0);
+	mono_mb_emit_stloc (mb, local_delegate);
+	loop_start = mb->pos;
+	mono_mb_emit_add_to_local (mb, local_len, 1);
+	mono_mb_emit_ldloc (mb, local_delegate);
+	mono_mb_emit_ldflda (mb, G_STRUCT_OFFSET (MonoMulticastDelegate, prev));
+	mono_mb_emit_byte (mb, CEE_LDIND_REF);
+	mono_mb_emit_stloc (mb, local_delegate);
+	mono_mb_emit_ldloc (mb, local_delegate);
+	mono_mb_emit_branch_label (mb, CEE_BRTRUE, loop_start);
+
+	/* list = localloc (len * sizeof (gpointer)) */
+	mono_mb_emit_ldloc (mb, local_len);
+	mono_mb_emit_icon (mb, sizeof (gpointer));
+	mono_mb_emit_byte (mb, CEE_MUL);
+	mono_mb_emit_byte (mb, CEE_PREFIX1);
+	mono_mb_emit_byte (mb, CEE_LOCALLOC);
+	mono_mb_emit_stloc (mb, local_list);
+
+	/* The Invoke signature is known here, so pass its parameter count instead of looking it up */
+	mono_mb_emit_ldarg (mb, 0);
+	mono_mb_emit_ldloc (mb, local_list);
+	mono_mb_emit_ldloc (mb, local_len);
+	mono_mb_emit_icon (mb, sig->param_count);
+	mono_mb_emit_icall (mb, mono_delegate_get_invocation_list);
+	pos_recurse = mono_mb_emit_branch (mb, CEE_BRFALSE);
+
+	mono_mb_emit_icon (mb, 0);
+	mono_mb_emit_stloc (mb, local_i);
+
+	/* for (i = 0; i < len - 1; ++i) */
+	loop_start = mb->pos;
+	mono_mb_emit_ldloc (mb, local_i);
+	mono_mb_emit_ldloc (mb, local_len);
+	mono_mb_emit_icon (mb, 1);
+	mono_mb_emit_byte (mb, CEE_SUB);
+	pos_done = mono_mb_emit_branch (mb, CEE_BGE);
+
+	/* d = list [i] */
+	mono_mb_emit_ldloc (mb, local_list);
+	mono_mb_emit_ldloc (mb, local_i);
+	mono_mb_emit_icon (mb, sizeof (gpointer));
+	mono_mb_emit_byte (mb, CEE_MUL);
+	mono_mb_emit_byte (mb, CEE_CONV_I);
+	mono_mb_emit_byte (mb, CEE_ADD);
+	mono_mb_emit_byte (mb, CEE_LDIND_REF);
+	mono_mb_emit_stloc (mb, local_delegate);
+
+	/* if d->target != null */
+	mono_mb_emit_ldloc (mb, local_delegate);
+	mono_mb_emit_ldflda (mb, G_STRUCT_OFFSET (MonoDelegate, target));
+	mono_mb_emit_byte (mb, CEE_LDIND_REF);
+	mono_mb_emit_stloc (mb, local_target);
+	mono_mb_emit_ldloc (mb, local_target);
+	pos_static = mono_mb_emit_branch (mb, CEE_BRFALSE);
+
+	/* then call d->method_ptr nonstatic */
+	mono_mb_emit_ldloc (mb, local_target);
+	for (i = 0; i < sig->param_count; ++i)
+		mono_mb_emit_ldarg (mb, i + 1);
+	mono_mb_emit_ldloc (mb, local_delegate);
+	mono_mb_emit_ldflda (mb, G_STRUCT_OFFSET (MonoDelegate, method_ptr));
+	mono_mb_emit_byte (mb, CEE_LDIND_I);
+	mono_mb_emit_op (mb, CEE_CALLI, sig);
+	if (sig->ret->type != MONO_TYPE_VOID)
+		mono_mb_emit_byte (mb, CEE_POP);
+	pos_next = mono_mb_emit_branch (mb, CEE_BR);
+
+	/* else call d->method_ptr static */
+	mono_mb_patch_branch (mb, pos_static);
+	for (i = 0; i < sig->param_count; ++i)
+		mono_mb_emit_ldarg (mb, i + 1);
+	mono_mb_emit_ldloc (mb, local_delegate);
+	mono_mb_emit_ldflda (mb, G_STRUCT_OFFSET (MonoDelegate, method_ptr));
+	mono_mb_emit_byte (mb, CEE_LDIND_I);
+	mono_mb_emit_op (mb, CEE_CALLI, static_sig);
+	if (sig->ret->type != MONO_TYPE_VOID)
+		mono_mb_emit_byte (mb, CEE_POP);
+
+	mono_mb_patch_branch (mb, pos_next);
+	mono_mb_emit_add_to_local (mb, local_i, 1);
+	mono_mb_emit_branch_label (mb, CEE_BR, loop_start);
+
+	mono_mb_patch_branch (mb, pos_done);
+	pos_next = mono_mb_emit_branch (mb, CEE_BR);
+
+	/* else recurse */
+	mono_mb_patch_branch (mb, pos_recurse);
 	mono_mb_emit_ldloc (mb, local_prev);
 	for (i = 0; i < sig->param_count; i++)
 		mono_mb_emit_ldarg (mb, i + 1);
@@ -3834,6 +3985,8 @@ mono_marshal_get_delegate_invoke (MonoMethod *method, MonoDelegate *del)
 	if (sig->ret->type != MONO_TYPE_VOID)
 		mono_mb_emit_byte (mb, CEE_POP);
 
+	mono_mb_patch_branch (mb, pos_next);
+
 	/* continued or prev == null */
 	mono_mb_patch_branch (mb, pos0);
 
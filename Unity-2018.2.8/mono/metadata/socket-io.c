@@ -1100,13 +1100,22 @@ static struct sockaddr *create_sockaddr_from_object(MonoObject *saddr_obj,
 						    socklen_t *sa_size,
 						    gint32 *error)
 {
+	MonoDomain *domain = mono_domain_get ();
 	MonoClassField *field;
 	MonoArray *data;
 	gint32 family;
 	int len;
 
-	/* Dig the SocketAddress data buffer out of the object */
-	field=mono_class_get_field_from_name(saddr_obj->vtable->klass, "data");
+	/* Dig the SocketAddress data buffer out of the object.  This
+	 * runs for every SendTo, so avoid the field lookup by name
+	 * whenever create_object_from_sockaddr () has already cached it
+	 */
+	if (saddr_obj->vtable->klass == domain->sockaddr_class &&
+	    domain->sockaddr_data_field) {
+		field = domain->sockaddr_data_field;
+	} else {
+		field=mono_class_get_field_from_name(saddr_obj->vtable->klass, "data");
+	}
 	data=*(MonoArray **)(((char *)saddr_obj) + field->offset);
 
 	/* The data buffer is laid out as follows:
@@ -1657,6 +1666,180 @@ gint32 ves_icall_System_Net_Sockets_Socket_SendTo_internal(SOCKET sock, MonoArra
 	return(ret);
 }
 
+#ifndef PLATFORM_WIN32
+/* Upper bound on the number of messages moved by one
+ * RecvFromMany_internal or SendToMany_internal call; the managed side
+ * calls again for the rest
+ */
+#define SOCKET_MAX_MSGS 64
+
+/*
+ * Each message i lives at buffer [offsets [i]] and is sizes [i] bytes
+ * long.  Returns the number of messages to transfer, or -1 if the
+ * arrays don't describe valid regions of the buffer.
+ */
+static int get_msg_count (MonoArray *buffer, MonoArray *offsets,
+			  MonoArray *sizes, MonoArray *sockaddrs)
+{
+	gint32 alen = mono_array_length (buffer);
+	int count = mono_array_length (offsets);
+	int i;
+
+	if (mono_array_length (sizes) < count) {
+		return(-1);
+	}
+	if (sockaddrs != NULL && mono_array_length (sockaddrs) < count) {
+		return(-1);
+	}
+	if (count > SOCKET_MAX_MSGS) {
+		count = SOCKET_MAX_MSGS;
+	}
+
+	for (i = 0; i < count; i++) {
+		gint32 offset = mono_array_get (offsets, gint32, i);
+		gint32 size = mono_array_get (sizes, gint32, i);
+
+		if (offset < 0 || size < 0 || offset > alen - size) {
+			return(-1);
+		}
+	}
+
+	return(count);
+}
+#endif
+
+gint32 ves_icall_System_Net_Sockets_Socket_RecvFromMany_internal(SOCKET sock, MonoArray *buffer, MonoArray *offsets, MonoArray *sizes, MonoArray *sockaddrs, gint32 flags, gint32 *error)
+{
+#ifdef PLATFORM_WIN32
+	*error = ERROR_NOT_SUPPORTED;
+	return(0);
+#else
+	struct msghdr msgs [SOCKET_MAX_MSGS];
+	struct iovec iovs [SOCKET_MAX_MSGS];
+	struct sockaddr_storage names [SOCKET_MAX_MSGS];
+	guint32 lengths [SOCKET_MAX_MSGS];
+	int recvflags;
+	int count, ret, i;
+	
+	MONO_ARCH_SAVE_REGS;
+
+	*error = 0;
+	
+	count = get_msg_count (buffer, offsets, sizes, sockaddrs);
+	if (count == -1) {
+		mono_raise_exception (mono_get_exception_index_out_of_range ());
+	}
+
+	recvflags = convert_socketflags (flags);
+	if (recvflags == -1) {
+		*error = WSAEOPNOTSUPP;
+		return (0);
+	}
+
+	memset (msgs, 0, sizeof (struct msghdr) * count);
+	for (i = 0; i < count; i++) {
+		iovs [i].iov_base = mono_array_addr (buffer, guchar, mono_array_get (offsets, gint32, i));
+		iovs [i].iov_len = mono_array_get (sizes, gint32, i);
+		msgs [i].msg_iov = &iovs [i];
+		msgs [i].msg_iovlen = 1;
+		if (sockaddrs != NULL) {
+			msgs [i].msg_name = &names [i];
+			msgs [i].msg_namelen = sizeof (names [i]);
+		}
+	}
+
+	ret = _wapi_recvmsgs (sock, msgs, lengths, count, recvflags);
+	if (ret == SOCKET_ERROR) {
+		*error = WSAGetLastError ();
+		return(0);
+	}
+
+	for (i = 0; i < ret; i++) {
+		mono_array_set (sizes, gint32, i, lengths [i]);
+
+		if (sockaddrs != NULL) {
+			MonoObject *sockaddr = NULL;
+
+			/* See RecvFrom_internal */
+			if (msgs [i].msg_namelen != 0) {
+				sockaddr = create_object_from_sockaddr ((struct sockaddr *)&names [i], msgs [i].msg_namelen, error);
+			}
+			mono_array_setref (sockaddrs, i, sockaddr);
+		}
+	}
+
+	return(ret);
+#endif
+}
+
+gint32 ves_icall_System_Net_Sockets_Socket_SendToMany_internal(SOCKET sock, MonoArray *buffer, MonoArray *offsets, MonoArray *sizes, MonoArray *sockaddrs, gint32 flags, gint32 *error)
+{
+#ifdef PLATFORM_WIN32
+	*error = ERROR_NOT_SUPPORTED;
+	return(0);
+#else
+	struct msghdr msgs [SOCKET_MAX_MSGS];
+	struct iovec iovs [SOCKET_MAX_MSGS];
+	guint32 lengths [SOCKET_MAX_MSGS];
+	int sendflags;
+	int count, ret = 0, i;
+	
+	MONO_ARCH_SAVE_REGS;
+
+	*error = 0;
+	
+	count = get_msg_count (buffer, offsets, sizes, sockaddrs);
+	if (count == -1) {
+		mono_raise_exception (mono_get_exception_index_out_of_range ());
+	}
+
+	sendflags = convert_socketflags (flags);
+	if (sendflags == -1) {
+		*error = WSAEOPNOTSUPP;
+		return (0);
+	}
+
+	memset (msgs, 0, sizeof (struct msghdr) * count);
+	for (i = 0; i < count; i++) {
+		iovs [i].iov_base = mono_array_addr (buffer, guchar, mono_array_get (offsets, gint32, i));
+		iovs [i].iov_len = mono_array_get (sizes, gint32, i);
+		msgs [i].msg_iov = &iovs [i];
+		msgs [i].msg_iovlen = 1;
+		if (sockaddrs != NULL) {
+			MonoObject *sockaddr = mono_array_get (sockaddrs, MonoObject *, i);
+			socklen_t sa_size;
+
+			/* A null entry sends to the connected peer */
+			if (sockaddr != NULL) {
+				msgs [i].msg_name = create_sockaddr_from_object (sockaddr, &sa_size, error);
+				if (*error != 0) {
+					goto done;
+				}
+				msgs [i].msg_namelen = sa_size;
+			}
+		}
+	}
+
+	ret = _wapi_sendmsgs (sock, msgs, lengths, count, sendflags);
+	if (ret == SOCKET_ERROR) {
+		*error = WSAGetLastError ();
+		ret = 0;
+		goto done;
+	}
+
+	for (i = 0; i < ret; i++) {
+		mono_array_set (sizes, gint32, i, lengths [i]);
+	}
+
+done:
+	for (i = 0; i < count; i++) {
+		g_free (msgs [i].msg_name);
+	}
+	
+	return(ret);
+#endif
+}
+
 static SOCKET Socket_to_SOCKET(MonoObject *sockobj)
 {
 	SOCKET sock;
@@ -3467,7 +3650,7 @@ ves_icall_System_Net_Sockets_Socket_SendFile (SOCKET sock, MonoString *filename,
 	if (filename == NULL)
 		return FALSE;
 
-	file = ves_icall_System_IO_MonoIO_Open (filename, FileMode_Open, FileAccess_Read, FileShare_Read, 0, &error);
+	file = ves_icall_System_IO_MonoIO_Open (filename, FileMode_Open, FileAccess_Read, FileShare_Read, FileOptions_SequentialScan, &error);
 	if (file == INVALID_HANDLE_VALUE) {
 		SetLastError (error);
 		return FALSE;
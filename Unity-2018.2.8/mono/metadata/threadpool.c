@@ -126,6 +126,7 @@ typedef struct {
 
 static void async_invoke_thread (gpointer data);
 static void append_job (CRITICAL_SECTION *cs, TPQueue *list, MonoObject *ar);
+static int append_jobs (CRITICAL_SECTION *cs, TPQueue *list, MonoObject **jobs, int count);
 static void start_thread_or_queue (MonoAsyncResult *ares);
 static void start_tpthread (MonoAsyncResult *ares);
 static void mono_async_invoke (MonoAsyncResult *ares);
@@ -410,36 +411,88 @@ start_io_thread_or_queue (MonoSocketAsyncResult *ares)
 	}
 }
 
+#ifdef HAVE_EPOLL
+/*
+ * Dispatch a batch of ready operations collected by the epoll thread.
+ * The threads we need to start are started one by one, but everything
+ * else goes into the io queue with a single lock acquisition and a
+ * single semaphore release.
+ */
+static void
+start_io_threads_or_queue (MonoSocketAsyncResult **states, int count)
+{
+	int busy, worker, i, queued;
+
+	if (count == 0)
+		return;
+
+	InterlockedExchangeAdd (&pending_io_items, count);
+	busy = (int) InterlockedCompareExchange (&busy_io_worker_threads, 0, -1);
+	worker = (int) InterlockedCompareExchange (&io_worker_threads, 0, -1);
+	for (i = 0; i < count; i++) {
+		if (worker > ++busy || worker >= mono_io_max_worker_threads)
+			break;
+		InterlockedIncrement (&busy_io_worker_threads);
+		InterlockedIncrement (&io_worker_threads);
+		worker++;
+		threadpool_jobs_inc ((MonoObject *)states [i]);
+		mono_thread_create_internal (mono_get_root_domain (), async_invoke_io_thread, states [i], TRUE);
+	}
+
+	queued = append_jobs (&io_queue_lock, &async_io_queue, (MonoObject **) states + i, count - i);
+	if (queued > 0)
+		ReleaseSemaphore (io_job_added, queued, NULL);
+}
+#endif
+
+/*
+ * Unlink the first operation in @list waiting for @event and return it
+ * in @state, or NULL if there is none or its domain is being unloaded.
+ * Returns the new head of the list.
+ */
 static MonoMList *
-process_io_event (MonoMList *list, int event)
+remove_io_event (MonoMList *list, int event, MonoSocketAsyncResult **state)
 {
-	MonoSocketAsyncResult *state;
+	MonoSocketAsyncResult *st;
 	MonoMList *oldlist;
 
+	*state = NULL;
 	oldlist = list;
-	state = NULL;
+	st = NULL;
 	while (list) {
-		state = (MonoSocketAsyncResult *) mono_mlist_get_data (list);
-		if (get_event_from_state (state) == event)
+		st = (MonoSocketAsyncResult *) mono_mlist_get_data (list);
+		if (get_event_from_state (st) == event)
 			break;
-		
+
 		list = mono_mlist_next (list);
 	}
 
 	if (list != NULL) {
 		oldlist = mono_mlist_remove_item (oldlist, list);
 #ifdef EPOLL_DEBUG
-		g_print ("Dispatching event %d on socket %d\n", event, state->handle);
+		g_print ("Dispatching event %d on socket %d\n", event, st->handle);
 #endif
-		if (!(mono_object_domain (state)->state == MONO_APPDOMAIN_UNLOADING || mono_object_domain (state)->state == MONO_APPDOMAIN_UNLOADED)) {
-			InterlockedIncrement (&pending_io_items);
-			start_io_thread_or_queue (state);
-		}
+		if (!(mono_object_domain (st)->state == MONO_APPDOMAIN_UNLOADING || mono_object_domain (st)->state == MONO_APPDOMAIN_UNLOADED))
+			*state = st;
 	}
 
 	return oldlist;
 }
 
+static MonoMList *
+process_io_event (MonoMList *list, int event)
+{
+	MonoSocketAsyncResult *state;
+
+	list = remove_io_event (list, event, &state);
+	if (state != NULL) {
+		InterlockedIncrement (&pending_io_items);
+		start_io_thread_or_queue (state);
+	}
+
+	return list;
+}
+
 static int
 mark_bad_fds (mono_pollfd *pfds, int nfds)
 {
@@ -605,6 +658,7 @@ socket_io_poll_main (gpointer p)
 
 #ifdef HAVE_EPOLL
 #define EPOLL_ERRORS (EPOLLERR | EPOLLHUP)
+#define EPOLL_NEVENTS 512
 static void
 socket_io_epoll_main (gpointer p)
 {
@@ -612,13 +666,20 @@ socket_io_epoll_main (gpointer p)
 	int epollfd;
 	MonoThread *thread;
 	struct epoll_event *events, *evt;
-	const int nevents = 512;
+	/*
+	 * Operations made ready by one epoll_wait () call. Every event can
+	 * complete at most one read and one write. This lives on the stack
+	 * so that the GC sees the states once they are unlinked from
+	 * sock_to_state and until they are queued.
+	 */
+	MonoSocketAsyncResult *ready_states [EPOLL_NEVENTS * 2];
+	int nready_states;
 	int ready = 0, i;
 
 	data = p;
 	epollfd = data->epollfd;
 	thread = mono_thread_current ();
-	events = g_new0 (struct epoll_event, nevents);
+	events = g_new0 (struct epoll_event, EPOLL_NEVENTS);
 
 	while (1) {
 		do {
@@ -629,7 +690,7 @@ socket_io_epoll_main (gpointer p)
 #ifdef EPOLL_DEBUG
 			g_print ("epoll_wait init\n");
 #endif
-			ready = epoll_wait (epollfd, events, nevents, -1);
+			ready = epoll_wait (epollfd, events, EPOLL_NEVENTS, -1);
 #ifdef EPOLL_DEBUG
 			{
 			int err = errno;
@@ -649,6 +710,7 @@ socket_io_epoll_main (gpointer p)
 			return;
 		}
 
+		nready_states = 0;
 		EnterCriticalSection (&data->io_lock);
 		if (data->inited == 0) {
 #ifdef EPOLL_DEBUG
@@ -660,8 +722,9 @@ socket_io_epoll_main (gpointer p)
 		}
 
 		for (i = 0; i < ready; i++) {
-			int fd;
+			int fd, old_events;
 			MonoMList *list;
+			MonoSocketAsyncResult *state;
 
 			evt = &events [i];
 			fd = evt->data.fd;
@@ -669,17 +732,25 @@ socket_io_epoll_main (gpointer p)
 #ifdef EPOLL_DEBUG
 			g_print ("Event %d on %d list length: %d\n", evt->events, fd, mono_mlist_length (list));
 #endif
+			old_events = get_events_from_list (list);
 			if (list != NULL && (evt->events & (EPOLLIN | EPOLL_ERRORS)) != 0) {
-				list = process_io_event (list, MONO_POLLIN);
+				list = remove_io_event (list, MONO_POLLIN, &state);
+				if (state != NULL)
+					ready_states [nready_states++] = state;
 			}
 
 			if (list != NULL && (evt->events & (EPOLLOUT | EPOLL_ERRORS)) != 0) {
-				list = process_io_event (list, MONO_POLLOUT);
+				list = remove_io_event (list, MONO_POLLOUT, &state);
+				if (state != NULL)
+					ready_states [nready_states++] = state;
 			}
 
 			if (list != NULL) {
 				mono_g_hash_table_replace (data->sock_to_state, GINT_TO_POINTER (fd), list);
 				evt->events = get_events_from_list (list);
+				/* Still interested in the same events: the registration is fine as it is */
+				if (evt->events == old_events)
+					continue;
 #ifdef EPOLL_DEBUG
 				g_print ("MOD %d to %d\n", fd, evt->events);
 #endif
@@ -701,6 +772,8 @@ socket_io_epoll_main (gpointer p)
 			}
 		}
 		LeaveCriticalSection (&data->io_lock);
+
+		start_io_threads_or_queue (ready_states, nready_states);
 	}
 }
 #endif
@@ -1253,26 +1326,13 @@ null_array (MonoArray *a, int first, int last)
 	memset (mono_array_addr (a, MonoObject*, first), 0, sizeof (MonoObject*) * (last - first));
 }
 
+/* Must be called with @cs held. Makes room for at least one more element. */
 static void
-append_job (CRITICAL_SECTION *cs, TPQueue *list, MonoObject *ar)
+grow_queue (TPQueue *list)
 {
-	if (mono_runtime_is_shutting_down())
+	if (list->array && (list->next_elem < mono_array_length (list->array)))
 		return;
 
-	threadpool_jobs_inc (ar); 
-
-	EnterCriticalSection (cs);
-	if (ar->vtable->domain->state == MONO_APPDOMAIN_UNLOADING ||
-			ar->vtable->domain->state == MONO_APPDOMAIN_UNLOADED) {
-		LeaveCriticalSection (cs);
-		return;
-	}
-	if (list->array && (list->next_elem < mono_array_length (list->array))) {
-		mono_array_setref (list->array, list->next_elem, ar);
-		list->next_elem++;
-		LeaveCriticalSection (cs);
-		return;
-	}
 	if (!list->array) {
 		MONO_GC_REGISTER_ROOT (list->array);
 		list->array = mono_array_new_cached (mono_get_root_domain (), mono_defaults.object_class, INITIAL_QUEUE_LENGTH);
@@ -1292,11 +1352,60 @@ append_job (CRITICAL_SECTION *cs, TPQueue *list, MonoObject *ar)
 		list->first_elem = 0;
 		list->next_elem = count;
 	}
+}
+
+static void
+append_job (CRITICAL_SECTION *cs, TPQueue *list, MonoObject *ar)
+{
+	if (mono_runtime_is_shutting_down())
+		return;
+
+	threadpool_jobs_inc (ar); 
+
+	EnterCriticalSection (cs);
+	if (ar->vtable->domain->state == MONO_APPDOMAIN_UNLOADING ||
+			ar->vtable->domain->state == MONO_APPDOMAIN_UNLOADED) {
+		LeaveCriticalSection (cs);
+		return;
+	}
+	grow_queue (list);
 	mono_array_setref (list->array, list->next_elem, ar);
 	list->next_elem++;
 	LeaveCriticalSection (cs);
 }
 
+/*
+ * Same as append_job () for @count jobs, taking @cs only once.
+ * Returns the number of jobs actually queued.
+ */
+static int
+append_jobs (CRITICAL_SECTION *cs, TPQueue *list, MonoObject **jobs, int count)
+{
+	int i, queued = 0;
+
+	if (count == 0 || mono_runtime_is_shutting_down())
+		return 0;
+
+	for (i = 0; i < count; i++)
+		threadpool_jobs_inc (jobs [i]);
+
+	EnterCriticalSection (cs);
+	for (i = 0; i < count; i++) {
+		MonoObject *ar = jobs [i];
+
+		if (ar->vtable->domain->state == MONO_APPDOMAIN_UNLOADING ||
+				ar->vtable->domain->state == MONO_APPDOMAIN_UNLOADED)
+			continue;
+		grow_queue (list);
+		mono_array_setref (list->array, list->next_elem, ar);
+		list->next_elem++;
+		queued++;
+	}
+	LeaveCriticalSection (cs);
+
+	return queued;
+}
+
 
 static void
 clear_queue (CRITICAL_SECTION *cs, TPQueue *list, MonoDomain *domain)
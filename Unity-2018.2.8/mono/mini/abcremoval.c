@@ -18,6 +18,7 @@
 #ifndef DISABLE_JIT
 
 #include "abcremoval.h"
+#include "ir-emit.h"
 
 #if SIZEOF_VOID_P == 8
 #define OP_PCONST OP_I8CONST
@@ -42,7 +43,6 @@
  */
 static int verbose_level;
 
-
 #define RELATION_BETWEEN_VALUES(value,related_value) (\
 	((value) > (related_value))? MONO_GT_RELATION :\
 	(((value) < (related_value))? MONO_LT_RELATION : MONO_EQ_RELATION))
@@ -946,8 +946,9 @@ remove_abc_from_inst (MonoInst *ins, MonoVariableRelationsEvaluationArea *area)
 		if (REPORT_ABC_REMOVAL) {
 			printf ("ARRAY-ACCESS: removed bounds check on array %d with index %d\n",
 					array_variable, index_variable);
-			NULLIFY_INS (ins);
 		}
+		NULLIFY_INS (ins);
+		mono_jit_stats.abc_checks_removed ++;
 	} else {
 		if (TRACE_ABC_REMOVAL) {
 			if (index_context->ranges.zero.lower >= 0) {
@@ -1264,4 +1265,637 @@ mono_perform_abc_removal (MonoCompile *cfg)
 	process_block (cfg, cfg->bblocks [0], &area);
 }
 
+/*
+ * Bounds check removal in counted loops.
+ *
+ * The pass above needs SSA, which is not enabled by default.  This one runs after SSA
+ * has been removed, on loops whose body is a single bblock, like
+ *
+ *   for (i = start; i < bound; ++i)
+ *       ... a [i] ... this.b [i] ...
+ *
+ * where bound is a constant, a variable or the length of an array, and the only
+ * assignment to i in the loop is the increment at the end of the body.  It handles the
+ * bounds checks on arrays indexed by i which come before the increment:
+ * - if the loop tests i < a.Length on a local a before the body and start is a constant
+ *   >= 0, the checks on a can't fail and are removed.
+ * - otherwise, if the loop contains no calls, it is versioned: a copy without the checks
+ *   is placed in front of it, behind guards which check that start >= 0 and that every
+ *   array is non null and at least bound long.  If a guard fails, the original loop
+ *   runs.  Arrays stored in a field are loaded once by the guards, so this is only done
+ *   if the loop doesn't store to anything but array elements.
+ */
+
+#define LOOP_ABC_MAX_ARRAYS 8
+#define LOOP_ABC_MAX_CHECKS 32
+/* Don't duplicate loops bigger than this */
+#define LOOP_ABC_MAX_CLONE_SIZE 200
+
+#if defined(TARGET_AMD64)
+#define OP_ABC_COMPARE_MEMBASE OP_AMD64_ICOMPARE_MEMBASE_REG
+#elif defined(TARGET_X86)
+#define OP_ABC_COMPARE_MEMBASE OP_X86_COMPARE_MEMBASE_REG
+#endif
+
+typedef struct {
+	/* the array var, or the object var holding the field, -1 for a static field */
+	int var;
+	/* the offset of the field, or -1 */
+	int offset;
+	/* the address of the static field */
+	gpointer addr;
+	/* the var holding the array in the versioned loop */
+	int hoisted;
+} LoopAbcArray;
+
+typedef struct {
+	MonoInst *def;
+	int defs;
+	/* the address of an array element */
+	gboolean elem_addr;
+} LoopAbcReg;
+
+typedef struct {
+	MonoCompile *cfg;
+	/* the loop is test -> body -> test, or a single body -> body bblock when test == body */
+	MonoBasicBlock *test, *body, *exit, *pred;
+	LoopAbcReg *regs;
+	int iv;
+	MonoInst *update;
+	int bound_reg, bound_imm, bound_array;
+	LoopAbcArray arrays [LOOP_ABC_MAX_ARRAYS];
+	int num_arrays;
+	MonoInst *checks [LOOP_ABC_MAX_CHECKS];
+	int check_arrays [LOOP_ABC_MAX_CHECKS];
+	int num_checks;
+	int size;
+	gboolean has_calls, has_stores;
+} LoopAbc;
+
+static void
+loop_abc_scan_defs (LoopAbc *la, MonoBasicBlock *bb)
+{
+	MonoInst *ins;
+
+	for (ins = bb->code; ins; ins = ins->next) {
+		const char *spec = INS_INFO (ins->opcode);
+
+		la->size ++;
+		if (spec [MONO_INST_DEST] != ' ' && ins->dreg != -1 && !MONO_IS_STORE_MEMBASE (ins)) {
+			la->regs [ins->dreg].defs ++;
+			la->regs [ins->dreg].def = ins;
+		}
+		/* &array [i], from mini_emit_ldelema_1_ins () */
+		if (ins->opcode == OP_X86_LEA && ins->inst_imm == G_STRUCT_OFFSET (MonoArray, vector))
+			la->regs [ins->dreg].elem_addr = TRUE;
+	}
+}
+
+/* Look for instructions which prevent the loop from being versioned */
+static void
+loop_abc_scan_effects (LoopAbc *la, MonoBasicBlock *bb)
+{
+	MonoInst *ins;
+
+	for (ins = bb->code; ins; ins = ins->next) {
+		if (MONO_IS_CALL (ins) || MONO_IS_JUMP_TABLE (ins) || ins->opcode == OP_BR_REG || ins->opcode == OP_SEQ_POINT || ins->opcode == OP_LOCALLOC) {
+			la->has_calls = TRUE;
+		} else if (MONO_IS_STORE_MEMBASE (ins)) {
+			LoopAbcReg *r = &la->regs [ins->inst_destbasereg];
+
+			/* Stores to array elements can't change a field or the length of an array */
+			if (get_vreg_to_inst (la->cfg, ins->inst_destbasereg) || r->defs != 1 || !r->elem_addr)
+				la->has_stores = TRUE;
+		} else if (MONO_IS_STORE_MEMINDEX (ins) || ins->opcode == OP_MEMCPY || ins->opcode == OP_MEMSET) {
+			la->has_stores = TRUE;
+		} else if (ins->opcode >= OP_ATOMIC_ADD_I4 && ins->opcode <= OP_ATOMIC_CAS_I8) {
+			/* Includes OP_MEMORY_BARRIER */
+			la->has_stores = TRUE;
+		}
+	}
+}
+
+static gboolean
+loop_abc_is_invariant (LoopAbc *la, int vreg)
+{
+	MonoInst *var = get_vreg_to_inst (la->cfg, vreg);
+
+	return var && la->regs [vreg].defs == 0 && !(var->flags & (MONO_INST_VOLATILE|MONO_INST_INDIRECT));
+}
+
+/* Follow the copies of local vregs made in the loop */
+static int
+loop_abc_copy_of (LoopAbc *la, int vreg)
+{
+	while (vreg != -1 && !get_vreg_to_inst (la->cfg, vreg) && la->regs [vreg].defs == 1 && la->regs [vreg].def->opcode == OP_MOVE)
+		vreg = la->regs [vreg].def->sreg1;
+	return vreg;
+}
+
+/* Return whenever VREG holds the induction variable, possibly sign extended */
+static gboolean
+loop_abc_is_index (LoopAbc *la, int vreg)
+{
+	while (vreg != la->iv) {
+		if (vreg == -1 || get_vreg_to_inst (la->cfg, vreg) || la->regs [vreg].defs != 1)
+			return FALSE;
+		if (la->regs [vreg].def->opcode != OP_MOVE && la->regs [vreg].def->opcode != OP_SEXT_I4)
+			return FALSE;
+		vreg = la->regs [vreg].def->sreg1;
+	}
+	return TRUE;
+}
+
+/*
+ * Return the index in la->arrays of the array VREG holds, which is either a var or a
+ * field load, or -1 if it is not known to be the same array in every iteration.
+ */
+static int
+loop_abc_array (LoopAbc *la, int vreg)
+{
+	LoopAbcArray key;
+	MonoInst *var, *def;
+	int i;
+
+	key.var = key.offset = -1;
+	key.addr = NULL;
+	key.hoisted = -1;
+
+	vreg = loop_abc_copy_of (la, vreg);
+	if (vreg == -1)
+		return -1;
+	var = get_vreg_to_inst (la->cfg, vreg);
+	if (var) {
+		if (!loop_abc_is_invariant (la, vreg) || var->type != STACK_OBJ)
+			return -1;
+		key.var = vreg;
+	} else {
+		def = la->regs [vreg].def;
+		/* volatile. loads have to be done in every iteration */
+		if (la->regs [vreg].defs != 1 || def->opcode != OP_LOAD_MEMBASE || (def->flags & MONO_INST_VOLATILE))
+			return -1;
+		key.offset = def->inst_offset;
+		var = get_vreg_to_inst (la->cfg, def->inst_basereg);
+		if (var) {
+			if (!loop_abc_is_invariant (la, def->inst_basereg) || var->type != STACK_OBJ)
+				return -1;
+			key.var = def->inst_basereg;
+		} else if (la->regs [def->inst_basereg].defs == 1 && la->regs [def->inst_basereg].def->opcode == OP_PCONST) {
+			key.addr = la->regs [def->inst_basereg].def->inst_p0;
+		} else {
+			return -1;
+		}
+	}
+
+	for (i = 0; i < la->num_arrays; ++i) {
+		if (la->arrays [i].var == key.var && la->arrays [i].offset == key.offset && la->arrays [i].addr == key.addr)
+			return i;
+	}
+	if (la->num_arrays == LOOP_ABC_MAX_ARRAYS)
+		return -1;
+	la->arrays [la->num_arrays] = key;
+	return la->num_arrays ++;
+}
+
+/* Return the index in la->arrays of the field INS loads, or -1.  volatile. loads are kept. */
+static int
+loop_abc_field (LoopAbc *la, MonoInst *ins)
+{
+	MonoInst *def;
+	int i;
+
+	if (ins->opcode != OP_LOAD_MEMBASE || (ins->flags & MONO_INST_VOLATILE))
+		return -1;
+	for (i = 0; i < la->num_arrays; ++i) {
+		LoopAbcArray *a = &la->arrays [i];
+
+		if (a->offset != ins->inst_offset)
+			continue;
+		if (a->var != -1 && a->var == ins->inst_basereg)
+			return i;
+		if (a->var == -1 && !get_vreg_to_inst (la->cfg, ins->inst_basereg)) {
+			def = la->regs [ins->inst_basereg].def;
+			if (def && def->opcode == OP_PCONST && def->inst_p0 == a->addr)
+				return i;
+		}
+	}
+	return -1;
+}
+
+/* Return whenever the induction variable is set to a constant >= 0 before the loop */
+static gboolean
+loop_abc_start_non_negative (LoopAbc *la)
+{
+	MonoInst *ins;
+	int reg = la->iv;
+
+	for (ins = la->pred->last_ins; ins; ins = ins->prev) {
+		if (ins->dreg != reg || INS_INFO (ins->opcode) [MONO_INST_DEST] == ' ' || MONO_IS_STORE_MEMBASE (ins))
+			continue;
+		if (ins->opcode == OP_ICONST)
+			return ins->inst_c0 >= 0;
+		if (ins->opcode != OP_MOVE)
+			return FALSE;
+		reg = ins->sreg1;
+	}
+	return FALSE;
+}
+
+/*
+ * Match the induction variable update at the end of the body, either
+ * IADD_IMM iv <- iv 1 or IADD_IMM t <- iv 1; MOVE iv <- t.
+ * Return the first instruction of the update.
+ */
+static MonoInst*
+loop_abc_match_update (LoopAbc *la, MonoInst *def)
+{
+	if (def->opcode == OP_MOVE) {
+		int reg = def->sreg1;
+
+		if (get_vreg_to_inst (la->cfg, reg) || la->regs [reg].defs != 1)
+			return NULL;
+		def = la->regs [reg].def;
+	}
+	if (def->opcode != OP_IADD_IMM || def->sreg1 != la->iv || def->inst_imm != 1)
+		return NULL;
+	return def;
+}
+
+/* The bounds check starting at INS, on la->arrays [*array], or NULL */
+static MonoInst*
+loop_abc_match_check (LoopAbc *la, MonoInst *ins, int *array)
+{
+	if (ins->opcode == OP_BOUNDS_CHECK) {
+		if (ins->inst_imm != G_STRUCT_OFFSET (MonoArray, max_length) || !loop_abc_is_index (la, ins->sreg2))
+			return NULL;
+		*array = loop_abc_array (la, ins->sreg1);
+		return *array != -1 ? ins : NULL;
+	}
+#ifdef OP_ABC_COMPARE_MEMBASE
+	/* From MONO_ARCH_EMIT_BOUNDS_CHECK */
+	if (ins->opcode == OP_ABC_COMPARE_MEMBASE) {
+		if (ins->inst_offset != G_STRUCT_OFFSET (MonoArray, max_length) || !loop_abc_is_index (la, ins->sreg2))
+			return NULL;
+		if (!ins->next || ins->next->opcode != OP_COND_EXC_LE_UN)
+			return NULL;
+		*array = loop_abc_array (la, ins->inst_basereg);
+		return *array != -1 ? ins : NULL;
+	}
+#endif
+	return NULL;
+}
+
+static gboolean
+loop_abc_is_check (LoopAbc *la, MonoInst *ins)
+{
+	int i;
+
+	for (i = 0; i < la->num_checks; ++i) {
+		if (la->checks [i] == ins)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+loop_abc_remove_check (MonoInst *ins)
+{
+	if (ins->opcode != OP_BOUNDS_CHECK)
+		NULLIFY_INS (ins->next);
+	NULLIFY_INS (ins);
+}
+
+static MonoBasicBlock*
+loop_abc_new_bblock (LoopAbc *la)
+{
+	MonoBasicBlock *bb;
+
+	NEW_BBLOCK (la->cfg, bb);
+	bb->region = la->test->region;
+	bb->real_offset = la->test->real_offset;
+	bb->nesting = la->body->nesting;
+	return bb;
+}
+
+/* Branch to the original loop if the compare in cfg->cbb is true, continue in a new bblock otherwise */
+static void
+loop_abc_emit_guard (LoopAbc *la, int opcode)
+{
+	MonoCompile *cfg = la->cfg;
+	MonoBasicBlock *next = loop_abc_new_bblock (la);
+
+	MONO_EMIT_NEW_BRANCH_BLOCK2 (cfg, opcode, la->test, next);
+	cfg->cbb->next_bb = next;
+	cfg->cbb = next;
+}
+
+/* Compare REG with the loop bound */
+static void
+loop_abc_emit_compare_bound (LoopAbc *la, int reg)
+{
+	MonoCompile *cfg = la->cfg;
+
+	if (la->bound_reg != -1)
+		MONO_EMIT_NEW_BIALU (cfg, OP_ICOMPARE, -1, reg, la->bound_reg);
+	else
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ICOMPARE_IMM, -1, reg, la->bound_imm);
+}
+
+/*
+ * Copy BB without the bounds checks, loading the arrays stored in fields from the
+ * hoisted vars.  The local vregs are shared with the original, they can't be live
+ * outside of a bblock.  Branches are fixed up by the caller.
+ */
+static MonoBasicBlock*
+loop_abc_clone_bblock (LoopAbc *la, MonoBasicBlock *bb)
+{
+	MonoCompile *cfg = la->cfg;
+	MonoBasicBlock *clone = loop_abc_new_bblock (la);
+	MonoInst *ins, *copy;
+	int array;
+
+	clone->has_array_access = bb->has_array_access;
+	for (ins = bb->code; ins; ins = ins->next) {
+		if (ins->opcode == OP_NOP)
+			continue;
+		if (loop_abc_is_check (la, ins)) {
+			if (ins->opcode != OP_BOUNDS_CHECK)
+				ins = ins->next;
+			continue;
+		}
+		array = loop_abc_field (la, ins);
+		if (array != -1) {
+			MONO_INST_NEW (cfg, copy, OP_MOVE);
+			copy->dreg = ins->dreg;
+			copy->sreg1 = la->arrays [array].hoisted;
+			copy->type = ins->type;
+			copy->cil_code = ins->cil_code;
+		} else {
+			MONO_INST_NEW (cfg, copy, ins->opcode);
+			*copy = *ins;
+			copy->next = copy->prev = NULL;
+			if (MONO_IS_COND_BRANCH_OP (ins))
+				copy->inst_many_bb = mono_mempool_alloc (cfg->mempool, sizeof (MonoBasicBlock*) * 2);
+		}
+		MONO_ADD_INS (clone, copy);
+	}
+	return clone;
+}
+
+static gboolean
+loop_abc_loop (MonoCompile *cfg, MonoBasicBlock *test, MonoBasicBlock *body)
+{
+	LoopAbc la_data, *la = &la_data;
+	MonoBasicBlock *pred, *first, *ctest, *cbody, *next;
+	MonoInst *branch, *cmp, *ins, *var, *check;
+	int i, n, reg, array;
+
+	memset (la, 0, sizeof (LoopAbc));
+	la->cfg = cfg;
+	la->test = test;
+	la->body = body;
+	la->bound_reg = la->bound_array = -1;
+
+	branch = test->last_ins;
+	cmp = branch->prev;
+	if (!cmp || (cmp->opcode != OP_ICOMPARE && cmp->opcode != OP_ICOMPARE_IMM))
+		return FALSE;
+	la->exit = branch->inst_false_bb;
+	if (!la->exit || la->exit == test || la->exit == body)
+		return FALSE;
+	if (test != body && body->last_ins && MONO_IS_BRANCH_OP (body->last_ins) && body->last_ins->opcode != OP_BR)
+		return FALSE;
+
+	/* The only edge into the loop from outside */
+	if (test->in_count != 2)
+		return FALSE;
+	pred = test->in_bb [0] == body ? test->in_bb [1] : test->in_bb [0];
+	if (pred == test || pred == body || pred->region != test->region)
+		return FALSE;
+	if (pred->last_ins && MONO_IS_BRANCH_OP (pred->last_ins)) {
+		if (pred->last_ins->opcode == OP_BR_REG || pred->last_ins->opcode == OP_SWITCH)
+			return FALSE;
+		if (MONO_IS_COND_BRANCH_OP (pred->last_ins) && !pred->last_ins->inst_false_bb)
+			return FALSE;
+	} else if (pred->next_bb != test) {
+		return FALSE;
+	}
+	la->pred = pred;
+
+	la->regs = mono_mempool_alloc0 (cfg->mempool, sizeof (LoopAbcReg) * cfg->next_vreg);
+	loop_abc_scan_defs (la, test);
+	if (test != body)
+		loop_abc_scan_defs (la, body);
+
+	/* The induction variable, a single bblock loop compares it after the update */
+	reg = loop_abc_copy_of (la, cmp->sreg1);
+	if (test == body && reg != -1 && !get_vreg_to_inst (cfg, reg) && la->regs [reg].defs == 1 && la->regs [reg].def->opcode == OP_IADD_IMM)
+		reg = la->regs [reg].def->sreg1;
+	var = reg != -1 ? get_vreg_to_inst (cfg, reg) : NULL;
+	if (!var || var->type != STACK_I4 || (var->flags & (MONO_INST_VOLATILE|MONO_INST_INDIRECT)) || la->regs [reg].defs != 1)
+		return FALSE;
+	la->iv = reg;
+	la->update = loop_abc_match_update (la, la->regs [reg].def);
+	if (!la->update)
+		return FALSE;
+
+	/* The loop bound */
+	if (cmp->opcode == OP_ICOMPARE_IMM) {
+		la->bound_imm = cmp->inst_imm;
+	} else {
+		reg = loop_abc_copy_of (la, cmp->sreg2);
+		var = reg != -1 ? get_vreg_to_inst (cfg, reg) : NULL;
+		if (var) {
+			if (!loop_abc_is_invariant (la, reg) || var->type != STACK_I4)
+				return FALSE;
+			la->bound_reg = reg;
+		} else if (reg != -1 && la->regs [reg].defs == 1 && la->regs [reg].def->opcode == OP_LDLEN) {
+			la->bound_array = loop_abc_array (la, la->regs [reg].def->sreg1);
+			if (la->bound_array == -1)
+				return FALSE;
+		} else {
+			return FALSE;
+		}
+	}
+
+	/* The checks done before the update, while i < bound holds */
+	for (ins = body->code; ins != la->update; ins = ins->next) {
+		if (!ins)
+			return FALSE;
+		check = loop_abc_match_check (la, ins, &array);
+		if (check && la->num_checks < LOOP_ABC_MAX_CHECKS) {
+			la->checks [la->num_checks] = check;
+			la->check_arrays [la->num_checks ++] = array;
+		}
+	}
+	if (la->num_checks == 0)
+		return FALSE;
+
+	/* Checks against the array the loop is bounded by */
+	if (test != body && la->bound_array != -1 && la->arrays [la->bound_array].offset == -1 && loop_abc_start_non_negative (la)) {
+		n = 0;
+		for (i = 0; i < la->num_checks; ++i) {
+			if (la->check_arrays [i] == la->bound_array) {
+				loop_abc_remove_check (la->checks [i]);
+			} else {
+				la->checks [n] = la->checks [i];
+				la->check_arrays [n ++] = la->check_arrays [i];
+			}
+		}
+		if (cfg->verbose_level > 1)
+			printf ("ABCREM: removed %d bounds checks from loop BB%d in %s\n", la->num_checks - n, body->block_num, mono_method_full_name (cfg->method, TRUE));
+		mono_jit_stats.abc_checks_removed += la->num_checks - n;
+		la->num_checks = n;
+	}
+	if (la->num_checks == 0)
+		return FALSE;
+
+	/* Version the loop */
+	loop_abc_scan_effects (la, test);
+	if (test != body)
+		loop_abc_scan_effects (la, body);
+	if (la->has_calls || la->size > LOOP_ABC_MAX_CLONE_SIZE)
+		return FALSE;
+	for (i = 0; i < la->num_arrays; ++i) {
+		if (la->arrays [i].offset != -1 && la->has_stores)
+			return FALSE;
+	}
+
+	if (cfg->verbose_level > 1)
+		printf ("ABCREM: versioning loop BB%d in %s\n", body->block_num, mono_method_full_name (cfg->method, TRUE));
+
+	/* The guards */
+	first = loop_abc_new_bblock (la);
+	cfg->cbb = first;
+	for (i = 0; i < la->num_arrays; ++i) {
+		LoopAbcArray *a = &la->arrays [i];
+
+		if (a->offset == -1) {
+			a->hoisted = a->var;
+		} else {
+			int base_reg;
+
+			if (a->var != -1) {
+				MONO_EMIT_NEW_BIALU_IMM (cfg, OP_COMPARE_IMM, -1, a->var, 0);
+				loop_abc_emit_guard (la, OP_PBEQ);
+				base_reg = a->var;
+			} else {
+				base_reg = alloc_preg (cfg);
+				MONO_EMIT_NEW_PCONST (cfg, base_reg, a->addr);
+			}
+			var = mono_compile_create_var (cfg, &mono_defaults.object_class->byval_arg, OP_LOCAL);
+			MONO_EMIT_NEW_LOAD_MEMBASE_OP (cfg, OP_LOAD_MEMBASE, var->dreg, base_reg, a->offset);
+			a->hoisted = var->dreg;
+		}
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_COMPARE_IMM, -1, a->hoisted, 0);
+		loop_abc_emit_guard (la, OP_PBEQ);
+	}
+	if (la->bound_array != -1) {
+		var = mono_compile_create_var (cfg, &mono_defaults.int32_class->byval_arg, OP_LOCAL);
+		MONO_EMIT_NEW_LOAD_MEMBASE_OP (cfg, OP_LOADI4_MEMBASE, var->dreg, la->arrays [la->bound_array].hoisted, G_STRUCT_OFFSET (MonoArray, max_length));
+		la->bound_reg = var->dreg;
+	}
+	if (!loop_abc_start_non_negative (la)) {
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ICOMPARE_IMM, -1, la->iv, 0);
+		loop_abc_emit_guard (la, OP_IBLT);
+	}
+	if (test == body) {
+		/* The body runs once before the first test */
+		loop_abc_emit_compare_bound (la, la->iv);
+		loop_abc_emit_guard (la, OP_IBGE);
+	}
+	for (i = 0; i < la->num_arrays; ++i) {
+		int len_reg;
+
+		if (i == la->bound_array)
+			continue;
+		len_reg = alloc_ireg (cfg);
+		MONO_EMIT_NEW_LOAD_MEMBASE_OP (cfg, OP_LOADI4_MEMBASE, len_reg, la->arrays [i].hoisted, G_STRUCT_OFFSET (MonoArray, max_length));
+		loop_abc_emit_compare_bound (la, len_reg);
+		loop_abc_emit_guard (la, OP_IBLT);
+	}
+
+	/* The copy of the loop, which the last guard bblock falls through into */
+	ctest = loop_abc_clone_bblock (la, test);
+	cfg->cbb->next_bb = ctest;
+	mono_link_bblock (cfg, cfg->cbb, ctest);
+	if (test != body) {
+		cbody = loop_abc_clone_bblock (la, body);
+		ctest->next_bb = cbody;
+		ins = cbody->last_ins;
+		if (!ins || ins->opcode != OP_BR) {
+			MONO_INST_NEW (cfg, ins, OP_BR);
+			MONO_ADD_INS (cbody, ins);
+		}
+		ins->inst_target_bb = ctest;
+		mono_link_bblock (cfg, cbody, ctest);
+	} else {
+		cbody = ctest;
+	}
+	ctest->last_ins->inst_true_bb = cbody;
+	ctest->last_ins->inst_false_bb = la->exit;
+	mono_link_bblock (cfg, ctest, cbody);
+	mono_link_bblock (cfg, ctest, la->exit);
+
+	/* Redirect the loop entry to the guards */
+	next = pred->next_bb;
+	ins = pred->last_ins;
+	if (ins && ins->opcode == OP_BR) {
+		ins->inst_target_bb = first;
+	} else if (ins && MONO_IS_COND_BRANCH_OP (ins)) {
+		if (ins->inst_true_bb == test)
+			ins->inst_true_bb = first;
+		if (ins->inst_false_bb == test)
+			ins->inst_false_bb = first;
+	} else {
+		MONO_INST_NEW (cfg, ins, OP_BR);
+		ins->inst_target_bb = first;
+		MONO_ADD_INS (pred, ins);
+	}
+	mono_unlink_bblock (cfg, pred, test);
+	mono_link_bblock (cfg, pred, first);
+	pred->next_bb = first;
+	cbody->next_bb = next;
+
+	mono_jit_stats.abc_checks_removed += la->num_checks;
+	mono_jit_stats.abc_loops_versioned ++;
+	return TRUE;
+}
+
+/**
+ * mono_perform_loop_abc_removal:
+ * @cfg: Control Flow Graph
+ *
+ * Removes the bounds checks from the simple counted loops of the method, see the
+ * comment above.  Runs after SSA has been removed, on code without exception clauses.
+ * Returns TRUE if the cfg has been changed, the caller has to recompute cfg->bblocks.
+ */
+gboolean
+mono_perform_loop_abc_removal (MonoCompile *cfg)
+{
+	MonoBasicBlock *bb, *next, *cbb = cfg->cbb;
+	gboolean changed = FALSE;
+
+	for (bb = cfg->bb_entry; bb; bb = next) {
+		MonoInst *branch = bb->last_ins;
+
+		next = bb->next_bb;
+		if (!branch || branch->opcode != OP_IBLT)
+			continue;
+		if (branch->inst_true_bb == bb) {
+			if (loop_abc_loop (cfg, bb, bb))
+				changed = TRUE;
+		} else {
+			MonoBasicBlock *body = branch->inst_true_bb;
+
+			if (body->in_count == 1 && body->out_count == 1 && body->out_bb [0] == bb && body->region == bb->region) {
+				if (loop_abc_loop (cfg, bb, body))
+					changed = TRUE;
+			}
+		}
+	}
+	cfg->cbb = cbb;
+	return changed;
+}
+
 #endif /* DISABLE_JIT */
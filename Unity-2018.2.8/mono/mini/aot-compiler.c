@@ -111,11 +111,11 @@ typedef struct MonoAotOptions {
 
 typedef struct MonoAotStats {
 	int ccount, mcount, lmfcount, abscount, gcount, ocount, genericcount;
-	int code_size, info_size, ex_info_size, unwind_info_size, got_size, class_info_size, got_info_size, got_info_offsets_size;
+	int code_size, info_size, ex_info_size, unwind_info_size, got_size, class_info_size, got_info_size, got_info_offsets_size, offsets_size;
 	int methods_without_got_slots, direct_calls, all_calls;
 	int got_slots;
 	int got_slot_types [MONO_PATCH_INFO_NONE];
-	int jit_time, gen_time, link_time;
+	int collect_time, jit_time, merge_time, gen_time, link_time;
 } MonoAotStats;
 
 typedef struct MonoAotCompile {
@@ -138,6 +138,10 @@ typedef struct MonoAotCompile {
 	GPtrArray *globals;
 	GList *method_order;
 	guint32 *plt_got_info_offsets;
+	/* Offsets of the entries of the method_info, ex_info and class_info blobs */
+	guint32 *method_info_offsets;
+	guint32 *ex_info_offsets;
+	guint32 *class_info_offsets;
 	guint32 got_offset, plt_offset, plt_got_offset_base;
 	/* Number of GOT entries reserved for trampolines */
 	guint32 num_trampoline_got_entries;
@@ -3075,7 +3079,6 @@ emit_method_info (MonoAotCompile *acfg, MonoCompile *cfg)
 	GList *l;
 	int pindex, buf_size, n_patches;
 	guint8 *code;
-	char symbol [128];
 	GPtrArray *patches;
 	MonoJumpInfo *patch_info;
 	MonoMethodHeader *header;
@@ -3089,9 +3092,6 @@ emit_method_info (MonoAotCompile *acfg, MonoCompile *cfg)
 
 	method_index = get_method_index (acfg, method);
 
-	/* Make the labels local */
-	sprintf (symbol, "%sm_%x_p", acfg->temp_prefix, method_index);
-
 	/* Sort relocations */
 	patches = g_ptr_array_new ();
 	for (patch_info = cfg->patch_info; patch_info; patch_info = patch_info->next)
@@ -3155,12 +3155,12 @@ emit_method_info (MonoAotCompile *acfg, MonoCompile *cfg)
 
 	encode_patch_list (acfg, patches, n_patches, first_got_offset, p, &p);
 
+	/* The entries are emitted contiguously, so the size emitted so far is the offset */
+	acfg->method_info_offsets [method_index] = acfg->stats.info_size;
 	acfg->stats.info_size += p - buf;
 
 	/* Emit method info */
 
-	emit_label (acfg, symbol);
-
 	g_assert (p - buf < buf_size);
 	emit_bytes (acfg, buf, p - buf);
 	g_free (buf);
@@ -3206,7 +3206,6 @@ emit_exception_debug_info (MonoAotCompile *acfg, MonoCompile *cfg)
 	int i, k, buf_size, method_index;
 	guint32 debug_info_size;
 	guint8 *code;
-	char symbol [128];
 	MonoMethodHeader *header;
 	guint8 *p, *buf, *debug_info;
 	MonoJitInfo *jinfo = cfg->jit_info;
@@ -3220,9 +3219,6 @@ emit_exception_debug_info (MonoAotCompile *acfg, MonoCompile *cfg)
 
 	method_index = get_method_index (acfg, method);
 
-	/* Make the labels local */
-	sprintf (symbol, "%se_%x_p", acfg->temp_prefix, method_index);
-
 	if (!acfg->aot_opts.nodebug) {
 		mono_debug_serialize_debug_info (cfg, &debug_info, &debug_info_size);
 	} else {
@@ -3329,12 +3325,11 @@ emit_exception_debug_info (MonoAotCompile *acfg, MonoCompile *cfg)
 		g_free (debug_info);
 	}
 
+	acfg->ex_info_offsets [method_index] = acfg->stats.ex_info_size;
 	acfg->stats.ex_info_size += p - buf;
 
 	/* Emit info */
 
-	emit_label (acfg, symbol);
-
 	g_assert (p - buf < buf_size);
 	emit_bytes (acfg, buf, p - buf);
 	g_free (buf);
@@ -3346,7 +3341,6 @@ emit_klass_info (MonoAotCompile *acfg, guint32 token)
 	MonoClass *klass = mono_class_get (acfg->image, token);
 	guint8 *p, *buf;
 	int i, buf_size;
-	char symbol [128];
 	gboolean no_special_static, cant_encode;
 	gpointer iter = NULL;
 
@@ -3404,11 +3398,10 @@ emit_klass_info (MonoAotCompile *acfg, guint32 token)
 		}
 	}
 
+	acfg->class_info_offsets [mono_metadata_token_index (token) - 1] = acfg->stats.class_info_size;
 	acfg->stats.class_info_size += p - buf;
 
 	/* Emit the info */
-	sprintf (symbol, "%sK_I_%x", acfg->temp_prefix, token - MONO_TOKEN_TYPE_DEF - 1);
-	emit_label (acfg, symbol);
 
 	g_assert (p - buf < buf_size);
 	emit_bytes (acfg, buf, p - buf);
@@ -3948,16 +3941,17 @@ mono_method_marked_as_wrapperless(MonoMethod* method);
 /*
  * compile_method:
  *
- *   AOT compile a given method.
- * This function might be called by multiple threads, so it must be thread-safe.
+ *   JIT compile METHOD for AOT, returning the resulting cfg, or NULL if the method
+ * can't be AOT compiled. The cfg is added to the image by add_compiled_method ().
+ * This function might be called by multiple threads, so it must be thread-safe. It
+ * doesn't modify ACFG except for the stats counters, so its result doesn't depend on
+ * the order in which methods are compiled.
  */
-static void
+static MonoCompile*
 compile_method (MonoAotCompile *acfg, MonoMethod *method)
 {
 	MonoCompile *cfg;
 	MonoJumpInfo *patch_info;
-	gboolean skip;
-	int index, depth;
 	MonoMethod *wrapped;
 
 #if defined(PLATFORM_IPHONE_XCOMP)
@@ -3969,40 +3963,36 @@ compile_method (MonoAotCompile *acfg, MonoMethod *method)
 		{
 			method->save_lmf = FALSE;
 			if (wrapped->signature->ret->type != MONO_TYPE_R4)
-				return;
+				return NULL;
 		}
 	}
 #endif
 
 	if (acfg->aot_opts.metadata_only)
-		return;
-
-	mono_acfg_lock (acfg);
-	index = get_method_index (acfg, method);
-	mono_acfg_unlock (acfg);
+		return NULL;
 
 	/* fixme: maybe we can also precompile wrapper methods */
 	if ((method->flags & METHOD_ATTRIBUTE_PINVOKE_IMPL) ||
 		(method->iflags & METHOD_IMPL_ATTRIBUTE_RUNTIME) ||
 		(method->flags & METHOD_ATTRIBUTE_ABSTRACT)) {
 		//printf ("Skip (impossible): %s\n", mono_method_full_name (method, TRUE));
-		return;
+		return NULL;
 	}
 
 	if (method->iflags & METHOD_IMPL_ATTRIBUTE_INTERNAL_CALL)
-		return;
+		return NULL;
 
 	wrapped = mono_marshal_method_from_wrapper (method);
 	if (wrapped && (wrapped->iflags & METHOD_IMPL_ATTRIBUTE_INTERNAL_CALL) && wrapped->is_generic)
 		// FIXME: The wrapper should be generic too, but it is not
-		return;
+		return NULL;
 
 	InterlockedIncrement (&acfg->stats.mcount);
 
 #if 0
 	if (method->is_generic || method->klass->generic_container) {
 		InterlockedIncrement (&acfg->stats.genericcount);
-		return;
+		return NULL;
 	}
 #endif
 
@@ -4018,11 +4008,11 @@ compile_method (MonoAotCompile *acfg, MonoMethod *method)
 	if (cfg->exception_type == MONO_EXCEPTION_GENERIC_SHARING_FAILED) {
 		//printf ("F: %s\n", mono_method_full_name (method, TRUE));
 		InterlockedIncrement (&acfg->stats.genericcount);
-		return;
+		return NULL;
 	}
 	if (cfg->exception_type != MONO_EXCEPTION_NONE) {
 		/* Let the exception happen at runtime */
-		return;
+		return NULL;
 	}
 
 	if (cfg->disable_aot) {
@@ -4030,7 +4020,7 @@ compile_method (MonoAotCompile *acfg, MonoMethod *method)
 			printf ("Skip (disabled): %s\n", mono_method_full_name (method, TRUE));
 		InterlockedIncrement (&acfg->stats.ocount);
 		mono_destroy_compile (cfg);
-		return;
+		return NULL;
 	}
 
 	/* Nullify patches which need no aot processing */
@@ -4045,8 +4035,28 @@ compile_method (MonoAotCompile *acfg, MonoMethod *method)
 		}
 	}
 
+	return cfg;
+}
+
+/*
+ * add_compiled_method:
+ *
+ *   Add CFG, the result of compile_method () for METHOD, to the image, or free it if
+ * it can't be encoded. This assigns method indexes to the generic instances referenced
+ * by the method, and it depends on the token info collected from earlier methods, so
+ * it is called in method index order to make the output independent of the number of
+ * compiler threads.
+ */
+static void
+add_compiled_method (MonoAotCompile *acfg, MonoMethod *method, MonoCompile *cfg)
+{
+	MonoJumpInfo *patch_info;
+	gboolean skip;
+	int index, depth;
+
 	/* Collect method->token associations from the cfg */
 	mono_acfg_lock (acfg);
+	index = get_method_index (acfg, method);
 	g_hash_table_foreach (cfg->token_info_hash, add_token_info_hash, acfg);
 	mono_acfg_unlock (acfg);
 
@@ -4247,18 +4257,47 @@ compile_method (MonoAotCompile *acfg, MonoMethod *method)
 	InterlockedIncrement (&acfg->stats.ccount);
 }
  
+/*
+ * The compile queue hands out the methods of a batch to the compiler threads. The
+ * methods are compiled in parallel, then the results are added to the image by the
+ * main thread in method index order, which also appends the methods they reference
+ * to the next batches.
+ */
+typedef struct {
+	MonoAotCompile *acfg;
+	MonoDomain *domain;
+	MonoMethod **methods;
+	MonoCompile **cfgs;
+	int len;
+	volatile gint32 next;
+	gboolean quit;
+	/* Released once per worker for each batch */
+	HANDLE start_sem;
+	/* Released by a worker when it finds no more methods in the batch */
+	HANDLE done_sem;
+} AotCompileQueue;
+
 static void
-compile_thread_main (gpointer *user_data)
+compile_queue_run (AotCompileQueue *queue)
 {
-	MonoDomain *domain = user_data [0];
-	MonoAotCompile *acfg = user_data [1];
-	GPtrArray *methods = user_data [2];
 	int i;
 
-	mono_thread_attach (domain);
+	while ((i = InterlockedIncrement (&queue->next) - 1) < queue->len)
+		queue->cfgs [i] = compile_method (queue->acfg, queue->methods [i]);
+}
+
+static void
+compile_thread_main (AotCompileQueue *queue)
+{
+	mono_thread_attach (queue->domain);
 
-	for (i = 0; i < methods->len; ++i)
-		compile_method (acfg, g_ptr_array_index (methods, i));
+	while (TRUE) {
+		WaitForSingleObjectEx (queue->start_sem, INFINITE, FALSE);
+		if (queue->quit)
+			break;
+		compile_queue_run (queue);
+		ReleaseSemaphore (queue->done_sem, 1, NULL);
+	}
 }
 
 static void
@@ -4338,6 +4377,83 @@ load_profile_files (MonoAotCompile *acfg)
 		acfg->method_order = unordered;
 }
 
+/*
+ * emit_offset_table:
+ *
+ *   Emit the table of offsets OFFSETS with NOFFSETS entries under SYMBOL in a compact
+ * form, decoded by get_offset () in aot-runtime.c. The offsets are split into groups
+ * of GROUP_SIZE entries. The first offset of a group is encoded in full, the rest as
+ * differences from the previous entry, and an index points to the start of each
+ * group, so a lookup decodes at most GROUP_SIZE values. Return the size of the table.
+ */
+static int
+emit_offset_table (MonoAotCompile *acfg, const char *symbol, int noffsets, int group_size, guint32 *offsets)
+{
+	int i, j, ngroups, index_entry_size, size;
+	guint32 *index_offsets;
+	guint8 *buf, *p;
+
+	ngroups = (noffsets + (group_size - 1)) / group_size;
+	index_offsets = g_new0 (guint32, ngroups);
+
+	/* An encoded value takes at most 5 bytes */
+	p = buf = g_malloc (noffsets * 5 + 1);
+
+	for (i = 0; i < ngroups; ++i) {
+		index_offsets [i] = p - buf;
+
+		encode_value (offsets [i * group_size], p, &p);
+		for (j = i * group_size + 1; j < noffsets && j < (i + 1) * group_size; ++j)
+			encode_value ((gint32)(offsets [j] - offsets [j - 1]), p, &p);
+	}
+
+	index_entry_size = (p - buf) <= 0xffff ? 2 : 4;
+
+	emit_section_change (acfg, ".text", 1);
+	emit_global (acfg, symbol, FALSE);
+	emit_alignment (acfg, 8);
+	emit_label (acfg, symbol);
+
+	emit_int32 (acfg, noffsets);
+	emit_int32 (acfg, group_size);
+	emit_int32 (acfg, ngroups);
+	emit_int32 (acfg, index_entry_size);
+	for (i = 0; i < ngroups; ++i) {
+		if (index_entry_size == 2)
+			emit_int16 (acfg, index_offsets [i]);
+		else
+			emit_int32 (acfg, index_offsets [i]);
+	}
+	emit_bytes (acfg, buf, p - buf);
+	emit_line (acfg);
+
+	size = 16 + (ngroups * index_entry_size) + (p - buf);
+	acfg->stats.offsets_size += size;
+
+	g_free (buf);
+	g_free (index_offsets);
+
+	return size;
+}
+
+/*
+ * fill_missing_offsets:
+ *
+ *   Set the offsets of methods which are not compiled to the offset of the previous
+ * method. They are never looked up, and this way they take up only one byte in the
+ * offset table.
+ */
+static void
+fill_missing_offsets (MonoAotCompile *acfg, guint32 *offsets)
+{
+	int i;
+
+	for (i = 1; i < acfg->nmethods; ++i) {
+		if (!acfg->cfgs [i])
+			offsets [i] = offsets [i - 1];
+	}
+}
+
 static void
 emit_code (MonoAotCompile *acfg)
 {
@@ -4432,6 +4548,8 @@ emit_info (MonoAotCompile *acfg)
 	sprintf (symbol, "mi");
 	emit_label (acfg, symbol);
 
+	acfg->method_info_offsets = g_new0 (guint32, acfg->nmethods);
+
 	for (l = acfg->method_order; l != NULL; l = l->next) {
 		i = GPOINTER_TO_UINT (l->data);
 
@@ -4439,21 +4557,8 @@ emit_info (MonoAotCompile *acfg)
 			emit_method_info (acfg, acfg->cfgs [i]);
 	}
 
-	sprintf (symbol, "method_info_offsets");
-	emit_section_change (acfg, ".text", 1);
-	emit_global (acfg, symbol, FALSE);
-	emit_alignment (acfg, 8);
-	emit_label (acfg, symbol);
-
-	for (i = 0; i < acfg->nmethods; ++i) {
-		if (acfg->cfgs [i]) {
-			sprintf (symbol, "%sm_%x_p", acfg->temp_prefix, i);
-			emit_symbol_diff (acfg, symbol, "mi", 0);
-		} else {
-			emit_int32 (acfg, 0);
-		}
-	}
-	emit_line (acfg);
+	fill_missing_offsets (acfg, acfg->method_info_offsets);
+	emit_offset_table (acfg, "method_info_offsets", acfg->nmethods, 10, acfg->method_info_offsets);
 }
 
 #endif /* #if !defined(DISABLE_AOT) && !defined(DISABLE_JIT) */
@@ -4932,26 +5037,15 @@ emit_exception_info (MonoAotCompile *acfg)
 	sprintf (symbol, "ex");
 	emit_label (acfg, symbol);
 
+	acfg->ex_info_offsets = g_new0 (guint32, acfg->nmethods);
+
 	for (i = 0; i < acfg->nmethods; ++i) {
 		if (acfg->cfgs [i])
 			emit_exception_debug_info (acfg, acfg->cfgs [i]);
 	}
 
-	sprintf (symbol, "ex_info_offsets");
-	emit_section_change (acfg, ".text", 1);
-	emit_global (acfg, symbol, FALSE);
-	emit_alignment (acfg, 8);
-	emit_label (acfg, symbol);
-
-	for (i = 0; i < acfg->nmethods; ++i) {
-		if (acfg->cfgs [i]) {
-			sprintf (symbol, "%se_%x_p", acfg->temp_prefix, i);
-			emit_symbol_diff (acfg, symbol, "ex", 0);
-		} else {
-			emit_int32 (acfg, 0);
-		}
-	}
-	emit_line (acfg);
+	fill_missing_offsets (acfg, acfg->ex_info_offsets);
+	emit_offset_table (acfg, "ex_info_offsets", acfg->nmethods, 10, acfg->ex_info_offsets);
 }
 
 static void
@@ -5002,20 +5096,12 @@ emit_class_info (MonoAotCompile *acfg)
 	emit_alignment (acfg, 8);
 	emit_label (acfg, symbol);
 
+	acfg->class_info_offsets = g_new0 (guint32, acfg->image->tables [MONO_TABLE_TYPEDEF].rows);
+
 	for (i = 0; i < acfg->image->tables [MONO_TABLE_TYPEDEF].rows; ++i)
 		emit_klass_info (acfg, MONO_TOKEN_TYPE_DEF | (i + 1));
 
-	sprintf (symbol, "class_info_offsets");
-	emit_section_change (acfg, ".text", 1);
-	emit_global (acfg, symbol, FALSE);
-	emit_alignment (acfg, 8);
-	emit_label (acfg, symbol);
-
-	for (i = 0; i < acfg->image->tables [MONO_TABLE_TYPEDEF].rows; ++i) {
-		sprintf (symbol, "%sK_I_%x", acfg->temp_prefix, i);
-		emit_symbol_diff (acfg, symbol, "class_info", 0);
-	}
-	emit_line (acfg);
+	emit_offset_table (acfg, "class_info_offsets", acfg->image->tables [MONO_TABLE_TYPEDEF].rows, 10, acfg->class_info_offsets);
 }
 
 typedef struct ClassNameTableEntry {
@@ -5194,17 +5280,8 @@ emit_got_info (MonoAotCompile *acfg)
 	emit_bytes (acfg, buf, p - buf);
 
 	/* Emit got_info_offsets table */
-	sprintf (symbol, "got_info_offsets");
-	emit_section_change (acfg, ".text", 1);
-	emit_global (acfg, symbol, FALSE);
-	emit_alignment (acfg, 8);
-	emit_label (acfg, symbol);
-
 	/* No need to emit offsets for the got plt entries, the plt embeds them directly */
-	for (i = 0; i < first_plt_got_patch; ++i)
-		emit_int32 (acfg, got_info_offsets [i]);
-
-	acfg->stats.got_info_offsets_size = acfg->got_patches->len * 4;
+	acfg->stats.got_info_offsets_size = emit_offset_table (acfg, "got_info_offsets", first_plt_got_patch, 10, got_info_offsets);
 }
 
 static void
@@ -5519,62 +5596,96 @@ collect_methods (MonoAotCompile *acfg)
 static void
 compile_methods (MonoAotCompile *acfg)
 {
-	int i, methods_len;
-
-	if (acfg->aot_opts.nthreads > 0) {
-		GPtrArray *frag;
-		int len, j;
-		GPtrArray *threads;
-		HANDLE handle;
-		gpointer *user_data;
-		MonoMethod **methods;
-
-		methods_len = acfg->methods->len;
+	AotCompileQueue queue;
+	GPtrArray *threads;
+	HANDLE handle;
+	int i, j, batch_size, nworkers;
+	TV_DECLARE (atv);
+	TV_DECLARE (btv);
 
-		len = acfg->methods->len / acfg->aot_opts.nthreads;
-		g_assert (len > 0);
-		/* 
-		 * Partition the list of methods into fragments, and hand it to threads to
-		 * process.
-		 */
-		threads = g_ptr_array_new ();
-		/* Make a copy since acfg->methods is modified by compile_method () */
-		methods = g_new0 (MonoMethod*, methods_len);
-		//memcpy (methods, g_ptr_array_index (acfg->methods, 0), sizeof (MonoMethod*) * methods_len);
-		for (i = 0; i < methods_len; ++i)
-			methods [i] = g_ptr_array_index (acfg->methods, i);
-		i = 0;
-		while (i < methods_len) {
-			frag = g_ptr_array_new ();
-			for (j = 0; j < len; ++j) {
-				if (i < methods_len) {
-					g_ptr_array_add (frag, methods [i]);
-					i ++;
-				}
+	if (acfg->aot_opts.nthreads <= 0) {
+		for (i = 0; i < acfg->methods->len; ++i) {
+			MonoMethod *method = g_ptr_array_index (acfg->methods, i);
+			MonoCompile *cfg;
+
+			/* This can add new methods to acfg->methods */
+			cfg = compile_method (acfg, method);
+			if (cfg) {
+				TV_GETTIME (atv);
+				add_compiled_method (acfg, method, cfg);
+				TV_GETTIME (btv);
+				acfg->stats.merge_time += TV_ELAPSED (atv, btv);
 			}
-
-			user_data = g_new0 (gpointer, 3);
-			user_data [0] = mono_domain_get ();
-			user_data [1] = acfg;
-			user_data [2] = frag;
-			
-			handle = mono_create_thread (NULL, 0, (gpointer)compile_thread_main, user_data, 0, NULL);
-			g_ptr_array_add (threads, handle);
 		}
-		g_free (methods);
+		return;
+	}
 
-		for (i = 0; i < threads->len; ++i) {
-			WaitForSingleObjectEx (g_ptr_array_index (threads, i), INFINITE, FALSE);
+	/* The main thread compiles too */
+	nworkers = acfg->aot_opts.nthreads - 1;
+	/*
+	 * The methods referenced by a batch are only added to the next one, so keep
+	 * batches small enough for them to be picked up soon.  This doesn't bound
+	 * memory use, acfg->cfgs keeps every cfg until emission anyway.
+	 */
+	batch_size = acfg->aot_opts.nthreads * 64;
+
+	memset (&queue, 0, sizeof (queue));
+	queue.acfg = acfg;
+	queue.domain = mono_domain_get ();
+	queue.methods = g_new0 (MonoMethod*, batch_size);
+	queue.cfgs = g_new0 (MonoCompile*, batch_size);
+	queue.start_sem = CreateSemaphore (NULL, 0, 0x7fffffff, NULL);
+	queue.done_sem = CreateSemaphore (NULL, 0, 0x7fffffff, NULL);
+	g_assert (queue.start_sem && queue.done_sem);
+
+	threads = g_ptr_array_new ();
+	for (i = 0; i < nworkers; ++i) {
+		handle = mono_create_thread (NULL, 0, (gpointer)compile_thread_main, &queue, 0, NULL);
+		g_assert (handle);
+		g_ptr_array_add (threads, handle);
+	}
+
+	i = 0;
+	while (i < acfg->methods->len) {
+		/* Make a copy since acfg->methods is modified by add_compiled_method () */
+		queue.len = MIN (acfg->methods->len - i, batch_size);
+		for (j = 0; j < queue.len; ++j) {
+			queue.methods [j] = g_ptr_array_index (acfg->methods, i + j);
+			queue.cfgs [j] = NULL;
 		}
-	} else {
-		methods_len = 0;
+		queue.next = 0;
+
+		if (nworkers)
+			ReleaseSemaphore (queue.start_sem, nworkers, NULL);
+		compile_queue_run (&queue);
+		for (j = 0; j < nworkers; ++j)
+			WaitForSingleObjectEx (queue.done_sem, INFINITE, FALSE);
+
+		TV_GETTIME (atv);
+		for (j = 0; j < queue.len; ++j) {
+			if (queue.cfgs [j])
+				/* This can add new methods to acfg->methods */
+				add_compiled_method (acfg, queue.methods [j], queue.cfgs [j]);
+		}
+		TV_GETTIME (btv);
+		acfg->stats.merge_time += TV_ELAPSED (atv, btv);
+
+		i += queue.len;
 	}
 
-	/* Compile methods added by compile_method () or all methods if nthreads == 0 */
-	for (i = methods_len; i < acfg->methods->len; ++i) {
-		/* This can new methods to acfg->methods */
-		compile_method (acfg, g_ptr_array_index (acfg->methods, i));
+	queue.quit = TRUE;
+	if (nworkers)
+		ReleaseSemaphore (queue.start_sem, nworkers, NULL);
+	for (i = 0; i < threads->len; ++i) {
+		WaitForSingleObjectEx (g_ptr_array_index (threads, i), INFINITE, FALSE);
+		CloseHandle (g_ptr_array_index (threads, i));
 	}
+	g_ptr_array_free (threads, TRUE);
+
+	CloseHandle (queue.start_sem);
+	CloseHandle (queue.done_sem);
+	g_free (queue.methods);
+	g_free (queue.cfgs);
 }
 
 static int
@@ -5738,6 +5849,9 @@ acfg_free (MonoAotCompile *acfg)
 		if (acfg->cfgs [i])
 			g_free (acfg->cfgs [i]);
 	g_free (acfg->cfgs);
+	g_free (acfg->method_info_offsets);
+	g_free (acfg->ex_info_offsets);
+	g_free (acfg->class_info_offsets);
 	g_free (acfg->static_linking_symbol);
 	g_free (acfg->got_symbol);
 	g_free (acfg->plt_symbol);
@@ -5832,8 +5946,14 @@ mono_compile_assembly (MonoAssembly *ass, guint32 opts, const char *aot_options)
 
 	acfg->method_index = 1;
 
+	TV_GETTIME (atv);
+
 	collect_methods (acfg);
 
+	TV_GETTIME (btv);
+
+	acfg->stats.collect_time = TV_ELAPSED (atv, btv);
+
 	acfg->cfgs_size = acfg->methods->len + 32;
 	acfg->cfgs = g_new0 (MonoCompile*, acfg->cfgs_size);
 
@@ -5956,7 +6076,7 @@ mono_compile_assembly (MonoAssembly *ass, guint32 opts, const char *aot_options)
 
 	acfg->stats.gen_time = TV_ELAPSED (atv, btv);
 
-	printf ("Code: %d Info: %d Ex Info: %d Unwind Info: %d Class Info: %d PLT: %d GOT Info: %d GOT Info Offsets: %d GOT: %d Offsets: %d\n", acfg->stats.code_size, acfg->stats.info_size, acfg->stats.ex_info_size, acfg->stats.unwind_info_size, acfg->stats.class_info_size, acfg->plt_offset, acfg->stats.got_info_size, acfg->stats.got_info_offsets_size, (int)(acfg->got_offset * sizeof (gpointer)), (int)(acfg->nmethods * 3 * sizeof (gpointer)));
+	printf ("Code: %d Info: %d Ex Info: %d Unwind Info: %d Class Info: %d PLT: %d GOT Info: %d GOT Info Offsets: %d GOT: %d Offsets: %d\n", acfg->stats.code_size, acfg->stats.info_size, acfg->stats.ex_info_size, acfg->stats.unwind_info_size, acfg->stats.class_info_size, acfg->plt_offset, acfg->stats.got_info_size, acfg->stats.got_info_offsets_size, (int)(acfg->got_offset * sizeof (gpointer)), acfg->stats.offsets_size + (int)(acfg->nmethods * (sizeof (guint32) + sizeof (gpointer))));
 
 	TV_GETTIME (atv);
 	res = img_writer_emit_writeout (acfg->w);
@@ -6000,7 +6120,7 @@ mono_compile_assembly (MonoAssembly *ass, guint32 opts, const char *aot_options)
 			printf ("\t%s: %d\n", get_patch_name (i), acfg->stats.got_slot_types [i]);
 	*/
 
-	printf ("JIT time: %d ms, Generation time: %d ms, Assembly+Link time: %d ms.\n", acfg->stats.jit_time / 1000, acfg->stats.gen_time / 1000, acfg->stats.link_time / 1000);
+	printf ("Collect time: %d ms, JIT time: %d ms (%d threads, of which merging: %d ms), Generation time: %d ms, Assembly+Link time: %d ms.\n", acfg->stats.collect_time / 1000, acfg->stats.jit_time / 1000, MAX (acfg->aot_opts.nthreads, 1), acfg->stats.merge_time / 1000, acfg->stats.gen_time / 1000, acfg->stats.link_time / 1000);
 
 	acfg_free (acfg);
 	
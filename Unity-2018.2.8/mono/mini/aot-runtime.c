@@ -15,6 +15,9 @@
 #endif
 #include <fcntl.h>
 #include <string.h>
+#ifndef PLATFORM_WIN32
+#include <sys/file.h>
+#endif
 #ifdef HAVE_SYS_MMAN_H
 #include <sys/mman.h>
 #endif
@@ -103,6 +106,15 @@ typedef struct MonoAotModule {
 	guint32 *ex_info_offsets;
 	guint32 *method_order;
 	guint32 *method_order_end;
+	/*
+	 * Maps code offsets >> ip_index_shift to positions in method_order_table, built
+	 * on demand by build_ip_index ().
+	 */
+	guint32 *ip_index;
+	int ip_index_shift;
+	/* The method indexes in method_order, sorted by code offset */
+	guint32 *method_order_table;
+	int method_order_len;
 	guint8 *class_info;
 	guint32 *class_info_offsets;
 	guint32 *methods_loaded;
@@ -142,10 +154,16 @@ static GHashTable *ji_to_amodule;
 
 /*
  * Whenever to AOT compile loaded assemblies on demand and store them in
- * a cache under $HOME/.mono/aot-cache.
+ * a cache under $HOME/.mono/aot-cache, or under aot_cache_dir.
  */
 static gboolean use_aot_cache = FALSE;
 
+/*
+ * The directory of the AOT cache. Set by MONO_AOT_CACHE_DIR to a directory shared
+ * by all processes on a host.
+ */
+static char *aot_cache_dir;
+
 /*
  * Whenever to spawn a new process to AOT a file or do it in-process. Only relevant if
  * use_aot_cache is TRUE.
@@ -157,6 +175,9 @@ static gint32 mono_last_aot_method = -1;
 
 static gboolean make_unreadable = FALSE;
 static guint32 name_table_accesses = 0;
+
+/* Used by all jit info decoded from AOT images */
+static MonoGenericSharingContext generic_sharing_context;
 static guint32 n_pagefaults = 0;
 
 /* Used to speed-up find_aot_module () */
@@ -235,6 +256,44 @@ decode_value (guint8 *ptr, guint8 **rptr)
 	return len;
 }
 
+/*
+ * get_offset:
+ *
+ *   Return the INDEXth entry of TABLE, which is emitted in a compact form by
+ * emit_offset_table () in aot-compiler.c.
+ */
+static guint32
+get_offset (guint32 *table, int index)
+{
+	int i, group, group_size, ngroups, index_entry_size;
+	guint32 offset;
+	guint8 *data_start, *p;
+
+	group_size = table [1];
+	ngroups = table [2];
+	index_entry_size = table [3];
+	group = index / group_size;
+
+	if (index_entry_size == 2) {
+		guint16 *index16 = (guint16*)&table [4];
+
+		data_start = (guint8*)&index16 [ngroups];
+		p = data_start + index16 [group];
+	} else {
+		guint32 *index32 = &table [4];
+
+		data_start = (guint8*)&index32 [ngroups];
+		p = data_start + index32 [group];
+	}
+
+	/* The first entry of the group is stored in full, the rest as differences */
+	offset = decode_value (p, &p);
+	for (i = group * group_size + 1; i <= index; ++i)
+		offset += decode_value (p, &p);
+
+	return offset;
+}
+
 static MonoMethod*
 decode_method_ref_2 (MonoAotModule *module, guint8 *buf, guint8 **endbuf);
 
@@ -714,47 +773,128 @@ make_writable (guint8* addr, guint32 len)
 	g_assert (err == 0);
 }
 
-static void
+static gboolean
+create_cache_dir (const char *dir)
+{
+	int err;
+
+	if (g_file_test (dir, G_FILE_TEST_IS_DIR))
+		return TRUE;
+
+	mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT creating directory %s", dir);
+#ifdef PLATFORM_WIN32
+	err = mkdir (dir);
+#else
+	err = mkdir (dir, 0777);
+#endif
+	/* Another process might have created it in the meantime */
+	if (err && errno != EEXIST) {
+		mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT failed: %s", g_strerror (errno));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
 create_cache_structure (void)
 {
 	const char *home;
 	char *tmp;
-	int err;
+	gboolean res;
+
+	if (aot_cache_dir)
+		/* Host wide cache set by MONO_AOT_CACHE_DIR */
+		return create_cache_dir (aot_cache_dir);
 
 	home = g_get_home_dir ();
 	if (!home)
-		return;
+		return FALSE;
 
 	tmp = g_build_filename (home, ".mono", NULL);
-	if (!g_file_test (tmp, G_FILE_TEST_IS_DIR)) {
-		mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT creating directory %s", tmp);
-#ifdef PLATFORM_WIN32
-		err = mkdir (tmp);
+	res = create_cache_dir (tmp);
+	g_free (tmp);
+	if (!res)
+		return FALSE;
+
+	aot_cache_dir = g_build_filename (home, ".mono", "aot-cache", NULL);
+	return create_cache_dir (aot_cache_dir);
+}
+
+/*
+ * create_cache_lock:
+ *
+ *   Take the lock which marks that a process is generating a cache entry, held
+ * on the file LOCK_NAME. Return its fd, or -1 if another process holds it.
+ * The lock is a flock () on the file, which the kernel drops when the last
+ * process holding the fd exits, so a crashed compiler can't leave it behind.
+ * The file itself is never removed, since a process which already opened it
+ * could then lock a different file than the next one.
+ * On windows, the lock is the existence of the file, see release_cache_lock ().
+ */
+static int
+create_cache_lock (const char *lock_name)
+{
+	int fd;
+
+#ifndef PLATFORM_WIN32
+	fd = open (lock_name, O_CREAT | O_WRONLY, 0644);
+	if (fd == -1)
+		return -1;
+	if (flock (fd, LOCK_EX | LOCK_NB) == -1) {
+		close (fd);
+		return -1;
+	}
+	/* Only the compiler process inherits it, see cache_lock_child_setup () */
+	fcntl (fd, F_SETFD, FD_CLOEXEC);
 #else
-		err = mkdir (tmp, 0777);
+	fd = open (lock_name, O_CREAT | O_EXCL | O_WRONLY, 0644);
 #endif
-		if (err) {
-			mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT failed: %s", g_strerror (errno));
-			g_free (tmp);
-			return;
-		}
-	}
-	g_free (tmp);
-	tmp = g_build_filename (home, ".mono", "aot-cache", NULL);
-	if (!g_file_test (tmp, G_FILE_TEST_IS_DIR)) {
-		mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT creating directory %s", tmp);
+	return fd;
+}
+
+static void
+release_cache_lock (const char *lock_name, int fd)
+{
+	close (fd);
 #ifdef PLATFORM_WIN32
-		err = mkdir (tmp);
-#else
-		err = mkdir (tmp, 0777);
+	unlink (lock_name);
 #endif
-		if (err) {
-			mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT failed: %s", g_strerror (errno));
-			g_free (tmp);
-			return;
-		}
+}
+
+#ifndef PLATFORM_WIN32
+/*
+ * cache_lock_child_setup:
+ *
+ *   Called in the spawned compiler process before exec, to hand it the cache
+ * lock, which is held until it exits.
+ */
+static void
+cache_lock_child_setup (gpointer user_data)
+{
+	fcntl (GPOINTER_TO_INT (user_data), F_SETFD, 0);
+}
+#endif
+
+/*
+ * publish_cache_entry:
+ *
+ *   Atomically replace FNAME with the fully written TMP_NAME, so other processes
+ * never dlopen a partially written module.
+ */
+static gboolean
+publish_cache_entry (const char *tmp_name, const char *fname)
+{
+	if (!g_file_test (tmp_name, G_FILE_TEST_EXISTS))
+		return FALSE;
+#ifdef PLATFORM_WIN32
+	unlink (fname);
+#endif
+	if (rename (tmp_name, fname)) {
+		mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT failed to publish '%s': %s", fname, g_strerror (errno));
+		unlink (tmp_name);
+		return FALSE;
 	}
-	g_free (tmp);
+	return TRUE;
 }
 
 /*
@@ -762,6 +902,16 @@ create_cache_structure (void)
  *
  *  Experimental code to AOT compile loaded assemblies on demand. 
  *
+ *  The cache lives under $HOME/.mono/aot-cache, or in the directory given by
+ * MONO_AOT_CACHE_DIR, which can be shared by all processes on a host. Entries
+ * are named after the assembly GUID and a hash of the runtime version and the
+ * AOT file format version, so runtimes never pick up each other's modules.
+ * A missing entry is generated by one process, which holds a lock file next to
+ * it, into a temporary file which is renamed into place when complete. The
+ * compiler runs in the background, so the process which triggered it JITs the
+ * assembly as usual, and later processes dlopen the module, sharing its code
+ * pages.
+ *
  * FIXME: 
  * - Add environment variable MONO_AOT_CACHE_OPTIONS
  * - Add options for controlling the cache size
@@ -774,69 +924,125 @@ create_cache_structure (void)
 static MonoDl*
 load_aot_module_from_cache (MonoAssembly *assembly, char **aot_name)
 {
-	char *fname, *cmd, *tmp2, *aot_options;
-	const char *home;
+	char *fname, *tmp_name, *lock_name, *tmp2, *build_info, *version, *aot_options;
 	MonoDl *module;
 	gboolean res;
-	gchar *out, *err;
-	gint exit_status;
+	int lock_fd;
 
 	*aot_name = NULL;
 
 	if (assembly->image->dynamic)
 		return NULL;
 
-	create_cache_structure ();
-
-	home = g_get_home_dir ();
+	if (!create_cache_structure ())
+		return NULL;
 
-	tmp2 = g_strdup_printf ("%s-%s%s", assembly->image->assembly_name, assembly->image->guid, SHARED_EXT);
-	fname = g_build_filename (home, ".mono", "aot-cache", tmp2, NULL);
+	build_info = mono_get_runtime_build_info ();
+	version = g_strdup_printf ("%s %s", MONO_AOT_FILE_VERSION, build_info);
+	g_free (build_info);
+	tmp2 = g_strdup_printf ("%s-%s-%08x%s", assembly->image->assembly_name, assembly->image->guid, mono_aot_str_hash (version), SHARED_EXT);
+	fname = g_build_filename (aot_cache_dir, tmp2, NULL);
 	*aot_name = fname;
 	g_free (tmp2);
+	g_free (version);
 
 	mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT trying to load from cache: '%s'.", fname);
 	module = mono_dl_open (fname, MONO_DL_LAZY, NULL);
+	if (module)
+		return module;
 
-	if (!module) {
-		mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT not found.");
+	mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT not found.");
 
-		mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT precompiling assembly '%s'... ", assembly->image->name);
+	lock_name = g_strdup_printf ("%s.lock", fname);
+	lock_fd = create_cache_lock (lock_name);
+	if (lock_fd == -1) {
+		mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT another process is compiling '%s'.", assembly->image->name);
+		g_free (lock_name);
+		return NULL;
+	}
 
-		aot_options = g_strdup_printf ("outfile=%s", fname);
+	/* The process which held the lock before us might have just published the entry */
+	module = mono_dl_open (fname, MONO_DL_LAZY, NULL);
+	if (module) {
+		release_cache_lock (lock_name, lock_fd);
+		g_free (lock_name);
+		return module;
+	}
 
-		if (spawn_compiler) {
-			/* FIXME: security */
-			/* FIXME: Has to pass the assembly loading path to the child process */
-			cmd = g_strdup_printf ("mono -O=all --aot=%s %s", aot_options, assembly->image->name);
+	mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT precompiling assembly '%s'... ", assembly->image->name);
 
-			res = g_spawn_command_line_sync (cmd, &out, &err, &exit_status, NULL);
+	tmp_name = g_strdup_printf ("%s.%d.tmp", fname, (int)getpid ());
+	aot_options = g_strdup_printf ("outfile=%s", tmp_name);
 
-#if !defined(PLATFORM_WIN32) && !defined(__ppc__) && !defined(__ppc64__) && !defined(__powerpc__)
-			if (res) {
-				if (!WIFEXITED (exit_status) && (WEXITSTATUS (exit_status) == 0))
-					mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT failed: %s.", err);
-				else
-					mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT succeeded.");
-				g_free (out);
-				g_free (err);
-			}
-#endif
-			g_free (cmd);
+	if (spawn_compiler) {
+#ifndef PLATFORM_WIN32
+		/* FIXME: security */
+		/* FIXME: Has to pass the assembly loading path to the child process */
+		/* 
+		 * Compile in the background and publish the result from the child, so loading
+		 * the assembly isn't blocked. The paths are passed as positional parameters
+		 * to avoid quoting them. The child inherits the lock, and it is released when
+		 * the child exits, however it exits.
+		 */
+		char *argv [] = {
+			"/bin/sh", "-c",
+			"mono -O=all --aot=outfile=\"$1\" \"$3\" && mv -f \"$1\" \"$2\"; rm -f \"$1\"",
+			"sh", tmp_name, fname, assembly->image->name, NULL
+		};
+		GError *error = NULL;
+
+		res = g_spawn_async_with_pipes (NULL, argv, NULL, G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL, cache_lock_child_setup, GINT_TO_POINTER (lock_fd), NULL, NULL, NULL, NULL, &error);
+		if (!res) {
+			mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT failed: %s.", error ? error->message : "");
+			if (error)
+				g_error_free (error);
 		} else {
-			res = mono_compile_assembly (assembly, mono_parse_default_optimizations (NULL), aot_options);
-			if (!res) {
-				mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT failed.");
-			} else {
-				mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT succeeded.");
-			}
+			mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT compiling in the background.");
 		}
+		/* The child has its own copy of the fd if it was started */
+		release_cache_lock (lock_name, lock_fd);
+
+		/* The assembly is JITted by this process */
+		module = NULL;
+#else
+		char *cmd;
+		gchar *out, *err;
+		gint exit_status;
 
-		module = mono_dl_open (fname, MONO_DL_LAZY, NULL);
+		cmd = g_strdup_printf ("mono -O=all --aot=%s \"%s\"", aot_options, assembly->image->name);
 
-		g_free (aot_options);
+		res = g_spawn_command_line_sync (cmd, &out, &err, &exit_status, NULL);
+		if (res) {
+			g_free (out);
+			g_free (err);
+		}
+		g_free (cmd);
+
+		module = NULL;
+		if (res && publish_cache_entry (tmp_name, fname)) {
+			mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT succeeded.");
+			module = mono_dl_open (fname, MONO_DL_LAZY, NULL);
+		} else {
+			mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT failed.");
+		}
+		release_cache_lock (lock_name, lock_fd);
+#endif
+	} else {
+		res = mono_compile_assembly (assembly, mono_parse_default_optimizations (NULL), aot_options);
+		module = NULL;
+		if (res && publish_cache_entry (tmp_name, fname)) {
+			mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT succeeded.");
+			module = mono_dl_open (fname, MONO_DL_LAZY, NULL);
+		} else {
+			mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT failed.");
+		}
+		release_cache_lock (lock_name, lock_fd);
 	}
 
+	g_free (aot_options);
+	g_free (tmp_name);
+	g_free (lock_name);
+
 	return module;
 }
 
@@ -1106,6 +1312,7 @@ load_aot_module (MonoAssembly *assembly, gpointer user_data)
 
 	/* Compute code_offsets from the method addresses */
 	amodule->code_offsets = g_malloc0 (amodule->info.nmethods * sizeof (gint32));
+	mono_jit_stats.aot_metadata_size += amodule->info.nmethods * sizeof (gint32);
 	for (i = 0; i < amodule->info.nmethods; ++i) {
 		if (!amodule->method_addresses [i])
 			amodule->code_offsets [i] = 0xffffffff;
@@ -1232,6 +1439,10 @@ mono_aot_init (void)
 		mono_last_aot_method = atoi (g_getenv ("MONO_LASTAOT"));
 	if (g_getenv ("MONO_AOT_CACHE"))
 		use_aot_cache = TRUE;
+	if (g_getenv ("MONO_AOT_CACHE_DIR")) {
+		aot_cache_dir = g_strdup (g_getenv ("MONO_AOT_CACHE_DIR"));
+		use_aot_cache = TRUE;
+	}
 }
 
 static gboolean
@@ -1290,7 +1501,7 @@ mono_aot_get_method_from_vt_slot (MonoDomain *domain, MonoVTable *vtable, int sl
 	if (MONO_CLASS_IS_INTERFACE (klass) || klass->rank || !aot_module)
 		return NULL;
 
-	info = &aot_module->class_info [aot_module->class_info_offsets [mono_metadata_token_index (klass->type_token) - 1]];
+	info = &aot_module->class_info [get_offset (aot_module->class_info_offsets, mono_metadata_token_index (klass->type_token) - 1)];
 	p = info;
 
 	err = decode_cached_class_info (aot_module, &class_info, p, &p);
@@ -1322,7 +1533,7 @@ mono_aot_get_cached_class_info (MonoClass *klass, MonoCachedClassInfo *res)
 	if (klass->rank || !aot_module)
 		return FALSE;
 
-	p = (guint8*)&aot_module->class_info [aot_module->class_info_offsets [mono_metadata_token_index (klass->type_token) - 1]];
+	p = (guint8*)&aot_module->class_info [get_offset (aot_module->class_info_offsets, mono_metadata_token_index (klass->type_token) - 1)];
 
 	err = decode_cached_class_info (aot_module, res, p, &p);
 	if (!err)
@@ -1506,6 +1717,8 @@ decode_exception_debug_info (MonoAotModule *amodule, MonoDomain *domain,
 		jinfo = mono_domain_alloc0 (domain, MONO_SIZEOF_JIT_INFO + generic_info_size);
 	}
 
+	mono_jit_stats.aot_metadata_size += MONO_SIZEOF_JIT_INFO + generic_info_size + (jinfo->num_clauses * sizeof (MonoJitExceptionInfo));
+
 	jinfo->code_size = code_len;
 	jinfo->used_regs = used_int_regs;
 	jinfo->method = method;
@@ -1525,8 +1738,8 @@ decode_exception_debug_info (MonoAotModule *amodule, MonoDomain *domain,
 		gi->this_reg = decode_value (p, &p);
 		gi->this_offset = decode_value (p, &p);
 
-		/* This currently contains no data */
-		gi->generic_sharing_context = g_new0 (MonoGenericSharingContext, 1);
+		/* This currently contains no data, so it is shared by all methods */
+		gi->generic_sharing_context = &generic_sharing_context;
 
 		jinfo->method = decode_method_ref_2 (amodule, p, &p);
 	}
@@ -1607,18 +1820,65 @@ mono_aot_get_unwind_info (MonoJitInfo *ji, guint32 *unwind_info_len)
 	return p;
 }
 
+/*
+ * build_ip_index:
+ *
+ *   Build the table used by mono_aot_find_jit_info () to map a code offset to the
+ * method containing it. Entry I is the position in the method order table of the
+ * method containing offset I << ip_index_shift, so a lookup only has to skip the
+ * methods starting in the same chunk of code. The chunk size is about the average
+ * method size, so the table has about one entry per method.
+ *
+ * LOCKING: Assumes the aot lock is held.
+ */
+static void
+build_ip_index (MonoAotModule *amodule)
+{
+	guint32 *ptr, *table, *ip_index;
+	int table_len, code_len, shift, len, i, pos;
+
+	/* Skip the page index in front of the method order */
+	ptr = amodule->method_order;
+	while (*ptr != 0xffffff)
+		ptr ++;
+	ptr ++;
+
+	table = ptr;
+	table_len = amodule->method_order_end - table;
+	code_len = amodule->code_end - amodule->code;
+
+	shift = 4;
+	while (table_len && ((code_len / table_len) >> (shift + 1)))
+		shift ++;
+
+	len = (code_len >> shift) + 1;
+	ip_index = g_new0 (guint32, len);
+	pos = 0;
+	for (i = 0; i < len; ++i) {
+		while (pos + 1 < table_len && amodule->code_offsets [table [pos + 1]] <= (i << shift))
+			pos ++;
+		ip_index [i] = pos;
+	}
+
+	mono_jit_stats.aot_metadata_size += len * sizeof (guint32);
+
+	amodule->method_order_table = table;
+	amodule->method_order_len = table_len;
+	amodule->ip_index_shift = shift;
+	mono_memory_barrier ();
+	amodule->ip_index = ip_index;
+}
+
 MonoJitInfo *
 mono_aot_find_jit_info (MonoDomain *domain, MonoImage *image, gpointer addr)
 {
-	int pos, left, right, offset, offset1, offset2, last_offset, new_offset;
-	int page_index, method_index, table_len, is_wrapper;
+	int pos, left, right, offset, method_index, table_len, is_wrapper;
 	guint32 token;
 	MonoAotModule *amodule = image->aot_module;
 	MonoMethod *method;
 	MonoJitInfo *jinfo;
 	guint8 *code, *ex_info, *p;
-	guint32 *table, *ptr;
-	gboolean found;
+	guint32 *table;
 
 	if (!amodule)
 		return NULL;
@@ -1628,80 +1888,29 @@ mono_aot_find_jit_info (MonoDomain *domain, MonoImage *image, gpointer addr)
 		return NULL;
 
 	offset = (guint8*)addr - amodule->code;
-
-	/* First search through the index */
-	ptr = amodule->method_order;
-	last_offset = 0;
-	page_index = 0;
-	found = FALSE;
-
-	if (*ptr == 0xffffff)
+	if (offset < 0 || offset >= amodule->code_end - amodule->code)
 		return NULL;
-	ptr ++;
-
-	while (*ptr != 0xffffff) {
-		guint32 method_index = ptr [0];
-		new_offset = amodule->code_offsets [method_index];
-
-		if (offset >= last_offset && offset < new_offset) {
-			found = TRUE;
-			break;
-		}
-
-		ptr ++;
-		last_offset = new_offset;
-		page_index ++;
-	}
-
-	/* Skip rest of index */
-	while (*ptr != 0xffffff)
-		ptr ++;
-	ptr ++;
 
-	table = ptr;
-	table_len = amodule->method_order_end - table;
-
-	g_assert (table <= amodule->method_order_end);
-
-	if (found) {
-		left = (page_index * 1024);
-		right = left + 1024;
-
-		if (right > table_len)
-			right = table_len;
-
-		offset1 = amodule->code_offsets [table [left]];
-		g_assert (offset1 <= offset);
-
-		//printf ("Found in index: 0x%x 0x%x 0x%x\n", offset, last_offset, new_offset);
-	}
-	else {
-		//printf ("Not found in index: 0x%x\n", offset);
-		left = 0;
-		right = table_len;
+	if (!amodule->ip_index) {
+		mono_aot_lock ();
+		if (!amodule->ip_index)
+			build_ip_index (amodule);
+		mono_aot_unlock ();
 	}
+	mono_memory_read_barrier ();
 
-	/* Binary search inside the method_order table to find the method */
-	while (TRUE) {
-		pos = (left + right) / 2;
-
-		g_assert (table + pos <= amodule->method_order_end);
-
-		//printf ("Pos: %5d < %5d < %5d Offset: 0x%05x < 0x%05x < 0x%05x\n", left, pos, right, amodule->code_offsets [table [left]], offset, amodule->code_offsets [table [right]]);
+	table = amodule->method_order_table;
+	table_len = amodule->method_order_len;
+	if (!table_len)
+		return NULL;
 
-		offset1 = amodule->code_offsets [table [pos]];
-		if (table + pos + 1 >= amodule->method_order_end)
-			offset2 = amodule->code_end - amodule->code;
-		else
-			offset2 = amodule->code_offsets [table [pos + 1]];
+	/* Skip the methods starting before OFFSET in the same chunk */
+	pos = amodule->ip_index [offset >> amodule->ip_index_shift];
+	while (pos + 1 < table_len && amodule->code_offsets [table [pos + 1]] <= offset)
+		pos ++;
 
-		if (offset < offset1)
-			right = pos;
-		else if (offset >= offset2)
-			left = pos + 1;
-		else
-			break;
-	}
+	if (offset < amodule->code_offsets [table [pos]])
+		return NULL;
 
 	method_index = table [pos];
 
@@ -1757,7 +1966,7 @@ mono_aot_find_jit_info (MonoDomain *domain, MonoImage *image, gpointer addr)
 	//printf ("F: %s\n", mono_method_full_name (method, TRUE));
 
 	code = &amodule->code [amodule->code_offsets [method_index]];
-	ex_info = &amodule->ex_info [amodule->ex_info_offsets [method_index]];
+	ex_info = &amodule->ex_info [get_offset (amodule->ex_info_offsets, method_index)];
 
 	jinfo = decode_exception_debug_info (amodule, domain, method, ex_info, code);
 
@@ -1968,7 +2177,7 @@ load_patch_info (MonoAotModule *aot_module, MonoMemPool *mp, int n_patches,
 			/* Already loaded */
 			//printf ("HIT!\n");
 		} else {
-			shared_p = aot_module->got_info + aot_module->got_info_offsets [got_offset];
+			shared_p = aot_module->got_info + get_offset (aot_module->got_info_offsets, got_offset);
 
 			ji->type = decode_value (shared_p, &shared_p);
 
@@ -2054,11 +2263,13 @@ load_method (MonoDomain *domain, MonoAotModule *amodule, MonoImage *image, MonoM
 	}
 
 	code = &amodule->code [amodule->code_offsets [method_index]];
-	info = &amodule->method_info [amodule->method_info_offsets [method_index]];
+	info = &amodule->method_info [get_offset (amodule->method_info_offsets, method_index)];
 
 	mono_aot_lock ();
-	if (!amodule->methods_loaded)
+	if (!amodule->methods_loaded) {
 		amodule->methods_loaded = g_new0 (guint32, amodule->info.nmethods + 1);
+		mono_jit_stats.aot_metadata_size += (amodule->info.nmethods + 1) * sizeof (guint32);
+	}
 	mono_aot_unlock ();
 
 	if ((amodule->methods_loaded [method_index / 32] >> (method_index % 32)) & 0x1)
@@ -2142,7 +2353,7 @@ load_method (MonoDomain *domain, MonoAotModule *amodule, MonoImage *image, MonoM
 		full_name = mono_method_full_name (method, TRUE);
 
 		if (!jinfo) {
-			ex_info = &amodule->ex_info [amodule->ex_info_offsets [method_index]];
+			ex_info = &amodule->ex_info [get_offset (amodule->ex_info_offsets, method_index)];
 			jinfo = decode_exception_debug_info (amodule, domain, method, ex_info, code);
 		}
 
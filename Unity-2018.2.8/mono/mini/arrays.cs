@@ -647,6 +647,354 @@ class Tests {
         }
 		return 0;
 	}		
+
+	/* Loops the loop vectorizer handles, the results are checked by loops it doesn't */
+
+	static void vect_add (int[] a, int[] b, int[] c, int start, int n) {
+		for (int i = start; i < n; ++i)
+			a [i] = b [i] + c [i] * 3;
+	}
+
+	static void vect_scale (float[] a, float[] b, float s, int n) {
+		for (int i = 0; i < n; ++i)
+			a [i] = b [i] * s + 1.0f;
+	}
+
+	static int vect_sum (int[] a, int n) {
+		int s = 0;
+
+		for (int i = 0; i < n; ++i)
+			s += a [i];
+		return s;
+	}
+
+	static int vect_min (int[] a, int n) {
+		int m = Int32.MaxValue;
+
+		for (int i = 0; i < n; ++i)
+			m = Math.Min (m, a [i]);
+		return m;
+	}
+
+	static int vect_max (int[] a, int n) {
+		int m = Int32.MinValue;
+
+		for (int i = 0; i < n; ++i)
+			m = Math.Max (m, a [i]);
+		return m;
+	}
+
+	static int[] vect_data (int n) {
+		int[] a = new int [n];
+
+		for (int i = 0; i < n; ++i) {
+			if (i % 2 == 0)
+				a [i] = (i * 7) % 11 - 5;
+			else
+				a [i] = -((i * 13) % 17);
+		}
+		return a;
+	}
+
+	public static int test_0_vectorize_trip_counts () {
+		/* 0-3 never enter the vector loop, the rest leave 0-3 iterations to the epilogue */
+		for (int n = 0; n < 12; ++n) {
+			int[] a = new int [n];
+			int[] b = vect_data (n);
+
+			vect_add (a, b, b, 0, n);
+			for (int i = 0; i < n; ++i) {
+				if (a [i] != b [i] * 4)
+					return n + 1;
+			}
+		}
+		return 0;
+	}
+
+	public static int test_0_vectorize_float_trip_counts () {
+		for (int n = 0; n < 12; ++n) {
+			float[] a = new float [n];
+			float[] b = new float [n];
+
+			for (int i = 0; i < n; ++i) {
+				if (i % 2 == 0)
+					b [i] = i * 0.5f;
+				else
+					b [i] = i / 2.0f;
+			}
+			vect_scale (a, b, 2.0f, n);
+			for (int i = 0; i < n; ++i) {
+				if (a [i] != i + 1.0f)
+					return n + 1;
+			}
+		}
+		return 0;
+	}
+
+	public static int test_0_vectorize_start_index () {
+		int[] a = new int [16];
+		int[] b = vect_data (16);
+
+		vect_add (a, b, b, 3, 13);
+		for (int i = 0; i < 16; ++i) {
+			if (a [i] != ((i >= 3 && i < 13) ? b [i] * 4 : 0))
+				return 1;
+		}
+
+		/* The first iteration throws */
+		a = new int [16];
+		try {
+			vect_add (a, b, b, -2, 13);
+			return 2;
+		} catch (IndexOutOfRangeException) {
+		}
+		for (int i = 0; i < 16; ++i) {
+			if (a [i] != 0)
+				return 3;
+		}
+		return 0;
+	}
+
+	public static int test_0_vectorize_short_array () {
+		int[] a = new int [6];
+		int[] b = vect_data (16);
+
+		/* The elements before the end of a are still stored */
+		try {
+			vect_add (a, b, b, 0, 16);
+			return 1;
+		} catch (IndexOutOfRangeException) {
+		}
+		for (int i = 0; i < 6; ++i) {
+			if (a [i] != b [i] * 4)
+				return 2;
+		}
+		return 0;
+	}
+
+	public static int test_0_vectorize_aliased_arrays () {
+		int[] a = vect_data (11);
+		int[] orig = vect_data (11);
+
+		/* a [i] = a [i] + a [i] * 3 */
+		vect_add (a, a, a, 0, 11);
+		for (int i = 0; i < 11; ++i) {
+			if (a [i] != orig [i] * 4)
+				return 1;
+		}
+
+		float[] f = new float [9];
+		for (int i = 0; i < 9; ++i) {
+			if (i >= 0)
+				f [i] = i;
+		}
+		vect_scale (f, f, 3.0f, 9);
+		for (int i = 0; i < 9; ++i) {
+			if (f [i] != i * 3 + 1)
+				return 2;
+		}
+		return 0;
+	}
+
+	static int vect_bound;
+
+	static void vect_field_bound (int[] a) {
+		for (int i = 0; i < vect_bound; ++i) {
+			a [i] = i + 1;
+			vect_bound = 5;
+		}
+	}
+
+	public static int test_0_vectorize_field_bound_written_in_loop () {
+		int[] a = new int [16];
+
+		vect_bound = 16;
+		vect_field_bound (a);
+		for (int i = 0; i < 16; ++i) {
+			if (a [i] != (i < 5 ? i + 1 : 0))
+				return 1;
+		}
+		return 0;
+	}
+
+	public static int test_0_vectorize_reductions () {
+		for (int n = 0; n < 12; ++n) {
+			int[] a = vect_data (n);
+			int sum = 0, min = Int32.MaxValue, max = Int32.MinValue;
+
+			for (int i = 0; i < n; ++i) {
+				if (a [i] < min)
+					min = a [i];
+				if (a [i] > max)
+					max = a [i];
+				sum += a [i];
+			}
+			if (vect_sum (a, n) != sum)
+				return n * 3 + 1;
+			if (vect_min (a, n) != min)
+				return n * 3 + 2;
+			if (vect_max (a, n) != max)
+				return n * 3 + 3;
+		}
+		return 0;
+	}
+
+	/* Counted loops whose bounds checks are removed or hoisted, over long arrays so they aren't vectorized */
+
+	static long abc_sum (long[] a, int start, int n) {
+		long res = 0;
+
+		for (int i = start; i < n; ++i)
+			res += a [i];
+		return res;
+	}
+
+	static void abc_fill (long[] a, int n) {
+		for (int i = 0; i < n; ++i)
+			a [i] = i + 1;
+	}
+
+	static long[] abc_array (int n) {
+		long[] a = new long [n];
+
+		for (int i = 0; i < n; ++i) {
+			if (i >= 0)
+				a [i] = i + 1;
+		}
+		return a;
+	}
+
+	public static int test_55_abc_length_bound () {
+		long[] a = abc_array (10);
+		long res = 0;
+
+		for (int i = 0; i < a.Length; ++i)
+			res += a [i];
+		return (int)res;
+	}
+
+	public static int test_0_abc_versioned_loop () {
+		long[] a = abc_array (10);
+
+		if (abc_sum (a, 0, 10) != 55)
+			return 1;
+		if (abc_sum (a, 4, 10) != 45)
+			return 2;
+		if (abc_sum (a, 0, 0) != 0)
+			return 3;
+		return 0;
+	}
+
+	public static int test_0_abc_out_of_range () {
+		long[] a = new long [5];
+
+		/* The guards fail, the loop throws when it reaches a.Length */
+		try {
+			abc_fill (a, 8);
+			return 1;
+		} catch (IndexOutOfRangeException) {
+		}
+		for (int i = 0; i < 5; ++i) {
+			if (a [i] != i + 1)
+				return 2;
+		}
+
+		try {
+			abc_sum (a, -1, 5);
+			return 3;
+		} catch (IndexOutOfRangeException) {
+		}
+
+		try {
+			abc_sum (null, 0, 5);
+			return 4;
+		} catch (NullReferenceException) {
+		}
+		return 0;
+	}
+
+	static long[] abc_static;
+	long[] abc_instance;
+
+	static long abc_static_sum (int n) {
+		long res = 0;
+
+		for (int i = 0; i < n; ++i)
+			res += abc_static [i];
+		return res;
+	}
+
+	long abc_instance_sum (int n) {
+		long res = 0;
+
+		for (int i = 0; i < n; ++i)
+			res += abc_instance [i];
+		return res;
+	}
+
+	static void abc_replace_static (long[] other, int n) {
+		for (int i = 0; i < n; ++i) {
+			abc_static [i] = 7;
+			abc_static = other;
+		}
+	}
+
+	public static int test_0_abc_field_arrays () {
+		Tests t = new Tests ();
+
+		abc_static = abc_array (10);
+		t.abc_instance = abc_array (10);
+		if (abc_static_sum (10) != 55)
+			return 1;
+		if (t.abc_instance_sum (10) != 55)
+			return 2;
+
+		try {
+			abc_static_sum (11);
+			return 3;
+		} catch (IndexOutOfRangeException) {
+		}
+		try {
+			t.abc_instance_sum (11);
+			return 4;
+		} catch (IndexOutOfRangeException) {
+		}
+
+		/* The loop replaces the array, the stores have to go to the new one */
+		long[] first = new long [4];
+		long[] second = new long [2];
+		abc_static = first;
+		try {
+			abc_replace_static (second, 4);
+			return 5;
+		} catch (IndexOutOfRangeException) {
+		}
+		if (first [0] != 7 || first [1] != 0 || second [1] != 7)
+			return 6;
+		return 0;
+	}
+
+	static volatile long[] abc_volatile;
+
+	static long abc_volatile_sum (int n) {
+		long res = 0;
+
+		for (int i = 0; i < n; ++i)
+			res += abc_volatile [i];
+		return res;
+	}
+
+	public static int test_0_abc_volatile_field () {
+		abc_volatile = abc_array (10);
+		if (abc_volatile_sum (10) != 55)
+			return 1;
+		try {
+			abc_volatile_sum (11);
+			return 2;
+		} catch (IndexOutOfRangeException) {
+		}
+		return 0;
+	}
 }
 
 
@@ -202,6 +202,25 @@ class Tests {
 		return loops;
 	}
 
+	/* More vars live across the loop than there are callee saved registers */
+	public static int test_20528_register_pressure () {
+		int a = 1, b = 2, c = 3, d = 4, e = 5, f = 6, g = 7, h = 8;
+		int sum = 0;
+
+		for (int i = 0; i < 10000000; i++) {
+			a += b ^ i;
+			b += c;
+			c ^= d + i;
+			d += e;
+			e -= f;
+			f += g ^ h;
+			g += a;
+			h ^= b;
+			sum += a ^ h;
+		}
+		return sum & 0xffff;
+	}
+
 	/*
         /// Gaussian blur of a generated grayscale picture
         private int test_0_blur(int size) {
@@ -1448,4 +1448,179 @@ mono_optimize_branches (MonoCompile *cfg)
 	} while (changed && (niterations > 0));
 }
 
+/*
+ * is_cold_clause:
+ *
+ *   Return whenever the handler of clause INDEX can be moved away from its try block.
+ * This is only done for catch/filter clauses which don't overlap other clauses, so
+ * the try block is covered by a single clause and its range can be computed from
+ * the bblocks of its region.
+ */
+static gboolean
+is_cold_clause (MonoCompile *cfg, MonoMethodHeader *header, int index)
+{
+	MonoExceptionClause *clause = &header->clauses [index];
+	MonoExceptionClause *other;
+	MonoBasicBlock *bb, *first = NULL, *last = NULL;
+	int i, start, end, region;
+
+	if (clause->flags != MONO_EXCEPTION_CLAUSE_NONE && clause->flags != MONO_EXCEPTION_CLAUSE_FILTER)
+		return FALSE;
+
+	start = MIN (clause->try_offset, clause->handler_offset);
+	if (clause->flags == MONO_EXCEPTION_CLAUSE_FILTER)
+		start = MIN (start, clause->data.filter_offset);
+	end = MAX (clause->try_offset + clause->try_len, clause->handler_offset + clause->handler_len);
+	for (i = 0; i < header->num_clauses; ++i) {
+		int other_start, other_end;
+
+		if (i == index)
+			continue;
+		other = &header->clauses [i];
+		other_start = MIN (other->try_offset, other->handler_offset);
+		if (other->flags == MONO_EXCEPTION_CLAUSE_FILTER)
+			other_start = MIN (other_start, other->data.filter_offset);
+		other_end = MAX (other->try_offset + other->try_len, other->handler_offset + other->handler_len);
+		if (other_start < end && start < other_end)
+			return FALSE;
+	}
+
+	/* The bblocks of the try block have to be consecutive */
+	region = ((index + 1) << 8) | MONO_REGION_TRY | clause->flags;
+	for (bb = cfg->bb_entry; bb; bb = bb->next_bb) {
+		if (bb->region == region) {
+			if (!first)
+				first = bb;
+			last = bb;
+		}
+	}
+	if (!first)
+		return FALSE;
+	for (bb = first; bb != last; bb = bb->next_bb)
+		if (bb->region != region)
+			return FALSE;
+	return TRUE;
+}
+
+/*
+ * Out of line bblocks are only moved outside of clauses.  Inside a try block they
+ * stay where they are, since the native code of a try block has to be contiguous
+ * for the exception clause ranges, so throw paths in try blocks are not moved.
+ */
+static gboolean
+is_cold_bblock (MonoCompile *cfg, MonoBasicBlock *bb)
+{
+	if (bb->region == -1)
+		return bb->out_of_line;
+	if (!cfg->cold_clauses || !cfg->cold_clauses [(bb->region >> 8) - 1])
+		return FALSE;
+	return MONO_BBLOCK_IS_IN_REGION (bb, MONO_REGION_CATCH) || MONO_BBLOCK_IS_IN_REGION (bb, MONO_REGION_FILTER);
+}
+
+/*
+ * Returns true if execution can continue from the end of @bb into the next bblock
+ * in the code layout.
+ */
+static gboolean
+bblock_falls_through (MonoBasicBlock *bb)
+{
+	if (!bb->last_ins)
+		return TRUE;
+
+	switch (bb->last_ins->opcode) {
+	case OP_BR:
+	case OP_BR_REG:
+	case OP_NOT_REACHED:
+	case OP_RETHROW:
+	case OP_ENDFINALLY:
+	case OP_ENDFILTER:
+	case OP_JMP:
+		return FALSE;
+	default:
+		/* The branch to the false target is added later if needed */
+		return !(MONO_IS_COND_BRANCH_OP (bb->last_ins) && bb->last_ins->inst_false_bb);
+	}
+}
+
+static void
+add_branch (MonoCompile *cfg, MonoBasicBlock *bb, MonoBasicBlock *target)
+{
+	MonoInst *ins;
+
+	MONO_INST_NEW (cfg, ins, OP_BR);
+	ins->inst_target_bb = target;
+	MONO_ADD_INS (bb, ins);
+}
+
+/*
+ * mono_move_cold_bblocks:
+ *
+ *   Move the rarely executed parts of the method, i.e. the out of line bblocks and
+ * the handlers of catch clauses, after the rest of the code, so the code which runs
+ * normally is dense in the i-cache. This changes the code layout, so it should run
+ * right before code generation.
+ */
+void
+mono_move_cold_bblocks (MonoCompile *cfg)
+{
+	MonoMethodHeader *header = mono_method_get_header (cfg->method);
+	MonoBasicBlock *bb, *prev, *next, *cold_first = NULL, *cold_last = NULL;
+	int i;
+
+	if (cfg->disable_out_of_line_bblocks)
+		return;
+
+	if (header->num_clauses) {
+		cfg->cold_clauses = mono_mempool_alloc0 (cfg->mempool, header->num_clauses);
+		for (i = 0; i < header->num_clauses; ++i)
+			cfg->cold_clauses [i] = is_cold_clause (cfg, header, i);
+	}
+
+	prev = cfg->bb_entry;
+	for (bb = prev->next_bb; bb; bb = next) {
+		next = bb->next_bb;
+		if (bb == cfg->bb_exit || !is_cold_bblock (cfg, bb)) {
+			prev = bb;
+			continue;
+		}
+
+		if (bblock_falls_through (prev))
+			add_branch (cfg, prev, bb);
+		/* Consecutive cold bblocks stay together */
+		if (next && bblock_falls_through (bb) && (next == cfg->bb_exit || !is_cold_bblock (cfg, next)))
+			add_branch (cfg, bb, next);
+
+		prev->next_bb = next;
+		bb->next_bb = NULL;
+		if (cold_last)
+			cold_last->next_bb = bb;
+		else
+			cold_first = bb;
+		cold_last = bb;
+		mono_jit_stats.cold_bblocks++;
+	}
+	prev->next_bb = cold_first;
+}
+
+/*
+ * mono_cold_clause_try_end:
+ *
+ *   Return the bblock following the try block of the clause CLAUSE_INDEX, whose
+ * handler was moved by mono_move_cold_bblocks ().
+ */
+MonoBasicBlock*
+mono_cold_clause_try_end (MonoCompile *cfg, int clause_index)
+{
+	MonoMethodHeader *header = mono_method_get_header (cfg->method);
+	MonoBasicBlock *bb, *last = NULL;
+	int region;
+
+	region = ((clause_index + 1) << 8) | MONO_REGION_TRY | header->clauses [clause_index].flags;
+	for (bb = cfg->bb_entry; bb; bb = bb->next_bb)
+		if (bb->region == region)
+			last = bb;
+	g_assert (last);
+	return last->next_bb;
+}
+
 #endif /* DISABLE_JIT */
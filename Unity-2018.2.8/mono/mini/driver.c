@@ -132,9 +132,10 @@ opt_funcs [sizeof (int) * 8] = {
     MONO_OPT_CMOV |  \
 	MONO_OPT_GSHARED |	\
 	MONO_OPT_SIMD |	\
+	MONO_OPT_ESCAPE |	\
 	MONO_OPT_AOT)
 
-#define EXCLUDED_FROM_ALL (MONO_OPT_SHARED | MONO_OPT_PRECOMP)
+#define EXCLUDED_FROM_ALL (MONO_OPT_SHARED | MONO_OPT_PRECOMP | MONO_OPT_TIER0)
 
 static guint32
 parse_optimizations (const char* p)
@@ -764,9 +764,10 @@ mono_arch_find_jit_info_ext (MonoDomain *domain, MonoJitTlsData *jit_tls,
 		regs [AMD64_R14] = new_ctx->r14;
 		regs [AMD64_R15] = new_ctx->r15;
 
-		mono_unwind_frame (unwind_info, unwind_info_len, ji->code_start, 
-						   (guint8*)ji->code_start + ji->code_size,
-						   ip, regs, MONO_MAX_IREGS + 1, &cfa);
+		mono_unwind_frame_cached (jit_tls ? jit_tls->unwind_cache : NULL,
+								  unwind_info, unwind_info_len, ji->code_start, 
+								  (guint8*)ji->code_start + ji->code_size,
+								  ip, regs, MONO_MAX_IREGS + 1, &cfa);
 
 		new_ctx->rax = regs [AMD64_RAX];
 		new_ctx->rbx = regs [AMD64_RBX];
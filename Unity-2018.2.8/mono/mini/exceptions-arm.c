@@ -406,9 +406,10 @@ mono_arch_find_jit_info_ext (MonoDomain *domain, MonoJitTlsData *jit_tls,
 			regs [i] = new_ctx->regs [i];
 		regs [ARMREG_SP] = new_ctx->esp;
 
-		mono_unwind_frame (unwind_info, unwind_info_len, ji->code_start, 
-						   (guint8*)ji->code_start + ji->code_size,
-						   ip, regs, MONO_MAX_IREGS, &cfa);
+		mono_unwind_frame_cached (jit_tls ? jit_tls->unwind_cache : NULL,
+								  unwind_info, unwind_info_len, ji->code_start, 
+								  (guint8*)ji->code_start + ji->code_size,
+								  ip, regs, MONO_MAX_IREGS, &cfa);
 
 		for (i = 0; i < 16; ++i)
 			new_ctx->regs [i] = regs [i];
@@ -887,9 +887,10 @@ mono_arch_find_jit_info_ext (MonoDomain *domain, MonoJitTlsData *jit_tls,
 		regs [X86_EDI] = new_ctx->edi;
 		regs [X86_NREG] = new_ctx->eip;
 
-		mono_unwind_frame (unwind_info, unwind_info_len, ji->code_start, 
-						   (guint8*)ji->code_start + ji->code_size,
-						   ip, regs, MONO_MAX_IREGS + 1, &cfa);
+		mono_unwind_frame_cached (jit_tls ? jit_tls->unwind_cache : NULL,
+								  unwind_info, unwind_info_len, ji->code_start, 
+								  (guint8*)ji->code_start + ji->code_size,
+								  ip, regs, MONO_MAX_IREGS + 1, &cfa);
 
 		new_ctx->eax = regs [X86_EAX];
 		new_ctx->ebx = regs [X86_EBX];
@@ -2606,5 +2606,120 @@ class Tests {
 
 		return 1;
 	}
+
+	static int cold_throw (int i) {
+		if ((i % 3) == 0)
+			throw new ArgumentException ();
+		return i;
+	}
+
+	/* The catch handler below is moved after the rest of the method */
+	public static int test_41_cold_catch () {
+		int res = 0;
+
+		for (int i = 0; i < 10; ++i) {
+			try {
+				res += cold_throw (i);
+			} catch (ArgumentException) {
+				res++;
+			}
+			res++;
+		}
+		return res;
+	}
+
+	public static int test_0_cold_nested_catch () {
+		int inner = 0, outer = 0, after = 0;
+
+		for (int i = 0; i < 12; ++i) {
+			try {
+				try {
+					if ((i % 4) == 0)
+						throw new InvalidOperationException ();
+					cold_throw (i);
+				} catch (ArgumentException) {
+					inner++;
+				}
+				after++;
+			} catch (InvalidOperationException) {
+				outer++;
+			}
+		}
+		/* i = 0, 4, 8 throw to the outer catch, i = 3, 6, 9 to the inner one */
+		if (outer != 3 || inner != 3 || after != 9)
+			return 1;
+		return 0;
+	}
+
+	public static int test_0_cold_catch_finally () {
+		int fin = 0, normal = 0, caught = 0;
+
+		for (int i = 0; i < 6; ++i) {
+			try {
+				try {
+					cold_throw (i);
+				} finally {
+					fin++;
+				}
+				normal++;
+			} catch (ArgumentException) {
+				caught++;
+			}
+		}
+		if (fin != 6 || normal != 4 || caught != 2)
+			return 1;
+
+		/* A moved catch next to a finally clause which isn't nested in it */
+		fin = 0;
+		caught = 0;
+		for (int i = 0; i < 6; ++i) {
+			try {
+				cold_throw (i);
+			} catch (ArgumentException) {
+				caught++;
+			}
+			try {
+				if (i == 5)
+					cold_throw (0);
+			} catch (ArgumentException) {
+				caught += 10;
+			} finally {
+				fin++;
+			}
+		}
+		if (fin != 6 || caught != 12)
+			return 2;
+		return 0;
+	}
+
+	static int rethrow_from_catch (int i, bool rethrow) {
+		try {
+			cold_throw (i);
+		} catch (ArgumentException) {
+			if (rethrow)
+				throw;
+			throw new InvalidOperationException ();
+		}
+		return i;
+	}
+
+	/* Unwinding out of a moved handler */
+	public static int test_0_cold_catch_unwind () {
+		if (rethrow_from_catch (1, false) != 1)
+			return 1;
+		try {
+			rethrow_from_catch (0, false);
+			return 2;
+		} catch (InvalidOperationException) {
+		}
+		try {
+			rethrow_from_catch (3, true);
+			return 3;
+		} catch (ArgumentException e) {
+			if (e.StackTrace.IndexOf ("cold_throw") == -1)
+				return 4;
+		}
+		return 0;
+	}
 }
 
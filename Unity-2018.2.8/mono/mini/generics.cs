@@ -669,4 +669,115 @@ class Tests {
 	static T Unbox <T> (object o) {
 		return (T) o;
 	}
+
+	/*
+	 * Shared code for reference type instantiations, whose small callees are
+	 * inlined when their rgctx can be reached through this.
+	 */
+	class SharedInline <T> {
+		T[] items = new T [4];
+		int count;
+
+		public int Count {
+			get { return count; }
+		}
+
+		T[] NewArray (int n) {
+			return new T [n];
+		}
+
+		bool IsT (object o) {
+			return o is T;
+		}
+
+		Type ElementType () {
+			return typeof (T);
+		}
+
+		T Cast (object o) {
+			return (T) o;
+		}
+
+		void Grow () {
+			T[] n = NewArray (items.Length * 2);
+			Array.Copy (items, n, count);
+			items = n;
+		}
+
+		public void Add (object o) {
+			if (count == items.Length)
+				Grow ();
+			items [count++] = Cast (o);
+		}
+
+		public T Get (int i) {
+			return items [i];
+		}
+
+		public int CountT (object[] objs) {
+			int res = 0;
+
+			foreach (object o in objs)
+				if (IsT (o))
+					res++;
+			return res;
+		}
+
+		public bool HasElementType (Type t) {
+			return ElementType () == t && items.GetType ().GetElementType () == t;
+		}
+
+		/* Not inlined: static, and generic methods need the method's own rgctx */
+		static T[] StaticNewArray (int n) {
+			return new T [n];
+		}
+
+		U[] GenericNewArray <U> (int n) {
+			return new U [n];
+		}
+
+		public int Fallback () {
+			return StaticNewArray (2).Length + GenericNewArray<T> (3).Length + GenericNewArray<List<T>> (4).Length;
+		}
+
+		public Type ListType () {
+			return new List<T> ().GetType ();
+		}
+	}
+
+	public static int test_0_shared_inline_rgctx () {
+		SharedInline<string> s = new SharedInline<string> ();
+		SharedInline<object> o = new SharedInline<object> ();
+
+		for (int i = 0; i < 10; ++i) {
+			s.Add (i.ToString ());
+			o.Add (i);
+		}
+		if (s.Count != 10 || s.Get (9) != "9" || (int)o.Get (3) != 3)
+			return 1;
+		if (!s.HasElementType (typeof (string)) || !o.HasElementType (typeof (object)))
+			return 2;
+
+		object[] objs = new object [] { "a", 1, "b", null, new object () };
+		if (s.CountT (objs) != 2 || o.CountT (objs) != 4)
+			return 3;
+
+		try {
+			s.Add (1);
+			return 4;
+		} catch (InvalidCastException) {
+		}
+		return 0;
+	}
+
+	public static int test_9_shared_inline_fallback () {
+		SharedInline<string> s = new SharedInline<string> ();
+		SharedInline<Tests> t = new SharedInline<Tests> ();
+
+		if (s.ListType () != typeof (List<string>) || t.ListType () != typeof (List<Tests>))
+			return 0;
+		if (s.Fallback () != t.Fallback ())
+			return 0;
+		return s.Fallback ();
+	}
 }
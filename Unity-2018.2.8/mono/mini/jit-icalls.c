@@ -1037,3 +1037,29 @@ mono_get_native_calli_wrapper (MonoImage *image, MonoMethodSignature *sig, gpoin
 
 	return mono_compile_method (m);
 }
+
+/*
+ * mono_inline_cache_miss:
+ *
+ *   Called by tier-0 code when the receiver of a virtual call has none of the
+ * types in CACHE.  A free entry is taken if there is one, otherwise the entry
+ * with the fewest hits is replaced, and its hits become misses.
+ */
+void
+mono_inline_cache_miss (MonoInlineCache *cache, MonoObject *obj)
+{
+	int i, victim = 0;
+
+	for (i = 0; i < MONO_INLINE_CACHE_SIZE; ++i) {
+		if (!cache->vtables [i]) {
+			victim = i;
+			break;
+		}
+		if (cache->hits [i] < cache->hits [victim])
+			victim = i;
+	}
+
+	cache->misses += cache->hits [victim];
+	cache->vtables [victim] = obj->vtable;
+	cache->hits [victim] = 1;
+}
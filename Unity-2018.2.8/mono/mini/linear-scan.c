@@ -280,10 +280,11 @@ regalloc_cost (MonoCompile *cfg, MonoMethodVar *vmv)
 void
 mono_linear_scan2 (MonoCompile *cfg, GList *vars, GList *regs, regmask_t *used_mask)
 {
-	GList *unhandled, *active, *inactive, *l;
+	GList *unhandled, *active, *inactive, *new_inactive, *l, *next;
 	MonoMethodVar *vmv;
 	gint32 free_pos [sizeof (regmask_t) * 8];
 	gint32 gains [sizeof (regmask_t) * 8];
+	gint32 spill_costs [sizeof (regmask_t) * 8];
 	regmask_t used_regs = 0;
 	int n_regs, n_regvars, i;
 
@@ -300,11 +301,11 @@ mono_linear_scan2 (MonoCompile *cfg, GList *vars, GList *regs, regmask_t *used_m
 	unhandled = g_list_sort (g_list_copy (vars), compare_by_interval_start_pos_func);
 	active = NULL;
 	inactive = NULL;
+	new_inactive = NULL;
 
 	while (unhandled) {
 		MonoMethodVar *current = unhandled->data;
 		int pos, reg, max_free_pos;
-		gboolean changed;
 
 		unhandled = g_list_delete_link (unhandled, unhandled);
 
@@ -318,62 +319,51 @@ mono_linear_scan2 (MonoCompile *cfg, GList *vars, GList *regs, regmask_t *used_m
 		pos = current->interval->range->from;
 
 		/* Check for intervals in active which expired or inactive */
-		changed = TRUE;
-		/* FIXME: Optimize this */
-		while (changed) {
-			changed = FALSE;
-			for (l = active; l != NULL; l = l->next) {
-				MonoMethodVar *v = (MonoMethodVar*)l->data;
-
-				if (v->interval->last_range->to < pos) {
-					active = g_list_delete_link (active, l);
-					LSCAN_DEBUG (printf ("Interval R%d has expired\n", cfg->varinfo [v->idx]->dreg));
-					changed = TRUE;
-					break;
-				}
-				else if (!mono_linterval_covers (v->interval, pos)) {
-					inactive = g_list_append (inactive, v);
-					active = g_list_delete_link (active, l);
-					LSCAN_DEBUG (printf ("Interval R%d became inactive\n", cfg->varinfo [v->idx]->dreg));
-					changed = TRUE;
-					break;
-				}
+		for (l = active; l != NULL; l = next) {
+			MonoMethodVar *v = (MonoMethodVar*)l->data;
+
+			next = l->next;
+			if (v->interval->last_range->to < pos) {
+				active = g_list_delete_link (active, l);
+				LSCAN_DEBUG (printf ("Interval R%d has expired\n", cfg->varinfo [v->idx]->dreg));
+			}
+			else if (!mono_linterval_covers (v->interval, pos)) {
+				active = g_list_delete_link (active, l);
+				new_inactive = g_list_prepend (new_inactive, v);
+				LSCAN_DEBUG (printf ("Interval R%d became inactive\n", cfg->varinfo [v->idx]->dreg));
 			}
 		}
 
 		/* Check for intervals in inactive which expired or active */
-		changed = TRUE;
-		/* FIXME: Optimize this */
-		while (changed) {
-			changed = FALSE;
-			for (l = inactive; l != NULL; l = l->next) {
-				MonoMethodVar *v = (MonoMethodVar*)l->data;
-
-				if (v->interval->last_range->to < pos) {
-					inactive = g_list_delete_link (inactive, l);
-					LSCAN_DEBUG (printf ("\tInterval R%d has expired\n", cfg->varinfo [v->idx]->dreg));
-					changed = TRUE;
-					break;
-				}
-				else if (mono_linterval_covers (v->interval, pos)) {
-					active = g_list_append (active, v);
-					inactive = g_list_delete_link (inactive, l);
-					LSCAN_DEBUG (printf ("\tInterval R%d became active\n", cfg->varinfo [v->idx]->dreg));
-					changed = TRUE;
-					break;
-				}
+		for (l = inactive; l != NULL; l = next) {
+			MonoMethodVar *v = (MonoMethodVar*)l->data;
+
+			next = l->next;
+			if (v->interval->last_range->to < pos) {
+				inactive = g_list_delete_link (inactive, l);
+				LSCAN_DEBUG (printf ("\tInterval R%d has expired\n", cfg->varinfo [v->idx]->dreg));
+			}
+			else if (mono_linterval_covers (v->interval, pos)) {
+				inactive = g_list_delete_link (inactive, l);
+				active = g_list_prepend (active, v);
+				LSCAN_DEBUG (printf ("\tInterval R%d became active\n", cfg->varinfo [v->idx]->dreg));
 			}
 		}
+		inactive = g_list_concat (new_inactive, inactive);
+		new_inactive = NULL;
 
 		/* Find a register for the current interval */
-		for (i = 0; i < n_regs; ++i)
+		for (i = 0; i < n_regs; ++i) {
 			free_pos [i] = ((gint32)0x7fffffff);
+			spill_costs [i] = 0;
+		}
 
 		for (l = active; l != NULL; l = l->next) {
 			MonoMethodVar *v = (MonoMethodVar*)l->data;
 
 			if (v->reg >= 0) {
 				free_pos [v->reg] = 0;
+				spill_costs [v->reg] += v->spill_costs;
 				LSCAN_DEBUG (printf ("\threg %d is busy (cost %d)\n", v->reg, v->spill_costs));
 			}
 		}
@@ -385,7 +375,9 @@ mono_linear_scan2 (MonoCompile *cfg, GList *vars, GList *regs, regmask_t *used_m
 			if (v->reg >= 0) {
 				intersect_pos = mono_linterval_get_intersect_pos (current->interval, v->interval);
 				if (intersect_pos != -1) {
-					free_pos [v->reg] = intersect_pos;
+					if (intersect_pos < free_pos [v->reg])
+						free_pos [v->reg] = intersect_pos;
+					spill_costs [v->reg] += v->spill_costs;
 					LSCAN_DEBUG (printf ("\threg %d becomes free at %d\n", v->reg, intersect_pos));
 				}
 			}
@@ -406,54 +398,59 @@ mono_linear_scan2 (MonoCompile *cfg, GList *vars, GList *regs, regmask_t *used_m
 			current->reg = reg;
 			LSCAN_DEBUG (printf ("\tAssigned hreg %d to R%d\n", reg, cfg->varinfo [current->idx]->dreg));
 
-			active = g_list_append (active, current);
+			active = g_list_prepend (active, current);
 			gains [current->reg] += current->spill_costs;
 		}
 		else {
 			/* 
 			 * free_pos [reg] > 0 means there is a register available for parts
-			 * of the interval, so splitting it is possible. This is not yet
-			 * supported, so we spill in this case too.
+			 * of the interval, so splitting it is possible. This is not
+			 * supported, since a variable either lives in a register or on the
+			 * stack for the whole method, so one of the conflicting intervals
+			 * has to be spilled.
+			 *
+			 * Pick the register whose conflicting intervals are the cheapest to
+			 * spill, and evict them if they are cheaper than the current interval.
 			 */
+			int min_spill_reg = -1;
+			gint32 min_spill_cost = G_MAXINT32;
 
-			/* Spill an interval */
-
-			/* FIXME: Optimize the selection of the interval */
-
-			if (active) {
-				GList *min_spill_pos;
-#if 0
-				/* 
-				 * This favors registers with big spill costs, thus larger liveness ranges,
-				 * thus actually leading to worse code size.
-				 */
-				guint32 min_spill_value = G_MAXINT32;
+			for (i = 0; i < n_regs; ++i) {
+				if (spill_costs [i] < min_spill_cost) {
+					min_spill_reg = i;
+					min_spill_cost = spill_costs [i];
+				}
+			}
 
-				for (l = active; l != NULL; l = l->next) {
+			if (min_spill_reg != -1 && min_spill_cost < current->spill_costs) {
+				for (l = active; l != NULL; l = next) {
 					vmv = (MonoMethodVar*)l->data;
-
-					if (vmv->spill_costs < min_spill_value) {
-						min_spill_pos = l;
-						min_spill_value = vmv->spill_costs;
+					next = l->next;
+					if (vmv->reg == min_spill_reg) {
+						LSCAN_DEBUG (printf ("\tSpilled R%d\n", cfg->varinfo [vmv->idx]->dreg));
+						gains [vmv->reg] -= vmv->spill_costs;
+						vmv->reg = -1;
+						active = g_list_delete_link (active, l);
 					}
 				}
-#else
-				/* Spill either the first active or the current interval */
-				min_spill_pos = active;
-#endif
-				vmv = (MonoMethodVar*)min_spill_pos->data;
-				if (vmv->spill_costs < current->spill_costs) {
-				//				if (vmv->interval->last_range->to < current->interval->last_range->to) {
-					gains [vmv->reg] -= vmv->spill_costs;
-					vmv->reg = -1;
-					LSCAN_DEBUG (printf ("\tSpilled R%d\n", cfg->varinfo [vmv->idx]->dreg));
-					active = g_list_delete_link (active, min_spill_pos);
+				for (l = inactive; l != NULL; l = next) {
+					vmv = (MonoMethodVar*)l->data;
+					next = l->next;
+					if (vmv->reg == min_spill_reg && mono_linterval_get_intersect_pos (current->interval, vmv->interval) != -1) {
+						LSCAN_DEBUG (printf ("\tSpilled R%d\n", cfg->varinfo [vmv->idx]->dreg));
+						gains [vmv->reg] -= vmv->spill_costs;
+						vmv->reg = -1;
+						inactive = g_list_delete_link (inactive, l);
+					}
 				}
-				else
-					LSCAN_DEBUG (printf ("\tSpilled current (cost %d)\n", current->spill_costs));
+
+				current->reg = min_spill_reg;
+				LSCAN_DEBUG (printf ("\tAssigned hreg %d to R%d\n", min_spill_reg, cfg->varinfo [current->idx]->dreg));
+				active = g_list_prepend (active, current);
+				gains [current->reg] += current->spill_costs;
 			}
 			else
-				LSCAN_DEBUG (printf ("\tSpilled current\n"));
+				LSCAN_DEBUG (printf ("\tSpilled current (cost %d)\n", current->spill_costs));
 		}
 	}
 
@@ -482,8 +482,16 @@ mono_analyze_liveness (MonoCompile *cfg)
 		optimize_initlocals (cfg);
 
 #ifdef ENABLE_LIVENESS2
-	/* This improves code size by about 5% but slows down compilation too much */
+	/*
+	 * This improves code size by about 5%. It used to slow down compilation
+	 * too much to be done in JIT mode, but its cost is now linear in the size
+	 * of the method, so archs can opt into it.
+	 */
+#ifdef MONO_ARCH_ENABLE_LIVE_INTERVALS
+	if (cfg->compile_aot || (cfg->opt & MONO_OPT_LINEARS))
+#else
 	if (cfg->compile_aot)
+#endif
 		mono_analyze_liveness2 (cfg);
 #endif
 }
@@ -689,9 +697,35 @@ mono_linterval_split (MonoCompile *cfg, MonoLiveInterval *interval, MonoLiveInte
 #define LIVENESS_DEBUG(a)
 #endif
 
+/*
+ * The per-bblock state of the liveness2 pass. Instead of clearing and scanning
+ * last_use for every variable in every bblock, the vars whose last_use was set
+ * in the current bblock are collected in TOUCHED, making the pass linear in the
+ * size of the method.
+ */
+typedef struct {
+	gint32 *last_use;
+	int *touched;
+	int ntouched;
+	/* The bblock stamp of the last time the var was added to TOUCHED */
+	gint32 *touched_stamp;
+	gint32 stamp;
+} Liveness2State;
+
+static inline void
+set_last_use (Liveness2State *state, int idx, gint32 pos)
+{
+	state->last_use [idx] = pos;
+	if (state->touched_stamp [idx] != state->stamp) {
+		state->touched_stamp [idx] = state->stamp;
+		state->touched [state->ntouched ++] = idx;
+	}
+}
+
 static inline void
-update_liveness2 (MonoCompile *cfg, MonoInst *ins, gboolean set_volatile, int inst_num, gint32 *last_use)
+update_liveness2 (MonoCompile *cfg, MonoInst *ins, gboolean set_volatile, int inst_num, Liveness2State *state)
 {
+	gint32 *last_use = state->last_use;
 	const char *spec = INS_INFO (ins->opcode);
 	int sreg;
 	int num_sregs, i;
@@ -711,7 +745,7 @@ update_liveness2 (MonoCompile *cfg, MonoInst *ins, gboolean set_volatile, int in
 		if (MONO_IS_STORE_MEMBASE (ins)) {
 			if (last_use [idx] == 0) {
 				LIVENESS_DEBUG (printf ("\tlast use of R%d set to %x\n", ins->dreg, inst_num));
-				last_use [idx] = inst_num;
+				set_last_use (state, idx, inst_num);
 			}
 		} else {
 			if (last_use [idx] > 0) {
@@ -745,7 +779,7 @@ update_liveness2 (MonoCompile *cfg, MonoInst *ins, gboolean set_volatile, int in
 
 			if (last_use [idx] == 0) {
 				LIVENESS_DEBUG (printf ("\tlast use of R%d set to %x\n", sreg, inst_num));
-				last_use [idx] = inst_num;
+				set_last_use (state, idx, inst_num);
 			}
 		}
 	}
@@ -754,8 +788,8 @@ update_liveness2 (MonoCompile *cfg, MonoInst *ins, gboolean set_volatile, int in
 static void
 mono_analyze_liveness2 (MonoCompile *cfg)
 {
-	int bnum, idx, i, j, nins, rem, max, max_vars, block_from, block_to, pos, reverse_len;
-	gint32 *last_use;
+	int bnum, idx, i, j, nins, max, max_vars, block_from, block_to, pos, reverse_len;
+	Liveness2State state;
 	static guint32 disabled = -1;
 	MonoInst **reverse;
 
@@ -773,7 +807,9 @@ mono_analyze_liveness2 (MonoCompile *cfg)
 	*/
 
 	max_vars = cfg->num_varinfo;
-	last_use = g_new0 (gint32, max_vars);
+	state.last_use = g_new0 (gint32, max_vars);
+	state.touched = g_new0 (int, max_vars);
+	state.touched_stamp = g_new0 (gint32, max_vars);
 
 	reverse_len = 1024;
 	reverse = mono_mempool_alloc (cfg->mempool, sizeof (MonoInst*) * reverse_len);
@@ -801,11 +837,12 @@ mono_analyze_liveness2 (MonoCompile *cfg)
 
 		LIVENESS_DEBUG (printf ("LIVENESS BLOCK BB%d:\n", bb->block_num));
 
-		memset (last_use, 0, max_vars * sizeof (gint32));
-		
+		/* last_use is all zero at this point */
+		state.ntouched = 0;
+		state.stamp = bnum + 1;
+
 		/* For variables in bb->live_out, set last_use to block_to */
 
-		rem = max_vars % BITS_PER_CHUNK;
 		max = ((max_vars + (BITS_PER_CHUNK -1)) / BITS_PER_CHUNK);
 		for (j = 0; j < max; ++j) {
 			gsize bits_out;
@@ -816,7 +853,7 @@ mono_analyze_liveness2 (MonoCompile *cfg)
 			while (bits_out) {
 				if (bits_out & 1) {
 					LIVENESS_DEBUG (printf ("Var R%d live at exit, set last_use to %x\n", cfg->varinfo [k]->dreg, block_to));
-					last_use [k] = block_to;
+					set_last_use (&state, k, block_to);
 				}
 				bits_out >>= 1;
 				k ++;
@@ -824,7 +861,7 @@ mono_analyze_liveness2 (MonoCompile *cfg)
 		}
 
 		if (cfg->ret)
-			last_use [cfg->ret->inst_c0] = block_to;
+			set_last_use (&state, cfg->ret->inst_c0, block_to);
 
 		for (nins = 0, pos = block_from, ins = bb->code; ins; ins = ins->next, ++nins, ++pos) {
 			if (nins >= reverse_len) {
@@ -842,18 +879,21 @@ mono_analyze_liveness2 (MonoCompile *cfg)
 		for (i = nins - 1; i >= 0; --i) {
 			MonoInst *ins = (MonoInst*)reverse [i];
 
- 			update_liveness2 (cfg, ins, FALSE, pos, last_use);
+ 			update_liveness2 (cfg, ins, FALSE, pos, &state);
 
 			pos --;
 		}
 
-		for (idx = 0; idx < max_vars; ++idx) {
-			MonoMethodVar *vi = MONO_VARINFO (cfg, idx);
+		for (j = 0; j < state.ntouched; ++j) {
+			MonoMethodVar *vi;
 
-			if (last_use [idx] != 0) {
+			idx = state.touched [j];
+			vi = MONO_VARINFO (cfg, idx);
+			if (state.last_use [idx] != 0) {
 				/* Live at exit, not written -> live on enter */
-				LIVENESS_DEBUG (printf ("Var R%d live at enter, add range to R%d: [%x, %x)\n", cfg->varinfo [idx]->dreg, cfg->varinfo [idx]->dreg, block_from, last_use [idx]));
-				mono_linterval_add_range (cfg, vi->interval, block_from, last_use [idx]);
+				LIVENESS_DEBUG (printf ("Var R%d live at enter, add range to R%d: [%x, %x)\n", cfg->varinfo [idx]->dreg, cfg->varinfo [idx]->dreg, block_from, state.last_use [idx]));
+				mono_linterval_add_range (cfg, vi->interval, block_from, state.last_use [idx]);
+				state.last_use [idx] = 0;
 			}
 		}
 	}
@@ -879,7 +919,9 @@ mono_analyze_liveness2 (MonoCompile *cfg)
 	}
 #endif
 
-	g_free (last_use);
+	g_free (state.last_use);
+	g_free (state.touched);
+	g_free (state.touched_stamp);
 }
 
 #endif
@@ -52,6 +52,7 @@
 #include <mono/metadata/debug-mono-symfile.h>
 #include <mono/utils/mono-compiler.h>
 #include <mono/metadata/mono-basic-block.h>
+#include <mono/metadata/mempool-internals.h>
 
 #include "mini.h"
 #include "trace.h"
@@ -64,6 +65,24 @@
 
 #define BRANCH_COST 100
 #define INLINE_LENGTH_LIMIT 20
+/*
+ * Methods smaller than this are inlined too if inline_cost_limit () finds the
+ * call site worth it, and the caller hasn't used up INLINE_BUDGET.
+ */
+#define INLINE_EXTENDED_LENGTH_LIMIT 64
+/* Inlining is abandoned if the IR of the callee costs this much */
+#define INLINE_COST_LIMIT 60
+#define INLINE_BUDGET 240
+/* What a call costs, which inlining saves */
+#define INLINE_CALL_COST 20
+#define INLINE_CONST_ARG_BONUS 10
+#define INLINE_VTYPE_ARG_BONUS 10
+#define INLINE_LOOP_BONUS 20
+/*
+ * What a branch adds to the cost of methods inlined through the cost model.
+ * BRANCH_COST alone is above INLINE_COST_LIMIT.
+ */
+#define INLINE_BRANCH_COST 10
 #define INLINE_FAILURE do {\
 		if ((cfg->method != method) && (method->wrapper_type == MONO_WRAPPER_NONE))\
 			goto inline_failure;\
@@ -2634,6 +2653,28 @@ mini_emit_initobj (MonoCompile *cfg, MonoInst *dest, const guchar *ip, MonoClass
 	}
 }
 
+/*
+ * inlined_rgctx_is_resolvable:
+ *
+ *   Return whenever code of METHOD inlined into shared generic code can get
+ * to its rgctx.  That is only the case when it is fetched through the vtable
+ * of the inlined method's own 'this' argument, and the slots can be registered
+ * in the rgctx template of its class, i.e. METHOD is instantiated with the
+ * type parameters of its own class.  The vtable/mrgctx variable used by
+ * static, valuetype and generic methods belongs to the inlining method.
+ */
+static gboolean
+inlined_rgctx_is_resolvable (MonoMethod *method, int context_used)
+{
+	if (!context_used)
+		return TRUE;
+	if ((method->flags & METHOD_ATTRIBUTE_STATIC) || method->klass->valuetype)
+		return FALSE;
+	if (context_used & MONO_GENERIC_CONTEXT_USED_METHOD)
+		return FALSE;
+	return method->klass->generic_class == NULL;
+}
+
 static MonoInst*
 emit_get_rgctx (MonoCompile *cfg, MonoMethod *method, int context_used)
 {
@@ -2641,6 +2682,10 @@ emit_get_rgctx (MonoCompile *cfg, MonoMethod *method, int context_used)
 
 	g_assert (cfg->generic_sharing_context);
 
+	/* inline_method () discards the inlined code in this case */
+	if (cfg->current_method != cfg->method && !inlined_rgctx_is_resolvable (method, context_used))
+		cfg->gshared_inline_failed = TRUE;
+
 	if (!(method->flags & METHOD_ATTRIBUTE_STATIC) &&
 			!(context_used & MONO_GENERIC_CONTEXT_USED_METHOD) &&
 			!method->klass->valuetype)
@@ -2699,9 +2744,91 @@ mono_patch_info_rgctx_entry_new (MonoMemPool *mp, MonoMethod *method, gboolean i
 	return res;
 }
 
+/*
+ * emit_rgctx_fetch_inline:
+ *
+ *   Emit the lookup done by the lazy fetch trampoline inline: walk the rgctx
+ * arrays to the slot and load it, and only call the trampoline if the slot or
+ * one of the arrays leading to it isn't filled in yet.
+ */
+static MonoInst*
+emit_rgctx_fetch_inline (MonoCompile *cfg, MonoInst *rgctx, MonoJumpInfoRgctxEntry *entry)
+{
+	MonoBasicBlock *slowpath_bb, *end_bb;
+	MonoInst *call, *ins;
+	guint32 slot;
+	int i, depth, index, ptr_reg, res_reg;
+	gboolean mrgctx;
+
+	/* This registers the slot now instead of when the call is patched */
+	slot = mono_patch_info_rgctx_entry_get_slot (entry);
+	mrgctx = MONO_RGCTX_SLOT_IS_MRGCTX (slot);
+	index = MONO_RGCTX_SLOT_INDEX (slot);
+	if (mrgctx)
+		index += MONO_SIZEOF_METHOD_RUNTIME_GENERIC_CONTEXT / sizeof (gpointer);
+	for (depth = 0; ; ++depth) {
+		int size = mono_class_rgctx_get_array_size (depth, mrgctx);
+
+		if (index < size - 1)
+			break;
+		index -= size - 1;
+	}
+
+	NEW_BBLOCK (cfg, slowpath_bb);
+	NEW_BBLOCK (cfg, end_bb);
+
+	res_reg = alloc_preg (cfg);
+	ptr_reg = alloc_preg (cfg);
+	if (mrgctx) {
+		MONO_EMIT_NEW_UNALU (cfg, OP_MOVE, ptr_reg, rgctx->dreg);
+	} else {
+		MONO_EMIT_NEW_LOAD_MEMBASE (cfg, ptr_reg, rgctx->dreg, G_STRUCT_OFFSET (MonoVTable, runtime_generic_context));
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_COMPARE_IMM, -1, ptr_reg, 0);
+		MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_PBEQ, slowpath_bb);
+	}
+
+	for (i = 0; i < depth; ++i) {
+		int next_reg = alloc_preg (cfg);
+
+		/* Load the pointer to the next array */
+		if (mrgctx && i == 0)
+			MONO_EMIT_NEW_LOAD_MEMBASE (cfg, next_reg, ptr_reg, MONO_SIZEOF_METHOD_RUNTIME_GENERIC_CONTEXT);
+		else
+			MONO_EMIT_NEW_LOAD_MEMBASE (cfg, next_reg, ptr_reg, 0);
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_COMPARE_IMM, -1, next_reg, 0);
+		MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_PBEQ, slowpath_bb);
+		ptr_reg = next_reg;
+	}
+
+	MONO_EMIT_NEW_LOAD_MEMBASE (cfg, res_reg, ptr_reg, sizeof (gpointer) * (index + 1));
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_COMPARE_IMM, -1, res_reg, 0);
+	MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_PBNE_UN, end_bb);
+
+	MONO_START_BB (cfg, slowpath_bb);
+	call = mono_emit_abs_call (cfg, MONO_PATCH_INFO_RGCTX_FETCH, entry, helper_sig_rgctx_lazy_fetch_trampoline, &rgctx);
+	MONO_EMIT_NEW_UNALU (cfg, OP_MOVE, res_reg, call->dreg);
+
+	MONO_START_BB (cfg, end_bb);
+
+	EMIT_NEW_UNALU (cfg, ins, OP_MOVE, alloc_preg (cfg), res_reg);
+	ins->type = STACK_PTR;
+
+	mono_jit_stats.rgctx_fetches_inlined ++;
+
+	return ins;
+}
+
 static inline MonoInst*
 emit_rgctx_fetch (MonoCompile *cfg, MonoInst *rgctx, MonoJumpInfoRgctxEntry *entry)
 {
+	/*
+	 * The slot is only known at compile time in JIT mode.  Splitting the
+	 * current bblock is only safe while it is the last one and has no
+	 * successors yet, i.e. while it is being filled by mono_method_to_ir ().
+	 */
+	if (!cfg->compile_aot && !cfg->gshared_inline_failed && !cfg->cbb->next_bb && !cfg->cbb->out_count)
+		return emit_rgctx_fetch_inline (cfg, rgctx, entry);
+
 	return mono_emit_abs_call (cfg, MONO_PATCH_INFO_RGCTX_FETCH, entry, helper_sig_rgctx_lazy_fetch_trampoline, &rgctx);
 }
 
@@ -2943,14 +3070,39 @@ handle_unbox (MonoCompile *cfg, MonoClass *klass, MonoInst **sp, int context_use
 	return add;
 }
 
+/* Objects up to this size are considered by mono_stack_alloc_objects () */
+#define STACK_ALLOC_MAX_SIZE 128
+
+/*
+ * is_stack_alloc_candidate:
+ *
+ *   Return whenever an allocation of KLASS could be replaced by a stack slot if the
+ * object doesn't escape.
+ */
+static gboolean
+is_stack_alloc_candidate (MonoCompile *cfg, MonoClass *klass, gboolean for_box)
+{
+	if (!(cfg->opt & MONO_OPT_ESCAPE) || for_box || COMPILE_LLVM (cfg))
+		return FALSE;
+	if (klass->has_finalize || klass->marshalbyref || klass->contextbound || klass->delegate || klass->rank)
+		return FALSE;
+	if (klass->instance_size > STACK_ALLOC_MAX_SIZE)
+		return FALSE;
+	/* The profiler wants to see every allocation */
+	if (mono_profiler_get_events () & MONO_PROFILE_ALLOCATIONS)
+		return FALSE;
+	return TRUE;
+}
+
 /*
  * Returns NULL and set the cfg exception on error.
  */
 static MonoInst*
 handle_alloc (MonoCompile *cfg, MonoClass *klass, gboolean for_box)
 {
-	MonoInst *iargs [2];
+	MonoInst *iargs [2], *alloc;
 	void *alloc_ftn;
+	gboolean candidate = FALSE;
 
 	if (cfg->opt & MONO_OPT_SHARED) {
 		EMIT_NEW_DOMAINCONST (cfg, iargs [0]);
@@ -2991,9 +3143,15 @@ handle_alloc (MonoCompile *cfg, MonoClass *klass, gboolean for_box)
 		else {
 			EMIT_NEW_VTABLECONST (cfg, iargs [0], vtable);
 		}
+		candidate = is_stack_alloc_candidate (cfg, klass, for_box);
 	}
 
-	return mono_emit_jit_icall (cfg, alloc_ftn, iargs);
+	alloc = mono_emit_jit_icall (cfg, alloc_ftn, iargs);
+	if (candidate) {
+		alloc->klass = klass;
+		cfg->object_allocs = g_slist_prepend_mempool (cfg->mempool, cfg->object_allocs, alloc);
+	}
+	return alloc;
 }
 
 static MonoInst*
@@ -3408,6 +3566,17 @@ handle_ccastclass (MonoCompile *cfg, MonoClass *klass, MonoInst *src)
 	return ins;
 }
 
+/*
+ * delegate_target_may_be_proxy:
+ *
+ *   Return whenever an object of type KLASS can be a transparent proxy.
+ */
+static gboolean
+delegate_target_may_be_proxy (MonoClass *klass)
+{
+	return klass == mono_defaults.object_class || klass->marshalbyref || MONO_CLASS_IS_INTERFACE (klass);
+}
+
 /*
  * Returns NULL and set the cfg exception on error.
  */
@@ -3415,9 +3584,10 @@ static G_GNUC_UNUSED MonoInst*
 handle_delegate_ctor (MonoCompile *cfg, MonoClass *klass, MonoInst *target, MonoMethod *method)
 {
 	gpointer *trampoline;
-	MonoInst *obj, *method_ins, *tramp_ins;
+	MonoInst *obj, *method_ins, *tramp_ins, *cache_ins;
 	MonoDomain *domain;
 	guint8 **code_slot;
+	MonoDelegateInvokeCache *cache;
 
 	obj = handle_alloc (cfg, klass, FALSE);
 	if (!obj)
@@ -3457,14 +3627,53 @@ handle_delegate_ctor (MonoCompile *cfg, MonoClass *klass, MonoInst *target, Mono
 		MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STORE_MEMBASE_REG, obj->dreg, G_STRUCT_OFFSET (MonoDelegate, method_code), code_slot_ins->dreg);		
 	}
 
-	/* Set invoke_impl field */
-	if (cfg->compile_aot) {
-		EMIT_NEW_AOTCONST (cfg, tramp_ins, MONO_PATCH_INFO_DELEGATE_TRAMPOLINE, klass);
+	/*
+	 * If the target is known to be non-NULL, or known to be NULL, the delegate
+	 * trampoline would compute the same invoke_impl and method_ptr for every
+	 * delegate created here, so load them from a per-domain cache which it fills.
+	 * Targets which can be transparent proxies need a remoting wrapper, so they
+	 * are left to the trampoline.
+	 */
+	cache = NULL;
+	if (!cfg->compile_aot && !method->dynamic && !(cfg->opt & MONO_OPT_SHARED)) {
+		MonoMethodSignature *invoke_sig = mono_method_signature (mono_get_delegate_invoke (klass));
+		MonoMethodSignature *sig = mono_method_signature (method);
+
+		if (method->flags & METHOD_ATTRIBUTE_STATIC) {
+			if (sig->param_count == invoke_sig->param_count + 1) {
+				/* Closed static delegate */
+				if (!delegate_target_may_be_proxy (mono_class_from_mono_type (sig->params [0])))
+					cache = mono_get_delegate_invoke_cache (cfg->domain, klass, method, TRUE, TRUE);
+			} else if (target->opcode == OP_PCONST && target->inst_p0 == 0) {
+				cache = mono_get_delegate_invoke_cache (cfg->domain, klass, method, FALSE, TRUE);
+			}
+		} else if (sig->param_count == invoke_sig->param_count && !delegate_target_may_be_proxy (method->klass)) {
+			/* The caller checks that the target is not NULL */
+			cache = mono_get_delegate_invoke_cache (cfg->domain, klass, method, TRUE, TRUE);
+		}
+	}
+
+	/* Set invoke_impl and method_ptr fields */
+	if (cache) {
+		int info_reg = alloc_preg (cfg);
+		int invoke_reg = alloc_preg (cfg);
+		int method_ptr_reg = alloc_preg (cfg);
+
+		EMIT_NEW_PCONST (cfg, cache_ins, cache);
+		MONO_EMIT_NEW_LOAD_MEMBASE (cfg, info_reg, cache_ins->dreg, G_STRUCT_OFFSET (MonoDelegateInvokeCache, info));
+		MONO_EMIT_NEW_LOAD_MEMBASE (cfg, invoke_reg, info_reg, G_STRUCT_OFFSET (MonoDelegateInvokeInfo, invoke_impl));
+		MONO_EMIT_NEW_LOAD_MEMBASE (cfg, method_ptr_reg, info_reg, G_STRUCT_OFFSET (MonoDelegateInvokeInfo, method_ptr));
+		MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STORE_MEMBASE_REG, obj->dreg, G_STRUCT_OFFSET (MonoDelegate, invoke_impl), invoke_reg);
+		MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STORE_MEMBASE_REG, obj->dreg, G_STRUCT_OFFSET (MonoDelegate, method_ptr), method_ptr_reg);
 	} else {
-		trampoline = mono_create_delegate_trampoline (klass);
-		EMIT_NEW_PCONST (cfg, tramp_ins, trampoline);
+		if (cfg->compile_aot) {
+			EMIT_NEW_AOTCONST (cfg, tramp_ins, MONO_PATCH_INFO_DELEGATE_TRAMPOLINE, klass);
+		} else {
+			trampoline = mono_create_delegate_trampoline (klass);
+			EMIT_NEW_PCONST (cfg, tramp_ins, trampoline);
+		}
+		MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STORE_MEMBASE_REG, obj->dreg, G_STRUCT_OFFSET (MonoDelegate, invoke_impl), tramp_ins->dreg);
 	}
-	MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STORE_MEMBASE_REG, obj->dreg, G_STRUCT_OFFSET (MonoDelegate, invoke_impl), tramp_ins->dreg);
 
 	/* All the checks which are in mono_delegate_ctor () are done by the delegate trampoline */
 
@@ -3523,6 +3732,7 @@ mono_emit_load_got_addr (MonoCompile *cfg)
 }
 
 static int inline_limit;
+static int inline_extended_limit;
 static gboolean inline_limit_inited;
 
 static gboolean
@@ -3535,7 +3745,8 @@ mono_method_check_inlining (MonoCompile *cfg, MonoMethod *method)
 	int i;
 #endif
 
-	if (cfg->generic_sharing_context)
+	/* See inlined_rgctx_is_resolvable () */
+	if (cfg->generic_sharing_context && !inlined_rgctx_is_resolvable (method, mono_method_check_context_used (method)))
 		return FALSE;
 
 	if (cfg->inline_depth > 10)
@@ -3562,14 +3773,21 @@ mono_method_check_inlining (MonoCompile *cfg, MonoMethod *method)
 	/* also consider num_locals? */
 	/* Do the size check early to avoid creating vtables */
 	if (!inline_limit_inited) {
-		if (getenv ("MONO_INLINELIMIT"))
+		/* An explicit limit turns off the cost model */
+		if (getenv ("MONO_INLINELIMIT")) {
 			inline_limit = atoi (getenv ("MONO_INLINELIMIT"));
-		else
+			inline_extended_limit = inline_limit;
+		} else {
 			inline_limit = INLINE_LENGTH_LIMIT;
+			inline_extended_limit = INLINE_EXTENDED_LENGTH_LIMIT;
+		}
 		inline_limit_inited = TRUE;
 	}
-	if (header.code_size >= inline_limit && !(method->iflags & METHOD_IMPL_ATTRIBUTE_AGGRESSIVE_INLINING))
-		return FALSE;
+	if (header.code_size >= inline_limit && !(method->iflags & METHOD_IMPL_ATTRIBUTE_AGGRESSIVE_INLINING)) {
+		/* Bigger methods are left to inline_cost_limit (), while the budget lasts */
+		if (header.code_size >= inline_extended_limit || cfg->inline_budget_used >= INLINE_BUDGET)
+			return FALSE;
+	}
 
 	/*
 	 * if we can initialize the class of the method right away, we do,
@@ -3639,6 +3857,49 @@ mono_method_check_inlining (MonoCompile *cfg, MonoMethod *method)
 	return TRUE;
 }
 
+/*
+ * inline_cost_limit:
+ *
+ *   Return the IR cost below which inlining CMETHOD at the current call
+ * site pays off.  Methods under the classic size limit get the old fixed
+ * limit.  Bigger ones have to be cheaper than the call they replace, plus
+ * what inlining is expected to save: constant arguments let branches and
+ * arithmetic in the callee fold, valuetype arguments don't have to be
+ * copied, and calls in loops run more often.  SP are the arguments, IN_LOOP
+ * is whether the call site is inside a loop of the calling method.
+ */
+static int
+inline_cost_limit (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig, MonoInst **sp, gboolean in_loop)
+{
+	MonoMethodHeaderSummary header;
+	int i, limit;
+
+	if (!mono_method_get_header_summary (cmethod, &header) || header.code_size < inline_limit ||
+		(cmethod->iflags & METHOD_IMPL_ATTRIBUTE_AGGRESSIVE_INLINING))
+		return INLINE_COST_LIMIT;
+
+	limit = INLINE_CALL_COST;
+	for (i = 0; i < fsig->param_count + fsig->hasthis; ++i) {
+		switch (sp [i]->opcode) {
+		case OP_ICONST:
+		case OP_I8CONST:
+		case OP_R4CONST:
+		case OP_R8CONST:
+			limit += INLINE_CONST_ARG_BONUS;
+			break;
+		default:
+			if (sp [i]->type == STACK_VTYPE)
+				limit += INLINE_VTYPE_ARG_BONUS;
+			break;
+		}
+	}
+	if (in_loop)
+		limit += INLINE_LOOP_BONUS;
+
+	limit = MIN (limit, INLINE_COST_LIMIT);
+	return MIN (limit, INLINE_BUDGET - cfg->inline_budget_used);
+}
+
 static gboolean
 mini_field_access_needs_cctor_run (MonoCompile *cfg, MonoMethod *method, MonoVTable *vtable)
 {
@@ -4372,9 +4633,16 @@ check_inline_caller_method_name_limit (MonoMethod *caller_method)
 }
 #endif
 
+/*
+ * inline_method:
+ *
+ *   Inline CMETHOD at IP if the IR it generates costs less than COST_LIMIT,
+ * or unconditionally if INLINE_ALLWAYS is set.  Returns the cost, or 0 if
+ * the method was not inlined.
+ */
 static int
 inline_method (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig, MonoInst **sp,
-		guchar *ip, guint real_offset, GList *dont_inline, gboolean inline_allways)
+		guchar *ip, guint real_offset, GList *dont_inline, gboolean inline_allways, int cost_limit)
 {
 	MonoInst *ins, *rvar = NULL;
 	MonoMethodHeader *cheader;
@@ -4391,7 +4659,7 @@ inline_method (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig,
 	guint32 prev_cil_offset_to_bb_len;
 	MonoMethod *prev_current_method;
 	MonoGenericContext *prev_generic_context;
-	gboolean ret_var_set, prev_ret_var_set;
+	gboolean ret_var_set, prev_ret_var_set, prev_gshared_inline_failed, gshared_inline_failed;
 
 	g_assert (cfg->exception_type == MONO_EXCEPTION_NONE);
 
@@ -4449,10 +4717,14 @@ inline_method (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig,
 	prev_current_method = cfg->current_method;
 	prev_generic_context = cfg->generic_context;
 	prev_ret_var_set = cfg->ret_var_set;
+	prev_gshared_inline_failed = cfg->gshared_inline_failed;
+	cfg->gshared_inline_failed = FALSE;
 
 	costs = mono_method_to_ir (cfg, cmethod, sbblock, ebblock, rvar, dont_inline, sp, real_offset, *ip == CEE_CALLVIRT);
 
 	ret_var_set = cfg->ret_var_set;
+	gshared_inline_failed = cfg->gshared_inline_failed;
+	cfg->gshared_inline_failed = prev_gshared_inline_failed;
 
 	cfg->inlined_method = prev_inlined_method;
 	cfg->real_offset = prev_real_offset;
@@ -4468,11 +4740,17 @@ inline_method (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig,
 	cfg->ret_var_set = prev_ret_var_set;
 	cfg->inline_depth --;
 
-	if ((costs >= 0 && costs < 60) || inline_allways || (costs >= 0 && (cmethod->iflags & METHOD_IMPL_ATTRIBUTE_AGGRESSIVE_INLINING))) {
+	if (!gshared_inline_failed && ((costs >= 0 && costs < cost_limit) || inline_allways || (costs >= 0 && (cmethod->iflags & METHOD_IMPL_ATTRIBUTE_AGGRESSIVE_INLINING)))) {
 		if (cfg->verbose_level > 2)
 			printf ("INLINE END %s -> %s\n", mono_method_full_name (cfg->method, TRUE), mono_method_full_name (cmethod, TRUE));
 		
 		mono_jit_stats.inlined_methods++;
+		if (cfg->generic_sharing_context)
+			mono_jit_stats.inlined_methods_shared++;
+		if (!inline_allways && cheader->code_size >= inline_limit && !(cmethod->iflags & METHOD_IMPL_ATTRIBUTE_AGGRESSIVE_INLINING)) {
+			mono_jit_stats.inlined_methods_extended++;
+			cfg->inline_budget_used += costs;
+		}
 
 		/* always add some code to avoid block split failures */
 		MONO_INST_NEW (cfg, ins, OP_NOP);
@@ -4596,8 +4874,26 @@ ip_in_bb (MonoCompile *cfg, MonoBasicBlock *bb, const guint8* ip)
 	return b == NULL || b == bb;
 }
 
+/*
+ * mark_loop_locs:
+ *
+ *   If the branch at CLI_ADDR to TARGET goes backwards, mark the IL offsets
+ * it loops over in LOOP_LOCS.
+ */
+static void
+mark_loop_locs (MonoBitSet *loop_locs, unsigned char *start, unsigned char *end, unsigned char *target, guint cli_addr)
+{
+	guint i;
+
+	if (!loop_locs || target < start || target >= end || target - start > cli_addr)
+		return;
+
+	for (i = target - start; i <= cli_addr; ++i)
+		mono_bitset_set_fast (loop_locs, i);
+}
+
 static int
-get_basic_blocks (MonoCompile *cfg, MonoMethodHeader* header, guint real_offset, unsigned char *start, unsigned char *end, unsigned char **pos)
+get_basic_blocks (MonoCompile *cfg, MonoMethodHeader* header, guint real_offset, unsigned char *start, unsigned char *end, unsigned char **pos, MonoBitSet *loop_locs)
 {
 	unsigned char *ip = start;
 	unsigned char *target;
@@ -4636,6 +4932,7 @@ get_basic_blocks (MonoCompile *cfg, MonoMethodHeader* header, guint real_offset,
 		case MonoShortInlineBrTarget:
 			target = start + cli_addr + 2 + (signed char)ip [1];
 			GET_BBLOCK (cfg, bblock, target);
+			mark_loop_locs (loop_locs, start, end, target, cli_addr);
 			ip += 2;
 			if (ip < end)
 				GET_BBLOCK (cfg, bblock, ip);
@@ -4643,6 +4940,7 @@ get_basic_blocks (MonoCompile *cfg, MonoMethodHeader* header, guint real_offset,
 		case MonoInlineBrTarget:
 			target = start + cli_addr + 5 + (gint32)read32 (ip + 1);
 			GET_BBLOCK (cfg, bblock, target);
+			mark_loop_locs (loop_locs, start, end, target, cli_addr);
 			ip += 5;
 			if (ip < end)
 				GET_BBLOCK (cfg, bblock, ip);
@@ -4786,6 +5084,341 @@ emit_throw_exception (MonoCompile *cfg, MonoException *ex)
 	mono_emit_method_call (cfg, thrower, args, NULL);
 }
 
+/*
+ * emit_tier0_counter:
+ *
+ *   Emit a call counter between START_BBLOCK and the rest of the method.
+ * When it reaches zero, the method is queued for its tier-1 recompile.  The
+ * counter isn't updated atomically, a lost update only delays the recompile.
+ */
+static void
+emit_tier0_counter (MonoCompile *cfg, MonoBasicBlock *start_bblock)
+{
+	MonoBasicBlock *body_bb = start_bblock->next_bb;
+	MonoBasicBlock *counter_bb, *tier_up_bb;
+	MonoInst *args [1];
+	gint32 *counter;
+	int addr_reg, count_reg;
+
+	counter = mono_domain_alloc (cfg->domain, sizeof (gint32));
+	*counter = mono_precomp_tier_up_calls ();
+
+	NEW_BBLOCK (cfg, counter_bb);
+	NEW_BBLOCK (cfg, tier_up_bb);
+
+	mono_unlink_bblock (cfg, start_bblock, body_bb);
+	start_bblock->next_bb = NULL;
+	cfg->cbb = start_bblock;
+	MONO_START_BB (cfg, counter_bb);
+
+	addr_reg = alloc_preg (cfg);
+	count_reg = alloc_ireg (cfg);
+	MONO_EMIT_NEW_PCONST (cfg, addr_reg, counter);
+	MONO_EMIT_NEW_LOAD_MEMBASE_OP (cfg, OP_LOADI4_MEMBASE, count_reg, addr_reg, 0);
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ISUB_IMM, count_reg, count_reg, 1);
+	MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STOREI4_MEMBASE_REG, addr_reg, 0, count_reg);
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ICOMPARE_IMM, -1, count_reg, 0);
+	MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_IBNE_UN, body_bb);
+
+	MONO_START_BB (cfg, tier_up_bb);
+	EMIT_NEW_PCONST (cfg, args [0], cfg->method);
+	mono_emit_jit_icall (cfg, mono_precomp_tier_up, args);
+
+	MONO_START_BB (cfg, body_bb);
+
+	cfg->tier0 = TRUE;
+}
+
+/* Calls a tier-0 call site has to see before its types are trusted */
+#define INLINE_CACHE_MIN_CALLS 16
+/* Percentage of the calls the guarded types have to cover */
+#define INLINE_CACHE_MIN_HIT_RATE 90
+
+static void
+emit_counter_inc (MonoCompile *cfg, guint32 *counter)
+{
+	int addr_reg = alloc_preg (cfg);
+	int count_reg = alloc_ireg (cfg);
+
+	MONO_EMIT_NEW_PCONST (cfg, addr_reg, counter);
+	MONO_EMIT_NEW_LOAD_MEMBASE_OP (cfg, OP_LOADI4_MEMBASE, count_reg, addr_reg, 0);
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_IADD_IMM, count_reg, count_reg, 1);
+	MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STOREI4_MEMBASE_REG, addr_reg, 0, count_reg);
+}
+
+/*
+ * is_inline_cache_site:
+ *
+ *   Return whenever the virtual call to CMETHOD made by METHOD is profiled by
+ * tier-0 code, and devirtualized under a type guard by tier-1 code.
+ */
+static gboolean
+is_inline_cache_site (MonoCompile *cfg, MonoMethod *method, MonoMethod *cmethod, MonoInst *this)
+{
+	if (!mono_tiered_compilation || cfg->method != method || cfg->compile_aot || cfg->generic_sharing_context)
+		return FALSE;
+	if (!(cmethod->flags & METHOD_ATTRIBUTE_VIRTUAL) || MONO_METHOD_IS_FINAL (cmethod))
+		return FALSE;
+	/* The receiver is likely a proxy */
+	if (cmethod->wrapper_type != MONO_WRAPPER_NONE || cmethod->klass->marshalbyref)
+		return FALSE;
+	return this->type == STACK_OBJ;
+}
+
+static guint32
+inline_cache_calls (MonoInlineCache *cache)
+{
+	guint32 calls = cache->misses;
+	int i;
+
+	for (i = 0; i < MONO_INLINE_CACHE_SIZE; ++i)
+		calls += cache->hits [i];
+	return calls;
+}
+
+static MonoInlineCache*
+inline_cache_new (MonoCompile *cfg, guint32 il_offset)
+{
+	MonoJitDomainInfo *info = domain_jit_info (cfg->domain);
+	MonoInlineCache *cache;
+	GSList *list;
+
+	cache = mono_domain_alloc0 (cfg->domain, sizeof (MonoInlineCache));
+	cache->method = cfg->method;
+	cache->il_offset = il_offset;
+
+	mono_domain_lock (cfg->domain);
+	if (!info->inline_cache_hash)
+		info->inline_cache_hash = g_hash_table_new (NULL, NULL);
+	list = g_hash_table_lookup (info->inline_cache_hash, cfg->method);
+	g_hash_table_insert (info->inline_cache_hash, cfg->method, g_slist_prepend (list, cache));
+	mono_domain_unlock (cfg->domain);
+
+	mono_jit_stats.inline_cache_sites++;
+	return cache;
+}
+
+static MonoInlineCache*
+inline_cache_lookup (MonoCompile *cfg, guint32 il_offset)
+{
+	MonoJitDomainInfo *info = domain_jit_info (cfg->domain);
+	MonoInlineCache *res = NULL;
+	GSList *l;
+
+	mono_domain_lock (cfg->domain);
+	if (info->inline_cache_hash) {
+		for (l = g_hash_table_lookup (info->inline_cache_hash, cfg->method); l; l = l->next) {
+			MonoInlineCache *cache = l->data;
+
+			/* Threads racing to compile the tier-0 code each created a cache */
+			if (cache->il_offset == il_offset && (!res || inline_cache_calls (cache) > inline_cache_calls (res)))
+				res = cache;
+		}
+	}
+	mono_domain_unlock (cfg->domain);
+
+	return res;
+}
+
+/*
+ * inline_cache_resolve:
+ *
+ *   Return the method a virtual call to CMETHOD calls when the receiver has
+ * VTABLE, or NULL if it can't be called directly.
+ */
+static MonoMethod*
+inline_cache_resolve (MonoCompile *cfg, MonoVTable *vtable, MonoMethod *cmethod)
+{
+	MonoClass *klass = vtable->klass;
+	MonoMethod *target;
+	int slot;
+
+	/* Boxed valuetypes and proxies need a wrapper around the target */
+	if (klass->valuetype || klass->marshalbyref || vtable != mono_class_vtable (cfg->domain, klass))
+		return NULL;
+
+	slot = mono_method_get_vtable_slot (cmethod);
+	if (slot < 0)
+		return NULL;
+	if (cmethod->klass->flags & TYPE_ATTRIBUTE_INTERFACE) {
+		int offset = mono_class_interface_offset (klass, cmethod->klass);
+
+		/* Variant interfaces are left to the IMT */
+		if (offset < 0)
+			return NULL;
+		slot += offset;
+	}
+
+	target = mono_class_get_vtable_entry (klass, slot);
+	if (!target || (target->flags & METHOD_ATTRIBUTE_ABSTRACT) || target->is_generic ||
+		mono_method_needs_static_rgctx_invoke (target, FALSE))
+		return NULL;
+	return target;
+}
+
+/*
+ * inline_cache_get_targets:
+ *
+ *   Fill VTABLES and TARGETS with the receiver types worth a type guard, most
+ * frequent first, and the methods called for them.  Returns their number, 0
+ * if the site saw too few calls, or too many types for the guards to cover
+ * INLINE_CACHE_MIN_HIT_RATE percent of the calls.
+ */
+static int
+inline_cache_get_targets (MonoCompile *cfg, MonoInlineCache *cache, MonoMethod *cmethod, MonoVTable **vtables, MonoMethod **targets)
+{
+	guint32 calls = inline_cache_calls (cache);
+	guint64 covered = 0;
+	int i, n = 0, first;
+
+	if (calls < INLINE_CACHE_MIN_CALLS)
+		return 0;
+
+	first = cache->hits [1] > cache->hits [0] ? 1 : 0;
+	for (i = 0; i < MONO_INLINE_CACHE_SIZE; ++i) {
+		int idx = (first + i) % MONO_INLINE_CACHE_SIZE;
+		MonoVTable *vtable = cache->vtables [idx];
+		MonoMethod *target;
+
+		/* Rare types are left to the virtual call */
+		if (!vtable || (guint64)cache->hits [idx] * 100 < (guint64)calls * (100 - INLINE_CACHE_MIN_HIT_RATE))
+			continue;
+		target = inline_cache_resolve (cfg, vtable, cmethod);
+		if (!target)
+			continue;
+		vtables [n] = vtable;
+		targets [n] = target;
+		covered += cache->hits [idx];
+		n ++;
+	}
+
+	if (covered * 100 < (guint64)calls * INLINE_CACHE_MIN_HIT_RATE)
+		return 0;
+	return n;
+}
+
+/*
+ * emit_inline_cache_probe:
+ *
+ *   Emit code counting the receiver types of a virtual call in CACHE.  Hits
+ * are counted inline, the rest is left to mono_inline_cache_miss ().
+ */
+static void
+emit_inline_cache_probe (MonoCompile *cfg, MonoInst *obj, MonoInlineCache *cache)
+{
+	MonoBasicBlock *hit_bb [MONO_INLINE_CACHE_SIZE], *end_bb;
+	MonoInst *args [2];
+	int i, vtable_reg, cache_reg;
+
+	NEW_BBLOCK (cfg, end_bb);
+
+	MONO_EMIT_NULL_CHECK (cfg, obj->dreg);
+	vtable_reg = alloc_preg (cfg);
+	MONO_EMIT_NEW_LOAD_MEMBASE (cfg, vtable_reg, obj->dreg, G_STRUCT_OFFSET (MonoObject, vtable));
+	cache_reg = alloc_preg (cfg);
+	MONO_EMIT_NEW_PCONST (cfg, cache_reg, cache);
+
+	for (i = 0; i < MONO_INLINE_CACHE_SIZE; ++i) {
+		int entry_reg = alloc_preg (cfg);
+
+		NEW_BBLOCK (cfg, hit_bb [i]);
+		MONO_EMIT_NEW_LOAD_MEMBASE (cfg, entry_reg, cache_reg, G_STRUCT_OFFSET (MonoInlineCache, vtables) + i * sizeof (gpointer));
+		MONO_EMIT_NEW_BIALU (cfg, OP_COMPARE, -1, vtable_reg, entry_reg);
+		MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_PBEQ, hit_bb [i]);
+	}
+
+	EMIT_NEW_PCONST (cfg, args [0], cache);
+	args [1] = obj;
+	mono_emit_jit_icall (cfg, mono_inline_cache_miss, args);
+	MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_BR, end_bb);
+
+	for (i = 0; i < MONO_INLINE_CACHE_SIZE; ++i) {
+		MONO_START_BB (cfg, hit_bb [i]);
+		emit_counter_inc (cfg, &cache->hits [i]);
+		MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_BR, end_bb);
+	}
+
+	MONO_START_BB (cfg, end_bb);
+}
+
+/*
+ * emit_guarded_call:
+ *
+ *   Emit a virtual call to CMETHOD which calls TARGETS [i] directly, or
+ * inlines it, when the receiver has VTABLES [i], and makes the virtual call
+ * otherwise.  Returns the result of the call, or NULL if it is void.
+ */
+static MonoInst*
+emit_guarded_call (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig, MonoInst **sp, unsigned char *ip,
+				   GList *dont_inline, gboolean in_loop, MonoInlineCache *cache, int n_targets, MonoVTable **vtables, MonoMethod **targets)
+{
+	MonoBasicBlock *end_bb, *next_bb;
+	MonoInst *ret_var = NULL, *ins, *store;
+	MonoInst **args;
+	int i, vtable_reg, n = fsig->param_count + fsig->hasthis;
+
+	if (!MONO_TYPE_IS_VOID (fsig->ret))
+		ret_var = mono_compile_create_var (cfg, fsig->ret, OP_LOCAL);
+
+	NEW_BBLOCK (cfg, end_bb);
+
+	MONO_EMIT_NULL_CHECK (cfg, sp [0]->dreg);
+	vtable_reg = alloc_preg (cfg);
+	MONO_EMIT_NEW_LOAD_MEMBASE (cfg, vtable_reg, sp [0]->dreg, G_STRUCT_OFFSET (MonoObject, vtable));
+
+	/* inline_method () stores the result into args [0] */
+	args = mono_mempool_alloc (cfg->mempool, sizeof (MonoInst*) * n);
+
+	for (i = 0; i < n_targets; ++i) {
+		MonoMethod *target = targets [i];
+		MonoMethodSignature *tsig = mono_method_signature (target);
+		int costs = 0;
+
+		NEW_BBLOCK (cfg, next_bb);
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_COMPARE_IMM, -1, vtable_reg, vtables [i]);
+		MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_PBNE_UN, next_bb);
+
+		if (mono_jit_stats.enabled)
+			emit_counter_inc (cfg, &cache->guard_hits);
+
+		memcpy (args, sp, sizeof (MonoInst*) * n);
+		if ((cfg->opt & MONO_OPT_INLINE) && mono_method_check_inlining (cfg, target) && !g_list_find (dont_inline, target))
+			costs = inline_method (cfg, target, tsig, args, ip, cfg->real_offset, dont_inline, FALSE,
+								   inline_cost_limit (cfg, target, tsig, args, in_loop));
+		if (costs) {
+			mono_jit_stats.guarded_calls_inlined++;
+			ins = args [0];
+		} else {
+			ins = mono_emit_method_call_full (cfg, target, tsig, args, NULL, NULL);
+			if (ret_var)
+				ins = mono_emit_widen_call_res (cfg, ins, tsig);
+		}
+		if (ret_var)
+			EMIT_NEW_TEMPSTORE (cfg, store, ret_var->inst_c0, ins);
+
+		MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_BR, end_bb);
+		MONO_START_BB (cfg, next_bb);
+	}
+
+	if (mono_jit_stats.enabled)
+		emit_counter_inc (cfg, &cache->guard_misses);
+
+	ins = mono_emit_method_call_full (cfg, cmethod, fsig, sp, sp [0], NULL);
+	if (ret_var) {
+		ins = mono_emit_widen_call_res (cfg, ins, fsig);
+		EMIT_NEW_TEMPSTORE (cfg, store, ret_var->inst_c0, ins);
+	}
+
+	MONO_START_BB (cfg, end_bb);
+
+	mono_jit_stats.guarded_call_sites++;
+
+	if (!ret_var)
+		return NULL;
+	EMIT_NEW_TEMPLOAD (cfg, ins, ret_var->inst_c0);
+	return ins;
+}
+
 /*
  * Return the original method is a wrapper is specified. We can only access 
  * the custom attributes from the original method.
@@ -5452,7 +6085,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 	MonoGenericContainer *generic_container = NULL;
 	MonoType **param_types;
 	int i, n, start_new_bblock, dreg;
-	int num_calls = 0, inline_costs = 0;
+	int num_calls = 0, inline_costs = 0, branch_cost;
 	int breakpoint_id = 0;
 	guint num_args;
 	MonoBoolean security, pinvoke;
@@ -5466,6 +6099,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 	MonoInst *cached_tls_addr = NULL;
 	MonoDebugMethodInfo *minfo;
 	MonoBitSet *seq_point_locs = NULL;
+	MonoBitSet *loop_locs = NULL;
 
 	/* serialization and xdomain stuff may need access to private fields and methods */
 	dont_verify = method->klass->image->assembly->corlib_internal? TRUE: FALSE;
@@ -5493,6 +6127,12 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 	mono_jit_stats.cil_code_size += header->code_size;
 	init_locals = header->init_locals;
 
+	/* Bigger inlinees are judged by inline_cost_limit (), which budgets for some branches */
+	if (cfg->method != method && inline_limit_inited && header->code_size >= inline_limit)
+		branch_cost = INLINE_BRANCH_COST;
+	else
+		branch_cost = BRANCH_COST;
+
 	seq_points = cfg->gen_seq_points && cfg->method == method;
 
 	if (cfg->gen_seq_points && cfg->method == method) {
@@ -5767,6 +6407,10 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 		link_bblock (cfg, start_bblock, bblock);
 	}
 
+	/* Shared generic code and AOT code are never recompiled */
+	if (cfg->method == method && (cfg->opt & MONO_OPT_TIER0) && !cfg->compile_aot && !cfg->generic_sharing_context)
+		emit_tier0_counter (cfg, start_bblock);
+
 	/* at this point we know, if security is TRUE, that some code needs to be generated */
 	if (security && (cfg->method == method)) {
 		MonoInst *args [2];
@@ -5825,7 +6469,11 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 	if (header->code_size == 0)
 		UNVERIFIED;
 
-	if (get_basic_blocks (cfg, header, cfg->real_offset, ip, end, &err_pos)) {
+	/* IL offsets inside loops, which make call sites worth inlining */
+	if (cfg->opt & MONO_OPT_INLINE)
+		loop_locs = mono_bitset_mem_new (mono_mempool_alloc0 (cfg->mempool, mono_bitset_alloc_size (header->code_size, 0)), header->code_size, 0);
+
+	if (get_basic_blocks (cfg, header, cfg->real_offset, ip, end, &err_pos, loop_locs)) {
 		ip = err_pos;
 		UNVERIFIED;
 	}
@@ -5890,6 +6538,9 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 		cfg->ip = ip;
 
 		context_used = 0;
+
+		/* Helpers like emit_rgctx_fetch () can split the current bblock */
+		bblock = cfg->cbb;
 		
 		if (start_new_bblock) {
 			bblock->cil_length = ip - bblock->cil_code;
@@ -6684,7 +7335,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 				{
 					this_temp = mono_compile_create_var (cfg, type_from_stack_type (sp [0]), OP_LOCAL);
 					NEW_TEMPSTORE (cfg, store, this_temp->inst_c0, sp [0]);
-					MONO_ADD_INS (bblock, store);
+					MONO_ADD_INS (cfg->cbb, store);
 
 					/* FIXME: This should be a managed pointer */
 					this_arg_temp = mono_compile_create_var (cfg, &mono_defaults.int_class->byval_arg, OP_LOCAL);
@@ -6757,6 +7408,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 				ins = (MonoInst*)call;
 				ins->inst_p0 = cmethod;
 				ins->inst_p1 = arg_array [0];
+				bblock = cfg->cbb;
 				MONO_ADD_INS (bblock, ins);
 				link_bblock (cfg, bblock, end_bblock);			
 				start_new_bblock = 1;
@@ -6786,9 +7438,34 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 				break;
 			}
 
-			/* Inlining */
-			if ((cfg->opt & MONO_OPT_INLINE) && cmethod &&
-				(!virtual || !(cmethod->flags & METHOD_ATTRIBUTE_VIRTUAL) || MONO_METHOD_IS_FINAL (cmethod)) &&
+			/* Guarded devirtualization, for the receiver types seen by the tier-0 code */
+			if (cmethod && virtual && !cfg->tier0 && !vtable_arg && !imt_arg && !addr && !array_rank &&
+				is_inline_cache_site (cfg, method, cmethod, sp [0])) {
+				MonoInlineCache *cache = inline_cache_lookup (cfg, ip - header->code);
+				MonoVTable *vtables [MONO_INLINE_CACHE_SIZE];
+				MonoMethod *targets [MONO_INLINE_CACHE_SIZE];
+				int n_targets = cache ? inline_cache_get_targets (cfg, cache, cmethod, vtables, targets) : 0;
+
+				if (n_targets) {
+					ins = emit_guarded_call (cfg, cmethod, fsig, sp, ip, dont_inline,
+						loop_locs && mono_bitset_test_fast (loop_locs, ip - header->code), cache, n_targets, vtables, targets);
+					bblock = cfg->cbb;
+					if (ins)
+						*sp++ = ins;
+
+					CHECK_CFG_EXCEPTION;
+
+					ip += 5;
+					ins_flag = 0;
+					if (need_seq_point)
+						emit_seq_point (cfg, method, ip, FALSE);
+					break;
+				}
+			}
+
+			/* Inlining */
+			if ((cfg->opt & MONO_OPT_INLINE) && cmethod &&
+				(!virtual || !(cmethod->flags & METHOD_ATTRIBUTE_VIRTUAL) || MONO_METHOD_IS_FINAL (cmethod)) &&
 			    mono_method_check_inlining (cfg, cmethod) &&
 				 !g_list_find (dont_inline, cmethod)) {
 				int costs;
@@ -6802,7 +7479,8 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 					allways = TRUE;
 				}
 
- 				if ((costs = inline_method (cfg, cmethod, fsig, sp, ip, cfg->real_offset, dont_inline, allways))) {
+ 				if ((costs = inline_method (cfg, cmethod, fsig, sp, ip, cfg->real_offset, dont_inline, allways,
+						inline_cost_limit (cfg, cmethod, fsig, sp, loop_locs && mono_bitset_test_fast (loop_locs, ip - header->code))))) {
 					ip += 5;
 					cfg->real_offset += 5;
 					bblock = cfg->cbb;
@@ -6840,6 +7518,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 					for (i = 0; i < n; ++i)
 						EMIT_NEW_ARGSTORE (cfg, ins, i, sp [i]);
 					MONO_INST_NEW (cfg, ins, OP_BR);
+					bblock = cfg->cbb;
 					MONO_ADD_INS (bblock, ins);
 					tblock = start_bblock->out_bb [0];
 					link_bblock (cfg, bblock, tblock);
@@ -6995,6 +7674,13 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 
 			/* Common call */
 			INLINE_FAILURE;
+
+			/* Record the receiver types for the tier-1 recompile */
+			if (cfg->tier0 && virtual && !vtable_arg && !imt_arg && is_inline_cache_site (cfg, method, cmethod, sp [0])) {
+				emit_inline_cache_probe (cfg, sp [0], inline_cache_new (cfg, ip - header->code));
+				bblock = cfg->cbb;
+			}
+
 			if (vtable_arg) {
 				ins = mono_emit_rgctx_method_call_full (cfg, cmethod, fsig, sp, virtual ? sp [0] : NULL,
 					NULL, vtable_arg);
@@ -7107,7 +7793,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 			}
 			MONO_ADD_INS (bblock, ins);
 			start_new_bblock = 1;
-			inline_costs += BRANCH_COST;
+			inline_costs += branch_cost;
 			break;
 		case CEE_BEQ_S:
 		case CEE_BGE_S:
@@ -7129,7 +7815,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 			ADD_BINCOND (NULL);
 
 			sp = stack_start;
-			inline_costs += BRANCH_COST;
+			inline_costs += branch_cost;
 			break;
 		case CEE_BR:
 			CHECK_OPSIZE (5);
@@ -7150,7 +7836,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 			MONO_ADD_INS (bblock, ins);
 
 			start_new_bblock = 1;
-			inline_costs += BRANCH_COST;
+			inline_costs += branch_cost;
 			break;
 		case CEE_BRFALSE_S:
 		case CEE_BRTRUE_S:
@@ -7211,7 +7897,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 			start_new_bblock = 2;
 
 			sp = stack_start;
-			inline_costs += BRANCH_COST;
+			inline_costs += branch_cost;
 			break;
 		}
 		case CEE_BEQ:
@@ -7234,7 +7920,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 			ADD_BINCOND (NULL);
 
 			sp = stack_start;
-			inline_costs += BRANCH_COST;
+			inline_costs += branch_cost;
 			break;
 		case CEE_SWITCH: {
 			MonoInst *src1;
@@ -7340,7 +8026,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 				MONO_EMIT_NEW_UNALU (cfg, OP_BR_REG, -1, target_reg);
 			}
 			start_new_bblock = 1;
-			inline_costs += (BRANCH_COST * 2);
+			inline_costs += (branch_cost * 2);
 			break;
 		}
 		case CEE_LDIND_I1:
@@ -7931,7 +8617,8 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 				    !g_list_find (dont_inline, cmethod)) {
 					int costs;
 
-					if ((costs = inline_method (cfg, cmethod, fsig, sp, ip, cfg->real_offset, dont_inline, FALSE))) {
+					if ((costs = inline_method (cfg, cmethod, fsig, sp, ip, cfg->real_offset, dont_inline, FALSE,
+							inline_cost_limit (cfg, cmethod, fsig, sp, loop_locs && mono_bitset_test_fast (loop_locs, ip - header->code))))) {
 						cfg->real_offset += 5;
 						bblock = cfg->cbb;
 
@@ -8005,7 +8692,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 				iargs [0] = sp [0];
 				
 				costs = inline_method (cfg, mono_castclass, mono_method_signature (mono_castclass), 
-							   iargs, ip, cfg->real_offset, dont_inline, TRUE);			
+							   iargs, ip, cfg->real_offset, dont_inline, TRUE, INLINE_COST_LIMIT);			
 				g_assert (costs > 0);
 				
 				ip += 5;
@@ -8059,7 +8746,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 				iargs [0] = sp [0];
 
 				costs = inline_method (cfg, mono_isinst, mono_method_signature (mono_isinst), 
-							   iargs, ip, cfg->real_offset, dont_inline, TRUE);			
+							   iargs, ip, cfg->real_offset, dont_inline, TRUE, INLINE_COST_LIMIT);			
 				g_assert (costs > 0);
 				
 				ip += 5;
@@ -8114,7 +8801,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 					iargs [0] = sp [0];
 
 					costs = inline_method (cfg, mono_castclass, mono_method_signature (mono_castclass), 
-										   iargs, ip, cfg->real_offset, dont_inline, TRUE);
+										   iargs, ip, cfg->real_offset, dont_inline, TRUE, INLINE_COST_LIMIT);
 			
 					g_assert (costs > 0);
 				
@@ -8322,7 +9009,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 
 					if (cfg->opt & MONO_OPT_INLINE || cfg->compile_aot) {
 						costs = inline_method (cfg, stfld_wrapper, mono_method_signature (stfld_wrapper), 
-								       iargs, ip, cfg->real_offset, dont_inline, TRUE);
+								       iargs, ip, cfg->real_offset, dont_inline, TRUE, INLINE_COST_LIMIT);
 						g_assert (costs > 0);
 						      
 						cfg->real_offset += 5;
@@ -8370,7 +9057,7 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 				EMIT_NEW_ICONST (cfg, iargs [3], klass->valuetype ? field->offset - sizeof (MonoObject) : field->offset);
 				if (cfg->opt & MONO_OPT_INLINE || cfg->compile_aot) {
 					costs = inline_method (cfg, wrapper, mono_method_signature (wrapper), 
-										   iargs, ip, cfg->real_offset, dont_inline, TRUE);
+										   iargs, ip, cfg->real_offset, dont_inline, TRUE, INLINE_COST_LIMIT);
 					bblock = cfg->cbb;
 					g_assert (costs > 0);
 						      
@@ -10927,6 +11614,606 @@ mono_handle_global_vregs (MonoCompile *cfg)
 		cfg->locals_start = cfg->num_varinfo;
 }
 
+/*
+ * Escape analysis
+ *
+ *   Allocations of small objects which never leave the method don't need to go
+ * through the GC. This is common after inlining, when the constructor and the methods
+ * called on a temporary object were inlined into the method which creates it.
+ * An object escapes if a reference to it is passed to a call, stored into memory,
+ * returned or thrown, i.e. used by anything else than copies, null checks, reference
+ * compares and loads/stores of its fields.
+ * Allocations which don't escape are handled in one of two ways:
+ * - if all references to the object are local to the bblock of the allocation, and
+ *   it is only used through non-overlapping primitive fields, the fields are
+ *   replaced by vregs and the allocation is removed (scalar replacement).
+ * - otherwise the object is placed into a stack slot allocated at method entry. This
+ *   requires that no reference can survive until the next execution of the
+ *   allocation, i.e. either all references are local to the bblock, or the bblock
+ *   is not part of a cycle.
+ * This runs after mono_handle_global_vregs (), so references which live in more
+ * than one bblock are known to be vars. Only the allocation functions used with
+ * Boehm are handled, sgen's managed allocators are method calls.
+ */
+
+#define STACK_ALLOC_MAX_FIELDS 16
+
+typedef struct {
+	int offset, size;
+	gboolean fp;
+	int dreg;
+} StackAllocField;
+
+typedef struct {
+	MonoInst *alloc;
+	MonoBasicBlock *bb;
+	int size;
+	/* Vregs holding a reference to the object */
+	guint8 *refs;
+	/* Vregs assigned in bb after the allocation */
+	guint8 *defined;
+	/* Whenever all references are used in bb after the allocation */
+	gboolean local;
+	/* Whenever the object is only accessed through the fields below */
+	gboolean scalar;
+	StackAllocField fields [STACK_ALLOC_MAX_FIELDS];
+	int num_fields;
+} StackAlloc;
+
+/*
+ * stack_alloc_access_size:
+ *
+ *   Return the size of the primitive load/store INS, or 0. Set *FP if it loads/stores
+ * a floating point value.
+ */
+static int
+stack_alloc_access_size (MonoInst *ins, gboolean *fp)
+{
+	*fp = FALSE;
+	switch (ins->opcode) {
+	case OP_LOADI1_MEMBASE:
+	case OP_LOADU1_MEMBASE:
+	case OP_STOREI1_MEMBASE_REG:
+	case OP_STOREI1_MEMBASE_IMM:
+		return 1;
+	case OP_LOADI2_MEMBASE:
+	case OP_LOADU2_MEMBASE:
+	case OP_STOREI2_MEMBASE_REG:
+	case OP_STOREI2_MEMBASE_IMM:
+		return 2;
+	case OP_LOADI4_MEMBASE:
+	case OP_LOADU4_MEMBASE:
+	case OP_STOREI4_MEMBASE_REG:
+	case OP_STOREI4_MEMBASE_IMM:
+		return 4;
+#if SIZEOF_REGISTER == 8
+	case OP_LOADI8_MEMBASE:
+	case OP_STOREI8_MEMBASE_REG:
+	case OP_STOREI8_MEMBASE_IMM:
+		return 8;
+#endif
+	case OP_LOAD_MEMBASE:
+	case OP_STORE_MEMBASE_REG:
+	case OP_STORE_MEMBASE_IMM:
+		return sizeof (gpointer);
+	case OP_LOADR4_MEMBASE:
+	case OP_STORER4_MEMBASE_REG:
+		*fp = TRUE;
+		return 4;
+	case OP_LOADR8_MEMBASE:
+	case OP_STORER8_MEMBASE_REG:
+		*fp = TRUE;
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+static StackAllocField*
+stack_alloc_find_field (StackAlloc *sa, int offset)
+{
+	int i;
+
+	for (i = 0; i < sa->num_fields; ++i)
+		if (sa->fields [i].offset == offset)
+			return &sa->fields [i];
+	g_assert_not_reached ();
+	return NULL;
+}
+
+static void
+stack_alloc_add_field (StackAlloc *sa, int offset, int size, gboolean fp)
+{
+	StackAllocField *field;
+	int i;
+
+	for (i = 0; i < sa->num_fields; ++i) {
+		field = &sa->fields [i];
+		if (field->offset == offset && field->size == size && field->fp == fp)
+			return;
+		if (offset < field->offset + field->size && field->offset < offset + size) {
+			/* Overlapping, or accessed with different types */
+			sa->scalar = FALSE;
+			return;
+		}
+	}
+	if (sa->num_fields == STACK_ALLOC_MAX_FIELDS) {
+		sa->scalar = FALSE;
+		return;
+	}
+	field = &sa->fields [sa->num_fields ++];
+	field->offset = offset;
+	field->size = size;
+	field->fp = fp;
+}
+
+/*
+ * stack_alloc_check_access:
+ *
+ *   Check the load/store INS at OFFSET inside the object. Return FALSE if it doesn't
+ * access the object itself.
+ */
+static gboolean
+stack_alloc_check_access (StackAlloc *sa, MonoInst *ins, int offset)
+{
+	gboolean fp;
+	int size;
+
+	size = stack_alloc_access_size (ins, &fp);
+	if (!size) {
+		if (ins->opcode == OP_LOADV_MEMBASE || ins->opcode == OP_STOREV_MEMBASE)
+			size = mono_class_value_size (ins->klass, NULL);
+		else if (ins->opcode == OP_LOADX_MEMBASE || ins->opcode == OP_STOREX_MEMBASE)
+			size = 16;
+		else
+			return FALSE;
+		sa->scalar = FALSE;
+	}
+	if (offset < 0 || offset + size > sa->size)
+		return FALSE;
+	if (offset < sizeof (MonoObject))
+		/* The header is needed by type checks */
+		sa->scalar = FALSE;
+	if (sa->scalar)
+		stack_alloc_add_field (sa, offset, size, fp);
+	return TRUE;
+}
+
+/*
+ * stack_alloc_check_use:
+ *
+ *   Return FALSE if the use of a reference by INS makes the object escape.
+ */
+static gboolean
+stack_alloc_check_use (StackAlloc *sa, MonoInst *ins)
+{
+	switch (ins->opcode) {
+	case OP_MOVE:
+	case OP_CHECK_THIS:
+	case OP_NOT_NULL:
+		return TRUE;
+	case OP_COMPARE:
+	case OP_ICOMPARE:
+	case OP_LCOMPARE:
+	case OP_COMPARE_IMM:
+	case OP_ICOMPARE_IMM:
+	case OP_LCOMPARE_IMM:
+		/* Needs the address */
+		sa->scalar = FALSE;
+		return TRUE;
+	default:
+		/* Loads have the reference in sreg1, anything else could store it somewhere */
+		if (MONO_IS_LOAD_MEMBASE (ins))
+			return stack_alloc_check_access (sa, ins, ins->inst_offset);
+		return FALSE;
+	}
+}
+
+/*
+ * stack_alloc_check_def:
+ *
+ *   Return FALSE if the vreg holding a reference could hold something else as well
+ * after INS.
+ */
+static gboolean
+stack_alloc_check_def (MonoCompile *cfg, StackAlloc *sa, MonoInst *ins)
+{
+	MonoInst *var = get_vreg_to_inst (cfg, ins->dreg);
+
+	if (var && (var == cfg->ret || var->opcode == OP_ARG || (var->flags & (MONO_INST_VOLATILE|MONO_INST_INDIRECT))))
+		return FALSE;
+
+	switch (ins->opcode) {
+	case OP_MOVE:
+		return sa->refs [ins->sreg1];
+	/* The null initialization of local vars, OP_PCONST is one of these */
+	case OP_ICONST:
+		return var && !ins->inst_c0;
+	case OP_I8CONST:
+		return var && !ins->inst_l;
+	default:
+		return FALSE;
+	}
+}
+
+static gboolean
+stack_alloc_call_uses_refs (StackAlloc *sa, MonoCallInst *call)
+{
+	GSList *l;
+
+	/* The argument vregs are not sregs of the call */
+	for (l = call->out_ireg_args; l; l = l->next) {
+		guint32 regpair = (guint32)(gssize)(l->data);
+
+		if (sa->refs [regpair & 0xffffff])
+			return TRUE;
+	}
+	for (l = call->out_freg_args; l; l = l->next) {
+		guint32 regpair = (guint32)(gssize)(l->data);
+
+		if (sa->refs [regpair & 0xffffff])
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * stack_alloc_analyze:
+ *
+ *   Compute the vregs referencing the object allocated by sa->alloc, and check that
+ * it doesn't escape. Return FALSE if it does.
+ */
+static gboolean
+stack_alloc_analyze (MonoCompile *cfg, StackAlloc *sa)
+{
+	MonoBasicBlock *bb;
+	MonoInst *ins;
+	gboolean changed, after;
+	int i, num_sregs, sregs [MONO_MAX_SRC_REGS];
+
+	sa->refs = mono_mempool_alloc0 (cfg->mempool, cfg->next_vreg);
+	sa->defined = mono_mempool_alloc0 (cfg->mempool, cfg->next_vreg);
+	sa->refs [sa->alloc->dreg] = TRUE;
+	sa->local = TRUE;
+	sa->scalar = TRUE;
+
+	/* Copies of the reference */
+	do {
+		changed = FALSE;
+		for (bb = cfg->bb_entry; bb; bb = bb->next_bb) {
+			MONO_BB_FOR_EACH_INS (bb, ins) {
+				if (ins->opcode == OP_MOVE && sa->refs [ins->sreg1] && !sa->refs [ins->dreg]) {
+					sa->refs [ins->dreg] = TRUE;
+					changed = TRUE;
+				}
+			}
+		}
+	} while (changed);
+
+	for (bb = cfg->bb_entry; bb; bb = bb->next_bb) {
+		after = FALSE;
+		MONO_BB_FOR_EACH_INS (bb, ins) {
+			const char *spec = INS_INFO (ins->opcode);
+
+			if (ins == sa->alloc) {
+				sa->defined [ins->dreg] = TRUE;
+				after = TRUE;
+				continue;
+			}
+
+			num_sregs = mono_inst_get_src_registers (ins, sregs);
+			for (i = 0; i < num_sregs; ++i) {
+				if (sregs [i] == -1 || !sa->refs [sregs [i]])
+					continue;
+				/* A use which could see the object of an earlier execution of the allocation */
+				if (bb != sa->bb || !after || !sa->defined [sregs [i]])
+					sa->local = FALSE;
+				if (!stack_alloc_check_use (sa, ins))
+					return FALSE;
+			}
+
+			if (MONO_IS_STORE_MEMBASE (ins)) {
+				if (sa->refs [ins->inst_destbasereg]) {
+					if (bb != sa->bb || !after || !sa->defined [ins->inst_destbasereg])
+						sa->local = FALSE;
+					if (!stack_alloc_check_access (sa, ins, ins->inst_offset))
+						return FALSE;
+				}
+			} else if (spec [MONO_INST_DEST] != ' ' && ins->dreg != -1) {
+				if (sa->refs [ins->dreg] && !stack_alloc_check_def (cfg, sa, ins))
+					return FALSE;
+				if (bb == sa->bb && after)
+					sa->defined [ins->dreg] = TRUE;
+			}
+
+			if (MONO_IS_CALL (ins) && stack_alloc_call_uses_refs (sa, (MonoCallInst*)ins))
+				return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static MonoBasicBlock*
+stack_alloc_find_bblock (MonoCompile *cfg, MonoInst *alloc)
+{
+	MonoBasicBlock *bb;
+	MonoInst *ins;
+
+	for (bb = cfg->bb_entry; bb; bb = bb->next_bb) {
+		MONO_BB_FOR_EACH_INS (bb, ins) {
+			if (ins == alloc)
+				return bb;
+		}
+	}
+	/* The code containing it was discarded, i.e. by an aborted inline */
+	return NULL;
+}
+
+/*
+ * stack_alloc_bblock_in_cycle:
+ *
+ *   Return whenever BB can be reached from itself.
+ */
+static gboolean
+stack_alloc_bblock_in_cycle (MonoCompile *cfg, MonoBasicBlock *bb)
+{
+	MonoBasicBlock **stack, *cur;
+	guint8 *visited;
+	int i, sp = 0;
+
+	visited = mono_mempool_alloc0 (cfg->mempool, cfg->num_bblocks);
+	stack = mono_mempool_alloc (cfg->mempool, sizeof (MonoBasicBlock*) * cfg->num_bblocks);
+
+	stack [sp ++] = bb;
+	while (sp) {
+		cur = stack [-- sp];
+		for (i = 0; i < cur->out_count; ++i) {
+			MonoBasicBlock *succ = cur->out_bb [i];
+
+			if (succ == bb)
+				return TRUE;
+			if (!visited [succ->block_num]) {
+				visited [succ->block_num] = TRUE;
+				stack [sp ++] = succ;
+			}
+		}
+	}
+	return FALSE;
+}
+
+/*
+ * stack_alloc_replace_call:
+ *
+ *   Replace the allocation call with the code emitted into FIRST_BB, and remove the
+ * moves which set up its arguments.
+ */
+static void
+stack_alloc_replace_call (MonoCompile *cfg, StackAlloc *sa, MonoBasicBlock *first_bb)
+{
+	MonoCallInst *call = (MonoCallInst*)sa->alloc;
+	MonoInst *ins, *prev;
+	GSList *l;
+
+	for (l = call->out_ireg_args; l; l = l->next) {
+		int vreg = ((guint32)(gssize)(l->data)) & 0xffffff;
+
+		for (ins = sa->alloc->prev; ins; ins = ins->prev) {
+			if (ins->opcode == OP_MOVE && ins->dreg == vreg) {
+				NULLIFY_INS (ins);
+				break;
+			}
+		}
+	}
+
+	if (first_bb->code) {
+		prev = sa->alloc->prev;
+		mono_replace_ins (cfg, sa->bb, sa->alloc, &prev, first_bb, first_bb);
+	} else {
+		NULLIFY_INS (sa->alloc);
+	}
+}
+
+/*
+ * stack_alloc_scalar_replace:
+ *
+ *   Replace the fields of the object with vregs.
+ */
+static void
+stack_alloc_scalar_replace (MonoCompile *cfg, StackAlloc *sa)
+{
+	static double r8_0 = 0.0;
+	MonoBasicBlock *bb, *first_bb;
+	MonoInst *ins;
+	StackAllocField *field;
+	int i;
+
+	/* The allocation is replaced by the zero initialization of the fields */
+	cfg->cbb = first_bb = mono_mempool_alloc0 (cfg->mempool, sizeof (MonoBasicBlock));
+	for (i = 0; i < sa->num_fields; ++i) {
+		field = &sa->fields [i];
+		if (field->fp) {
+			field->dreg = alloc_freg (cfg);
+			MONO_INST_NEW (cfg, ins, OP_R8CONST);
+			ins->type = STACK_R8;
+			ins->dreg = field->dreg;
+			ins->inst_p0 = (gpointer)&r8_0;
+			MONO_ADD_INS (cfg->cbb, ins);
+		} else {
+			field->dreg = alloc_ireg (cfg);
+			if (field->size == 8)
+				MONO_EMIT_NEW_I8CONST (cfg, field->dreg, 0);
+			else
+				MONO_EMIT_NEW_ICONST (cfg, field->dreg, 0);
+		}
+	}
+	stack_alloc_replace_call (cfg, sa, first_bb);
+
+	for (bb = cfg->bb_entry; bb; bb = bb->next_bb) {
+		MONO_BB_FOR_EACH_INS (bb, ins) {
+			const char *spec = INS_INFO (ins->opcode);
+
+			if (MONO_IS_STORE_MEMBASE (ins)) {
+				gint64 imm;
+
+				if (!sa->refs [ins->inst_destbasereg])
+					continue;
+				field = stack_alloc_find_field (sa, ins->inst_offset);
+				switch (ins->opcode) {
+				case OP_STOREI1_MEMBASE_IMM:
+				case OP_STOREI2_MEMBASE_IMM:
+				case OP_STOREI4_MEMBASE_IMM:
+				case OP_STOREI8_MEMBASE_IMM:
+				case OP_STORE_MEMBASE_IMM:
+					imm = ins->inst_imm;
+					if (field->size == 8) {
+						ins->opcode = OP_I8CONST;
+						ins->inst_l = imm;
+					} else {
+						ins->opcode = OP_ICONST;
+						ins->inst_c0 = imm;
+					}
+					break;
+				case OP_STORER4_MEMBASE_REG:
+					ins->opcode = OP_FCONV_TO_R4;
+					break;
+				case OP_STORER8_MEMBASE_REG:
+					ins->opcode = OP_FMOVE;
+					break;
+				default:
+					ins->opcode = OP_MOVE;
+					break;
+				}
+				ins->dreg = field->dreg;
+			} else if (MONO_IS_LOAD_MEMBASE (ins) && sa->refs [ins->inst_basereg]) {
+				field = stack_alloc_find_field (sa, ins->inst_offset);
+				switch (ins->opcode) {
+				case OP_LOADI1_MEMBASE:
+					ins->opcode = OP_ICONV_TO_I1;
+					break;
+				case OP_LOADU1_MEMBASE:
+					ins->opcode = OP_ICONV_TO_U1;
+					break;
+				case OP_LOADI2_MEMBASE:
+					ins->opcode = OP_ICONV_TO_I2;
+					break;
+				case OP_LOADU2_MEMBASE:
+					ins->opcode = OP_ICONV_TO_U2;
+					break;
+#if SIZEOF_REGISTER == 8
+				case OP_LOADI4_MEMBASE:
+					ins->opcode = OP_SEXT_I4;
+					break;
+				case OP_LOADU4_MEMBASE:
+					ins->opcode = OP_ZEXT_I4;
+					break;
+#endif
+				case OP_LOADR4_MEMBASE:
+				case OP_LOADR8_MEMBASE:
+					ins->opcode = OP_FMOVE;
+					break;
+				default:
+					ins->opcode = OP_MOVE;
+					break;
+				}
+				ins->sreg1 = field->dreg;
+			} else if (spec [MONO_INST_DEST] != ' ' && ins->dreg != -1 && sa->refs [ins->dreg]) {
+				/* Copies and null initializations of the reference */
+				NULLIFY_INS (ins);
+			} else if ((ins->opcode == OP_CHECK_THIS || ins->opcode == OP_NOT_NULL) && sa->refs [ins->sreg1]) {
+				NULLIFY_INS (ins);
+			}
+		}
+	}
+}
+
+/*
+ * stack_alloc_to_stack:
+ *
+ *   Place the object into a stack slot allocated at method entry.
+ */
+static void
+stack_alloc_to_stack (MonoCompile *cfg, StackAlloc *sa)
+{
+	MonoBasicBlock *first_bb;
+	MonoInst *ins, *slot, *vtable_ins;
+	MonoVTable *vtable;
+	int size, offset;
+
+	vtable = mono_class_vtable (cfg->domain, sa->alloc->klass);
+	g_assert (vtable);
+	size = (sa->size + sizeof (gpointer) - 1) & ~(sizeof (gpointer) - 1);
+
+	slot = mono_compile_create_var (cfg, &mono_defaults.int_class->byval_arg, OP_LOCAL);
+	MONO_INST_NEW (cfg, ins, OP_LOCALLOC_IMM);
+	ins->dreg = slot->dreg;
+	ins->inst_imm = size;
+	ins->type = STACK_PTR;
+	mono_add_ins_to_end (cfg->bb_entry, ins);
+	cfg->flags |= MONO_CFG_HAS_ALLOCA;
+
+	/* The allocation is replaced by the initialization of the slot */
+	cfg->cbb = first_bb = mono_mempool_alloc0 (cfg->mempool, sizeof (MonoBasicBlock));
+	MONO_EMIT_NEW_UNALU (cfg, OP_MOVE, sa->alloc->dreg, slot->dreg);
+	for (offset = 0; offset < size; offset += sizeof (gpointer)) {
+		if (offset != G_STRUCT_OFFSET (MonoObject, vtable))
+			MONO_EMIT_NEW_STORE_MEMBASE_IMM (cfg, OP_STORE_MEMBASE_IMM, sa->alloc->dreg, offset, 0);
+	}
+	EMIT_NEW_VTABLECONST (cfg, vtable_ins, vtable);
+	MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STORE_MEMBASE_REG, sa->alloc->dreg, G_STRUCT_OFFSET (MonoObject, vtable), vtable_ins->dreg);
+	stack_alloc_replace_call (cfg, sa, first_bb);
+}
+
+/**
+ * mono_stack_alloc_objects:
+ *
+ *   Remove the heap allocation of the objects in cfg->object_allocs which don't escape
+ * the method. Return whenever the code was changed.
+ */
+gboolean
+mono_stack_alloc_objects (MonoCompile *cfg)
+{
+	MonoMethodHeader *header = mono_method_get_header (cfg->method);
+	StackAlloc sa;
+	GSList *l;
+	gboolean changed = FALSE;
+
+	for (l = cfg->object_allocs; l; l = l->next) {
+		memset (&sa, 0, sizeof (StackAlloc));
+		sa.alloc = l->data;
+		/* Stack arguments would need their pushes removed too */
+		if (((MonoCallInst*)sa.alloc)->stack_usage)
+			continue;
+		sa.bb = stack_alloc_find_bblock (cfg, sa.alloc);
+		if (!sa.bb)
+			continue;
+		sa.size = sa.alloc->klass->instance_size;
+
+		if (!stack_alloc_analyze (cfg, &sa))
+			continue;
+
+		if (sa.local && sa.scalar) {
+			stack_alloc_scalar_replace (cfg, &sa);
+			mono_jit_stats.objects_scalar_replaced++;
+		} else {
+			/* Exception handlers could form cycles which are not visible in the cfg */
+			if (!sa.local && (header->num_clauses || stack_alloc_bblock_in_cycle (cfg, sa.bb)))
+				continue;
+#ifdef MONO_ARCH_NEED_GOT_VAR
+			/* The vtable constant would need the GOT var */
+			if (cfg->compile_aot)
+				continue;
+#endif
+			stack_alloc_to_stack (cfg, &sa);
+			mono_jit_stats.objects_stack_allocated++;
+		}
+		changed = TRUE;
+	}
+	cfg->object_allocs = NULL;
+
+	return changed;
+}
+
 /**
  * mono_spill_global_vars:
  *
@@ -11129,6 +12416,10 @@ mono_spill_global_vars (MonoCompile *cfg, gboolean *need_local_opts)
 
 				store_opcode = mono_type_to_store_membase (cfg, var->inst_vtype);
 
+				/* Accesses to vars which could have been allocated to a register */
+				if (var->opcode != OP_REGVAR && !(var->flags & (MONO_INST_VOLATILE|MONO_INST_INDIRECT)))
+					mono_jit_stats.regalloc_global_spill_stores ++;
+
 				if (var->opcode == OP_REGVAR) {
 					ins->dreg = var->dreg;
 				} else if ((ins->dreg == ins->sreg1) && (spec [MONO_INST_DEST] == 'i') && (spec [MONO_INST_SRC1] == 'i') && !vreg_to_lvreg [ins->dreg] && (op_to_op_dest_membase (store_opcode, ins->opcode) != -1)) {
@@ -11276,6 +12567,9 @@ mono_spill_global_vars (MonoCompile *cfg, gboolean *need_local_opts)
 						continue;
 					}
 
+					if (!(var->flags & (MONO_INST_VOLATILE|MONO_INST_INDIRECT)))
+						mono_jit_stats.regalloc_global_spill_loads ++;
+
 					/* Try to fuse the load into the instruction */
 					if ((srcindex == 0) && (op_to_op_src1_membase (load_opcode, ins->opcode) != -1)) {
 						ins->opcode = op_to_op_src1_membase (load_opcode, ins->opcode);
@@ -7226,7 +7226,7 @@ mono_arch_build_imt_thunk (MonoVTable *vtable, MonoDomain *domain, MonoIMTCheckI
 	if (fail_tramp)
 		code = mono_method_alloc_generic_virtual_thunk (domain, size);
 	else
-		code = mono_domain_code_reserve (domain, size);
+		code = mono_domain_code_reserve_pool (domain, MONO_CODE_POOL_TRAMPOLINE, size);
 	start = code;
 	for (i = 0; i < count; ++i) {
 		MonoIMTCheckItem *item = imt_entries [i];
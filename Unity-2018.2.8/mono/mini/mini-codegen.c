@@ -733,6 +733,7 @@ get_register_force_spilling (MonoCompile *cfg, MonoBasicBlock *bb, MonoInst **la
 	load->inst_basereg = cfg->frame_reg;
 	load->inst_offset = mono_spillvar_offset (cfg, spill, bank);
 	insert_after_ins (bb, ins, last, load);
+	mono_jit_stats.regalloc_local_spill_loads ++;
 	DEBUG (printf ("SPILLED LOAD (%d at 0x%08lx(%%ebp)) R%d (freed %s)\n", spill, (long)load->inst_offset, i, mono_regname_full (sel, bank)));
 	if (G_UNLIKELY (bank))
 		i = mono_regstate_alloc_general (rs, regmask (sel), bank);
@@ -821,6 +822,7 @@ get_register_spilling (MonoCompile *cfg, MonoBasicBlock *bb, MonoInst **last, Mo
 	load->inst_basereg = cfg->frame_reg;
 	load->inst_offset = mono_spillvar_offset (cfg, spill, bank);
 	insert_after_ins (bb, ins, last, load);
+	mono_jit_stats.regalloc_local_spill_loads ++;
 	DEBUG (printf ("\tSPILLED LOAD (%d at 0x%08lx(%%ebp)) R%d (freed %s)\n", spill, (long)load->inst_offset, i, mono_regname_full (sel, bank)));
 	if (G_UNLIKELY (bank))
 		i = mono_regstate_alloc_general (rs, regmask (sel), bank);
@@ -877,6 +879,7 @@ create_spilled_store (MonoCompile *cfg, MonoBasicBlock *bb, int spill, int reg,
 	store->sreg1 = reg;
 	store->inst_destbasereg = cfg->frame_reg;
 	store->inst_offset = mono_spillvar_offset (cfg, spill, bank);
+	mono_jit_stats.regalloc_local_spill_stores ++;
 	if (ins) {
 		mono_bblock_insert_after_ins (bb, ins, store);
 		*last = store;
@@ -984,21 +984,67 @@ callback_get_stack_frames_security_info (MonoDomain *domain, MonoContext *ctx, M
 	return FALSE;
 }
 
+/*
+ * The number of frames whose ip/generic info pairs are recorded into the
+ * TraceIps buffer on the C stack before it spills to the heap.
+ */
+#define TRACE_IPS_INLINE 16
+
+/*
+ * TraceIps:
+ *
+ *   The raw ip/generic info pairs of the frames an exception passed through,
+ * collected while the first pass of exception handling walks the stack.
+ * Methods and source locations are only looked up when the trace is read by
+ * ves_icall_get_trace ().
+ */
+typedef struct {
+	gpointer *ips;
+	int len, size;
+	gpointer inline_ips [TRACE_IPS_INLINE * 2];
+} TraceIps;
+
+static void
+trace_ips_init (TraceIps *trace)
+{
+	trace->ips = trace->inline_ips;
+	trace->len = 0;
+	trace->size = TRACE_IPS_INLINE * 2;
+}
+
+static void
+trace_ips_add (TraceIps *trace, gpointer ip, gpointer generic_info)
+{
+	if (trace->len + 2 > trace->size) {
+		gpointer *ips = g_new (gpointer, trace->size * 2);
+
+		memcpy (ips, trace->ips, trace->len * sizeof (gpointer));
+		if (trace->ips != trace->inline_ips)
+			g_free (trace->ips);
+		trace->ips = ips;
+		trace->size *= 2;
+	}
+	trace->ips [trace->len ++] = ip;
+	trace->ips [trace->len ++] = generic_info;
+}
+
+static void
+trace_ips_free (TraceIps *trace)
+{
+	if (trace->ips != trace->inline_ips)
+		g_free (trace->ips);
+}
+
 static MonoArray *
-glist_to_array (GList *list, MonoClass *eclass) 
+trace_ips_to_array (TraceIps *trace)
 {
-	MonoDomain *domain = mono_domain_get ();
 	MonoArray *res;
-	int len, i;
 
-	if (!list)
+	if (!trace->len)
 		return NULL;
 
-	len = g_list_length (list);
-	res = mono_array_new (domain, eclass, len);
-
-	for (i = 0; list; list = list->next, i++)
-		mono_array_set (res, gpointer, i, list->data);
+	res = mono_array_new (mono_domain_get (), mono_defaults.int_class, trace->len);
+	memcpy (mono_array_addr (res, gpointer, 0), trace->ips, trace->len * sizeof (gpointer));
 
 	return res;
 }
@@ -1116,6 +1162,9 @@ mini_jit_info_table_find (MonoDomain *domain, char *addr, MonoDomain **out_domai
 	return NULL;
 }
 
+/* The number of frames whose MonoJitInfo is passed from the first to the second pass */
+#define FRAME_JIS_SIZE 32
+
 /**
  * mono_handle_exception_internal:
  * @ctx: saved processor state
@@ -1123,9 +1172,12 @@ mini_jit_info_table_find (MonoDomain *domain, char *addr, MonoDomain **out_domai
  * @test_only: only test if the exception is caught, but dont call handlers
  * @out_filter_idx: out parameter. if test_only is true, set to the index of 
  * the first filter clause which caught the exception.
+ * @frame_jis: if not NULL, an array of FRAME_JIS_SIZE entries. The first pass
+ * stores the MonoJitInfo of the frames it unwinds into it, so the second pass
+ * can skip the jit info table lookups.
  */
 static gboolean
-mono_handle_exception_internal (MonoContext *ctx, gpointer obj, gpointer original_ip, gboolean test_only, gint32 *out_filter_idx, MonoJitInfo **out_ji)
+mono_handle_exception_internal (MonoContext *ctx, gpointer obj, gpointer original_ip, gboolean test_only, gint32 *out_filter_idx, MonoJitInfo **out_ji, MonoJitInfo **frame_jis)
 {
 	MonoDomain *domain = mono_domain_get ();
 	MonoJitInfo *ji, rji;
@@ -1134,13 +1186,14 @@ mono_handle_exception_internal (MonoContext *ctx, gpointer obj, gpointer origina
 	MonoJitTlsData *jit_tls = TlsGetValue (mono_jit_tls_id);
 	MonoLMF *lmf = mono_get_lmf ();
 	MonoArray *initial_trace_ips = NULL;
-	GList *trace_ips = NULL;
+	TraceIps trace_ips;
 	MonoException *mono_ex;
 	gboolean stack_overflow = FALSE;
 	MonoContext initial_ctx;
-	int frame_count = 0;
+	int frame_count = 0, frame_index = 0;
 	gboolean has_dynamic_methods = FALSE;
 	gint32 filter_idx, first_filter_idx;
+	MonoJitInfo *first_pass_jis [FRAME_JIS_SIZE];
 
 	g_assert (ctx != NULL);
 	if (!obj) {
@@ -1194,7 +1247,9 @@ mono_handle_exception_internal (MonoContext *ctx, gpointer obj, gpointer origina
 		if (mono_trace_is_enabled ())
 			g_print ("[%p:] EXCEPTION handling: %s\n", (void*)GetCurrentThreadId (), mono_object_class (obj)->name);
 		mono_profiler_exception_thrown (obj);
-		if (!mono_handle_exception_internal (&ctx_cp, obj, original_ip, TRUE, &first_filter_idx, out_ji)) {
+		memset (first_pass_jis, 0, sizeof (first_pass_jis));
+		frame_jis = first_pass_jis;
+		if (!mono_handle_exception_internal (&ctx_cp, obj, original_ip, TRUE, &first_filter_idx, out_ji, frame_jis)) {
 			if (mono_break_on_exc)
 				G_BREAKPOINT ();
 			mono_debugger_agent_handle_exception (obj, ctx, NULL);
@@ -1213,18 +1268,27 @@ mono_handle_exception_internal (MonoContext *ctx, gpointer obj, gpointer origina
 	filter_idx = 0;
 	initial_ctx = *ctx;
 	memset (&rji, 0, sizeof (rji));
+	trace_ips_init (&trace_ips);
 
 	while (1) {
 		MonoContext new_ctx;
+		MonoJitInfo *prev_ji = &rji;
 		guint32 free_stack;
 
-		ji = mono_find_jit_info (domain, jit_tls, &rji, &rji, ctx, &new_ctx, 
+		if (!test_only && frame_jis && frame_index < FRAME_JIS_SIZE && frame_jis [frame_index])
+			prev_ji = frame_jis [frame_index];
+
+		ji = mono_find_jit_info (domain, jit_tls, &rji, prev_ji, ctx, &new_ctx, 
 								 NULL, &lmf, NULL, NULL);
 		if (!ji) {
 			g_warning ("Exception inside function without unwind info");
 			g_assert_not_reached ();
 		}
 
+		if (test_only && frame_jis && frame_index < FRAME_JIS_SIZE && ji != (gpointer)-1 && ji != &rji)
+			frame_jis [frame_index] = ji;
+		frame_index ++;
+
 		if (ji != (gpointer)-1 && !(ji->code_start <= MONO_CONTEXT_GET_IP (ctx) && (((guint8*)ji->code_start + ji->code_size >= (guint8*)MONO_CONTEXT_GET_IP (ctx))))) {
 			/*
 			 * The exception was raised in native code and we got back to managed code 
@@ -1244,11 +1308,8 @@ mono_handle_exception_internal (MonoContext *ctx, gpointer obj, gpointer origina
 				 * rethrown. Also avoid giant stack traces during a stack
 				 * overflow.
 				 */
-				if (!initial_trace_ips && (frame_count < 1000)) {
-					trace_ips = g_list_prepend (trace_ips, MONO_CONTEXT_GET_IP (ctx));
-					trace_ips = g_list_prepend (trace_ips,
-						get_generic_info_from_stack_frame (ji, ctx));
-				}
+				if (!initial_trace_ips && (frame_count < 1000))
+					trace_ips_add (&trace_ips, MONO_CONTEXT_GET_IP (ctx), get_generic_info_from_stack_frame (ji, ctx));
 			}
 
 			if (ji->method->dynamic)
@@ -1317,13 +1378,12 @@ mono_handle_exception_internal (MonoContext *ctx, gpointer obj, gpointer origina
 						     mono_object_isinst (obj, catch_class)) || filtered) {
 							if (test_only) {
 								if (mono_ex && !initial_trace_ips) {
-									trace_ips = g_list_reverse (trace_ips);
-									MONO_OBJECT_SETREF (mono_ex, trace_ips, glist_to_array (trace_ips, mono_defaults.int_class));
+									MONO_OBJECT_SETREF (mono_ex, trace_ips, trace_ips_to_array (&trace_ips));
 									if (has_dynamic_methods)
 										/* These methods could go away anytime, so compute the stack trace now */
 										MONO_OBJECT_SETREF (mono_ex, stack_trace, ves_icall_System_Exception_get_trace (mono_ex));
 								}
-								g_list_free (trace_ips);
+								trace_ips_free (&trace_ips);
 
 								return TRUE;
 							}
@@ -1387,13 +1447,12 @@ mono_handle_exception_internal (MonoContext *ctx, gpointer obj, gpointer origina
 				g_assert_not_reached ();
 			} else {
 				if (mono_ex && !initial_trace_ips) {
-					trace_ips = g_list_reverse (trace_ips);
-					MONO_OBJECT_SETREF (mono_ex, trace_ips, glist_to_array (trace_ips, mono_defaults.int_class));
+					MONO_OBJECT_SETREF (mono_ex, trace_ips, trace_ips_to_array (&trace_ips));
 					if (has_dynamic_methods)
 						/* These methods could go away anytime, so compute the stack trace now */
 						MONO_OBJECT_SETREF (mono_ex, stack_trace, ves_icall_System_Exception_get_trace (mono_ex));
 				}
-				g_list_free (trace_ips);
+				trace_ips_free (&trace_ips);
 				return FALSE;
 			}
 		}
@@ -1443,7 +1502,7 @@ mono_debugger_handle_exception (MonoContext *ctx, MonoObject *obj)
 		 * The debugger wants us to stop only if this exception is user-unhandled.
 		 */
 
-		ret = mono_handle_exception_internal (&ctx_cp, obj, MONO_CONTEXT_GET_IP (ctx), TRUE, NULL, &ji);
+		ret = mono_handle_exception_internal (&ctx_cp, obj, MONO_CONTEXT_GET_IP (ctx), TRUE, NULL, &ji, NULL);
 		if (ret && (ji != NULL) && (ji->method->wrapper_type == MONO_WRAPPER_RUNTIME_INVOKE)) {
 			/*
 			 * The exception is handled in a runtime-invoke wrapper, that means that it's unhandled
@@ -1522,7 +1581,7 @@ mono_handle_exception (MonoContext *ctx, gpointer obj, gpointer original_ip, gbo
 	if (!test_only)
 		mono_perfcounters->exceptions_thrown++;
 
-	return mono_handle_exception_internal (ctx, obj, original_ip, test_only, NULL, NULL);
+	return mono_handle_exception_internal (ctx, obj, original_ip, test_only, NULL, NULL, NULL);
 }
 
 #ifdef MONO_ARCH_SIGSEGV_ON_ALTSTACK
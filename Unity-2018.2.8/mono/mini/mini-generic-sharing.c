@@ -217,4 +217,5 @@ mini_type_stack_size_full (MonoGenericSharingContext *gsctx, MonoType *t, guint3
 void
 mono_generic_sharing_init (void)
 {
+	mono_domain_shared_generic_init ();
 }
@@ -0,0 +1,829 @@
+/*
+ * mini-precomp.c: Speculative background compilation for the mono JIT
+ *
+ * Methods are compiled on background threads before they are first
+ * called, so the thread calling them finds their code already published
+ * instead of stopping in the JIT trampoline.  The queue is fed from three
+ * sources:
+ *
+ * - the direct callees of each method the JIT compiles, taken from the
+ *   METHOD/METHOD_JUMP patches of the new code.
+ * - the methods compiled by a previous run, as recorded by the AOT profiler
+ *   (--profile=aot) in <dir>/<assembly name>-<n>, queued when the assembly
+ *   is loaded.
+ * - the methods compiled during the first seconds of a previous run, as
+ *   recorded by this file (see precomp_record_write ()), queued in the
+ *   order they were compiled in when their assembly is loaded.
+ *
+ * The workers never initialize the class of a method they compile, the
+ * first real call still goes through the trampoline, which finds the code
+ * and runs the cctor then.  Only beforefieldinit cctors, which the JIT
+ * itself runs while compiling, can run early.
+ *
+ * With tiered compilation, methods are first compiled as tier-0 code, with
+ * few optimizations and a call counter in the prologue.  When the counter
+ * runs out, the method is queued ahead of everything else, and a worker
+ * recompiles it with the tier-1 optimizations (see mono_jit_tier_up_method ()).
+ *
+ * Enabled with MONO_PRECOMP=<option>,..., see mono_precomp_init ().
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <mono/metadata/appdomain.h>
+#include <mono/metadata/assembly.h>
+#include <mono/metadata/debug-helpers.h>
+#include <mono/metadata/domain-internals.h>
+#include <mono/metadata/metadata-internals.h>
+#include <mono/metadata/object-internals.h>
+#include <mono/metadata/tabledefs.h>
+#include <mono/metadata/threads.h>
+#include <mono/metadata/threads-types.h>
+#include <mono/utils/mono-proclib.h>
+#include <mono/utils/mono-time.h>
+
+#include "mini.h"
+
+/* Don't let a long profile or a deep call graph grow the queue without limit */
+#define PRECOMP_MAX_QUEUED 8192
+
+/* Recorded entries are (image index << 24) | method table row */
+#define PRECOMP_RECORD_MAGIC 0x4d504a4d
+#define PRECOMP_RECORD_VERSION 1
+#define PRECOMP_RECORD_MAX_IMAGES 256
+#define PRECOMP_RECORD_MAX_ROW 0xffffff
+
+enum {
+	PRECOMP_METHOD,
+	/* Queue the methods of IMAGE listed by the AOT profiler */
+	PRECOMP_PROFILE,
+	/* Queue the methods of IMAGE listed in the replay file */
+	PRECOMP_REPLAY,
+	/* Recompile the tier-0 code of METHOD */
+	PRECOMP_TIER_UP
+};
+
+typedef struct {
+	int kind;
+	MonoDomain *domain;
+	MonoMethod *method;
+	MonoImage *image;
+	/* How many callee links separate METHOD from a method compiled on demand */
+	int depth;
+	/* Whether METHOD comes from the replay file, so it is recorded again */
+	gboolean replayed;
+} PrecompItem;
+
+/* An image of the record or replay file */
+typedef struct {
+	char *name;
+	char *guid;
+	/* Only used for matching while recording, can be stale */
+	MonoImage *image;
+	/* Method table rows, in the order they were compiled in */
+	GArray *rows;
+} PrecompImage;
+
+static gboolean precomp_callees;
+static int precomp_max_depth = 1;
+static char *precomp_profile_dir;
+static char *precomp_record_file;
+static guint32 precomp_record_ms = 30 * 1000;
+static char *precomp_replay_file;
+static int precomp_tier_up_calls = 30;
+
+static CRITICAL_SECTION precomp_mutex;
+#define precomp_lock() EnterCriticalSection (&precomp_mutex)
+#define precomp_unlock() LeaveCriticalSection (&precomp_mutex)
+
+/* These are protected by precomp_mutex */
+static GQueue precomp_queue;
+/* Methods which were queued once already, mapped to their domain */
+static GHashTable *precomp_queued;
+/* The same for tier-up requests */
+static GHashTable *precomp_tier_queued;
+/* PrecompImage, and the entries recorded so far */
+static GPtrArray *precomp_record_images;
+static GArray *precomp_record_entries;
+static gboolean precomp_recording;
+
+/* PrecompImage, read-only after init */
+static GPtrArray *precomp_replay_images;
+
+/* Released once for every item added to the queue */
+static HANDLE precomp_sem;
+
+static guint32 precomp_start_time;
+
+/* The item the current worker is processing, NULL on other threads */
+static guint32 precomp_tls_id = -1;
+
+/*
+ * precomp_enqueue:
+ *
+ *   Add an item for DOMAIN to the queue.  Methods are only queued once
+ * per domain.  Tier-up requests go first, the methods are known to be hot,
+ * and they are not subject to the queue limit, since they are not queued
+ * again.
+ */
+static void
+precomp_enqueue (int kind, MonoDomain *domain, MonoMethod *method, MonoImage *image, int depth, gboolean replayed)
+{
+	GHashTable *queued = kind == PRECOMP_TIER_UP ? precomp_tier_queued : precomp_queued;
+	PrecompItem *item;
+
+	precomp_lock ();
+
+	if (domain->state != MONO_APPDOMAIN_CREATED || (kind != PRECOMP_TIER_UP && precomp_queue.length >= PRECOMP_MAX_QUEUED)) {
+		precomp_unlock ();
+		return;
+	}
+
+	if (method) {
+		if (g_hash_table_lookup (queued, method) == domain) {
+			precomp_unlock ();
+			return;
+		}
+		g_hash_table_insert (queued, method, domain);
+	}
+
+	item = g_new0 (PrecompItem, 1);
+	item->kind = kind;
+	item->domain = domain;
+	item->method = method;
+	item->image = image;
+	item->depth = depth;
+	item->replayed = replayed;
+	if (kind == PRECOMP_TIER_UP)
+		g_queue_push_head (&precomp_queue, item);
+	else
+		g_queue_push_tail (&precomp_queue, item);
+
+	precomp_unlock ();
+
+	ReleaseSemaphore (precomp_sem, 1, NULL);
+}
+
+static PrecompImage*
+precomp_image_new (const char *name, const char *guid)
+{
+	PrecompImage *pimage = g_new0 (PrecompImage, 1);
+
+	pimage->name = g_strdup (name);
+	pimage->guid = g_strdup (guid);
+	pimage->rows = g_array_new (FALSE, FALSE, sizeof (guint32));
+	return pimage;
+}
+
+/*
+ * precomp_record_method:
+ *
+ *   Append METHOD to the list of methods compiled during the record window.
+ *
+ * LOCKING: precomp_mutex is assumed to be taken.
+ */
+static void
+precomp_record_method (MonoMethod *method)
+{
+	MonoImage *image = method->klass->image;
+	PrecompImage *pimage = NULL;
+	guint32 row, entry;
+	int i;
+
+	if (method->wrapper_type != MONO_WRAPPER_NONE || method->is_inflated || image->dynamic || !image->guid)
+		return;
+	if (mono_metadata_token_table (method->token) != MONO_TABLE_METHOD)
+		return;
+	row = mono_metadata_token_index (method->token);
+	if (row > PRECOMP_RECORD_MAX_ROW)
+		return;
+
+	for (i = 0; i < precomp_record_images->len; ++i) {
+		PrecompImage *p = g_ptr_array_index (precomp_record_images, i);
+
+		/* The guid check catches an image freed and another loaded at its address */
+		if (p->image == image && !strcmp (p->guid, image->guid)) {
+			pimage = p;
+			break;
+		}
+	}
+	if (!pimage) {
+		if (precomp_record_images->len >= PRECOMP_RECORD_MAX_IMAGES)
+			return;
+		pimage = precomp_image_new (mono_image_get_name (image), image->guid);
+		pimage->image = image;
+		g_ptr_array_add (precomp_record_images, pimage);
+		i = precomp_record_images->len - 1;
+	}
+
+	entry = ((guint32)i << 24) | row;
+	g_array_append_val (precomp_record_entries, entry);
+}
+
+static gboolean
+precomp_write_string (FILE *outfile, const char *s)
+{
+	guint32 len = strlen (s);
+
+	return fwrite (&len, sizeof (len), 1, outfile) == 1 && fwrite (s, 1, len, outfile) == len;
+}
+
+static char*
+precomp_read_string (FILE *infile)
+{
+	guint32 len;
+	char *s;
+
+	if (fread (&len, sizeof (len), 1, infile) != 1 || len > 4096)
+		return NULL;
+	s = g_malloc (len + 1);
+	if (fread (s, 1, len, infile) != len) {
+		g_free (s);
+		return NULL;
+	}
+	s [len] = '\0';
+	return s;
+}
+
+/*
+ * precomp_record_write:
+ *
+ *   Stop recording and write the record file.  The file is in native byte
+ * order, it is meant to be read back on the same machine:
+ *
+ *   guint32 magic, version, image count
+ *   for each image: guint32 length + name, guint32 length + guid
+ *   guint32 entry count
+ *   guint32 entries, (image index << 24) | method table row
+ *
+ * It is written to a temporary file first, so a crash doesn't leave a
+ * truncated file for the next run to replay.
+ */
+static void
+precomp_record_write (void)
+{
+	FILE *outfile;
+	char *tmp;
+	guint32 header [3];
+	gboolean ok;
+	int i;
+
+	precomp_lock ();
+
+	if (!precomp_recording) {
+		precomp_unlock ();
+		return;
+	}
+	precomp_recording = FALSE;
+
+	tmp = g_strdup_printf ("%s.tmp", precomp_record_file);
+	outfile = fopen (tmp, "wb");
+	if (!outfile) {
+		precomp_unlock ();
+		g_warning ("Unable to create the JIT record file '%s': %s", tmp, g_strerror (errno));
+		g_free (tmp);
+		return;
+	}
+
+	header [0] = PRECOMP_RECORD_MAGIC;
+	header [1] = PRECOMP_RECORD_VERSION;
+	header [2] = precomp_record_images->len;
+	ok = fwrite (header, sizeof (header), 1, outfile) == 1;
+
+	for (i = 0; ok && i < precomp_record_images->len; ++i) {
+		PrecompImage *pimage = g_ptr_array_index (precomp_record_images, i);
+
+		ok = precomp_write_string (outfile, pimage->name) && precomp_write_string (outfile, pimage->guid);
+	}
+
+	if (ok)
+		ok = fwrite (&precomp_record_entries->len, sizeof (guint32), 1, outfile) == 1;
+	if (ok && precomp_record_entries->len)
+		ok = fwrite (precomp_record_entries->data, sizeof (guint32), precomp_record_entries->len, outfile) == precomp_record_entries->len;
+
+	precomp_unlock ();
+
+	if (fclose (outfile) != 0)
+		ok = FALSE;
+
+	if (ok) {
+		/* Windows' rename () doesn't replace an existing file */
+		unlink (precomp_record_file);
+		ok = rename (tmp, precomp_record_file) == 0;
+	}
+	if (!ok) {
+		g_warning ("Unable to write the JIT record file '%s'", precomp_record_file);
+		unlink (tmp);
+	}
+	g_free (tmp);
+}
+
+/*
+ * precomp_replay_read:
+ *
+ *   Read the file written by precomp_record_write () into
+ * precomp_replay_images, with the rows of each image kept in compile order.
+ * A missing or invalid file is ignored, it just means there is nothing to
+ * replay.
+ */
+static void
+precomp_replay_read (const char *filename)
+{
+	FILE *infile;
+	GPtrArray *images;
+	guint32 header [3], count, entry, i;
+	gboolean ok;
+
+	infile = fopen (filename, "rb");
+	if (!infile)
+		return;
+
+	images = g_ptr_array_new ();
+
+	ok = fread (header, sizeof (header), 1, infile) == 1 && header [0] == PRECOMP_RECORD_MAGIC &&
+		header [1] == PRECOMP_RECORD_VERSION && header [2] <= PRECOMP_RECORD_MAX_IMAGES;
+
+	for (i = 0; ok && i < header [2]; ++i) {
+		char *name = precomp_read_string (infile);
+		char *guid = name ? precomp_read_string (infile) : NULL;
+
+		if (guid)
+			g_ptr_array_add (images, precomp_image_new (name, guid));
+		else
+			ok = FALSE;
+		g_free (name);
+		g_free (guid);
+	}
+
+	if (ok)
+		ok = fread (&count, sizeof (count), 1, infile) == 1;
+
+	for (i = 0; ok && i < count; ++i) {
+		PrecompImage *pimage;
+
+		if (fread (&entry, sizeof (entry), 1, infile) != 1 || (entry >> 24) >= images->len) {
+			ok = FALSE;
+			break;
+		}
+		pimage = g_ptr_array_index (images, entry >> 24);
+		entry &= PRECOMP_RECORD_MAX_ROW;
+		g_array_append_val (pimage->rows, entry);
+	}
+
+	fclose (infile);
+
+	if (!ok) {
+		g_warning ("The JIT record file '%s' is invalid, ignoring it", filename);
+		for (i = 0; i < images->len; ++i) {
+			PrecompImage *pimage = g_ptr_array_index (images, i);
+
+			g_free (pimage->name);
+			g_free (pimage->guid);
+			g_array_free (pimage->rows, TRUE);
+			g_free (pimage);
+		}
+		g_ptr_array_free (images, TRUE);
+		return;
+	}
+
+	precomp_replay_images = images;
+}
+
+/*
+ * precomp_replay_image:
+ *
+ *   Queue the recorded methods of IMAGE, if the recorded image is the same
+ * build as the loaded one.
+ */
+static void
+precomp_replay_image (MonoDomain *domain, MonoImage *image)
+{
+	int i, j;
+
+	for (i = 0; i < precomp_replay_images->len; ++i) {
+		PrecompImage *pimage = g_ptr_array_index (precomp_replay_images, i);
+
+		if (strcmp (pimage->name, mono_image_get_name (image)) || strcmp (pimage->guid, image->guid))
+			continue;
+
+		for (j = 0; j < pimage->rows->len; ++j) {
+			guint32 row = g_array_index (pimage->rows, guint32, j);
+			MonoMethod *method;
+
+			if (row == 0 || row > image->tables [MONO_TABLE_METHOD].rows)
+				continue;
+
+			method = mono_get_method (image, MONO_TOKEN_METHOD_DEF | row, NULL);
+			if (method)
+				precomp_enqueue (PRECOMP_METHOD, domain, method, NULL, precomp_max_depth, TRUE);
+			else
+				mono_loader_clear_error ();
+		}
+	}
+}
+
+/*
+ * mono_precomp_method_compiled:
+ *
+ *   Called by the JIT after it published the code of CFG->method.  Record
+ * the method if it was needed during the record window, and queue the
+ * methods the new code calls directly, so they are compiled before the
+ * calls reach them.
+ */
+void
+mono_precomp_method_compiled (MonoDomain *domain, MonoCompile *cfg)
+{
+	PrecompItem *cur;
+	MonoJumpInfo *patch_info;
+	int depth;
+
+	if (cfg->compile_aot || !precomp_sem)
+		return;
+
+	cur = TlsGetValue (precomp_tls_id);
+
+	if (precomp_recording && (!cur || cur->replayed)) {
+		precomp_lock ();
+		if (precomp_recording)
+			precomp_record_method (cfg->method);
+		precomp_unlock ();
+	}
+
+	if (!precomp_callees)
+		return;
+
+	/* Methods compiled on demand are at depth 0 */
+	depth = cur ? cur->depth + 1 : 1;
+	if (depth > precomp_max_depth)
+		return;
+
+	for (patch_info = cfg->patch_info; patch_info; patch_info = patch_info->next) {
+		MonoMethod *callee;
+
+		if (patch_info->type != MONO_PATCH_INFO_METHOD && patch_info->type != MONO_PATCH_INFO_METHOD_JUMP)
+			continue;
+
+		callee = patch_info->data.method;
+		if (callee == cfg->method || callee->wrapper_type != MONO_WRAPPER_NONE)
+			continue;
+
+		precomp_enqueue (PRECOMP_METHOD, domain, callee, NULL, depth, FALSE);
+	}
+}
+
+/*
+ * mono_precomp_tier_up_calls:
+ *
+ *   Return the number of calls after which tier-0 code is recompiled.
+ */
+int
+mono_precomp_tier_up_calls (void)
+{
+	return precomp_tier_up_calls;
+}
+
+/*
+ * mono_precomp_tier_up:
+ *
+ *   JIT icall called by tier-0 code once its call counter runs out.
+ */
+void
+mono_precomp_tier_up (MonoMethod *method)
+{
+	if (!precomp_sem)
+		return;
+
+	precomp_enqueue (PRECOMP_TIER_UP, mono_domain_get (), method, NULL, 0, FALSE);
+}
+
+/*
+ * precomp_load_profile:
+ *
+ *   Queue the methods of IMAGE listed in the profile files written for it by
+ * the AOT profiler.  The format is the one read by the AOT compiler: a
+ * "#VER:2" line followed by one full method name per line.
+ */
+static void
+precomp_load_profile (MonoDomain *domain, MonoImage *image)
+{
+	FILE *infile;
+	char *tmp;
+	char ver [256];
+	char name [1024];
+	int file_index, res;
+
+	for (file_index = 0; ; ++file_index) {
+		tmp = g_strdup_printf ("%s/%s-%d", precomp_profile_dir, mono_image_get_name (image), file_index);
+		infile = fopen (tmp, "r");
+		g_free (tmp);
+		if (!infile)
+			break;
+
+		res = fscanf (infile, "%32s\n", ver);
+		if ((res != 1) || strcmp (ver, "#VER:2") != 0) {
+			fclose (infile);
+			continue;
+		}
+
+		while (fgets (name, sizeof (name), infile)) {
+			MonoMethodDesc *desc;
+			MonoMethod *method;
+
+			/* Kill the newline */
+			if (strlen (name) > 0)
+				name [strlen (name) - 1] = '\0';
+
+			desc = mono_method_desc_new (name, TRUE);
+			if (!desc)
+				continue;
+			method = mono_method_desc_search_in_image (desc, image);
+			mono_method_desc_free (desc);
+
+			/* The profile already lists the callees which were needed */
+			if (method)
+				precomp_enqueue (PRECOMP_METHOD, domain, method, NULL, precomp_max_depth, FALSE);
+		}
+		fclose (infile);
+	}
+}
+
+static void
+precomp_assembly_loaded (MonoAssembly *assembly, gpointer user_data)
+{
+	MonoDomain *domain = mono_domain_get ();
+
+	if (assembly->image->dynamic || !assembly->image->guid)
+		return;
+
+	/* The replayed methods go first, they are the ones needed earliest */
+	if (precomp_replay_images)
+		precomp_enqueue (PRECOMP_REPLAY, domain, NULL, assembly->image, 0, FALSE);
+	if (precomp_profile_dir)
+		precomp_enqueue (PRECOMP_PROFILE, domain, NULL, assembly->image, 0, FALSE);
+}
+
+static void
+precomp_assembly_foreach (gpointer data, gpointer user_data)
+{
+	precomp_assembly_loaded ((MonoAssembly*)data, user_data);
+}
+
+/*
+ * precomp_reset_abort:
+ *
+ *   Unloading a domain aborts the threads holding a reference to it, the
+ * workers included.  A worker doesn't run managed code where the abort
+ * would be delivered, so consume it here, before it can hit some unrelated
+ * cctor run by the JIT later.
+ */
+static void
+precomp_reset_abort (void)
+{
+	MonoException *exc = mono_thread_get_and_clear_pending_exception ();
+
+	if (exc && exc->object.vtable->klass == mono_defaults.threadabortexception_class)
+		ves_icall_System_Threading_Thread_ResetAbort ();
+}
+
+static void
+precomp_worker (gpointer data)
+{
+	while (!mono_runtime_is_shutting_down ()) {
+		PrecompItem *item;
+		MonoDomain *domain;
+		guint32 timeout = INFINITE;
+
+		/* Wake up when the record window ends, to write the file */
+		if (precomp_recording) {
+			guint32 elapsed = mono_msec_ticks () - precomp_start_time;
+
+			timeout = elapsed < precomp_record_ms ? precomp_record_ms - elapsed : 0;
+		}
+
+		/* Alertable, so interruptions wake us up */
+		if (WaitForSingleObjectEx (precomp_sem, timeout, TRUE) == WAIT_TIMEOUT) {
+			precomp_record_write ();
+			continue;
+		}
+		precomp_reset_abort ();
+		if (mono_runtime_is_shutting_down ())
+			break;
+
+		precomp_lock ();
+		item = g_queue_pop_head (&precomp_queue);
+		if (item) {
+			/*
+			 * Take the reference before checking the state, so either the
+			 * unload sees the reference and waits for us, or we see that
+			 * it started.
+			 */
+			mono_thread_push_appdomain_ref (item->domain);
+			if (item->domain->state != MONO_APPDOMAIN_CREATED) {
+				mono_thread_pop_appdomain_ref ();
+				g_free (item);
+				item = NULL;
+			}
+		}
+		precomp_unlock ();
+
+		if (!item)
+			continue;
+
+		domain = item->domain;
+		if (mono_domain_set (domain, FALSE)) {
+			TlsSetValue (precomp_tls_id, item);
+			switch (item->kind) {
+			case PRECOMP_METHOD:
+				mono_jit_precompile_method (domain, item->method);
+				break;
+			case PRECOMP_PROFILE:
+				precomp_load_profile (domain, item->image);
+				break;
+			case PRECOMP_REPLAY:
+				precomp_replay_image (domain, item->image);
+				break;
+			case PRECOMP_TIER_UP:
+				mono_jit_tier_up_method (domain, item->method);
+				break;
+			default:
+				g_assert_not_reached ();
+			}
+			TlsSetValue (precomp_tls_id, NULL);
+			mono_domain_set (mono_get_root_domain (), TRUE);
+		}
+		mono_thread_pop_appdomain_ref ();
+		g_free (item);
+
+		precomp_reset_abort ();
+	}
+}
+
+static gboolean
+precomp_queued_in_domain (gpointer key, gpointer value, gpointer user_data)
+{
+	return value == user_data;
+}
+
+/*
+ * mono_precomp_domain_free:
+ *
+ *   Drop the items queued for DOMAIN, which is being freed.  The workers
+ * are not compiling for it anymore, since the unload waited for threads
+ * with a reference to the domain.
+ */
+void
+mono_precomp_domain_free (MonoDomain *domain)
+{
+	GQueue keep = { NULL, NULL, 0 };
+	PrecompItem *item;
+
+	if (!precomp_sem)
+		return;
+
+	precomp_lock ();
+
+	while ((item = g_queue_pop_head (&precomp_queue))) {
+		if (item->domain == domain)
+			g_free (item);
+		else
+			g_queue_push_tail (&keep, item);
+	}
+	precomp_queue = keep;
+
+	g_hash_table_foreach_remove (precomp_queued, precomp_queued_in_domain, domain);
+	g_hash_table_foreach_remove (precomp_tier_queued, precomp_queued_in_domain, domain);
+
+	precomp_unlock ();
+}
+
+/*
+ * mono_precomp_cleanup:
+ *
+ *   Write the record file if the run ended before the record window did.
+ */
+void
+mono_precomp_cleanup (void)
+{
+	if (!precomp_sem)
+		return;
+
+	precomp_record_write ();
+}
+
+/*
+ * mono_precomp_init:
+ *
+ *   Parse MONO_PRECOMP and start the workers if it enables anything.  The
+ * options are:
+ *
+ *   callees[=<depth>]    queue the callees of compiled methods
+ *   profile[=<dir>]      queue the methods listed by the AOT profiler
+ *   record=<file>        write the methods compiled in the first seconds
+ *   record-time=<secs>   length of the record window, 30 by default
+ *   replay=<file>        queue the methods listed in a record file
+ *   threads=<n>          number of workers, by default one, or one per
+ *                        core but one when replaying
+ *   tiered[=<calls>]     compile tier-0 code first, and recompile it after
+ *                        30 calls by default, also enabled by -O=tier0
+ *
+ * The same file can be given to replay and record, the replayed methods
+ * which get compiled are recorded again.
+ */
+void
+mono_precomp_init (void)
+{
+	char *options = getenv ("MONO_PRECOMP");
+	gboolean profile = FALSE;
+	gchar **args, **ptr;
+	int i, threads = 0;
+
+	if (!options && !mono_tiered_compilation)
+		return;
+
+	precomp_start_time = mono_msec_ticks ();
+
+	args = options ? g_strsplit (options, ",", -1) : NULL;
+
+	for (ptr = args; ptr && *ptr; ptr++) {
+		const char *arg = *ptr;
+
+		if (!strcmp (arg, "callees")) {
+			precomp_callees = TRUE;
+		} else if (!strncmp (arg, "callees=", 8)) {
+			precomp_callees = TRUE;
+			precomp_max_depth = MAX (atoi (arg + 8), 1);
+		} else if (!strcmp (arg, "profile")) {
+			profile = TRUE;
+		} else if (!strncmp (arg, "profile=", 8)) {
+			profile = TRUE;
+			precomp_profile_dir = g_strdup (arg + 8);
+		} else if (!strncmp (arg, "record=", 7)) {
+			precomp_record_file = g_strdup (arg + 7);
+		} else if (!strncmp (arg, "record-time=", 12)) {
+			precomp_record_ms = MAX (atoi (arg + 12), 1) * 1000;
+		} else if (!strncmp (arg, "replay=", 7)) {
+			precomp_replay_file = g_strdup (arg + 7);
+		} else if (!strncmp (arg, "threads=", 8)) {
+			threads = MAX (atoi (arg + 8), 1);
+		} else if (!strcmp (arg, "tiered")) {
+			mono_tiered_compilation = TRUE;
+		} else if (!strncmp (arg, "tiered=", 7)) {
+			mono_tiered_compilation = TRUE;
+			precomp_tier_up_calls = MAX (atoi (arg + 7), 1);
+		} else {
+			fprintf (stderr, "Invalid option for the MONO_PRECOMP env variable: %s\n", arg);
+			fprintf (stderr, "Available options: \n");
+			fprintf (stderr, "  callees[=<depth>]\n");
+			fprintf (stderr, "  profile[=<dir>]\n");
+			fprintf (stderr, "  record=<file>\n");
+			fprintf (stderr, "  record-time=<seconds>\n");
+			fprintf (stderr, "  replay=<file>\n");
+			fprintf (stderr, "  threads=<n>\n");
+			fprintf (stderr, "  tiered[=<calls>]\n");
+			exit (1);
+		}
+	}
+
+	g_strfreev (args);
+
+	if (precomp_replay_file)
+		precomp_replay_read (precomp_replay_file);
+
+	if (!precomp_callees && !profile && !precomp_record_file && !precomp_replay_images && !mono_tiered_compilation)
+		return;
+
+	InitializeCriticalSection (&precomp_mutex);
+	precomp_queued = g_hash_table_new (NULL, NULL);
+	precomp_tier_queued = g_hash_table_new (NULL, NULL);
+	precomp_sem = CreateSemaphore (NULL, 0, 0x7fffffff, NULL);
+	g_assert (precomp_sem);
+	precomp_tls_id = TlsAlloc ();
+
+	if (precomp_record_file) {
+		precomp_record_images = g_ptr_array_new ();
+		precomp_record_entries = g_array_new (FALSE, FALSE, sizeof (guint32));
+		precomp_recording = TRUE;
+	}
+
+	if (profile && !precomp_profile_dir)
+		precomp_profile_dir = g_strdup_printf ("%s/.mono/aot-profile-data", g_get_home_dir ());
+
+	if (precomp_profile_dir || precomp_replay_images) {
+		mono_install_assembly_load_hook (precomp_assembly_loaded, NULL);
+		/* corlib and anything else loaded during startup */
+		mono_assembly_foreach (precomp_assembly_foreach, NULL);
+	}
+
+	if (!threads)
+		threads = precomp_replay_images ? MAX (mono_cpu_count () - 1, 1) : 1;
+
+	for (i = 0; i < threads; ++i)
+		mono_thread_create_internal (mono_get_root_domain (), precomp_worker, NULL, TRUE);
+}
@@ -254,6 +254,24 @@ mono_convert_imt_slot_to_vtable_slot (gpointer* slot, mgreg_t *regs, guint8 *cod
 }
 #endif
 
+/*
+ * is_tier0_code:
+ *
+ *   Return whenever ADDR is tier-0 code, which is replaced once the method is hot,
+ * so it shouldn't be patched into callers.
+ */
+static gboolean
+is_tier0_code (MonoDomain *domain, gpointer addr)
+{
+	MonoJitInfo *ji;
+
+	if (!mono_tiered_compilation)
+		return FALSE;
+
+	ji = mono_jit_info_table_find (domain, mono_get_addr_from_ftnptr (addr));
+	return ji && ji->tier0;
+}
+
 /**
  * mono_magic_trampoline:
  *
@@ -271,6 +289,7 @@ mono_magic_trampoline (mgreg_t *regs, guint8 *code, gpointer arg, guint8* tramp)
 	int context_used;
 	gboolean proxy = FALSE;
 	gboolean need_rgctx_tramp = FALSE;
+	gboolean tier0 = FALSE;
 
 	m = arg;
 
@@ -495,6 +514,13 @@ mono_magic_trampoline (mgreg_t *regs, guint8 *code, gpointer arg, guint8* tramp)
 
 	mono_debugger_trampoline_compiled (code, m, addr);
 
+	/*
+	 * Tier-0 code is going to be replaced, so don't patch it into the caller.
+	 * The caller comes back here, and gets patched, once the tier-1 code
+	 * is published.
+	 */
+	tier0 = is_tier0_code (mono_domain_get (), compiled_method);
+
 	if (need_rgctx_tramp)
 		addr = mono_create_static_rgctx_trampoline (m, addr);
 
@@ -508,9 +534,10 @@ mono_magic_trampoline (mgreg_t *regs, guint8 *code, gpointer arg, guint8* tramp)
 		if (vt->klass->valuetype)
 			addr = get_unbox_trampoline (mono_get_generic_context_from_code (code), m, addr, need_rgctx_tramp);
 
-		mono_method_add_generic_virtual_invocation (mono_domain_get (), 
-													vt, vtable_slot,
-													generic_virtual, addr);
+		if (!tier0)
+			mono_method_add_generic_virtual_invocation (mono_domain_get (), 
+														vt, vtable_slot,
+														generic_virtual, addr);
 
 		return addr;
 	}
@@ -524,7 +551,7 @@ mono_magic_trampoline (mgreg_t *regs, guint8 *code, gpointer arg, guint8* tramp)
 		 * We do this here instead of in mono_codegen () to cover the case when m
 		 * was loaded from an aot image.
 		 */
-		if (domain_jit_info (domain)->jump_target_got_slot_hash) {
+		if (domain_jit_info (domain)->jump_target_got_slot_hash && !tier0) {
 			GSList *list, *tmp;
 
 			mono_domain_lock (domain);
@@ -550,14 +577,14 @@ mono_magic_trampoline (mgreg_t *regs, guint8 *code, gpointer arg, guint8* tramp)
 			addr = get_unbox_trampoline (mono_get_generic_context_from_code (code), m, addr, need_rgctx_tramp);
 		g_assert (*vtable_slot);
 
-		if (!proxy && (mono_aot_is_got_entry (code, (guint8*)vtable_slot) || mono_domain_owns_vtable_slot (mono_domain_get (), vtable_slot))) {
+		if (!proxy && !tier0 && (mono_aot_is_got_entry (code, (guint8*)vtable_slot) || mono_domain_owns_vtable_slot (mono_domain_get (), vtable_slot))) {
 #ifdef MONO_ARCH_HAVE_IMT
 			vtable_slot = mono_convert_imt_slot_to_vtable_slot (vtable_slot, regs, code, m, NULL, &need_rgctx_tramp);
 #endif
 			*vtable_slot = mono_get_addr_from_ftnptr (addr);
 		}
 	}
-	else {
+	else if (!tier0) {
 		guint8 *plt_entry = mono_aot_get_plt_entry (code);
 
 		if (plt_entry) {
@@ -896,7 +923,8 @@ mono_delegate_trampoline (mgreg_t *regs, guint8 *code, gpointer *tramp_data, gui
 			delegate->method_ptr = *delegate->method_code;
 		} else {
 			delegate->method_ptr = mono_compile_method (method);
-			if (delegate->method_code)
+			/* Don't cache tier-0 code, so delegates created later get the tier-1 code */
+			if (delegate->method_code && !is_tier0_code (domain, delegate->method_ptr))
 				*delegate->method_code = delegate->method_ptr;
 			mono_debugger_trampoline_compiled (NULL, method, delegate->method_ptr);
 		}
@@ -915,6 +943,28 @@ mono_delegate_trampoline (mgreg_t *regs, guint8 *code, gpointer *tramp_data, gui
 
 		if (code) {
 			delegate->invoke_impl = mono_get_addr_from_ftnptr (code);
+
+			/* 
+			 * Let delegates created later for the same method bypass this trampoline.
+			 * The result only depends on the delegate type, the method and whenever
+			 * the impl_this version was used, except for remoting.
+			 */
+			if (delegate->method && !delegate->method->dynamic && method &&
+				!(delegate->target && delegate->target->vtable->klass == mono_defaults.transparent_proxy_class) &&
+				!is_tier0_code (domain, delegate->method_ptr)) {
+				MonoDelegateInvokeCache *cache;
+
+				cache = mono_get_delegate_invoke_cache (domain, delegate->object.vtable->klass, delegate->method, code == impl_this, FALSE);
+				if (cache && !cache->info->method_ptr) {
+					MonoDelegateInvokeInfo *info = mono_domain_alloc0 (domain, sizeof (MonoDelegateInvokeInfo));
+
+					info->invoke_impl = delegate->invoke_impl;
+					info->method_ptr = delegate->method_ptr;
+					mono_memory_barrier ();
+					cache->info = info;
+					mono_jit_stats.delegate_invoke_caches++;
+				}
+			}
 			return code;
 		}
 	}
@@ -1104,7 +1154,7 @@ mono_create_jump_trampoline (MonoDomain *domain, MonoMethod *method, gboolean ad
 	 * method from its native code address, so we use the
 	 * trampoline instead.
 	 */
-	if (code && !ji->has_generic_jit_info)
+	if (code && !ji->has_generic_jit_info && !ji->tier0)
 		return code;
 
 	mono_domain_lock (domain);
@@ -1232,6 +1282,49 @@ mono_create_delegate_trampoline (MonoClass *klass)
 #endif
 }
 
+/*
+ * mono_get_delegate_invoke_cache:
+ *
+ *   Return the MonoDelegateInvokeCache for delegates of type KLASS pointing to
+ * METHOD, with a target if HAS_TARGET is TRUE.  If CREATE is TRUE, create it if
+ * it doesn't exist, with an info which points to the delegate trampoline.
+ */
+MonoDelegateInvokeCache*
+mono_get_delegate_invoke_cache (MonoDomain *domain, MonoClass *klass, MonoMethod *method, gboolean has_target, gboolean create)
+{
+	MonoDelegateInvokeCache *cache, *list;
+	MonoDelegateInvokeInfo *info;
+	gpointer tramp = NULL;
+
+	if (create)
+		tramp = mono_create_delegate_trampoline (klass);
+
+	mono_domain_lock (domain);
+	if (!domain_jit_info (domain)->delegate_invoke_cache_hash)
+		domain_jit_info (domain)->delegate_invoke_cache_hash = g_hash_table_new (mono_aligned_addr_hash, NULL);
+	list = g_hash_table_lookup (domain_jit_info (domain)->delegate_invoke_cache_hash, method);
+	for (cache = list; cache; cache = cache->next) {
+		if (cache->klass == klass && cache->has_target == has_target)
+			break;
+	}
+
+	if (!cache && create) {
+		info = mono_domain_alloc0 (domain, sizeof (MonoDelegateInvokeInfo));
+		info->invoke_impl = tramp;
+
+		cache = mono_domain_alloc0 (domain, sizeof (MonoDelegateInvokeCache));
+		cache->klass = klass;
+		cache->method = method;
+		cache->has_target = has_target;
+		cache->info = info;
+		cache->next = list;
+		g_hash_table_insert (domain_jit_info (domain)->delegate_invoke_cache_hash, method, cache);
+	}
+	mono_domain_unlock (domain);
+
+	return cache;
+}
+
 gpointer
 mono_create_rgctx_lazy_fetch_trampoline (guint32 offset)
 {
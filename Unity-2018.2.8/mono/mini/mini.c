@@ -91,6 +91,8 @@ gboolean mono_break_on_exc = FALSE;
 gboolean mono_compile_aot = FALSE;
 /* If this is set, no code is generated dynamically, everything is taken from AOT files */
 gboolean mono_aot_only = FALSE;
+/* Whenever to compile methods quickly first, and recompile the ones which get hot */
+gboolean mono_tiered_compilation = FALSE;
 /* Whenever to use IMT */
 #ifdef MONO_ARCH_HAVE_IMT
 gboolean mono_use_imt = TRUE;
@@ -2330,6 +2332,7 @@ setup_jit_tls_data (gpointer stack_start, gpointer abort_func)
 #endif
 
 	jit_tls->first_lmf = lmf;
+	jit_tls->unwind_cache = mono_unwind_cache_new ();
 
 #if defined(HAVE_KW_THREAD) && defined(MONO_ARCH_ENABLE_MONO_LMF_VAR)
 	/* jit_tls->lmf is unused */
@@ -2395,6 +2398,7 @@ mini_thread_cleanup (MonoThread *thread)
 
 		mono_free_altstack (jit_tls);
 		g_free (jit_tls->first_lmf);
+		mono_unwind_cache_free (jit_tls->unwind_cache);
 		g_free (jit_tls);
 		thread->jit_data = NULL;
 
@@ -2467,6 +2471,29 @@ mono_add_patch_info (MonoCompile *cfg, int ip, MonoJumpInfoType type, gconstpoin
 	cfg->patch_info = ji;
 }
 
+/*
+ * mono_patch_info_rgctx_entry_get_slot:
+ *
+ *   Return the (m)rgctx slot holding the data described by ENTRY, registering
+ * it in the rgctx template of the class of ENTRY->method if needed.
+ */
+guint32
+mono_patch_info_rgctx_entry_get_slot (MonoJumpInfoRgctxEntry *entry)
+{
+	switch (entry->data->type) {
+	case MONO_PATCH_INFO_CLASS:
+		return mono_method_lookup_or_register_other_info (entry->method, entry->in_mrgctx, &entry->data->data.klass->byval_arg, entry->info_type, mono_method_get_context (entry->method));
+	case MONO_PATCH_INFO_METHOD:
+	case MONO_PATCH_INFO_METHODCONST:
+		return mono_method_lookup_or_register_other_info (entry->method, entry->in_mrgctx, entry->data->data.method, entry->info_type, mono_method_get_context (entry->method));
+	case MONO_PATCH_INFO_FIELD:
+		return mono_method_lookup_or_register_other_info (entry->method, entry->in_mrgctx, entry->data->data.field, entry->info_type, mono_method_get_context (entry->method));
+	default:
+		g_assert_not_reached ();
+		return -1;
+	}
+}
+
 MonoJumpInfo *
 mono_patch_info_list_prepend (MonoJumpInfo *list, int ip, MonoJumpInfoType type, gconstpointer target)
 {
@@ -2804,24 +2831,7 @@ mono_resolve_patch_target (MonoMethod *method, MonoDomain *domain, guint8 *code,
 	case MONO_PATCH_INFO_NONE:
 		break;
 	case MONO_PATCH_INFO_RGCTX_FETCH: {
-		MonoJumpInfoRgctxEntry *entry = patch_info->data.rgctx_entry;
-		guint32 slot = -1;
-
-		switch (entry->data->type) {
-		case MONO_PATCH_INFO_CLASS:
-			slot = mono_method_lookup_or_register_other_info (entry->method, entry->in_mrgctx, &entry->data->data.klass->byval_arg, entry->info_type, mono_method_get_context (entry->method));
-			break;
-		case MONO_PATCH_INFO_METHOD:
-		case MONO_PATCH_INFO_METHODCONST:
-			slot = mono_method_lookup_or_register_other_info (entry->method, entry->in_mrgctx, entry->data->data.method, entry->info_type, mono_method_get_context (entry->method));
-			break;
-		case MONO_PATCH_INFO_FIELD:
-			slot = mono_method_lookup_or_register_other_info (entry->method, entry->in_mrgctx, entry->data->data.field, entry->info_type, mono_method_get_context (entry->method));
-			break;
-		default:
-			g_assert_not_reached ();
-			break;
-		}
+		guint32 slot = mono_patch_info_rgctx_entry_get_slot (patch_info->data.rgctx_entry);
 
 		target = mono_create_rgctx_lazy_fetch_trampoline (slot);
 		break;
@@ -3140,6 +3150,27 @@ mono_save_seq_point_info (MonoCompile *cfg)
 	cfg->seq_points = NULL;
 }
 
+/*
+ * method_code_pool:
+ *
+ *   Return the code manager pool the code of CFG is allocated from. Methods which
+ * run once or are replaced when they get hot go into the cold pool, so they don't
+ * dilute the code which runs in steady state.
+ */
+static MonoCodePool
+method_code_pool (MonoCompile *cfg)
+{
+	MonoMethod *method = cfg->method;
+
+	if (method->wrapper_type != MONO_WRAPPER_NONE)
+		return MONO_CODE_POOL_WRAPPER;
+	if ((method->flags & METHOD_ATTRIBUTE_SPECIAL_NAME) && !strcmp (method->name, ".cctor"))
+		return MONO_CODE_POOL_COLD;
+	if (cfg->opt & MONO_OPT_TIER0)
+		return MONO_CODE_POOL_COLD;
+	return MONO_CODE_POOL_HOT;
+}
+
 void
 mono_codegen (MonoCompile *cfg)
 {
@@ -3225,7 +3256,7 @@ mono_codegen (MonoCompile *cfg)
 #ifdef MONO_ARCH_HAVE_UNWIND_TABLE
 		unwindlen = mono_arch_unwindinfo_get_size (cfg->arch.unwindinfo);
 #endif
-		code = mono_domain_code_reserve (cfg->domain, cfg->code_size + unwindlen);
+		code = mono_domain_code_reserve_pool (cfg->domain, method_code_pool (cfg), cfg->code_size + unwindlen);
 	}
 
 	memcpy (code, cfg->native_code, cfg->code_len);
@@ -3663,6 +3694,9 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, gbool
 	mono_handle_global_vregs (cfg);
 	if (cfg->opt & MONO_OPT_DEADCE)
 		mono_local_deadce (cfg);
+	/* Needs the vars computed by mono_handle_global_vregs () */
+	if (cfg->object_allocs && mono_stack_alloc_objects (cfg) && (cfg->opt & MONO_OPT_DEADCE))
+		mono_local_deadce (cfg);
 	/* Disable this for LLVM to make the IR easier to handle */
 	if (!COMPILE_LLVM (cfg))
 		mono_if_conversion (cfg);
@@ -3819,6 +3853,30 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, gbool
 		return cfg;
 	}
 
+	if ((cfg->opt & MONO_OPT_LOOP) && !header->num_clauses && !COMPILE_LLVM (cfg)) {
+		gboolean changed = FALSE;
+
+		if (cfg->flags & MONO_CFG_HAS_LDELEMA)
+			changed = mono_perform_loop_abc_removal (cfg);
+#ifdef MONO_ARCH_SIMD_INTRINSICS
+		if ((cfg->opt & MONO_OPT_SIMD) && mono_simd_vectorize_loops (cfg))
+			changed = TRUE;
+#endif
+		if (changed) {
+			MonoBasicBlock *bb;
+
+			/* Have to recompute cfg->bblocks and bb->dfn */
+			for (bb = cfg->bb_entry; bb; bb = bb->next_bb)
+				bb->dfn = 0;
+
+			cfg->bblocks = mono_mempool_alloc (cfg->mempool, sizeof (MonoBasicBlock*) * (cfg->num_bblocks + 1));
+
+			dfn = 0;
+			df_visit (cfg->bb_entry, &dfn, cfg->bblocks);
+			cfg->num_bblocks = dfn + 1;
+		}
+	}
+
 #ifdef MONO_ARCH_SOFT_FLOAT
 	mono_decompose_soft_float (cfg);
 #endif
@@ -3919,6 +3977,9 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, gbool
 			}
 		}
 
+		if ((cfg->opt & MONO_OPT_BRANCH) && !cfg->globalra && !COMPILE_LLVM (cfg))
+			mono_move_cold_bblocks (cfg);
+
 		/* Add branches between non-consecutive bblocks */
 		for (bb = cfg->bb_entry; bb; bb = bb->next_bb) {
 			if (bb->last_ins && MONO_IS_COND_BRANCH_OP (bb->last_ins) &&
@@ -4042,6 +4103,7 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, gbool
 	jinfo->num_clauses = header->num_clauses;
 	if (COMPILE_LLVM (cfg))
 		jinfo->from_llvm = TRUE;
+	jinfo->tier0 = cfg->tier0;
 
 	if (cfg->generic_sharing_context) {
 		MonoInst *inst;
@@ -4115,7 +4177,11 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, gbool
 			g_assert (tblock);
 			ei->try_start = cfg->native_code + tblock->native_offset;
 			g_assert (tblock->native_offset);
-			tblock = cfg->cil_offset_to_bb [ec->try_offset + ec->try_len];
+			if (cfg->cold_clauses && cfg->cold_clauses [i])
+				/* The handler no longer follows the try block */
+				tblock = mono_cold_clause_try_end (cfg, i);
+			else
+				tblock = cfg->cil_offset_to_bb [ec->try_offset + ec->try_len];
 			g_assert (tblock);
 			ei->try_end = cfg->native_code + tblock->native_offset;
 			g_assert (tblock->native_offset);
@@ -4216,35 +4282,114 @@ lookup_generic_method (MonoDomain *domain, MonoMethod *method)
 }
 
 /*
- * LOCKING: Assumes domain->jit_code_hash_lock is held.
+ * LOCKING: Takes domain->jit_code_hash_lock, but not the loader lock.
+ *
+ * The shared generic lookup inflates methods, which takes the loader
+ * lock, so it is done without holding jit_code_hash_lock.  That keeps
+ * the usual loader -> jit_code_hash lock order without callers having
+ * to take the loader lock around every lookup.
  */
 static MonoJitInfo*
-lookup_method_inner (MonoDomain *domain, MonoMethod *method)
+lookup_method (MonoDomain *domain, MonoMethod *method)
 {
-	MonoJitInfo *ji = mono_internal_hash_table_lookup (&domain->jit_code_hash, method);
+	MonoJitInfo *info;
 
-	if (ji)
-		return ji;
+	mono_domain_jit_code_hash_lock (domain);
+	info = mono_internal_hash_table_lookup (&domain->jit_code_hash, method);
+	mono_domain_jit_code_hash_unlock (domain);
+
+	if (info)
+		return info;
 
 	return lookup_generic_method (domain, method);
 }
 
-static MonoJitInfo*
-lookup_method (MonoDomain *domain, MonoMethod *method)
+/*
+ * The optimizations used for tier-0 code, which is compiled for compile
+ * speed.  Inlining, global register allocation and the dataflow passes are
+ * left to the tier-1 recompile.
+ */
+#define TIER0_OPTIMIZATIONS (MONO_OPT_PEEPHOLE | MONO_OPT_BRANCH | MONO_OPT_CFOLD | MONO_OPT_INTRINS | \
+	MONO_OPT_CMOV | MONO_OPT_FCMOV | MONO_OPT_EXCEPTION | MONO_OPT_SSE2 | MONO_OPT_GSHARED | MONO_OPT_SIMD | MONO_OPT_AOT)
+
+/* Added to the default optimizations for tier-1 code, ABCREM brings in SSA */
+#define TIER1_OPTIMIZATIONS (MONO_OPT_LOOP | MONO_OPT_ABCREM)
+
+/*
+ * use_tier0:
+ *
+ *   Return whenever METHOD should be compiled as tier-0 code first.  Domain
+ * neutral code, wrappers and code which runs only once are compiled directly
+ * with OPT.  So is code mini_method_compile () is going to share, since shared
+ * generic code is never recompiled.
+ */
+static gboolean
+use_tier0 (MonoMethod *method, guint32 opt)
 {
-	MonoJitInfo *info;
+	if (!mono_tiered_compilation || (opt & MONO_OPT_SHARED))
+		return FALSE;
+	/* Dynamic methods could be freed while their tier-1 recompile is queued */
+	if (method->wrapper_type != MONO_WRAPPER_NONE || method->dynamic)
+		return FALSE;
+	if ((method->flags & METHOD_ATTRIBUTE_SPECIAL_NAME) && !strcmp (method->name, ".cctor"))
+		return FALSE;
+	if ((opt & MONO_OPT_GSHARED) && mono_class_generic_sharing_enabled (method->klass) &&
+		mono_method_is_generic_sharable_impl (method, FALSE))
+		return FALSE;
+	return TRUE;
+}
 
-	mono_loader_lock (); /*FIXME lookup_method_inner acquired it*/
-	mono_domain_jit_code_hash_lock (domain);
-	info = lookup_method_inner (domain, method);
-	mono_domain_jit_code_hash_unlock (domain);
-	mono_loader_unlock ();
+/*
+ * patch_jump_targets:
+ *
+ *   Patch the jumps to METHOD made from code compiled in DOMAIN before
+ * METHOD was, to jump to its published code.
+ */
+static void
+patch_jump_targets (MonoDomain *domain, MonoMethod *method)
+{
+	MonoJumpInfo patch_info;
+	MonoJumpList *jlist;
+	GSList *tmp;
 
-	return info;
+	if (!domain_jit_info (domain)->jump_target_hash)
+		return;
+
+	mono_domain_lock (domain);
+	jlist = g_hash_table_lookup (domain_jit_info (domain)->jump_target_hash, method);
+	if (jlist)
+		g_hash_table_remove (domain_jit_info (domain)->jump_target_hash, method);
+	mono_domain_unlock (domain);
+
+	if (!jlist)
+		return;
+
+	/* Resolving the jump target can load classes, so keep the loader -> domain lock order */
+	mono_loader_lock ();
+	mono_domain_lock (domain);
+
+	patch_info.next = NULL;
+	patch_info.ip.i = 0;
+	patch_info.type = MONO_PATCH_INFO_METHOD_JUMP;
+	patch_info.data.method = method;
+
+	for (tmp = jlist->list; tmp; tmp = tmp->next)
+		mono_arch_patch_code (NULL, domain, tmp->data, &patch_info, NULL, TRUE);
+
+	mono_domain_unlock (domain);
+	mono_loader_unlock ();
 }
 
+/*
+ * mono_jit_compile_method_inner:
+ *
+ *   Compile METHOD for TARGET_DOMAIN and publish the code.  If CLASS_INIT is
+ * TRUE, the class of METHOD is initialized as well, which is what a call
+ * through a trampoline needs.  Speculative compilation passes FALSE, so the
+ * cctor of a precise-init class only runs when the method is really called.
+ */
 static gpointer
-mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, int opt, MonoException **jit_ex)
+mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, int opt, gboolean class_init, MonoException **jit_ex)
 {
 	MonoCompile *cfg;
 	gpointer code = NULL;
@@ -4252,6 +4397,7 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 	MonoVTable *vtable;
 	MonoException *ex = NULL;
 	guint32 prof_options;
+	gboolean tier0 = FALSE;
 
 #ifdef MONO_USE_AOT_COMPILER
 	if (opt & MONO_OPT_AOT) {
@@ -4260,9 +4406,11 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 		mono_class_init (method->klass);
 
 		if ((code = mono_aot_get_method (domain, method))) {
-			vtable = mono_class_vtable (domain, method->klass);
-			g_assert (vtable);
-			mono_runtime_class_init (vtable);
+			if (class_init) {
+				vtable = mono_class_vtable (domain, method->klass);
+				g_assert (vtable);
+				mono_runtime_class_init (vtable);
+			}
 
 			return code;
 		}
@@ -4339,6 +4487,11 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 		return NULL;
 	}
 
+	if (use_tier0 (method, opt))
+		opt = (opt & TIER0_OPTIMIZATIONS) | MONO_OPT_TIER0;
+	else
+		opt &= ~MONO_OPT_TIER0;
+
 	cfg = mini_method_compile (method, opt, target_domain, TRUE, FALSE, 0);
 
 	switch (cfg->exception_type) {
@@ -4420,19 +4573,29 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 		return NULL;
 	}
 
-	mono_loader_lock (); /*FIXME lookup_method_inner requires the loader lock*/
-	mono_domain_lock (target_domain);
-
 	/* Check if some other thread already did the job. In this case, we can
        discard the code this thread generated. */
 
+	/*
+	 * Only publishing the code is serialized, and only by the jit code hash
+	 * lock, so threads compiling different methods don't wait for each other.
+	 * The shared generic lookup is done first since it can take the loader
+	 * lock, and the key we are about to insert under is checked again below,
+	 * so a racing thread which published the same code is still noticed.
+	 */
+	info = lookup_generic_method (target_domain, method);
+
 	mono_domain_jit_code_hash_lock (target_domain);
 
-	info = lookup_method_inner (target_domain, method);
+	if (!info)
+		info = mono_internal_hash_table_lookup (&target_domain->jit_code_hash, method);
+	if (!info && cfg->jit_info->method != method)
+		info = mono_internal_hash_table_lookup (&target_domain->jit_code_hash, cfg->jit_info->method);
 	if (info) {
 		/* We can't use a domain specific method in another domain */
 		if ((target_domain == mono_domain_get ()) || info->domain_neutral) {
 			code = info->code_start;
+			tier0 = info->tier0;
 //			printf("Discarding code for method %s\n", method->name);
 		}
 	}
@@ -4441,9 +4604,12 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 		mono_internal_hash_table_insert (&target_domain->jit_code_hash, cfg->jit_info->method, cfg->jit_info);
 		mono_domain_jit_code_hash_unlock (target_domain);
 		code = cfg->native_code;
+		tier0 = cfg->tier0;
 
 		if (cfg->generic_sharing_context && mono_method_is_generic_sharable_impl (method, FALSE))
 			mono_stats.generics_shared_methods++;
+
+		mono_precomp_method_compiled (target_domain, cfg);
 	} else {
 		mono_domain_jit_code_hash_unlock (target_domain);
 	}
@@ -4454,25 +4620,9 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 
 	mono_destroy_compile (cfg);
 
-	if (domain_jit_info (target_domain)->jump_target_hash) {
-		MonoJumpInfo patch_info;
-		MonoJumpList *jlist;
-		GSList *tmp;
-		jlist = g_hash_table_lookup (domain_jit_info (target_domain)->jump_target_hash, method);
-		if (jlist) {
-			patch_info.next = NULL;
-			patch_info.ip.i = 0;
-			patch_info.type = MONO_PATCH_INFO_METHOD_JUMP;
-			patch_info.data.method = method;
-			g_hash_table_remove (domain_jit_info (target_domain)->jump_target_hash, method);
-
-			for (tmp = jlist->list; tmp; tmp = tmp->next)
-				mono_arch_patch_code (NULL, target_domain, tmp->data, &patch_info, NULL, TRUE);
-		}
-	}
-
-	mono_domain_unlock (target_domain);
-	mono_loader_unlock ();
+	/* The jumps to tier-0 code keep going through the trampoline, they are patched with the tier-1 code */
+	if (!tier0)
+		patch_jump_targets (target_domain, method);
 
 	vtable = mono_class_vtable (target_domain, method->klass);
 	if (!vtable) {
@@ -4496,10 +4646,12 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 		}
 	}
 
-	ex = mono_runtime_class_init_full (vtable, FALSE);
-	if (ex) {
-		*jit_ex = ex;
-		return NULL;
+	if (class_init) {
+		ex = mono_runtime_class_init_full (vtable, FALSE);
+		if (ex) {
+			*jit_ex = ex;
+			return NULL;
+		}
 	}
 	return code;
 }
@@ -4552,7 +4704,7 @@ mono_jit_compile_method_with_opt (MonoMethod *method, guint32 opt, MonoException
 		}
 	}
 
-	code = mono_jit_compile_method_inner (method, target_domain, opt, ex);
+	code = mono_jit_compile_method_inner (method, target_domain, opt, TRUE, ex);
 	if (!code)
 		return NULL;
 
@@ -4571,6 +4723,116 @@ mono_jit_compile_method_with_opt (MonoMethod *method, guint32 opt, MonoException
 	return p;
 }
 
+/*
+ * mono_jit_precompile_method:
+ *
+ *   Compile METHOD for DOMAIN ahead of its first call, without initializing
+ * its class.  Methods which don't go through the JIT proper, or which can't
+ * be compiled without a caller supplying the generic context, are skipped.
+ * Failures are ignored, the method will fail again, and raise the exception,
+ * when it is called.  Returns whether code was generated.
+ */
+gboolean
+mono_jit_precompile_method (MonoDomain *domain, MonoMethod *method)
+{
+	MonoDomain *target_domain;
+	MonoException *ex = NULL;
+	guint32 opt = default_opt;
+
+	if (method->wrapper_type != MONO_WRAPPER_NONE)
+		return FALSE;
+	if ((method->iflags & (METHOD_IMPL_ATTRIBUTE_INTERNAL_CALL | METHOD_IMPL_ATTRIBUTE_RUNTIME)) ||
+	    (method->flags & (METHOD_ATTRIBUTE_PINVOKE_IMPL | METHOD_ATTRIBUTE_ABSTRACT)))
+		return FALSE;
+	if (method->is_generic || method->klass->generic_container || mono_method_check_context_used (method))
+		return FALSE;
+	if (mono_aot_only)
+		return FALSE;
+
+	if (opt & MONO_OPT_SHARED)
+		target_domain = mono_get_root_domain ();
+	else
+		target_domain = domain;
+
+	if (lookup_method (target_domain, method))
+		return FALSE;
+
+	if (!mono_jit_compile_method_inner (method, target_domain, opt, FALSE, &ex)) {
+		mono_loader_clear_error ();
+		return FALSE;
+	}
+
+	mono_jit_stats.methods_precompiled++;
+	return TRUE;
+}
+
+/*
+ * mono_jit_tier_up_method:
+ *
+ *   Recompile METHOD, whose tier-0 code is published in DOMAIN, with the
+ * tier-1 optimizations, and publish the new code in its place.  The tier-0
+ * code stays in the jit info table, since frames can still be running it.
+ * Callers reach it through trampolines, which find the new code on their
+ * next call, and only then patch the call site.  Returns whether the new
+ * code was published.  If it wasn't, the tier-0 code becomes final: its call
+ * counter has already run out, so it would never be recompiled again.
+ */
+gboolean
+mono_jit_tier_up_method (MonoDomain *domain, MonoMethod *method)
+{
+	MonoCompile *cfg;
+	MonoJitInfo *info;
+	gboolean published = FALSE, final = FALSE;
+
+	mono_domain_jit_code_hash_lock (domain);
+	info = mono_internal_hash_table_lookup (&domain->jit_code_hash, method);
+	mono_domain_jit_code_hash_unlock (domain);
+	if (!info || !info->tier0)
+		return FALSE;
+
+	/* The class was initialized when the tier-0 code was first called */
+	cfg = mini_method_compile (method, (default_opt | TIER1_OPTIMIZATIONS) & ~MONO_OPT_TIER0, domain, FALSE, FALSE, 0);
+
+	if (cfg->exception_type == MONO_EXCEPTION_NONE && cfg->jit_info->method == method) {
+		mono_domain_jit_code_hash_lock (domain);
+		/* Tier-up requests for a method are only processed by one worker at a time, but check anyway */
+		if (mono_internal_hash_table_lookup (&domain->jit_code_hash, method) == info) {
+			mono_internal_hash_table_remove (&domain->jit_code_hash, method);
+			mono_internal_hash_table_insert (&domain->jit_code_hash, method, cfg->jit_info);
+			published = TRUE;
+		}
+		mono_domain_jit_code_hash_unlock (domain);
+	}
+
+	if (cfg->prof_options & MONO_PROFILE_JIT_COMPILATION)
+		mono_profiler_method_end_jit (method, published ? cfg->jit_info : NULL, published ? MONO_PROFILE_OK : MONO_PROFILE_FAILED);
+
+	if (cfg->exception_type == MONO_EXCEPTION_OBJECT_SUPPLIED)
+		MONO_GC_UNREGISTER_ROOT (cfg->exception_ptr);
+	mono_destroy_compile (cfg);
+	/* A failure leaves the tier-0 code in place, it already ran fine */
+	mono_loader_clear_error ();
+
+	if (!published) {
+		/* Let the trampolines patch the tier-0 code into callers */
+		mono_domain_jit_code_hash_lock (domain);
+		if (mono_internal_hash_table_lookup (&domain->jit_code_hash, method) == info && info->tier0) {
+			info->tier0 = FALSE;
+			final = TRUE;
+		}
+		mono_domain_jit_code_hash_unlock (domain);
+
+		if (final)
+			patch_jump_targets (domain, method);
+		return FALSE;
+	}
+
+	patch_jump_targets (domain, method);
+
+	mono_jit_stats.methods_tiered_up++;
+	return TRUE;
+}
+
 gpointer
 mono_jit_compile_method (MonoMethod *method)
 {
@@ -4620,7 +4882,9 @@ mono_jit_free_method (MonoDomain *domain, MonoMethod *method)
 
 	mono_domain_lock (domain);
 	g_hash_table_remove (domain_jit_info (domain)->dynamic_code_hash, method);
+	mono_domain_jit_code_hash_lock (domain);
 	mono_internal_hash_table_remove (&domain->jit_code_hash, method);
+	mono_domain_jit_code_hash_unlock (domain);
 	g_hash_table_remove (domain_jit_info (domain)->jump_trampoline_hash, method);
 	g_hash_table_remove (domain_jit_info (domain)->runtime_invoke_hash, method);
 
@@ -5280,11 +5544,20 @@ static void seq_point_info_free (gpointer value)
 	g_free (info);
 }
 
+static void
+delete_inline_cache_list (gpointer key, gpointer value, gpointer user_data)
+{
+	/* The caches themselves live in the domain mempool */
+	g_slist_free (value);
+}
+
 static void
 mini_free_jit_domain_info (MonoDomain *domain)
 {
 	MonoJitDomainInfo *info = domain_jit_info (domain);
 
+	mono_precomp_domain_free (domain);
+
 	g_hash_table_foreach (info->jump_target_hash, delete_jump_list, NULL);
 	g_hash_table_destroy (info->jump_target_hash);
 	if (info->jump_target_got_slot_hash) {
@@ -5297,6 +5570,12 @@ mini_free_jit_domain_info (MonoDomain *domain)
 	}
 	if (info->method_code_hash)
 		g_hash_table_destroy (info->method_code_hash);
+	if (info->delegate_invoke_cache_hash)
+		g_hash_table_destroy (info->delegate_invoke_cache_hash);
+	if (info->inline_cache_hash) {
+		g_hash_table_foreach (info->inline_cache_hash, delete_inline_cache_list, NULL);
+		g_hash_table_destroy (info->inline_cache_hash);
+	}
 	g_hash_table_destroy (info->class_init_trampoline_hash);
 	g_hash_table_destroy (info->jump_trampoline_hash);
 	g_hash_table_destroy (info->jit_trampoline_hash);
@@ -5315,6 +5594,24 @@ mini_free_jit_domain_info (MonoDomain *domain)
 	domain->runtime_info = NULL;
 }
 
+/*
+ * register_jit_stats:
+ *
+ *   Register the JIT statistics which are reported through mono-counters.
+ */
+static void
+register_jit_stats (void)
+{
+	mono_counters_register ("ABC checks removed", MONO_COUNTER_JIT | MONO_COUNTER_WORD, &mono_jit_stats.abc_checks_removed);
+	mono_counters_register ("ABC loops versioned", MONO_COUNTER_JIT | MONO_COUNTER_WORD, &mono_jit_stats.abc_loops_versioned);
+	mono_counters_register ("Regalloc local spill stores", MONO_COUNTER_JIT | MONO_COUNTER_WORD, &mono_jit_stats.regalloc_local_spill_stores);
+	mono_counters_register ("Regalloc local spill loads", MONO_COUNTER_JIT | MONO_COUNTER_WORD, &mono_jit_stats.regalloc_local_spill_loads);
+	mono_counters_register ("Regalloc global spill stores", MONO_COUNTER_JIT | MONO_COUNTER_WORD, &mono_jit_stats.regalloc_global_spill_stores);
+	mono_counters_register ("Regalloc global spill loads", MONO_COUNTER_JIT | MONO_COUNTER_WORD, &mono_jit_stats.regalloc_global_spill_loads);
+	mono_counters_register ("RGCTX fetches inlined", MONO_COUNTER_GENERICS | MONO_COUNTER_WORD, &mono_jit_stats.rgctx_fetches_inlined);
+	mono_counters_register ("Methods inlined into shared code", MONO_COUNTER_GENERICS | MONO_COUNTER_WORD, &mono_jit_stats.inlined_methods_shared);
+}
+
 MonoDomain *
 mini_init (const char *filename, const char *runtime_version)
 {
@@ -5349,6 +5646,10 @@ mini_init (const char *filename, const char *runtime_version)
 	mono_runtime_set_has_tls_get (FALSE);
 #endif
 
+	/* Has to be set before the code managers of the domains are created */
+	if (getenv ("MONO_HUGE_CODE_PAGES"))
+		mono_code_manager_set_huge_pages (TRUE);
+
 	if (!global_codeman)
 		global_codeman = mono_code_manager_new ();
 	jit_icall_name_hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
@@ -5368,6 +5669,8 @@ mini_init (const char *filename, const char *runtime_version)
 
 	mini_gc_init ();
 
+	register_jit_stats ();
+
 	if (getenv ("MONO_DEBUG") != NULL)
 		mini_parse_debug_options ();
 
@@ -5670,6 +5973,8 @@ mini_init (const char *filename, const char *runtime_version)
 	register_icall (mono_helper_newobj_mscorlib, "helper_newobj_mscorlib", "object int", FALSE);
 	register_icall (mono_value_copy, "mono_value_copy", "void ptr ptr ptr", FALSE);
 	register_icall (mono_object_castclass, "mono_object_castclass", "object object ptr", FALSE);
+	register_icall (mono_precomp_tier_up, "mono_precomp_tier_up", "void ptr", FALSE);
+	register_icall (mono_inline_cache_miss, "mono_inline_cache_miss", "void ptr object", FALSE);
 	register_icall (mono_break, "mono_break", NULL, TRUE);
 	register_icall (mono_create_corlib_exception_0, "mono_create_corlib_exception_0", "object int", TRUE);
 	register_icall (mono_create_corlib_exception_1, "mono_create_corlib_exception_1", "object int object", TRUE);
@@ -5702,6 +6007,13 @@ mini_init (const char *filename, const char *runtime_version)
 	mono_install_runtime_cleanup ((MonoDomainFunc)mini_cleanup);
 	mono_runtime_init (domain, mono_thread_start_cb, mono_thread_attach_cb);
 	mono_thread_attach (domain);
+
+	if (!mono_compile_aot) {
+		/* -O=tier0 turns tiered compilation on with the default settings */
+		if (default_opt & MONO_OPT_TIER0)
+			mono_tiered_compilation = TRUE;
+		mono_precomp_init ();
+	}
 #endif
 
 	mono_profiler_runtime_initialized ();
@@ -5713,6 +6025,36 @@ mini_init (const char *filename, const char *runtime_version)
 
 MonoJitStats mono_jit_stats = {0};
 
+static void
+print_inline_cache_site (gpointer key, gpointer value, gpointer user_data)
+{
+	GSList *l;
+
+	for (l = value; l; l = l->next) {
+		MonoInlineCache *cache = l->data;
+		guint32 calls = cache->guard_hits + cache->guard_misses;
+		char *name;
+
+		if (!calls)
+			continue;
+		name = mono_method_full_name (cache->method, TRUE);
+		g_print ("    %s IL_%04x: %u/%u (%.1f%%)\n", name, cache->il_offset, cache->guard_hits, calls,
+				 cache->guard_hits * 100.0 / calls);
+		g_free (name);
+	}
+}
+
+static void
+print_inline_cache_sites (MonoDomain *domain, gpointer user_data)
+{
+	MonoJitDomainInfo *info = domain_jit_info (domain);
+
+	mono_domain_lock (domain);
+	if (info && info->inline_cache_hash)
+		g_hash_table_foreach (info->inline_cache_hash, print_inline_cache_site, NULL);
+	mono_domain_unlock (domain);
+}
+
 static void 
 print_jit_stats (void)
 {
@@ -5720,7 +6062,11 @@ print_jit_stats (void)
 		g_print ("Mono Jit statistics\n");
 		g_print ("Compiled methods:       %ld\n", mono_jit_stats.methods_compiled);
 		g_print ("Methods from AOT:       %ld\n", mono_jit_stats.methods_aot);
+		g_print ("AOT metadata size:      %ld\n", mono_jit_stats.aot_metadata_size);
+		g_print ("AOT metadata/method:    %ld\n", mono_jit_stats.methods_aot ? mono_jit_stats.aot_metadata_size / mono_jit_stats.methods_aot : 0);
 		g_print ("Methods cache lookup:   %ld\n", mono_jit_stats.methods_lookups);
+		g_print ("Precompiled methods:    %ld\n", mono_jit_stats.methods_precompiled);
+		g_print ("Tier-1 recompiles:      %ld\n", mono_jit_stats.methods_tiered_up);
 		g_print ("Method trampolines:     %ld\n", mono_jit_stats.method_trampolines);
 		g_print ("Basic blocks:           %ld\n", mono_jit_stats.basic_blocks);
 		g_print ("Max basic blocks:       %ld\n", mono_jit_stats.max_basic_blocks);
@@ -5735,6 +6081,19 @@ print_jit_stats (void)
 		g_print ("Allocated code size:    %ld\n", mono_jit_stats.allocated_code_size);
 		g_print ("Inlineable methods:     %ld\n", mono_jit_stats.inlineable_methods);
 		g_print ("Inlined methods:        %ld\n", mono_jit_stats.inlined_methods);
+		g_print ("Inlined by cost model:  %ld\n", mono_jit_stats.inlined_methods_extended);
+		g_print ("Inline cache sites:     %ld\n", mono_jit_stats.inline_cache_sites);
+		g_print ("Guarded call sites:     %ld\n", mono_jit_stats.guarded_call_sites);
+		g_print ("Guarded calls inlined:  %ld\n", mono_jit_stats.guarded_calls_inlined);
+		if (mono_jit_stats.guarded_call_sites) {
+			g_print ("Guard hits per site:\n");
+			mono_domain_foreach (print_inline_cache_sites, NULL);
+		}
+		g_print ("Vectorized loops:       %ld\n", mono_jit_stats.loops_vectorized);
+		g_print ("Stack allocated objs:   %ld\n", mono_jit_stats.objects_stack_allocated);
+		g_print ("Scalar replaced objs:   %ld\n", mono_jit_stats.objects_scalar_replaced);
+		g_print ("Cold bblocks moved:     %ld\n", mono_jit_stats.cold_bblocks);
+		g_print ("Delegate invoke caches: %ld\n", mono_jit_stats.delegate_invoke_caches);
 		g_print ("Regvars:                %ld\n", mono_jit_stats.regvars);
 		g_print ("Locals stack size:      %ld\n", mono_jit_stats.locals_stack_size);
 
@@ -5820,6 +6179,8 @@ mini_cleanup (MonoDomain *domain)
 	/* This accesses metadata so needs to be called before runtime shutdown */
 	print_jit_stats ();
 
+	mono_precomp_cleanup ();
+
 	mono_profiler_shutdown ();
 
 #ifndef MONO_CROSS_COMPILE
@@ -95,7 +95,7 @@ typedef gint64 mgreg_t;
 #endif
 
 /* Version number of the AOT file format */
-#define MONO_AOT_FILE_VERSION "66"
+#define MONO_AOT_FILE_VERSION "67"
 
 //TODO: This is x86/amd64 specific.
 #define mono_simd_shuffle_mask(a,b,c,d) ((a) | ((b) << 2) | ((c) << 4) | ((d) << 6))
@@ -153,6 +153,8 @@ typedef struct
 	/* maps MonoMethod -> MonoJitDynamicMethodInfo */
 	GHashTable *dynamic_code_hash;
 	GHashTable *method_code_hash;
+	/* Maps MonoMethod to a list of MonoDelegateInvokeCache structures */
+	GHashTable *delegate_invoke_cache_hash;
 	/* Maps methods to a RuntimeInvokeInfo structure */
 	GHashTable *runtime_invoke_hash;
 	/* Maps MonoMethod to a GPtrArray containing sequence point locations */
@@ -161,6 +163,8 @@ typedef struct
 	gpointer agent_info;
 	/* Maps MonoMethod to an arch-specific structure */
 	GHashTable *arch_seq_points;
+	/* Maps MonoMethod to a GSList of the MonoInlineCache's of its tier-0 code */
+	GHashTable *inline_cache_hash;
 } MonoJitDomainInfo;
 
 typedef struct {
@@ -175,6 +179,49 @@ typedef struct {
 	GSList *list;
 } MonoJumpList;
 
+#define MONO_INLINE_CACHE_SIZE 2
+
+/*
+ * The receiver types seen by a virtual call site of tier-0 code, used to
+ * devirtualize the call under a type guard in the tier-1 code.  The counters
+ * are updated without locking.
+ */
+typedef struct {
+	MonoVTable *vtables [MONO_INLINE_CACHE_SIZE];
+	guint32 hits [MONO_INLINE_CACHE_SIZE];
+	/* Calls whose receiver type is not in VTABLES anymore */
+	guint32 misses;
+	/* Outcome of the type guards of the tier-1 code, only counted with --stats */
+	guint32 guard_hits;
+	guint32 guard_misses;
+	MonoMethod *method;
+	guint32 il_offset;
+} MonoInlineCache;
+
+/*
+ * The invoke_impl and method_ptr which mono_delegate_trampoline () computed for
+ * a delegate of a given type pointing to a given method.
+ */
+typedef struct {
+	gpointer invoke_impl;
+	gpointer method_ptr;
+} MonoDelegateInvokeInfo;
+
+/*
+ * Delegate constructors emitted by the JIT load the invoke_impl and method_ptr
+ * of the new delegate through INFO, so once the first delegate of a given
+ * (type, method, target) combination was invoked, the others bypass the
+ * delegate trampoline.  INFO is replaced atomically.
+ */
+typedef struct _MonoDelegateInvokeCache MonoDelegateInvokeCache;
+struct _MonoDelegateInvokeCache {
+	MonoClass *klass;
+	MonoMethod *method;
+	gboolean has_target;
+	MonoDelegateInvokeInfo *info;
+	MonoDelegateInvokeCache *next;
+};
+
 /* Arch-specific */
 typedef struct {
 	int dummy;
@@ -400,6 +447,7 @@ extern gboolean mono_dont_free_global_codeman;
 extern gboolean mono_do_x86_stack_align;
 extern const char *mono_build_date;
 extern gboolean mono_do_signal_chaining;
+extern gboolean mono_tiered_compilation;
 
 #define INS_INFO(opcode) (&ins_info [((opcode) - OP_START - 1) * 4])
 
@@ -812,6 +860,8 @@ typedef struct {
 	MonoClass       *class_cast_from, *class_cast_to;
 	/* Stores state needed by the backport of r157327 */
 	MonoContext      ex_ctx;
+	/* Decoded unwind info of recently unwound frames */
+	MonoUnwindCache *unwind_cache;
 } MonoJitTlsData;
 
 typedef enum {
@@ -1049,6 +1099,9 @@ typedef struct {
 	guint            keep_cil_nops : 1;
 	guint            gen_seq_points : 1;
 	guint            explicit_null_checks : 1;
+	guint            tier0 : 1;
+	/* Set when code inlined into shared generic code needs an rgctx it can't get to */
+	guint            gshared_inline_failed : 1;
 	gpointer         debug_info;
 	guint32          lmf_offset;
     guint16          *intvars;
@@ -1056,6 +1109,8 @@ typedef struct {
 	GHashTable       *token_info_hash;
 	MonoCompileArch  arch;
 	guint32          inline_depth;
+	/* IR cost added by inlining methods above the classic size limit */
+	int              inline_budget_used;
 	guint32          exception_type;	/* MONO_EXCEPTION_* */
 	guint32          exception_data;
 	char*            exception_message;
@@ -1106,6 +1161,12 @@ typedef struct {
 	/* Used to implement dyn_call */
 	MonoInst *dyn_call_var;
 
+	/* Allocation calls considered by mono_stack_alloc_objects () */
+	GSList *object_allocs;
+
+	/* Clauses whose handler was moved by mono_move_cold_bblocks () */
+	guint8 *cold_clauses;
+
 	/*
 	 * List of sequence points represented as IL offset+native offset pairs.
 	 * Allocated using glib.
@@ -1137,7 +1198,18 @@ typedef enum {
 typedef struct {
 	gulong methods_compiled;
 	gulong methods_aot;
+	gulong aot_metadata_size;
 	gulong methods_lookups;
+	gulong methods_precompiled;
+	gulong methods_tiered_up;
+	gulong inline_cache_sites;
+	gulong guarded_call_sites;
+	gulong guarded_calls_inlined;
+	gulong loops_vectorized;
+	gulong objects_stack_allocated;
+	gulong objects_scalar_replaced;
+	gulong cold_bblocks;
+	gulong delegate_invoke_caches;
 	gulong method_trampolines;
 	gulong allocate_var;
 	gulong cil_code_size;
@@ -1148,10 +1220,19 @@ typedef struct {
 	gulong allocated_code_size;
 	gulong inlineable_methods;
 	gulong inlined_methods;
+	gulong inlined_methods_extended;
 	gulong basic_blocks;
 	gulong max_basic_blocks;
 	gulong locals_stack_size;
 	gulong regvars;
+	gulong abc_checks_removed;
+	gulong abc_loops_versioned;
+	gulong regalloc_local_spill_stores;
+	gulong regalloc_local_spill_loads;
+	gulong regalloc_global_spill_stores;
+	gulong regalloc_global_spill_loads;
+	gulong rgctx_fetches_inlined;
+	gulong inlined_methods_shared;
 	gulong cas_declsec_check;
 	gulong cas_linkdemand_icall;
 	gulong cas_linkdemand_pinvoke;
@@ -1441,6 +1522,8 @@ void      mono_remove_bblock                (MonoCompile *cfg, MonoBasicBlock *b
 void      mono_nullify_basic_block          (MonoBasicBlock *bb) MONO_INTERNAL;
 void      mono_merge_basic_blocks           (MonoCompile *cfg, MonoBasicBlock *bb, MonoBasicBlock *bbn) MONO_INTERNAL;
 void      mono_optimize_branches            (MonoCompile *cfg) MONO_INTERNAL;
+void      mono_move_cold_bblocks            (MonoCompile *cfg) MONO_INTERNAL;
+MonoBasicBlock* mono_cold_clause_try_end    (MonoCompile *cfg, int clause_index) MONO_INTERNAL;
 
 void      mono_blockset_print               (MonoCompile *cfg, MonoBitSet *set, const char *name, guint idom) MONO_INTERNAL;
 void      mono_print_ins_index              (int i, MonoInst *ins) MONO_INTERNAL;
@@ -1465,6 +1548,7 @@ MonoJumpInfo* mono_patch_info_dup_mp        (MonoMemPool *mp, MonoJumpInfo *patc
 guint     mono_patch_info_hash (gconstpointer data) MONO_INTERNAL;
 gint      mono_patch_info_equal (gconstpointer ka, gconstpointer kb) MONO_INTERNAL;
 MonoJumpInfo *mono_patch_info_list_prepend  (MonoJumpInfo *list, int ip, MonoJumpInfoType type, gconstpointer target) MONO_INTERNAL;
+guint32   mono_patch_info_rgctx_entry_get_slot (MonoJumpInfoRgctxEntry *entry) MONO_INTERNAL;
 gpointer  mono_resolve_patch_target         (MonoMethod *method, MonoDomain *domain, guint8 *code, MonoJumpInfo *patch_info, gboolean run_cctors) MONO_INTERNAL;
 gpointer  mono_jit_find_compiled_method_with_jit_info (MonoDomain *domain, MonoMethod *method, MonoJitInfo **ji) MONO_INTERNAL;
 gpointer  mono_jit_find_compiled_method     (MonoDomain *domain, MonoMethod *method) MONO_INTERNAL;
@@ -1585,6 +1669,7 @@ gpointer          mono_create_jit_trampoline (MonoMethod *method) MONO_INTERNAL;
 gpointer          mono_create_jit_trampoline_from_token (MonoImage *image, guint32 token) MONO_INTERNAL;
 gpointer          mono_create_jit_trampoline_in_domain (MonoDomain *domain, MonoMethod *method) MONO_INTERNAL;
 gpointer          mono_create_delegate_trampoline (MonoClass *klass) MONO_INTERNAL;
+MonoDelegateInvokeCache* mono_get_delegate_invoke_cache (MonoDomain *domain, MonoClass *klass, MonoMethod *method, gboolean has_target, gboolean create) MONO_INTERNAL;
 gpointer          mono_create_rgctx_lazy_fetch_trampoline (guint32 offset) MONO_INTERNAL;
 gpointer          mono_create_monitor_enter_trampoline (void) MONO_INTERNAL;
 gpointer          mono_create_monitor_exit_trampoline (void) MONO_INTERNAL;
@@ -1643,6 +1728,7 @@ void              mono_decompose_vtype_opts (MonoCompile *cfg) MONO_INTERNAL;
 void              mono_decompose_array_access_opts (MonoCompile *cfg) MONO_INTERNAL;
 void              mono_decompose_soft_float (MonoCompile *cfg) MONO_INTERNAL;
 void              mono_handle_global_vregs (MonoCompile *cfg) MONO_INTERNAL;
+gboolean          mono_stack_alloc_objects (MonoCompile *cfg) MONO_INTERNAL;
 void              mono_spill_global_vars (MonoCompile *cfg, gboolean *need_local_opts) MONO_INTERNAL;
 void              mono_if_conversion (MonoCompile *cfg) MONO_INTERNAL;
 
@@ -1887,6 +1973,8 @@ extern void
 mono_perform_abc_removal (MonoCompile *cfg) MONO_INTERNAL;
 extern void
 mono_perform_abc_removal (MonoCompile *cfg) MONO_INTERNAL;
+extern gboolean
+mono_perform_loop_abc_removal (MonoCompile *cfg) MONO_INTERNAL;
 extern void
 mono_perform_ssapre (MonoCompile *cfg) MONO_INTERNAL;
 extern void
@@ -1927,6 +2015,16 @@ int mini_type_stack_size_full (MonoGenericSharingContext *gsctx, MonoType *t, gu
 void type_to_eval_stack_type (MonoCompile *cfg, MonoType *type, MonoInst *inst) MONO_INTERNAL;
 guint mono_type_to_regmove (MonoCompile *cfg, MonoType *type) MONO_INTERNAL;
 
+/* Background precompilation (mini-precomp.c) */
+void      mono_precomp_init                 (void) MONO_INTERNAL;
+void      mono_precomp_method_compiled      (MonoDomain *domain, MonoCompile *cfg) MONO_INTERNAL;
+void      mono_precomp_domain_free          (MonoDomain *domain) MONO_INTERNAL;
+void      mono_precomp_cleanup              (void) MONO_INTERNAL;
+gboolean  mono_jit_precompile_method        (MonoDomain *domain, MonoMethod *method) MONO_INTERNAL;
+int       mono_precomp_tier_up_calls        (void) MONO_INTERNAL;
+void      mono_precomp_tier_up              (MonoMethod *method) MONO_INTERNAL;
+gboolean  mono_jit_tier_up_method           (MonoDomain *domain, MonoMethod *method) MONO_INTERNAL;
+
 /* wapihandles.c */
 int mini_wapi_hps (int argc, char **argv) MONO_INTERNAL;
 
@@ -1973,6 +2071,7 @@ void        mono_simd_simplify_indirection (MonoCompile *cfg) MONO_INTERNAL;
 MonoInst*   mono_emit_simd_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig, MonoInst **args) MONO_INTERNAL;
 guint32     mono_arch_cpu_enumerate_simd_versions (void) MONO_INTERNAL;
 void        mono_simd_intrinsics_init (void) MONO_INTERNAL;
+gboolean    mono_simd_vectorize_loops (MonoCompile *cfg) MONO_INTERNAL;
 
 /*
  * Per-OS implementation functions.
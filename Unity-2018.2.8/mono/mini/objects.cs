@@ -81,6 +81,33 @@ class Sample {
 	}
 }
 
+class DelegateTarget {
+	public int v;
+
+	public virtual int Get (int x) {
+		return v + x;
+	}
+}
+
+class DelegateTargetDerived : DelegateTarget {
+	public override int Get (int x) {
+		return v * x;
+	}
+}
+
+class EscapePoint {
+	public int x, y;
+	public EscapePoint next;
+
+	public EscapePoint () {
+	}
+
+	public EscapePoint (int x, int y) {
+		this.x = x;
+		this.y = y;
+	}
+}
+
 [StructLayout ( LayoutKind.Explicit )]
 struct StructWithBigOffsets {
 		[ FieldOffset(10000) ] public byte b;
@@ -867,6 +894,124 @@ class Tests {
 		return 2;
 	}
 
+	delegate int IntOp (int x);
+
+	int factor;
+
+	static int add1 (int x) {
+		return x + 1;
+	}
+
+	static int add2 (int x) {
+		return x + 2;
+	}
+
+	int mul (int x) {
+		return x * factor;
+	}
+
+	/*
+	 * Each of these creates all its delegates at one site, so the ones created
+	 * after the first invoke get invoke_impl and method_ptr from the cache.
+	 */
+	static IntOp static_delegate (bool first) {
+		return first ? new IntOp (add1) : new IntOp (add2);
+	}
+
+	static IntOp instance_delegate (Tests t) {
+		return new IntOp (t.mul);
+	}
+
+	static IntOp virtual_delegate (DelegateTarget t) {
+		return new IntOp (t.Get);
+	}
+
+	public static int test_0_delegate_invoke_cache () {
+		Tests a = new Tests ();
+		Tests b = new Tests ();
+		DelegateTarget base_target = new DelegateTarget ();
+		DelegateTarget derived_target = new DelegateTargetDerived ();
+
+		a.factor = 2;
+		b.factor = 10;
+		base_target.v = 1;
+		derived_target.v = 3;
+
+		for (int i = 0; i < 4; ++i) {
+			bool first = (i & 1) == 0;
+
+			if (static_delegate (first) (i) != (first ? i + 1 : i + 2))
+				return 1;
+			if (static_delegate (!first) (i) != (first ? i + 2 : i + 1))
+				return 1;
+			if (instance_delegate (first ? a : b) (5) != (first ? 10 : 50))
+				return 2;
+			if (instance_delegate (first ? b : a) (5) != (first ? 50 : 10))
+				return 3;
+			if (virtual_delegate (first ? base_target : derived_target) (5) != (first ? 6 : 15))
+				return 4;
+			if (virtual_delegate (first ? derived_target : base_target) (5) != (first ? 15 : 6))
+				return 5;
+		}
+		return 0;
+	}
+
+	delegate int TargetOp (DelegateTarget t, int x);
+
+	static int chain_trace;
+
+	static int target_add (DelegateTarget t, int x) {
+		chain_trace = chain_trace * 10 + 1;
+		return t.v + x + 100;
+	}
+
+	int target_scale (DelegateTarget t, int x) {
+		chain_trace = chain_trace * 10 + 2;
+		return t.v * factor + x;
+	}
+
+	static int invoke_chain (TargetOp d, DelegateTarget t, int trace) {
+		chain_trace = 0;
+		int res = d (t, 2);
+		return chain_trace == trace ? res : -1;
+	}
+
+	/*
+	 * Multicast delegates whose chain has an open instance delegate can't be
+	 * invoked in a loop by the delegate invoke wrapper, so it recurses through
+	 * Invoke. The value returned by the last delegate must be the result.
+	 */
+	public static int test_0_delegate_chain_fallback () {
+		Tests t = new Tests ();
+		DelegateTarget base_target = new DelegateTarget ();
+		DelegateTarget derived_target = new DelegateTargetDerived ();
+		TargetOp open = (TargetOp) Delegate.CreateDelegate (typeof (TargetOp), typeof (DelegateTarget).GetMethod ("Get"));
+		TargetOp add = new TargetOp (target_add);
+		TargetOp scale = new TargetOp (t.target_scale);
+
+		t.factor = 10;
+		base_target.v = 1;
+		derived_target.v = 3;
+
+		/* Invoke each chain twice, the second time goes through the cached wrapper */
+		for (int i = 0; i < 2; ++i) {
+			if (invoke_chain (open + add + scale, derived_target, 12) != 32)
+				return 1;
+			if (invoke_chain (add + open + scale, derived_target, 12) != 32)
+				return 2;
+			if (invoke_chain (add + scale + open, derived_target, 12) != 6)
+				return 3;
+			if (invoke_chain (add + scale + open, base_target, 12) != 3)
+				return 4;
+			/* Mixed static and instance targets */
+			if (invoke_chain (scale + add, derived_target, 21) != 105)
+				return 5;
+			if (invoke_chain (add + scale + add + scale, base_target, 1212) != 12)
+				return 6;
+		}
+		return 0;
+	}
+
 	public static int test_1_store_decimal () {
 		decimal[,] a = {{1}};
 
@@ -1433,5 +1578,128 @@ ncells ) {
 			return 1;
 		return 0;
 	}
+
+	/* Escape analysis */
+
+	public static int test_7_escape_scalar_replaced () {
+		EscapePoint p = new EscapePoint (3, 4);
+
+		return p.x + p.y;
+	}
+
+	public static int test_45_escape_fresh_object_per_iteration () {
+		int res = 0;
+
+		/* A stack allocated object has to be cleared each time it is allocated */
+		for (int i = 0; i < 10; ++i) {
+			EscapePoint p = new EscapePoint ();
+			p.x += i;
+			if (p.y != 0)
+				return -1;
+			p.y = 1;
+			res += p.x;
+		}
+		return res;
+	}
+
+	public static int test_10_escape_previous_iteration () {
+		EscapePoint prev = null, cur = new EscapePoint (0, 0);
+		int res = 0;
+
+		/* prev outlives the next execution of the allocation */
+		for (int i = 1; i <= 10; ++i) {
+			prev = cur;
+			cur = new EscapePoint (i, 0);
+			if (prev == cur)
+				return -1;
+			res += cur.x - prev.x;
+		}
+		return res;
+	}
+
+	static EscapePoint escape_static;
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void escape_clobber_stack (int depth) {
+		EscapePoint p = new EscapePoint (-1, -1);
+
+		if (depth > 0)
+			escape_clobber_stack (depth - 1);
+		p.x = p.y;
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void escape_to_field (int x) {
+		EscapePoint p = new EscapePoint (x, x);
+
+		escape_static = p;
+	}
+
+	public static int test_0_escape_through_field () {
+		escape_to_field (5);
+		escape_clobber_stack (10);
+		if (escape_static.x != 5 || escape_static.y != 5)
+			return 1;
+
+		EscapePoint outer = new EscapePoint (1, 1);
+		EscapePoint inner = new EscapePoint (2, 2);
+		/* inner escapes through outer, which escapes through the static field */
+		outer.next = inner;
+		escape_static = outer;
+		escape_clobber_stack (10);
+		if (escape_static.next.x != 2)
+			return 2;
+		return 0;
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static EscapePoint escape_return (int x) {
+		EscapePoint p = new EscapePoint (x, 0);
+
+		p.y = p.x * 2;
+		return p;
+	}
+
+	public static int test_0_escape_through_return () {
+		EscapePoint p = escape_return (3);
+
+		escape_clobber_stack (10);
+		if (p.x != 3 || p.y != 6)
+			return 1;
+		return 0;
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void escape_out (out EscapePoint res, int x) {
+		EscapePoint p = new EscapePoint (x, x + 1);
+
+		res = p;
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void escape_ref (ref EscapePoint p) {
+		p.x ++;
+	}
+
+	public static int test_0_escape_through_byref () {
+		EscapePoint p;
+
+		escape_out (out p, 4);
+		escape_clobber_stack (10);
+		if (p.x != 4 || p.y != 5)
+			return 1;
+
+		EscapePoint q = new EscapePoint (1, 2);
+		escape_ref (ref q);
+		if (q.x != 2)
+			return 2;
+
+		EscapePoint[] arr = new EscapePoint [1];
+		arr [0] = new EscapePoint (7, 8);
+		escape_clobber_stack (10);
+		if (arr [0].x != 7)
+			return 3;
+		return 0;
+	}
 }
 
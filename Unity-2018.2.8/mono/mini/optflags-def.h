@@ -24,3 +24,5 @@ OPTFLAG(TREEPROP ,22, "treeprop",   "Tree propagation")
 OPTFLAG(SSE2     ,23, "sse2",       "SSE2 instructions on x86")
 OPTFLAG(GSHARED  ,24, "gshared",    "Share generics")
 OPTFLAG(SIMD	 ,25, "simd",	    "Simd intrinsics")
+OPTFLAG(TIER0    ,26, "tier0",      "Quick first-tier code, recompiled when hot")
+OPTFLAG(ESCAPE   ,27, "escape",     "Stack allocate objects which don't escape")
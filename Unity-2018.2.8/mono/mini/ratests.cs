@@ -380,4 +380,95 @@ public class Tests {
 
 		return 0;
 	}
+
+	public static int test_1496_pressure_loop () {
+		int a0 = 1, a1 = 2, a2 = 3, a3 = 4, a4 = 5, a5 = 6, a6 = 7, a7 = 8;
+		int a8 = 9, a9 = 10, a10 = 11, a11 = 12, a12 = 13, a13 = 14, a14 = 15, a15 = 16;
+
+		/* More values live across the loop than there are registers */
+		for (int i = 0; i < 10; ++i) {
+			a0 += 1; a1 += 2; a2 += 3; a3 += 4; a4 += 5; a5 += 6; a6 += 7; a7 += 8;
+			a8 += 9; a9 += 10; a10 += 11; a11 += 12; a12 += 13; a13 += 14; a14 += 15; a15 += 16;
+		}
+		return a0 + a1 + a2 + a3 + a4 + a5 + a6 + a7 + a8 + a9 + a10 + a11 + a12 + a13 + a14 + a15;
+	}
+
+	[System.Runtime.CompilerServices.MethodImplAttribute (System.Runtime.CompilerServices.MethodImplOptions.NoInlining)]
+	static int clobber_regs (int x) {
+		int a = x + 1, b = x + 2, c = x + 3, d = x + 4, e = x + 5, f = x + 6, g = x + 7, h = x + 8;
+		double da = x + 0.5, db = x + 1.5, dc = x + 2.5, dd = x + 3.5;
+
+		for (int i = 0; i < 3; ++i) {
+			a ^= b; b ^= c; c ^= d; d ^= e; e ^= f; f ^= g; g ^= h; h ^= a;
+			da *= db; db *= dc; dc *= dd; dd *= da;
+		}
+		return a + b + c + d + e + f + g + h + (int)(da + db + dc + dd) * 0;
+	}
+
+	public static int test_0_live_across_calls () {
+		for (int i = 0; i < 5; ++i) {
+			int a = i, b = i * 2, c = i * 3, d = i * 4, e = i * 5, f = i * 6;
+			long l = ((long)i << 40) + i;
+			double x = i + 0.25, y = i * 2.5;
+
+			clobber_regs (i);
+			if (a != i || b != i * 2 || c != i * 3 || d != i * 4 || e != i * 5 || f != i * 6)
+				return 1;
+			clobber_regs (a + b);
+			if (l != ((long)i << 40) + i)
+				return 2;
+			clobber_regs (c);
+			if (x != i + 0.25 || y != i * 2.5)
+				return 3;
+		}
+		return 0;
+	}
+
+	public static int test_160_interval_hole () {
+		int x = 10;
+		int res = 0;
+
+		/* x is not used by the loop, its interval has a hole there while the loop needs the registers */
+		for (int i = 0; i < 4; ++i) {
+			int a = i, b = i + 1, c = i + 2, d = i + 3, e = i + 4, f = i + 5, g = i + 6, h = i + 7;
+			int j = i + 8, k = i + 9, m = i + 10, n = i + 11, o = i + 12, p = i + 13, q = i + 14;
+
+			res += (a ^ b) + (c ^ d) + (e ^ f) + (g ^ h) + (j ^ k) + (m ^ n) + (o ^ p) + q - 30 - i;
+		}
+		return res + x * 10;
+	}
+
+	public static int test_50_fp_pressure_across_call () {
+		double d0 = 0.5, d1 = 1.5, d2 = 2.5, d3 = 3.5, d4 = 4.5, d5 = 5.5, d6 = 6.5, d7 = 7.5, d8 = 8.5, d9 = 9.5;
+
+		clobber_regs (3);
+		return (int)(d0 + d1 + d2 + d3 + d4 + d5 + d6 + d7 + d8 + d9);
+	}
+
+	public static int test_0_long_pressure () {
+		long a = 1, b = 2, c = 3, d = 4, e = 5, f = 6, g = 7, h = 8;
+
+		for (int i = 0; i < 8; ++i) {
+			a = a * 3 + h;
+			b = b * 3 + a;
+			c = c * 3 + b;
+			d = d * 3 + c;
+			e = e * 3 + d;
+			f = f * 3 + e;
+			g = g * 3 + f;
+			h = h * 3 + g;
+			clobber_regs (i);
+		}
+		long r1 = a ^ b ^ c ^ d ^ e ^ f ^ g ^ h;
+
+		/* The same computation without values live across the calls */
+		long[] v = new long [] { 1, 2, 3, 4, 5, 6, 7, 8 };
+		for (int i = 0; i < 8; ++i) {
+			v [0] = v [0] * 3 + v [7];
+			for (int k = 1; k < 8; ++k)
+				v [k] = v [k] * 3 + v [k - 1];
+		}
+		long r2 = v [0] ^ v [1] ^ v [2] ^ v [3] ^ v [4] ^ v [5] ^ v [6] ^ v [7];
+		return r1 == r2 ? 0 : 1;
+	}
 }
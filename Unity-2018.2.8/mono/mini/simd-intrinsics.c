@@ -572,6 +572,61 @@ static const SimdIntrinsc vector16sb_intrinsics[] = {
 	{ SN_set_V9, 9, SIMD_EMIT_SETTER },
 };
 
+/*
+ * Intrinsics of the value types registered with mono_class_register_simd_type ().
+ * These only cover the methods which operate lane by lane on two vectors, and
+ * are only used when the call signature matches, see simd_signature_is_valid ().
+ */
+static const SimdIntrinsc float4_intrinsics[] = {
+	{ SN_ctor, OP_EXPAND_R4, SIMD_EMIT_CTOR },
+	{ SN_op_Addition, OP_ADDPS, SIMD_EMIT_BINARY },
+	{ SN_op_Division, OP_DIVPS, SIMD_EMIT_BINARY },
+	{ SN_op_Multiply, OP_MULPS, SIMD_EMIT_BINARY },
+	{ SN_op_Subtraction, OP_SUBPS, SIMD_EMIT_BINARY },
+};
+
+static const SimdIntrinsc numerics_vector4_intrinsics[] = {
+	{ SN_ctor, OP_EXPAND_R4, SIMD_EMIT_CTOR },
+	{ SN_Max, OP_MAXPS, SIMD_EMIT_BINARY },
+	{ SN_Min, OP_MINPS, SIMD_EMIT_BINARY },
+	{ SN_SquareRoot, OP_SQRTPS, SIMD_EMIT_UNARY },
+	{ SN_op_Addition, OP_ADDPS, SIMD_EMIT_BINARY },
+	{ SN_op_Division, OP_DIVPS, SIMD_EMIT_BINARY },
+	{ SN_op_Multiply, OP_MULPS, SIMD_EMIT_BINARY },
+	{ SN_op_Subtraction, OP_SUBPS, SIMD_EMIT_BINARY },
+};
+
+/* op_Equality is approximate and op_Multiply is Vector4*float */
+static const SimdIntrinsc unity_vector4_intrinsics[] = {
+	{ SN_ctor, OP_EXPAND_R4, SIMD_EMIT_CTOR },
+	{ SN_Max, OP_MAXPS, SIMD_EMIT_BINARY },
+	{ SN_Min, OP_MINPS, SIMD_EMIT_BINARY },
+	{ SN_Scale, OP_MULPS, SIMD_EMIT_BINARY },
+	{ SN_op_Addition, OP_ADDPS, SIMD_EMIT_BINARY },
+	{ SN_op_Subtraction, OP_SUBPS, SIMD_EMIT_BINARY },
+};
+
+/* Quaternion math isn't lane by lane, this only keeps them in registers */
+static const SimdIntrinsc unity_quaternion_intrinsics[] = {
+	{ SN_ctor, OP_EXPAND_R4, SIMD_EMIT_CTOR },
+};
+
+typedef struct {
+	const char *name_space;
+	const char *name;
+	const SimdIntrinsc *intrinsics;
+	guint32 size;
+} SimdTypeInfo;
+
+#define SIMD_TYPE(ns,name,intrinsics) { ns, name, intrinsics, sizeof (intrinsics) / sizeof (SimdIntrinsc) }
+
+static const SimdTypeInfo registered_simd_types [] = {
+	SIMD_TYPE ("System.Numerics", "Vector4", numerics_vector4_intrinsics),
+	SIMD_TYPE ("UnityEngine", "Vector4", unity_vector4_intrinsics),
+	SIMD_TYPE ("UnityEngine", "Quaternion", unity_quaternion_intrinsics),
+	SIMD_TYPE ("Unity.Mathematics", "float4", float4_intrinsics),
+};
+
 static guint32 simd_supported_versions;
 
 /*TODO match using number of parameters as well*/
@@ -592,8 +647,38 @@ typedef enum {
 void
 mono_simd_intrinsics_init (void)
 {
+	const char *types = g_getenv ("MONO_SIMD_TYPES");
+	int i;
+
 	simd_supported_versions = mono_arch_cpu_enumerate_simd_versions ();
 	/*TODO log the supported flags*/
+
+	for (i = 0; i < G_N_ELEMENTS (registered_simd_types); ++i)
+		mono_class_register_simd_type (registered_simd_types [i].name_space, registered_simd_types [i].name);
+
+	/*
+	 * MONO_SIMD_TYPES is a comma separated list of Namespace.Name value types with 4 float
+	 * fields, whose .ctor (float, float, float, float) sets the fields in order, and whose
+	 * arithmetic operators work lane by lane.
+	 */
+	if (types) {
+		gchar **names = g_strsplit (types, ",", -1);
+
+		for (i = 0; names [i]; ++i) {
+			char *name = g_strstrip (names [i]);
+			char *dot = strrchr (name, '.');
+
+			if (!*name)
+				continue;
+			if (dot) {
+				*dot = '\0';
+				mono_class_register_simd_type (name, dot + 1);
+			} else {
+				mono_class_register_simd_type ("", name);
+			}
+		}
+		g_strfreev (names);
+	}
 }
 
 static inline gboolean
@@ -1364,6 +1449,47 @@ simd_version_name (guint32 version)
 	return "n/a";
 }
 
+static gboolean
+is_simd_param (MonoType *t, MonoClass *klass)
+{
+	return !t->byref && t->type == MONO_TYPE_VALUETYPE && t->data.klass == klass;
+}
+
+/*
+ * simd_signature_is_valid:
+ *
+ *   The intrinsics of registered types are matched by name only, so check that
+ * FSIG is the overload the intrinsic implements.  Mono.Simd types don't need this.
+ */
+static gboolean
+simd_signature_is_valid (const SimdIntrinsc *intrinsic, MonoMethod *cmethod, MonoMethodSignature *fsig)
+{
+	MonoClass *klass = cmethod->klass;
+	int i;
+
+	switch (intrinsic->simd_emit_mode) {
+	case SIMD_EMIT_CTOR:
+		if (!fsig->hasthis || (fsig->param_count != 1 && fsig->param_count != 4))
+			return FALSE;
+		for (i = 0; i < fsig->param_count; ++i) {
+			if (fsig->params [i]->byref || fsig->params [i]->type != MONO_TYPE_R4)
+				return FALSE;
+		}
+		return TRUE;
+	case SIMD_EMIT_BINARY:
+	case SIMD_EMIT_UNARY:
+		if (fsig->hasthis || fsig->param_count != (intrinsic->simd_emit_mode == SIMD_EMIT_BINARY ? 2 : 1) || !is_simd_param (fsig->ret, klass))
+			return FALSE;
+		for (i = 0; i < fsig->param_count; ++i) {
+			if (!is_simd_param (fsig->params [i], klass))
+				return FALSE;
+		}
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
 static MonoInst*
 emit_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig, MonoInst **args, const SimdIntrinsc *intrinsics, guint32 size)
 {
@@ -1372,6 +1498,10 @@ emit_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsi
 		DEBUG (printf ("function doesn't have a simd intrinsic %s::%s/%d\n", cmethod->klass->name, cmethod->name, fsig->param_count));
 		return NULL;
 	}
+	if (strcmp ("Mono.Simd", cmethod->klass->name_space) && !simd_signature_is_valid (result, cmethod, fsig)) {
+		DEBUG (printf ("function %s::%s/%d doesn't match the signature of its simd intrinsic\n", cmethod->klass->name, cmethod->name, fsig->param_count));
+		return NULL;
+	}
 	if (IS_DEBUG_ON (cfg)) {
 		int i, max;
 		printf ("found call to intrinsic %s::%s/%d -> %s\n", cmethod->klass->name, cmethod->name, fsig->param_count, method_name (result->name));
@@ -1501,6 +1631,32 @@ emit_array_extension_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMeth
 	return NULL;
 }
 
+/*
+ * emit_registered_type_intrinsics:
+ *
+ *   Emit intrinsics for the methods of types registered with
+ * mono_class_register_simd_type ().  Types registered through MONO_SIMD_TYPES
+ * use float4_intrinsics.
+ */
+static MonoInst*
+emit_registered_type_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig, MonoInst **args)
+{
+	MonoClass *klass = cmethod->klass;
+	int i;
+
+	if (!klass->simd_type)
+		return NULL;
+
+	cfg->uses_simd_intrinsics = 1;
+	for (i = 0; i < G_N_ELEMENTS (registered_simd_types); ++i) {
+		const SimdTypeInfo *info = &registered_simd_types [i];
+
+		if (!strcmp (info->name, klass->name) && !strcmp (info->name_space, klass->name_space))
+			return emit_intrinsics (cfg, cmethod, fsig, args, info->intrinsics, info->size);
+	}
+	return emit_intrinsics (cfg, cmethod, fsig, args, float4_intrinsics, sizeof (float4_intrinsics) / sizeof (SimdIntrinsc));
+}
+
 static MonoInst*
 emit_simd_runtime_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig, MonoInst **args)
 {
@@ -1518,7 +1674,7 @@ mono_emit_simd_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSign
 	const char *class_name;
 
 	if (strcmp ("Mono.Simd", cmethod->klass->name_space))
-		return NULL;
+		return emit_registered_type_intrinsics (cfg, cmethod, fsig, args);
 
 	class_name = cmethod->klass->name;
 	if (!strcmp ("SimdRuntime", class_name))
@@ -1559,4 +1715,890 @@ mono_emit_simd_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSign
 	return NULL;
 }
 
+/*
+ * Loop vectorization.
+ *
+ * Counted loops whose body is a single basic block, like
+ *
+ *   for (i = start; i < n; ++i)
+ *       a [i] = b [i] * c + d [i];
+ *
+ * where every array is indexed by i and has 4 byte int or float elements, get a copy
+ * which works on 4 elements at a time, placed in front of the original loop:
+ *
+ *   guards: n >= 4, 0 <= i <= n - 4, every array is non null and at least n long
+ *   vector: the body using packed ops and no bounds checks, i += 4 while i <= n - 4
+ *   exit:   continue in the original loop, which does the remaining iterations
+ *
+ * If a guard fails the original loop runs alone.  Int sums, mins and maxes into a
+ * local are reduced horizontally on each vector iteration, since xregs can't be live
+ * across bblocks.  For the same reason the loop invariant operands are broadcast again
+ * on each vector iteration.
+ * Float ops are done in single precision, while the scalar code might keep the
+ * intermediate results in double precision.  The ECMA spec allows both.
+ */
+
+typedef enum {
+	VECT_NONE,
+	VECT_IV,	/* the induction variable */
+	VECT_INDEX,	/* the induction variable sign extended to a native int */
+	VECT_ADDR,	/* address of the current element of an array */
+	VECT_LEN,	/* length of an array */
+	VECT_INV,	/* loop invariant scalar */
+	VECT_VEC,	/* 4 consecutive elements in an xreg */
+	VECT_REDUCE	/* a vector reduced into an accumulator, waiting for the store to it */
+} VectKind;
+
+enum {
+	VECT_ELEM_I4,
+	VECT_ELEM_R4
+};
+
+typedef struct {
+	guint8 kind, elem;
+	guint16 defs, uses;
+	/* ADDR/LEN: the array var, INV: the var or -1, VEC/REDUCE: the xreg */
+	int reg;
+	/* ADDR: the element address in the vector loop, INV: the broadcast value */
+	int xreg;
+	/* INV: the constant */
+	MonoInst *def;
+	/* REDUCE: the accumulator and the scalar opcode */
+	int acc, op;
+} VectValue;
+
+#define VECT_MAX_ARRAYS 8
+
+typedef struct {
+	MonoCompile *cfg;
+	/* the loop is test -> body -> test, or a single body -> body bblock when test == body */
+	MonoBasicBlock *head, *test, *body, *exit, *pred;
+	VectValue *values;
+	int num_values;
+	int iv, idx_reg;
+	int bound_reg, bound_imm, bound_array;
+	int arrays [VECT_MAX_ARRAYS];
+	int num_arrays;
+} VectLoop;
+
+typedef struct {
+	guint16 op, vop;
+	guint8 elem;
+	guint8 version;
+} VectOp;
+
+static const VectOp vect_ops [] = {
+	{ OP_FADD, OP_ADDPS, VECT_ELEM_R4 },
+	{ OP_FSUB, OP_SUBPS, VECT_ELEM_R4 },
+	{ OP_FMUL, OP_MULPS, VECT_ELEM_R4 },
+	{ OP_FDIV, OP_DIVPS, VECT_ELEM_R4 },
+	{ OP_IADD, OP_PADDD, VECT_ELEM_I4 },
+	{ OP_ISUB, OP_PSUBD, VECT_ELEM_I4 },
+	{ OP_IAND, OP_PAND, VECT_ELEM_I4 },
+	{ OP_IOR, OP_POR, VECT_ELEM_I4 },
+	{ OP_IXOR, OP_PXOR, VECT_ELEM_I4 },
+	{ OP_IMUL, OP_PMULD, VECT_ELEM_I4, SIMD_VERSION_SSE41 },
+	{ OP_IMIN, OP_PMIND, VECT_ELEM_I4, SIMD_VERSION_SSE41 },
+	{ OP_IMAX, OP_PMAXD, VECT_ELEM_I4, SIMD_VERSION_SSE41 },
+	{ OP_IMIN_UN, OP_PMIND_UN, VECT_ELEM_I4, SIMD_VERSION_SSE41 },
+	{ OP_IMAX_UN, OP_PMAXD_UN, VECT_ELEM_I4, SIMD_VERSION_SSE41 },
+	{ OP_ISHL_IMM, OP_PSHLD, VECT_ELEM_I4 },
+	{ OP_ISHR_IMM, OP_PSARD, VECT_ELEM_I4 },
+	{ OP_ISHR_UN_IMM, OP_PSHRD, VECT_ELEM_I4 },
+};
+
+static const VectOp*
+vect_get_op (int opcode)
+{
+	int i;
+
+	for (i = 0; i < G_N_ELEMENTS (vect_ops); ++i) {
+		if (vect_ops [i].op == opcode)
+			return (vect_ops [i].version & ~simd_supported_versions) ? NULL : &vect_ops [i];
+	}
+	return NULL;
+}
+
+static VectValue*
+vect_get (VectLoop *vl, int vreg)
+{
+	MonoInst *var;
+	VectValue *v;
+
+	if (vreg < 0 || vreg >= vl->num_values)
+		return NULL;
+	v = &vl->values [vreg];
+	if (v->kind != VECT_NONE)
+		return v;
+	var = get_vreg_to_inst (vl->cfg, vreg);
+	if (!var || v->defs || (var->flags & (MONO_INST_VOLATILE|MONO_INST_INDIRECT)))
+		return NULL;
+	/* A variable which is not assigned in the loop */
+	v->kind = VECT_INV;
+	v->reg = vreg;
+	return v;
+}
+
+/*
+ * Only the induction variable and the accumulators are assigned in the loop, every
+ * other result must be a local vreg.
+ */
+static VectValue*
+vect_def (VectLoop *vl, MonoInst *ins, int kind)
+{
+	VectValue *v;
+
+	if (ins->dreg < 0 || ins->dreg >= vl->num_values || get_vreg_to_inst (vl->cfg, ins->dreg))
+		return NULL;
+	v = &vl->values [ins->dreg];
+	if (v->defs != 1 || v->kind != VECT_NONE)
+		return NULL;
+	v->kind = kind;
+	return v;
+}
+
+/* Return the array var VREG holds, or -1 */
+static int
+vect_array (VectLoop *vl, int vreg)
+{
+	VectValue *v = vect_get (vl, vreg);
+	MonoInst *var;
+
+	if (!v || v->kind != VECT_INV || v->def)
+		return -1;
+	var = get_vreg_to_inst (vl->cfg, v->reg);
+	if (var->type != STACK_OBJ)
+		return -1;
+	return v->reg;
+}
+
+static gboolean
+vect_add_array (VectLoop *vl, int array)
+{
+	int i;
+
+	if (array == -1)
+		return FALSE;
+	for (i = 0; i < vl->num_arrays; ++i) {
+		if (vl->arrays [i] == array)
+			return TRUE;
+	}
+	if (vl->num_arrays == VECT_MAX_ARRAYS)
+		return FALSE;
+	vl->arrays [vl->num_arrays ++] = array;
+	return TRUE;
+}
+
+static gboolean
+vect_is_index (VectLoop *vl, int vreg)
+{
+	VectValue *v = vect_get (vl, vreg);
+
+#if SIZEOF_REGISTER == 8
+	return v && v->kind == VECT_INDEX;
+#else
+	return v && v->kind == VECT_IV;
+#endif
+}
+
+static gboolean
+vect_is_accumulator (VectLoop *vl, int vreg)
+{
+	MonoInst *var = get_vreg_to_inst (vl->cfg, vreg);
+
+	if (!var || vreg == vl->iv || var->type != STACK_I4 || (var->flags & (MONO_INST_VOLATILE|MONO_INST_INDIRECT)))
+		return FALSE;
+	/* The reduction is the only use and the only assignment in the loop */
+	return vl->values [vreg].defs == 1 && vl->values [vreg].uses == 1;
+}
+
+static int
+vect_emit_op (MonoCompile *cfg, int opcode, int sreg1, int sreg2)
+{
+	MonoInst *ins;
+
+	MONO_INST_NEW (cfg, ins, opcode);
+	ins->sreg1 = sreg1;
+	ins->sreg2 = sreg2;
+	ins->type = STACK_VTYPE;
+	ins->dreg = alloc_ireg (cfg);
+	MONO_ADD_INS (cfg->cbb, ins);
+	return ins->dreg;
+}
+
+static int
+vect_broadcast_imm (MonoCompile *cfg, gssize imm)
+{
+	int sreg = alloc_ireg (cfg);
+
+	MONO_EMIT_NEW_ICONST (cfg, sreg, imm);
+	return vect_emit_op (cfg, OP_EXPAND_I4, sreg, -1);
+}
+
+static int
+vect_broadcast (VectLoop *vl, VectValue *v, int elem)
+{
+	MonoCompile *cfg = vl->cfg;
+	MonoInst *ins, *var;
+	int sreg;
+
+	if (v->xreg)
+		return v->elem == elem ? v->xreg : 0;
+
+	if (v->def) {
+		if (v->def->opcode == OP_ICONST && elem == VECT_ELEM_I4) {
+			v->elem = elem;
+			return v->xreg = vect_broadcast_imm (cfg, v->def->inst_c0);
+		}
+		if (v->def->opcode != OP_R4CONST || elem != VECT_ELEM_R4)
+			return 0;
+		MONO_INST_NEW (cfg, ins, OP_R4CONST);
+		ins->type = STACK_R8;
+		ins->dreg = sreg = alloc_freg (cfg);
+		ins->inst_p0 = v->def->inst_p0;
+		MONO_ADD_INS (cfg->cbb, ins);
+	} else {
+		var = get_vreg_to_inst (cfg, v->reg);
+		if (elem == VECT_ELEM_I4) {
+			if (var->type != STACK_I4)
+				return 0;
+			v->elem = elem;
+			return v->xreg = vect_emit_op (cfg, OP_EXPAND_I4, v->reg, -1);
+		}
+		if (var->inst_vtype->byref || var->inst_vtype->type != MONO_TYPE_R4)
+			return 0;
+		sreg = v->reg;
+	}
+
+	MONO_INST_NEW (cfg, ins, OP_EXPAND_R4);
+	ins->sreg1 = sreg;
+	ins->type = STACK_VTYPE;
+	ins->dreg = alloc_ireg (cfg);
+	ins->backend.spill_var = get_int_to_float_spill_area (cfg);
+	MONO_ADD_INS (cfg->cbb, ins);
+
+	v->elem = elem;
+	return v->xreg = ins->dreg;
+}
+
+/* Return the xreg holding the vector value of SREG, broadcasting invariants */
+static int
+vect_operand (VectLoop *vl, int sreg, int elem)
+{
+	VectValue *v = vect_get (vl, sreg);
+
+	if (!v)
+		return 0;
+	if (v->kind == VECT_VEC)
+		return v->elem == elem ? v->reg : 0;
+	if (v->kind == VECT_INV)
+		return vect_broadcast (vl, v, elem);
+	return 0;
+}
+
+/* ACC <- ACC op (XREG [0] op XREG [1] op XREG [2] op XREG [3]) */
+static void
+vect_emit_reduction (VectLoop *vl, int acc, int op, int xreg)
+{
+	MonoCompile *cfg = vl->cfg;
+	MonoInst *ins;
+	int vop = vect_get_op (op)->vop;
+	int res;
+
+	MONO_INST_NEW (cfg, ins, OP_PSHUFLED);
+	ins->sreg1 = xreg;
+	ins->inst_c0 = 0x4E;
+	ins->type = STACK_VTYPE;
+	ins->dreg = alloc_ireg (cfg);
+	MONO_ADD_INS (cfg->cbb, ins);
+	xreg = vect_emit_op (cfg, vop, xreg, ins->dreg);
+
+	MONO_INST_NEW (cfg, ins, OP_PSHUFLED);
+	ins->sreg1 = xreg;
+	ins->inst_c0 = 0xB1;
+	ins->type = STACK_VTYPE;
+	ins->dreg = alloc_ireg (cfg);
+	MONO_ADD_INS (cfg->cbb, ins);
+	xreg = vect_emit_op (cfg, vop, xreg, ins->dreg);
+
+	MONO_INST_NEW (cfg, ins, OP_EXTRACT_I4);
+	ins->sreg1 = xreg;
+	ins->inst_c0 = 0;
+	ins->type = STACK_I4;
+	ins->dreg = res = alloc_ireg (cfg);
+	MONO_ADD_INS (cfg->cbb, ins);
+
+	MONO_EMIT_NEW_BIALU (cfg, op, acc, acc, res);
+}
+
+static gboolean
+vect_translate_op (VectLoop *vl, MonoInst *ins)
+{
+	MonoCompile *cfg = vl->cfg;
+	const VectOp *vop;
+	VectValue *v;
+	MonoInst *vins;
+	int opcode, sreg1, sreg2;
+
+	vop = vect_get_op (ins->opcode);
+	if (vop && (ins->opcode == OP_ISHL_IMM || ins->opcode == OP_ISHR_IMM || ins->opcode == OP_ISHR_UN_IMM)) {
+		if (!(sreg1 = vect_operand (vl, ins->sreg1, VECT_ELEM_I4)))
+			return FALSE;
+		MONO_INST_NEW (cfg, vins, vop->vop);
+		vins->sreg1 = sreg1;
+		vins->inst_imm = ins->inst_imm & 0x1f;
+		vins->type = STACK_VTYPE;
+		vins->dreg = alloc_ireg (cfg);
+		MONO_ADD_INS (cfg->cbb, vins);
+		if (!(v = vect_def (vl, ins, VECT_VEC)))
+			return FALSE;
+		v->reg = vins->dreg;
+		v->elem = VECT_ELEM_I4;
+		return TRUE;
+	}
+
+	switch (ins->opcode) {
+	case OP_IADD_IMM:
+	case OP_ISUB_IMM:
+	case OP_IMUL_IMM:
+	case OP_IAND_IMM:
+	case OP_IOR_IMM:
+	case OP_IXOR_IMM:
+		opcode = mono_op_imm_to_op (ins->opcode);
+		vop = vect_get_op (opcode);
+		if (!vop || !(sreg1 = vect_operand (vl, ins->sreg1, VECT_ELEM_I4)))
+			return FALSE;
+		sreg2 = vect_broadcast_imm (cfg, ins->inst_imm);
+		break;
+	case OP_IADD:
+	case OP_IMIN:
+	case OP_IMAX:
+	case OP_IMIN_UN:
+	case OP_IMAX_UN: {
+		int acc = -1, other = -1;
+
+		if (!vop)
+			return FALSE;
+		if (vect_is_accumulator (vl, ins->sreg1)) {
+			acc = ins->sreg1;
+			other = ins->sreg2;
+		} else if (vect_is_accumulator (vl, ins->sreg2)) {
+			acc = ins->sreg2;
+			other = ins->sreg1;
+		}
+		if (acc != -1) {
+			/* Only reduce values which differ between the lanes */
+			v = vect_get (vl, other);
+			if (!v || v->kind != VECT_VEC || v->elem != VECT_ELEM_I4)
+				return FALSE;
+			if (ins->dreg == acc) {
+				vect_emit_reduction (vl, acc, ins->opcode, v->reg);
+				return TRUE;
+			}
+			sreg1 = v->reg;
+			if (!(v = vect_def (vl, ins, VECT_REDUCE)))
+				return FALSE;
+			v->reg = sreg1;
+			v->acc = acc;
+			v->op = ins->opcode;
+			return TRUE;
+		}
+	}
+		/* Fall through */
+	default:
+		if (!vop)
+			return FALSE;
+		sreg1 = vect_operand (vl, ins->sreg1, vop->elem);
+		sreg2 = vect_operand (vl, ins->sreg2, vop->elem);
+		if (!sreg1 || !sreg2)
+			return FALSE;
+		break;
+	}
+
+	if (!(v = vect_def (vl, ins, VECT_VEC)))
+		return FALSE;
+	v->reg = vect_emit_op (cfg, vop->vop, sreg1, sreg2);
+	v->elem = vop->elem;
+	return TRUE;
+}
+
+/*
+ * Translate the instructions between FIRST and LAST (inclusive) into the vector loop.
+ */
+static gboolean
+vect_translate (VectLoop *vl, MonoInst *first, MonoInst *last)
+{
+	MonoCompile *cfg = vl->cfg;
+	MonoInst *ins, *vins;
+	VectValue *v, *d;
+	int array, elem, xreg;
+
+	if (!first || !last)
+		return TRUE;
+
+	for (ins = first; ins; ins = ins->next) {
+		switch (ins->opcode) {
+		case OP_NOP:
+			break;
+		case OP_ICONST:
+		case OP_R4CONST:
+			if (!(d = vect_def (vl, ins, VECT_INV)))
+				return FALSE;
+			d->reg = -1;
+			d->def = ins;
+			break;
+		case OP_MOVE:
+		case OP_FMOVE:
+		case OP_FCONV_TO_R4:
+			v = vect_get (vl, ins->sreg1);
+			if (v && v->kind == VECT_REDUCE && ins->opcode == OP_MOVE && ins->dreg == v->acc && vl->values [ins->sreg1].uses == 1) {
+				vect_emit_reduction (vl, v->acc, v->op, v->reg);
+				break;
+			}
+			if (!v || v->kind == VECT_REDUCE)
+				return FALSE;
+			if (ins->opcode == OP_FCONV_TO_R4 && !(v->kind == VECT_VEC && v->elem == VECT_ELEM_R4))
+				return FALSE;
+			if (!(d = vect_def (vl, ins, v->kind)))
+				return FALSE;
+			d->elem = v->elem;
+			d->reg = v->reg;
+			d->xreg = v->xreg;
+			d->def = v->def;
+			break;
+#if SIZEOF_REGISTER == 8
+		case OP_SEXT_I4:
+			v = vect_get (vl, ins->sreg1);
+			if (!v || v->kind != VECT_IV || !vect_def (vl, ins, VECT_INDEX))
+				return FALSE;
+			break;
+#endif
+		case OP_LDLEN:
+			array = vect_array (vl, ins->sreg1);
+			if (!vect_add_array (vl, array) || !(d = vect_def (vl, ins, VECT_LEN)))
+				return FALSE;
+			d->reg = array;
+			break;
+		case OP_X86_LEA:
+			/* &array [i], from mini_emit_ldelema_1_ins () */
+			array = vect_array (vl, ins->sreg1);
+			if (!vect_is_index (vl, ins->sreg2) || ins->backend.shift_amount != 2 || ins->inst_imm != G_STRUCT_OFFSET (MonoArray, vector))
+				return FALSE;
+			if (!vect_add_array (vl, array) || !(d = vect_def (vl, ins, VECT_ADDR)))
+				return FALSE;
+			MONO_INST_NEW (cfg, vins, OP_X86_LEA);
+			vins->sreg1 = array;
+			vins->sreg2 = vl->idx_reg;
+			vins->inst_imm = ins->inst_imm;
+			vins->backend.shift_amount = 2;
+			vins->type = STACK_PTR;
+			vins->dreg = alloc_preg (cfg);
+			MONO_ADD_INS (cfg->cbb, vins);
+			d->reg = array;
+			d->xreg = vins->dreg;
+			break;
+		case OP_BOUNDS_CHECK:
+			if (!vect_is_index (vl, ins->sreg2) || !vect_add_array (vl, vect_array (vl, ins->sreg1)))
+				return FALSE;
+			break;
+		/* The bounds check from MONO_ARCH_EMIT_BOUNDS_CHECK, the guards make it redundant */
+#if defined(TARGET_AMD64)
+		case OP_AMD64_ICOMPARE_MEMBASE_REG:
+#else
+		case OP_X86_COMPARE_MEMBASE_REG:
+#endif
+			if (ins->inst_offset != G_STRUCT_OFFSET (MonoArray, max_length) || !vect_is_index (vl, ins->sreg2))
+				return FALSE;
+			if (!vect_add_array (vl, vect_array (vl, ins->inst_basereg)))
+				return FALSE;
+			if (ins == last || ins->next->opcode != OP_COND_EXC_LE_UN)
+				return FALSE;
+			ins = ins->next;
+			break;
+		/* Explicit null checks */
+		case OP_COMPARE_IMM:
+			if (ins->inst_imm != 0 || !vect_add_array (vl, vect_array (vl, ins->sreg1)))
+				return FALSE;
+			if (ins == last || ins->next->opcode != OP_COND_EXC_EQ)
+				return FALSE;
+			ins = ins->next;
+			break;
+		case OP_LOADI4_MEMBASE:
+		case OP_LOADU4_MEMBASE:
+		case OP_LOADR4_MEMBASE:
+			v = vect_get (vl, ins->inst_basereg);
+			if (v && v->kind == VECT_ADDR && ins->inst_offset == 0) {
+				MONO_INST_NEW (cfg, vins, OP_LOADX_MEMBASE);
+				vins->sreg1 = v->xreg;
+				vins->inst_offset = 0;
+				vins->type = STACK_VTYPE;
+				vins->dreg = alloc_ireg (cfg);
+				MONO_ADD_INS (cfg->cbb, vins);
+				if (!(d = vect_def (vl, ins, VECT_VEC)))
+					return FALSE;
+				d->reg = vins->dreg;
+				d->elem = ins->opcode == OP_LOADR4_MEMBASE ? VECT_ELEM_R4 : VECT_ELEM_I4;
+			} else if (ins->opcode == OP_LOADI4_MEMBASE && ins->inst_offset == G_STRUCT_OFFSET (MonoArray, max_length)) {
+				array = vect_array (vl, ins->inst_basereg);
+				if (!vect_add_array (vl, array) || !(d = vect_def (vl, ins, VECT_LEN)))
+					return FALSE;
+				d->reg = array;
+			} else {
+				return FALSE;
+			}
+			break;
+		case OP_STOREI4_MEMBASE_REG:
+		case OP_STOREI4_MEMBASE_IMM:
+		case OP_STORER4_MEMBASE_REG:
+			v = vect_get (vl, ins->inst_destbasereg);
+			if (!v || v->kind != VECT_ADDR || ins->inst_offset != 0)
+				return FALSE;
+			elem = ins->opcode == OP_STORER4_MEMBASE_REG ? VECT_ELEM_R4 : VECT_ELEM_I4;
+			if (ins->opcode == OP_STOREI4_MEMBASE_IMM)
+				xreg = vect_broadcast_imm (cfg, ins->inst_imm);
+			else
+				xreg = vect_operand (vl, ins->sreg1, elem);
+			if (!xreg)
+				return FALSE;
+			MONO_INST_NEW (cfg, vins, OP_STOREX_MEMBASE);
+			vins->dreg = v->xreg;
+			vins->sreg1 = xreg;
+			vins->inst_offset = 0;
+			MONO_ADD_INS (cfg->cbb, vins);
+			break;
+		default:
+			if (!vect_translate_op (vl, ins))
+				return FALSE;
+			break;
+		}
+		if (ins == last)
+			break;
+	}
+	return TRUE;
+}
+
+static void
+vect_count_regs (VectLoop *vl, MonoBasicBlock *bb)
+{
+	MonoInst *ins;
+	int i, num_sregs;
+	int sregs [MONO_MAX_SRC_REGS];
+
+	for (ins = bb->code; ins; ins = ins->next) {
+		const char *spec = INS_INFO (ins->opcode);
+
+		num_sregs = mono_inst_get_src_registers (ins, sregs);
+		for (i = 0; i < num_sregs; ++i) {
+			if (sregs [i] != -1)
+				vl->values [sregs [i]].uses ++;
+		}
+		if (spec [MONO_INST_DEST] != ' ' && ins->dreg != -1) {
+			if (MONO_IS_STORE_MEMBASE (ins))
+				vl->values [ins->dreg].uses ++;
+			else
+				vl->values [ins->dreg].defs ++;
+		}
+	}
+}
+
+/*
+ * Match the induction variable update at the end of the loop, either
+ * IADD_IMM iv <- iv 1 or IADD_IMM t <- iv 1; MOVE iv <- t.
+ * Return the first instruction of the update.
+ */
+static MonoInst*
+vect_match_update (VectLoop *vl, MonoInst *ins, int *step_reg)
+{
+	MonoInst *var;
+
+	if (!ins)
+		return NULL;
+	if (ins->opcode == OP_MOVE && ins->prev && ins->prev->opcode == OP_IADD_IMM && ins->prev->dreg == ins->sreg1 && ins->prev->sreg1 == ins->dreg) {
+		*step_reg = ins->sreg1;
+		ins = ins->prev;
+	} else if (ins->opcode == OP_IADD_IMM && ins->dreg == ins->sreg1) {
+		*step_reg = ins->dreg;
+	} else {
+		return NULL;
+	}
+	if (ins->inst_imm != 1)
+		return NULL;
+
+	vl->iv = ins->sreg1;
+	var = get_vreg_to_inst (vl->cfg, vl->iv);
+	if (!var || var->type != STACK_I4 || (var->flags & (MONO_INST_VOLATILE|MONO_INST_INDIRECT)))
+		return NULL;
+	return ins;
+}
+
+static MonoBasicBlock*
+vect_new_bblock (VectLoop *vl)
+{
+	MonoBasicBlock *bb;
+
+	NEW_BBLOCK (vl->cfg, bb);
+	bb->region = vl->head->region;
+	bb->real_offset = vl->head->real_offset;
+	bb->nesting = vl->body->nesting;
+	return bb;
+}
+
+/* Branch to the original loop if the compare in cfg->cbb is true, continue in a new bblock otherwise */
+static void
+vect_emit_guard (VectLoop *vl, int opcode)
+{
+	MonoCompile *cfg = vl->cfg;
+	MonoBasicBlock *next = vect_new_bblock (vl);
+
+	MONO_EMIT_NEW_BRANCH_BLOCK2 (cfg, opcode, vl->head, next);
+	cfg->cbb->next_bb = next;
+	cfg->cbb = next;
+}
+
+static gboolean
+vect_loop (MonoCompile *cfg, MonoBasicBlock *test, MonoBasicBlock *body)
+{
+	VectLoop vl_data, *vl = &vl_data;
+	MonoBasicBlock *vbody, *vexit, *first, *pred, *next;
+	MonoInst *cmp, *branch, *update, *len, *ins, *var, *limit;
+	VectValue *v;
+	int i, reg, step_reg;
+
+	memset (vl, 0, sizeof (VectLoop));
+	vl->cfg = cfg;
+	vl->test = test;
+	vl->body = body;
+	vl->head = test;
+	vl->bound_reg = vl->bound_array = -1;
+
+	branch = test->last_ins;
+	cmp = branch->prev;
+	if (!cmp || (cmp->opcode != OP_ICOMPARE && cmp->opcode != OP_ICOMPARE_IMM))
+		return FALSE;
+	vl->exit = branch->inst_false_bb;
+	if (!vl->exit || vl->exit == test || vl->exit == body)
+		return FALSE;
+
+	/* The only edge into the loop from outside */
+	if (vl->head->in_count != 2)
+		return FALSE;
+	pred = vl->head->in_bb [0] == body ? vl->head->in_bb [1] : vl->head->in_bb [0];
+	if (pred == test || pred == body || pred->region != vl->head->region)
+		return FALSE;
+	if (pred->last_ins && MONO_IS_BRANCH_OP (pred->last_ins)) {
+		if (pred->last_ins->opcode == OP_BR_REG || pred->last_ins->opcode == OP_SWITCH)
+			return FALSE;
+		if (MONO_IS_COND_BRANCH_OP (pred->last_ins) && !pred->last_ins->inst_false_bb)
+			return FALSE;
+	} else if (pred->next_bb != vl->head) {
+		return FALSE;
+	}
+	vl->pred = pred;
+
+	len = NULL;
+	if (test == body) {
+		/* i < a.Length is computed after the update */
+		ins = cmp->prev;
+		reg = cmp->sreg2;
+		while (cmp->opcode == OP_ICOMPARE && ins && ins->opcode == OP_MOVE && ins->dreg == reg) {
+			reg = ins->sreg1;
+			ins = ins->prev;
+		}
+		if (cmp->opcode == OP_ICOMPARE && ins && ins->opcode == OP_LDLEN && ins->dreg == reg) {
+			len = ins;
+			ins = ins->prev;
+		} else {
+			ins = cmp->prev;
+		}
+	} else {
+		ins = body->last_ins;
+		if (ins && ins->opcode == OP_BR)
+			ins = ins->prev;
+	}
+	update = vect_match_update (vl, ins, &step_reg);
+	if (!update)
+		return FALSE;
+	if (cmp->sreg1 != vl->iv && !(test == body && cmp->sreg1 == step_reg))
+		return FALSE;
+
+	vl->num_values = cfg->next_vreg;
+	vl->values = mono_mempool_alloc0 (cfg->mempool, sizeof (VectValue) * vl->num_values);
+	vect_count_regs (vl, body);
+	if (test != body)
+		vect_count_regs (vl, test);
+	vl->values [vl->iv].kind = VECT_IV;
+
+	/* Translate the loop into a new bblock, which is only added to the cfg on success */
+	vbody = mono_mempool_alloc0 (cfg->mempool, sizeof (MonoBasicBlock));
+	vbody->region = vl->head->region;
+	vbody->real_offset = vl->head->real_offset;
+	vbody->nesting = body->nesting;
+	cfg->cbb = vbody;
+
+#if SIZEOF_REGISTER == 8
+	vl->idx_reg = alloc_preg (cfg);
+	MONO_EMIT_NEW_UNALU (cfg, OP_SEXT_I4, vl->idx_reg, vl->iv);
+#else
+	vl->idx_reg = vl->iv;
+#endif
+
+	if (test != body && !vect_translate (vl, test->code, cmp->prev))
+		return FALSE;
+	if (!vect_translate (vl, body->code, update->prev))
+		return FALSE;
+	if (vl->num_arrays == 0)
+		return FALSE;
+
+	/* The loop bound: a constant, a var or the length of an array */
+	if (len) {
+		vl->bound_array = vect_array (vl, len->sreg1);
+		if (!vect_add_array (vl, vl->bound_array))
+			return FALSE;
+	} else if (cmp->opcode == OP_ICOMPARE_IMM) {
+		vl->bound_imm = cmp->inst_imm;
+	} else {
+		v = vect_get (vl, cmp->sreg2);
+		if (!v)
+			return FALSE;
+		if (v->kind == VECT_LEN) {
+			vl->bound_array = v->reg;
+		} else if (v->kind == VECT_INV && v->def && v->def->opcode == OP_ICONST) {
+			vl->bound_imm = v->def->inst_c0;
+		} else if (v->kind == VECT_INV && !v->def) {
+			var = get_vreg_to_inst (cfg, v->reg);
+			if (var->type != STACK_I4)
+				return FALSE;
+			vl->bound_reg = v->reg;
+		} else {
+			return FALSE;
+		}
+	}
+	if (vl->bound_reg == -1 && vl->bound_array == -1 && vl->bound_imm < 4)
+		return FALSE;
+
+	if (cfg->verbose_level > 1)
+		printf ("VECTORIZING LOOP BB%d in %s\n", body->block_num, mono_method_full_name (cfg->method, TRUE));
+
+	/* The guards */
+	first = vect_new_bblock (vl);
+	cfg->cbb = first;
+	if (vl->bound_array != -1) {
+		var = mono_compile_create_var (cfg, &mono_defaults.int32_class->byval_arg, OP_LOCAL);
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_COMPARE_IMM, -1, vl->bound_array, 0);
+		vect_emit_guard (vl, OP_PBEQ);
+		MONO_EMIT_NEW_LOAD_MEMBASE_OP (cfg, OP_LOADI4_MEMBASE, var->dreg, vl->bound_array, G_STRUCT_OFFSET (MonoArray, max_length));
+		vl->bound_reg = var->dreg;
+	}
+	limit = mono_compile_create_var (cfg, &mono_defaults.int32_class->byval_arg, OP_LOCAL);
+	if (vl->bound_reg != -1) {
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ICOMPARE_IMM, -1, vl->bound_reg, 4);
+		vect_emit_guard (vl, OP_IBLT);
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ISUB_IMM, limit->dreg, vl->bound_reg, 4);
+	} else {
+		MONO_EMIT_NEW_ICONST (cfg, limit->dreg, vl->bound_imm - 4);
+	}
+	MONO_EMIT_NEW_BIALU (cfg, OP_ICOMPARE, -1, vl->iv, limit->dreg);
+	vect_emit_guard (vl, OP_IBGT);
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ICOMPARE_IMM, -1, vl->iv, 0);
+	vect_emit_guard (vl, OP_IBLT);
+	for (i = 0; i < vl->num_arrays; ++i) {
+		int len_reg = alloc_ireg (cfg);
+
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_COMPARE_IMM, -1, vl->arrays [i], 0);
+		vect_emit_guard (vl, OP_PBEQ);
+		MONO_EMIT_NEW_LOAD_MEMBASE_OP (cfg, OP_LOADI4_MEMBASE, len_reg, vl->arrays [i], G_STRUCT_OFFSET (MonoArray, max_length));
+		if (vl->bound_reg != -1)
+			MONO_EMIT_NEW_BIALU (cfg, OP_ICOMPARE, -1, len_reg, vl->bound_reg);
+		else
+			MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ICOMPARE_IMM, -1, len_reg, vl->bound_imm);
+		vect_emit_guard (vl, OP_IBLT);
+	}
+	/* The last guard bblock falls through into the vector loop */
+	vbody->block_num = cfg->num_bblocks ++;
+	cfg->cbb->next_bb = vbody;
+	mono_link_bblock (cfg, cfg->cbb, vbody);
+
+	/* The vector loop */
+	vexit = vect_new_bblock (vl);
+	cfg->cbb = vbody;
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_IADD_IMM, vl->iv, vl->iv, 4);
+	MONO_EMIT_NEW_BIALU (cfg, OP_ICOMPARE, -1, vl->iv, limit->dreg);
+	MONO_EMIT_NEW_BRANCH_BLOCK2 (cfg, OP_IBLE, vbody, vexit);
+	vbody->next_bb = vexit;
+
+	/* Back into the original loop for the remaining iterations */
+	cfg->cbb = vexit;
+	if (test == body) {
+		if (vl->bound_reg != -1)
+			MONO_EMIT_NEW_BIALU (cfg, OP_ICOMPARE, -1, vl->iv, vl->bound_reg);
+		else
+			MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ICOMPARE_IMM, -1, vl->iv, vl->bound_imm);
+		MONO_EMIT_NEW_BRANCH_BLOCK2 (cfg, OP_IBLT, body, vl->exit);
+	} else {
+		MONO_INST_NEW (cfg, ins, OP_BR);
+		ins->inst_target_bb = vl->head;
+		MONO_ADD_INS (vexit, ins);
+		mono_link_bblock (cfg, vexit, vl->head);
+	}
+
+	/* Redirect the loop entry to the guards */
+	next = pred->next_bb;
+	ins = pred->last_ins;
+	if (ins && ins->opcode == OP_BR) {
+		ins->inst_target_bb = first;
+	} else if (ins && MONO_IS_COND_BRANCH_OP (ins)) {
+		if (ins->inst_true_bb == vl->head)
+			ins->inst_true_bb = first;
+		if (ins->inst_false_bb == vl->head)
+			ins->inst_false_bb = first;
+	} else {
+		MONO_INST_NEW (cfg, ins, OP_BR);
+		ins->inst_target_bb = first;
+		MONO_ADD_INS (pred, ins);
+	}
+	mono_unlink_bblock (cfg, pred, vl->head);
+	mono_link_bblock (cfg, pred, first);
+	pred->next_bb = first;
+	vexit->next_bb = next;
+
+	mono_jit_stats.loops_vectorized ++;
+	return TRUE;
+}
+
+/*
+ * mono_simd_vectorize_loops:
+ *
+ *   Add a vector version in front of the simple counted loops of the method, see the
+ * comment above.  Runs after SSA has been removed, on code without exception clauses.
+ * Returns TRUE if the cfg has been changed, the caller has to recompute cfg->bblocks.
+ */
+gboolean
+mono_simd_vectorize_loops (MonoCompile *cfg)
+{
+	MonoBasicBlock *bb, *next, *cbb = cfg->cbb;
+	gboolean changed = FALSE;
+
+	for (bb = cfg->bb_entry; bb; bb = next) {
+		MonoInst *branch = bb->last_ins;
+
+		next = bb->next_bb;
+		if (!branch || branch->opcode != OP_IBLT)
+			continue;
+		if (branch->inst_true_bb == bb) {
+			/* A single bblock loop, branch opts have rotated the condition to the end */
+			if (vect_loop (cfg, bb, bb))
+				changed = TRUE;
+		} else {
+			MonoBasicBlock *body = branch->inst_true_bb;
+
+			if (body->in_count == 1 && body->out_count == 1 && body->out_bb [0] == bb && body->region == bb->region) {
+				if (vect_loop (cfg, bb, body))
+					changed = TRUE;
+			}
+		}
+	}
+	cfg->cbb = cbb;
+	return changed;
+}
+
 #endif
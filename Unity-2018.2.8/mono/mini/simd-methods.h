@@ -84,6 +84,7 @@ SIMD_METHOD("PrefetchTemporal1stLevelCache", SN_PrefetchTemporal1stLevelCache)
 SIMD_METHOD("PrefetchTemporal2ndLevelCache", SN_PrefetchTemporal2ndLevelCache)
 SIMD_METHOD("PrefetchNonTemporal", SN_PrefetchNonTemporal)
 SIMD_METHOD("Reciprocal", SN_Reciprocal)
+SIMD_METHOD("Scale", SN_Scale)
 SIMD_METHOD("ArithmeticRightShift", SN_ArithmeticRightShift)
 SIMD_METHOD("LogicalRightShift", SN_LogicalRightShift)
 SIMD_METHOD("ShuffleHigh", SN_ShuffleHigh)
@@ -92,6 +93,7 @@ SIMD_METHOD("Shuffle", SN_Shuffle)
 SIMD_METHOD("SignedPackWithSignedSaturation", SN_SignedPackWithSignedSaturation)
 SIMD_METHOD("SignedPackWithUnsignedSaturation", SN_SignedPackWithUnsignedSaturation)
 SIMD_METHOD("Sqrt", SN_Sqrt)
+SIMD_METHOD("SquareRoot", SN_SquareRoot)
 SIMD_METHOD("StoreAligned", SN_StoreAligned)
 SIMD_METHOD("StoreNonTemporal", SN_StoreNonTemporal)
 SIMD_METHOD("SubtractWithSaturation", SN_SubtractWithSaturation)
@@ -49,7 +49,7 @@ mono_arch_get_unbox_trampoline (MonoGenericSharingContext *gsctx, MonoMethod *m,
 
 	this_reg = mono_arch_get_this_arg_reg (mono_method_signature (m), gsctx, NULL);
 
-	start = code = mono_domain_code_reserve (domain, 20);
+	start = code = mono_domain_code_reserve_pool (domain, MONO_CODE_POOL_TRAMPOLINE, 20);
 
 	amd64_alu_reg_imm (code, X86_ADD, this_reg, sizeof (MonoObject));
 	/* FIXME: Optimize this */
@@ -85,7 +85,7 @@ mono_arch_get_static_rgctx_trampoline (MonoMethod *m, MonoMethodRuntimeGenericCo
 		buf_len = 30;
 #endif
 
-	start = code = mono_domain_code_reserve (domain, buf_len);
+	start = code = mono_domain_code_reserve_pool (domain, MONO_CODE_POOL_TRAMPOLINE, buf_len);
 
 	amd64_mov_reg_imm (code, MONO_ARCH_RGCTX_REG, mrgctx);
 	amd64_jump_code (code, addr);
@@ -105,7 +105,7 @@ mono_arch_get_llvm_imt_trampoline (MonoDomain *domain, MonoMethod *m, int vt_off
 
 	buf_len = 32;
 
-	start = code = mono_domain_code_reserve (domain, buf_len);
+	start = code = mono_domain_code_reserve_pool (domain, MONO_CODE_POOL_TRAMPOLINE, buf_len);
 
 	this_reg = mono_arch_get_this_arg_reg (mono_method_signature (m), NULL, NULL);
 
@@ -634,7 +634,7 @@ mono_arch_create_specific_trampoline (gpointer arg1, MonoTrampolineType tramp_ty
 	else
 		size = 5 + 1 + 8;
 
-	code = buf = mono_domain_code_reserve_align (domain, size, 1);
+	code = buf = mono_domain_code_reserve_pool_align (domain, MONO_CODE_POOL_TRAMPOLINE, size, 1);
 
 
 	if (((gint64)tramp - (gint64)code) >> 31 != 0 && ((gint64)tramp - (gint64)code) >> 31 != -1) {
@@ -643,7 +643,7 @@ mono_arch_create_specific_trampoline (gpointer arg1, MonoTrampolineType tramp_ty
 #endif
 		far_addr = TRUE;
 		size += 16;
-		code = buf = mono_domain_code_reserve_align (domain, size, 1);
+		code = buf = mono_domain_code_reserve_pool_align (domain, MONO_CODE_POOL_TRAMPOLINE, size, 1);
 	}
 
 	if (far_addr) {
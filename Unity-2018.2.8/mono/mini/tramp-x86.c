@@ -48,7 +48,7 @@ mono_arch_get_unbox_trampoline (MonoGenericSharingContext *gsctx, MonoMethod *m,
 	if (MONO_TYPE_ISSTRUCT (mono_method_signature (m)->ret))
 		this_pos = 8;
 	    
-	start = code = mono_domain_code_reserve (domain, 16);
+	start = code = mono_domain_code_reserve_pool (domain, MONO_CODE_POOL_TRAMPOLINE, 16);
 
 	x86_alu_membase_imm (code, X86_ADD, X86_ESP, this_pos, sizeof (MonoObject));
 	x86_jump_code (code, addr);
@@ -67,7 +67,7 @@ mono_arch_get_static_rgctx_trampoline (MonoMethod *m, MonoMethodRuntimeGenericCo
 
 	buf_len = 10;
 
-	start = code = mono_domain_code_reserve (domain, buf_len);
+	start = code = mono_domain_code_reserve_pool (domain, MONO_CODE_POOL_TRAMPOLINE, buf_len);
 
 	x86_mov_reg_imm (code, MONO_ARCH_RGCTX_REG, mrgctx);
 	x86_jump_code (code, addr);
@@ -481,7 +481,7 @@ mono_arch_create_specific_trampoline (gpointer arg1, MonoTrampolineType tramp_ty
 	
 	tramp = mono_get_trampoline_code (tramp_type);
 
-	code = buf = mono_domain_code_reserve_align (domain, TRAMPOLINE_SIZE, 4);
+	code = buf = mono_domain_code_reserve_pool_align (domain, MONO_CODE_POOL_TRAMPOLINE, TRAMPOLINE_SIZE, 4);
 
 	x86_push_imm (buf, arg1);
 	x86_jump_code (buf, tramp);
@@ -311,20 +311,17 @@ print_dwarf_state (int cfa_reg, int cfa_offset, int ip, int nregs, Loc *location
 }
 
 /*
- * Given the state of the current frame as stored in REGS, execute the unwind 
- * operations in unwind_info until the location counter reaches POS. The result is 
- * stored back into REGS. OUT_CFA will receive the value of the CFA.
+ * Execute the unwind operations in unwind_info until the location counter reaches
+ * the offset of IP, storing the location of each register into LOCATIONS and the
+ * definition of the CFA into OUT_CFA_REG/OUT_CFA_OFFSET.
  * This function is signal safe.
  */
-void
-mono_unwind_frame (guint8 *unwind_info, guint32 unwind_info_len, 
-				   guint8 *start_ip, guint8 *end_ip, guint8 *ip, mgreg_t *regs, 
-				   int nregs, guint8 **out_cfa) 
+static void
+decode_unwind_ops (guint8 *unwind_info, guint32 unwind_info_len, guint8 *start_ip, guint8 *ip,
+				   int nregs, Loc *locations, int *out_cfa_reg, int *out_cfa_offset)
 {
-	Loc locations [NUM_REGS];
 	int i, pos, reg, cfa_reg, cfa_offset, offset;
 	guint8 *p;
-	guint8 *cfa_val;
 
 	g_assert (nregs <= NUM_REGS);
 
@@ -382,6 +379,27 @@ mono_unwind_frame (guint8 *unwind_info, guint32 unwind_info_len,
 		}
 	}
 
+	*out_cfa_reg = cfa_reg;
+	*out_cfa_offset = cfa_offset;
+}
+
+/*
+ * Given the state of the current frame as stored in REGS, execute the unwind 
+ * operations in unwind_info until the location counter reaches POS. The result is 
+ * stored back into REGS. OUT_CFA will receive the value of the CFA.
+ * This function is signal safe.
+ */
+void
+mono_unwind_frame (guint8 *unwind_info, guint32 unwind_info_len, 
+				   guint8 *start_ip, guint8 *end_ip, guint8 *ip, mgreg_t *regs, 
+				   int nregs, guint8 **out_cfa) 
+{
+	Loc locations [NUM_REGS];
+	int i, cfa_reg, cfa_offset;
+	guint8 *cfa_val;
+
+	decode_unwind_ops (unwind_info, unwind_info_len, start_ip, ip, nregs, locations, &cfa_reg, &cfa_offset);
+
 	cfa_val = (guint8*)regs [cfa_reg] + cfa_offset;
 	for (i = 0; i < nregs; ++i) {
 		if (locations [i].loc_type == LOC_OFFSET)
@@ -391,6 +409,115 @@ mono_unwind_frame (guint8 *unwind_info, guint32 unwind_info_len,
 	*out_cfa = cfa_val;
 }
 
+/*
+ * The decoded unwind state at one offset of one piece of unwind info. Only the
+ * registers saved on the stack are stored.
+ */
+typedef struct {
+	guint8 *unwind_info;
+	guint32 offset;
+	gint16 cfa_reg;
+	gint16 nlocs;
+	gint32 cfa_offset;
+	guint8 loc_regs [UNWIND_CACHE_MAX_LOCS];
+	gint32 loc_offsets [UNWIND_CACHE_MAX_LOCS];
+} UnwindCacheEntry;
+
+struct MonoUnwindCache {
+	/* Set while an entry is read or written, so signal handlers bypass the cache */
+	volatile int busy;
+	UnwindCacheEntry entries [UNWIND_CACHE_SIZE];
+};
+
+MonoUnwindCache*
+mono_unwind_cache_new (void)
+{
+	return g_new0 (MonoUnwindCache, 1);
+}
+
+void
+mono_unwind_cache_free (MonoUnwindCache *cache)
+{
+	g_free (cache);
+}
+
+/*
+ * mono_unwind_frame_cached:
+ *
+ *   Same as mono_unwind_frame (), but look up the decoded unwind state of IP in
+ * the per-thread CACHE first. Unwind info is shared between methods and is
+ * never freed, so the state only depends on the unwind info and the offset of
+ * IP inside the method. The exception handling code unwinds the same frames
+ * in both of its passes, and usually throws from the same places repeatedly.
+ * CACHE can be NULL.
+ * This function is signal safe.
+ */
+void
+mono_unwind_frame_cached (MonoUnwindCache *cache, guint8 *unwind_info, guint32 unwind_info_len, 
+						  guint8 *start_ip, guint8 *end_ip, guint8 *ip, mgreg_t *regs, 
+						  int nregs, guint8 **out_cfa)
+{
+	Loc locations [NUM_REGS];
+	UnwindCacheEntry *entry;
+	guint32 offset = ip - start_ip;
+	int i, nlocs, cfa_reg, cfa_offset;
+	guint8 *cfa_val;
+
+	if (!cache || cache->busy) {
+		mono_unwind_frame (unwind_info, unwind_info_len, start_ip, end_ip, ip, regs, nregs, out_cfa);
+		return;
+	}
+
+	cache->busy = TRUE;
+	mono_memory_barrier ();
+
+	entry = &cache->entries [(((gsize)unwind_info >> 3) + offset * 31) & (UNWIND_CACHE_SIZE - 1)];
+	if (entry->unwind_info != unwind_info || entry->offset != offset) {
+		decode_unwind_ops (unwind_info, unwind_info_len, start_ip, ip, nregs, locations, &cfa_reg, &cfa_offset);
+
+		nlocs = 0;
+		for (i = 0; i < nregs; ++i) {
+			if (locations [i].loc_type == LOC_OFFSET) {
+				if (nlocs == UNWIND_CACHE_MAX_LOCS)
+					break;
+				entry->loc_regs [nlocs] = i;
+				entry->loc_offsets [nlocs] = locations [i].offset;
+				nlocs ++;
+			}
+		}
+
+		if (i < nregs) {
+			/* Too many saved registers to cache */
+			entry->unwind_info = NULL;
+			mono_memory_barrier ();
+			cache->busy = FALSE;
+
+			cfa_val = (guint8*)regs [cfa_reg] + cfa_offset;
+			for (i = 0; i < nregs; ++i) {
+				if (locations [i].loc_type == LOC_OFFSET)
+					regs [i] = *(gssize*)(cfa_val + locations [i].offset);
+			}
+			*out_cfa = cfa_val;
+			return;
+		}
+
+		entry->unwind_info = unwind_info;
+		entry->offset = offset;
+		entry->cfa_reg = cfa_reg;
+		entry->cfa_offset = cfa_offset;
+		entry->nlocs = nlocs;
+	}
+
+	cfa_val = (guint8*)regs [entry->cfa_reg] + entry->cfa_offset;
+	for (i = 0; i < entry->nlocs; ++i)
+		regs [entry->loc_regs [i]] = *(gssize*)(cfa_val + entry->loc_offsets [i]);
+
+	mono_memory_barrier ();
+	cache->busy = FALSE;
+
+	*out_cfa = cfa_val;
+}
+
 void
 mono_unwind_init (void)
 {
@@ -103,6 +103,23 @@ mono_unwind_frame (guint8 *unwind_info, guint32 unwind_info_len,
 				   guint8 *start_ip, guint8 *end_ip, guint8 *ip, mgreg_t *regs, 
 				   int nregs, guint8 **out_cfa) MONO_INTERNAL;
 
+/*
+ * A small per-thread cache of decoded unwind info, see mono_unwind_frame_cached ().
+ */
+#define UNWIND_CACHE_SIZE 64
+#define UNWIND_CACHE_MAX_LOCS 12
+
+typedef struct MonoUnwindCache MonoUnwindCache;
+
+MonoUnwindCache* mono_unwind_cache_new (void) MONO_INTERNAL;
+
+void mono_unwind_cache_free (MonoUnwindCache *cache) MONO_INTERNAL;
+
+void
+mono_unwind_frame_cached (MonoUnwindCache *cache, guint8 *unwind_info, guint32 unwind_info_len, 
+						  guint8 *start_ip, guint8 *end_ip, guint8 *ip, mgreg_t *regs, 
+						  int nregs, guint8 **out_cfa) MONO_INTERNAL;
+
 void mono_unwind_init (void) MONO_INTERNAL;
 
 void mono_unwind_cleanup (void) MONO_INTERNAL;
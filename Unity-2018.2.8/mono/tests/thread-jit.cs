@@ -0,0 +1,93 @@
+using System;
+using System.Collections.Generic;
+using System.Text;
+using System.Threading;
+
+/*
+ * Several threads JIT the same methods at the same time, including
+ * instantiations of shared generic code, whose compilation looks up the
+ * shared version of the method.  Every thread must get working code.
+ */
+class Gen<T> {
+	public static int Count (T [] a, T v) {
+		EqualityComparer<T> comparer = EqualityComparer<T>.Default;
+		int n = 0;
+
+		foreach (T x in a)
+			if (comparer.Equals (x, v))
+				n++;
+		return n;
+	}
+
+	public static int Twice (T v) {
+		return Count (new T [] { v, v }, v);
+	}
+
+	public static int Listed (T v) {
+		List<T> l = new List<T> ();
+
+		l.Add (v);
+		l.Add (v);
+		return l.Count;
+	}
+}
+
+class X {
+	const int cases = 16;
+
+	static ManualResetEvent start = new ManualResetEvent (false);
+	static int errors;
+
+	static int run (int k) {
+		switch (k) {
+		case 0: return Gen<string>.Count (new string [] { "a", "b", "a" }, "a");
+		case 1: return Gen<object>.Count (new object [] { 1, "a", 1 }, 1);
+		case 2: return Gen<Type>.Count (new Type [] { typeof (int), typeof (string), typeof (int) }, typeof (int));
+		case 3: return Gen<int>.Count (new int [] { 1, 2, 1 }, 1);
+		case 4: return Gen<double>.Count (new double [] { 0.5, 1, 0.5 }, 0.5);
+		case 5: return Gen<string>.Twice ("x");
+		case 6: return Gen<Version>.Twice (new Version (1, 2));
+		case 7: return Gen<StringBuilder>.Twice (new StringBuilder ());
+		case 8: return Gen<long>.Twice (42);
+		case 9: return Gen<DateTime>.Twice (DateTime.MinValue);
+		case 10: return Gen<string>.Listed ("x");
+		case 11: return Gen<Exception>.Listed (new Exception ());
+		case 12: return Gen<Thread>.Listed (Thread.CurrentThread);
+		case 13: return Gen<int>.Listed (1);
+		case 14: return Gen<Guid>.Listed (Guid.Empty);
+		case 15: return Gen<byte []>.Listed (new byte [0]);
+		default: return -1;
+		}
+	}
+
+	static void worker (object o) {
+		int first = (int) o;
+
+		start.WaitOne ();
+		for (int i = 0; i < cases; ++i) {
+			int k = (first + i) % cases;
+
+			if (run (k) != 2) {
+				Console.WriteLine ("case {0} failed", k);
+				Interlocked.Increment (ref errors);
+			}
+		}
+	}
+
+	static int Main () {
+		int nthreads = Math.Max (Environment.ProcessorCount * 2, 4);
+		Thread [] threads = new Thread [nthreads];
+
+		for (int i = 0; i < nthreads; ++i) {
+			threads [i] = new Thread (worker);
+			threads [i].Start (i);
+		}
+
+		/* Release all the threads at once so they race to compile the same methods */
+		start.Set ();
+		foreach (Thread t in threads)
+			t.Join ();
+
+		return errors == 0 ? 0 : 1;
+	}
+}
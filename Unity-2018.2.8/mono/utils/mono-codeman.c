@@ -52,6 +52,11 @@
 
 #define MONO_PROT_RWX (MONO_MMAP_READ|MONO_MMAP_WRITE|MONO_MMAP_EXEC)
 
+/* Size of the chunks of the hot pool when huge pages are enabled */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+static int use_huge_pages;
+
 typedef struct _CodeChunck CodeChunk;
 
 enum {
@@ -72,7 +77,8 @@ struct _CodeChunck {
 struct _MonoCodeManager {
 	int dynamic;
 	int read_only;
-	CodeChunk *current;
+	/* the chunks with free space, separately for each placement pool */
+	CodeChunk *current [MONO_CODE_POOL_NUM];
 	CodeChunk *full;
 };
 
@@ -101,9 +107,12 @@ MonoCodeManager*
 mono_code_manager_new (void)
 {
 	MonoCodeManager *cman = malloc (sizeof (MonoCodeManager));
+	int i;
+
 	if (!cman)
 		return NULL;
-	cman->current = NULL;
+	for (i = 0; i < MONO_CODE_POOL_NUM; ++i)
+		cman->current [i] = NULL;
 	cman->full = NULL;
 	cman->dynamic = 0;
 	cman->read_only = 0;
@@ -169,8 +178,11 @@ free_chunklist (CodeChunk *chunk)
 void
 mono_code_manager_destroy (MonoCodeManager *cman)
 {
+	int i;
+
 	free_chunklist (cman->full);
-	free_chunklist (cman->current);
+	for (i = 0; i < MONO_CODE_POOL_NUM; ++i)
+		free_chunklist (cman->current [i]);
 	free (cman);
 }
 
@@ -186,6 +198,7 @@ void
 mono_code_manager_invalidate (MonoCodeManager *cman)
 {
 	CodeChunk *chunk;
+	int i;
 
 #if defined(__i386__) || defined(__x86_64__)
 	int fill_value = 0xcc; /* x86 break */
@@ -193,8 +206,9 @@ mono_code_manager_invalidate (MonoCodeManager *cman)
 	int fill_value = 0x2a;
 #endif
 
-	for (chunk = cman->current; chunk; chunk = chunk->next)
-		memset (chunk->data, fill_value, chunk->size);
+	for (i = 0; i < MONO_CODE_POOL_NUM; ++i)
+		for (chunk = cman->current [i]; chunk; chunk = chunk->next)
+			memset (chunk->data, fill_value, chunk->size);
 	for (chunk = cman->full; chunk; chunk = chunk->next)
 		memset (chunk->data, fill_value, chunk->size);
 }
@@ -211,6 +225,20 @@ mono_code_manager_set_read_only (MonoCodeManager *cman)
 	cman->read_only = TRUE;
 }
 
+/**
+ * mono_code_manager_set_huge_pages:
+ * @enable: whenever to use huge pages
+ *
+ * Back the chunks of the hot pool of non dynamic code managers created after this
+ * call with 2MB pages, to reduce the iTLB misses of big applications. Only
+ * supported on linux, with transparent huge pages enabled.
+ */
+void
+mono_code_manager_set_huge_pages (int enable)
+{
+	use_huge_pages = enable;
+}
+
 /**
  * mono_code_manager_foreach:
  * @cman: a code manager
@@ -224,9 +252,13 @@ void
 mono_code_manager_foreach (MonoCodeManager *cman, MonoCodeManagerFunc func, void *user_data)
 {
 	CodeChunk *chunk;
-	for (chunk = cman->current; chunk; chunk = chunk->next) {
-		if (func (chunk->data, chunk->size, chunk->bsize, user_data))
-			return;
+	int i;
+
+	for (i = 0; i < MONO_CODE_POOL_NUM; ++i) {
+		for (chunk = cman->current [i]; chunk; chunk = chunk->next) {
+			if (func (chunk->data, chunk->size, chunk->bsize, user_data))
+				return;
+		}
 	}
 	for (chunk = cman->full; chunk; chunk = chunk->next) {
 		if (func (chunk->data, chunk->size, chunk->bsize, user_data))
@@ -246,8 +278,35 @@ mono_code_manager_foreach (MonoCodeManager *cman, MonoCodeManagerFunc func, void
 #define BIND_ROOM 8
 #endif
 
+/*
+ * valloc_huge:
+ *
+ *   Allocate SIZE bytes of executable memory aligned to HUGE_PAGE_SIZE, so the
+ * kernel can back it with huge pages.
+ */
+static void*
+valloc_huge (int size)
+{
+#ifndef PLATFORM_WIN32
+	char *ptr, *aligned;
+
+	ptr = mono_valloc (NULL, size + HUGE_PAGE_SIZE, MONO_PROT_RWX | ARCH_MAP_FLAGS | MONO_MMAP_HUGE);
+	if (!ptr)
+		return NULL;
+	aligned = (char*)ALIGN_INT ((gsize)ptr, HUGE_PAGE_SIZE);
+	/* Give back the unaligned head and tail */
+	if (aligned > ptr)
+		mono_vfree (ptr, aligned - ptr);
+	if (aligned < ptr + HUGE_PAGE_SIZE)
+		mono_vfree (aligned + size, ptr + HUGE_PAGE_SIZE - aligned);
+	return aligned;
+#else
+	return mono_valloc (NULL, size, MONO_PROT_RWX | ARCH_MAP_FLAGS);
+#endif
+}
+
 static CodeChunk*
-new_codechunk (int dynamic, int size)
+new_codechunk (int dynamic, int huge, int size)
 {
 	int minsize, flags = CODE_FLAG_MMAP;
 	int chunk_size, bsize = 0;
@@ -264,6 +323,8 @@ new_codechunk (int dynamic, int size)
 	if (dynamic) {
 		chunk_size = size;
 		flags = CODE_FLAG_MALLOC;
+	} else if (huge) {
+		chunk_size = ALIGN_INT (size, HUGE_PAGE_SIZE);
 	} else {
 		minsize = pagesize * MIN_PAGES;
 		if (size < minsize)
@@ -291,6 +352,10 @@ new_codechunk (int dynamic, int size)
 		ptr = dlmemalign (MIN_ALIGN, chunk_size + MIN_ALIGN - 1);
 		if (!ptr)
 			return NULL;
+	} else if (huge) {
+		ptr = valloc_huge (chunk_size);
+		if (!ptr)
+			return NULL;
 	} else {
 		ptr = mono_valloc (NULL, chunk_size, MONO_PROT_RWX | ARCH_MAP_FLAGS);
 		if (!ptr)
@@ -330,20 +395,23 @@ new_codechunk (int dynamic, int size)
 }
 
 /**
- * mono_code_manager_reserve:
+ * mono_code_manager_reserve_pool_align:
  * @cman: a code manager
+ * @pool: the placement pool to allocate from
  * @size: size of memory to allocate
  * @alignment: power of two alignment value
  *
- * Allocates at least @size bytes of memory inside the code manager @cman.
+ * Allocates at least @size bytes of memory inside the code manager @cman, in the
+ * chunks of the placement pool @pool.
  *
  * Returns: the pointer to the allocated memory or #NULL on failure
  */
 void*
-mono_code_manager_reserve_align (MonoCodeManager *cman, int size, int alignment)
+mono_code_manager_reserve_pool_align (MonoCodeManager *cman, MonoCodePool pool, int size, int alignment)
 {
 	CodeChunk *chunk, *prev;
 	void *ptr;
+	int huge;
 
 	g_assert (!cman->read_only);
 
@@ -357,13 +425,15 @@ mono_code_manager_reserve_align (MonoCodeManager *cman, int size, int alignment)
 		mono_stats.dynamic_code_bytes_count += size;
 	}
 
-	if (!cman->current) {
-		cman->current = new_codechunk (cman->dynamic, size);
-		if (!cman->current)
+	huge = use_huge_pages && !cman->dynamic && pool == MONO_CODE_POOL_HOT;
+
+	if (!cman->current [pool]) {
+		cman->current [pool] = new_codechunk (cman->dynamic, huge, size);
+		if (!cman->current [pool])
 			return NULL;
 	}
 
-	for (chunk = cman->current; chunk; chunk = chunk->next) {
+	for (chunk = cman->current [pool]; chunk; chunk = chunk->next) {
 		if (ALIGN_INT (chunk->pos, alignment) + size <= chunk->size) {
 			chunk->pos = ALIGN_INT (chunk->pos, alignment);
 			ptr = chunk->data + chunk->pos;
@@ -376,29 +446,62 @@ mono_code_manager_reserve_align (MonoCodeManager *cman, int size, int alignment)
 	 * to keep cman->current from growing too much
 	 */
 	prev = NULL;
-	for (chunk = cman->current; chunk; prev = chunk, chunk = chunk->next) {
+	for (chunk = cman->current [pool]; chunk; prev = chunk, chunk = chunk->next) {
 		if (chunk->pos + MIN_ALIGN * 4 <= chunk->size)
 			continue;
 		if (prev) {
 			prev->next = chunk->next;
 		} else {
-			cman->current = chunk->next;
+			cman->current [pool] = chunk->next;
 		}
 		chunk->next = cman->full;
 		cman->full = chunk;
 		break;
 	}
-	chunk = new_codechunk (cman->dynamic, size);
+	chunk = new_codechunk (cman->dynamic, huge, size);
 	if (!chunk)
 		return NULL;
-	chunk->next = cman->current;
-	cman->current = chunk;
+	chunk->next = cman->current [pool];
+	cman->current [pool] = chunk;
 	chunk->pos = ALIGN_INT (chunk->pos, alignment);
 	ptr = chunk->data + chunk->pos;
 	chunk->pos += size;
 	return ptr;
 }
 
+/**
+ * mono_code_manager_reserve_align:
+ * @cman: a code manager
+ * @size: size of memory to allocate
+ * @alignment: power of two alignment value
+ *
+ * Allocates at least @size bytes of memory inside the code manager @cman.
+ *
+ * Returns: the pointer to the allocated memory or #NULL on failure
+ */
+void*
+mono_code_manager_reserve_align (MonoCodeManager *cman, int size, int alignment)
+{
+	return mono_code_manager_reserve_pool_align (cman, MONO_CODE_POOL_HOT, size, alignment);
+}
+
+/**
+ * mono_code_manager_reserve_pool:
+ * @cman: a code manager
+ * @pool: the placement pool to allocate from
+ * @size: size of memory to allocate
+ *
+ * Allocates at least @size bytes of memory inside the code manager @cman, in the
+ * chunks of the placement pool @pool.
+ *
+ * Returns: the pointer to the allocated memory or #NULL on failure
+ */
+void*
+mono_code_manager_reserve_pool (MonoCodeManager *cman, MonoCodePool pool, int size)
+{
+	return mono_code_manager_reserve_pool_align (cman, pool, size, MIN_ALIGN);
+}
+
 /**
  * mono_code_manager_reserve:
  * @cman: a code manager
@@ -428,10 +531,17 @@ mono_code_manager_reserve (MonoCodeManager *cman, int size)
 void
 mono_code_manager_commit (MonoCodeManager *cman, void *data, int size, int newsize)
 {
+	CodeChunk *chunk;
+	int i;
+
 	g_assert (newsize <= size);
 
-	if (cman->current && (size != newsize) && (data == cman->current->data + cman->current->pos - size)) {
-		cman->current->pos -= size - newsize;
+	for (i = 0; i < MONO_CODE_POOL_NUM; ++i) {
+		chunk = cman->current [i];
+		if (chunk && (size != newsize) && (data == chunk->data + chunk->pos - size)) {
+			chunk->pos -= size - newsize;
+			break;
+		}
 	}
 }
 
@@ -452,9 +562,13 @@ mono_code_manager_size (MonoCodeManager *cman, int *used_size)
 	CodeChunk *chunk;
 	guint32 size = 0;
 	guint32 used = 0;
-	for (chunk = cman->current; chunk; chunk = chunk->next) {
-		size += chunk->size;
-		used += chunk->pos;
+	int i;
+
+	for (i = 0; i < MONO_CODE_POOL_NUM; ++i) {
+		for (chunk = cman->current [i]; chunk; chunk = chunk->next) {
+			size += chunk->size;
+			used += chunk->pos;
+		}
 	}
 	for (chunk = cman->full; chunk; chunk = chunk->next) {
 		size += chunk->size;
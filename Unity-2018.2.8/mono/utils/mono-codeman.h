@@ -3,6 +3,18 @@
 
 typedef struct _MonoCodeManager MonoCodeManager;
 
+/*
+ * Placement pools: code allocated from different pools lives in different chunks,
+ * so code which runs often isn't interleaved with code which runs rarely.
+ */
+typedef enum {
+	MONO_CODE_POOL_HOT,
+	MONO_CODE_POOL_COLD,
+	MONO_CODE_POOL_WRAPPER,
+	MONO_CODE_POOL_TRAMPOLINE,
+	MONO_CODE_POOL_NUM
+} MonoCodePool;
+
 MonoCodeManager* mono_code_manager_new     (void);
 MonoCodeManager* mono_code_manager_new_dynamic (void);
 void             mono_code_manager_destroy (MonoCodeManager *cman);
@@ -10,10 +22,13 @@ void             mono_code_manager_invalidate (MonoCodeManager *cman);
 void             mono_code_manager_set_read_only (MonoCodeManager *cman);
 
 void*            mono_code_manager_reserve_align (MonoCodeManager *cman, int size, int alignment);
+void*            mono_code_manager_reserve_pool (MonoCodeManager *cman, MonoCodePool pool, int size);
+void*            mono_code_manager_reserve_pool_align (MonoCodeManager *cman, MonoCodePool pool, int size, int alignment);
 
 void*            mono_code_manager_reserve (MonoCodeManager *cman, int size);
 void             mono_code_manager_commit  (MonoCodeManager *cman, void *data, int size, int newsize);
 int              mono_code_manager_size    (MonoCodeManager *cman, int *used_size);
+void             mono_code_manager_set_huge_pages (int enable);
 
 /* find the extra block allocated to resolve branches close to code */
 typedef int    (*MonoCodeManagerFunc)      (void *data, int csize, int size, void *user_data);
@@ -280,6 +280,11 @@ mono_valloc (void *addr, size_t length, int flags)
 		if (ptr == (void*)-1)
 			return NULL;
 	}
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	/* Transparent huge pages, only used for the 2MB aligned parts of the area */
+	if (flags & MONO_MMAP_HUGE)
+		madvise (ptr, length, MADV_HUGEPAGE);
+#endif
 	return ptr;
 }
 
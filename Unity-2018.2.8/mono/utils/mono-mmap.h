@@ -16,7 +16,9 @@ enum {
 	MONO_MMAP_SHARED  = 1 << 5,
 	MONO_MMAP_ANON    = 1 << 6,
 	MONO_MMAP_FIXED   = 1 << 7,
-	MONO_MMAP_32BIT   = 1 << 8
+	MONO_MMAP_32BIT   = 1 << 8,
+	/* back the area with huge pages if the OS supports it */
+	MONO_MMAP_HUGE    = 1 << 9
 };
 
 /*